@@ -0,0 +1,97 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_AT24C32_H_
+#define RTC_AT24C32_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <i2clib/master.h>
+#include "rtclib/byte_storage.h"
+
+namespace rtc {
+
+/**
+ * The 4 KiB AT24C32 serial EEPROM found on most DS3231 modules.
+ *
+ * Writes are split at the 32 byte page boundaries, and each page is
+ * written in a single transaction. After a page write the EEPROM does not
+ * acknowledge its address until its internal write cycle (at most 10 ms)
+ * completes, so rather than waiting a fixed time the next access first
+ * polls the address until acknowledged. A write therefore returns as soon
+ * as its last page is sent, and the write cycle overlaps with whatever
+ * the caller does next. Reads of any length are a single sequential read.
+ */
+class AT24C32 : public ByteStorage {
+ public:
+  /**
+   * The address with A2..A0 pulled high, as on DS3231 modules.
+   */
+  static constexpr uint8_t kDefaultAddress = 0x57;
+
+  static constexpr size_t kSize = 4096;
+  static constexpr size_t kPageSize = 32;
+
+  explicit AT24C32(i2c::Master i2c);
+
+  /**
+   * @param i2c The I2C master.
+   * @param address The EEPROM's I2C address, 0x50..0x57.
+   */
+  AT24C32(i2c::Master i2c, uint8_t address);
+
+  /**
+   * Test for a successful connection.
+   *
+   * @return True if the EEPROM is found, false otherwise.
+   */
+  bool begin();
+
+  size_t size() const override { return kSize; }
+
+  /**
+   * Read |num_bytes| bytes starting at |address| in one transaction.
+   *
+   * @return True if successful, false upon I2C error or if the range is
+   *         outside of the EEPROM.
+   */
+  bool read(uint16_t address, void* buf, size_t num_bytes) override;
+
+  /**
+   * Write |num_bytes| bytes starting at |address|, one transaction per
+   * page. Returns without waiting for the last page's write cycle.
+   *
+   * @return True if successful, false upon I2C error, write cycle timeout,
+   *         or if the range is outside of the EEPROM.
+   */
+  bool write(uint16_t address, const void* buf, size_t num_bytes) override;
+
+  /**
+   * Wait for a pending write cycle to complete.
+   *
+   * @return True if the EEPROM is ready, false upon timeout.
+   */
+  bool waitReady();
+
+  /**
+   * The number of page writes since construction.
+   */
+  uint32_t pageWrites() const { return page_writes_; }
+
+ private:
+  bool writePage(uint16_t address, const uint8_t* data, size_t num_bytes);
+
+  i2c::Master i2c_;
+  const uint8_t address_;
+  bool busy_ = false;  // A write cycle may be in progress.
+  uint32_t page_writes_ = 0;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_AT24C32_H_
@@ -0,0 +1,46 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_BYTE_STORAGE_H_
+#define RTC_BYTE_STORAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rtc {
+
+/**
+ * Byte addressable non-volatile memory, such as an RTC's battery backed
+ * RAM.
+ */
+class ByteStorage {
+ public:
+  virtual ~ByteStorage() = default;
+
+  /**
+   * The size of the memory in bytes.
+   */
+  virtual size_t size() const = 0;
+
+  /**
+   * Read |num_bytes| bytes starting at |address|.
+   *
+   * @return True if successful, false if not.
+   */
+  virtual bool read(uint16_t address, void* buf, size_t num_bytes) = 0;
+
+  /**
+   * Write |num_bytes| bytes starting at |address|.
+   *
+   * @return True if successful, false if not.
+   */
+  virtual bool write(uint16_t address, const void* buf, size_t num_bytes) = 0;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_BYTE_STORAGE_H_
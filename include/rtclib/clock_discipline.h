@@ -0,0 +1,148 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_CLOCK_DISCIPLINE_H_
+#define RTC_CLOCK_DISCIPLINE_H_
+
+#include <cstdint>
+
+namespace rtc {
+
+class SoftwareClock;
+
+/**
+ * Frequency and phase discipline of a SoftwareClock, such as Micros'.
+ *
+ * A hybrid FLL/PLL, loosely modeled on the NTP clock discipline. Each
+ * update() takes an offset measurement (reference time minus the clock's
+ * nowMicros()) and retunes the clock's rate:
+ *
+ * - Frequency: for the first few measurements a frequency-locked loop
+ *   estimates the frequency error directly from the change in offset,
+ *   acquiring large errors quickly. The loop then switches to a
+ *   phase-locked loop which integrates the offset, giving the best
+ *   long-term stability.
+ * - Phase: the measured offset is never stepped. It is slewed out by
+ *   temporarily adding offset / time constant to the rate.
+ *
+ * All corrections are applied with SoftwareClock::adjustDriftPpb(), so the
+ * clock is never stepped and the resolution is 1 ppb. The discipline owns
+ * the clock's drift adjustment: other known corrections, such as a
+ * TemperatureCompensator's, are fed to it with setFeedForwardPpb() rather
+ * than applied to the clock directly.
+ */
+class ClockDiscipline {
+ public:
+  struct Config {
+    /**
+     * PLL time constant (seconds). Larger values filter more measurement
+     * noise, but converge more slowly. Should be at least the interval
+     * between measurements.
+     */
+    int32_t time_constant = 64;
+
+    /**
+     * Number of FLL measurements before switching to the PLL.
+     */
+    uint32_t fll_samples = 4;
+
+    /**
+     * Offsets larger than this (microseconds) switch back to the FLL.
+     */
+    int64_t fll_threshold = 128000;
+
+    /**
+     * Limit of the frequency correction (ppb).
+     */
+    int32_t max_frequency = 500000;
+
+    /**
+     * Limit of the phase slew rate (ppb).
+     */
+    int32_t max_slew = 500000;
+  };
+
+  /**
+   * @param clock The clock to discipline. Not owned.
+   * @param config The loop parameters.
+   */
+  ClockDiscipline(SoftwareClock* clock, const Config& config);
+  explicit ClockDiscipline(SoftwareClock* clock);
+
+  /**
+   * Discipline the clock using an offset measurement.
+   *
+   * @param offset_micros The reference time minus the clock's nowMicros(),
+   *                      at the time of the call.
+   */
+  void update(int64_t offset_micros);
+
+  /**
+   * Set a known frequency correction, applied on top of the discipline's
+   * own, which then only has to learn the remainder. The clock is retuned
+   * immediately.
+   *
+   * @param ppb The correction, e.g. from a TemperatureCompensator.
+   */
+  void setFeedForwardPpb(int32_t ppb);
+
+  /**
+   * Forget all state and return to the FLL.
+   */
+  void reset();
+
+  /**
+   * Resume with a frequency correction learned earlier, e.g. before a
+   * reboot (see SyncState), going straight to the PLL.
+   *
+   * @param frequency_ppb A previous frequencyPpb().
+   */
+  void restore(int32_t frequency_ppb);
+
+  /**
+   * The current frequency correction estimate (ppb), excluding the feed
+   * forward.
+   */
+  int32_t frequencyPpb() const { return static_cast<int32_t>(frequency_); }
+
+  /**
+   * The current phase slew rate (ppb).
+   */
+  int32_t slewPpb() const { return static_cast<int32_t>(slew_); }
+
+  /**
+   * The current feed forward correction (ppb).
+   */
+  int32_t feedForwardPpb() const { return feed_forward_; }
+
+  /**
+   * The disciplined clock.
+   */
+  SoftwareClock* clock() const { return clock_; }
+
+  /**
+   * True when the PLL (rather than the FLL) is active.
+   */
+  bool locked() const { return fll_count_ >= config_.fll_samples; }
+
+ private:
+  void apply();
+
+  SoftwareClock* const clock_;
+  const Config config_;
+  double frequency_ = 0;  // ppb.
+  double slew_ = 0;       // ppb.
+  int32_t feed_forward_ = 0;
+  int64_t last_offset_ = 0;
+  int64_t last_update_ = 0;
+  uint32_t num_updates_ = 0;
+  uint32_t fll_count_ = 0;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_CLOCK_DISCIPLINE_H_
@@ -0,0 +1,180 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_CLOCK_FUSION_H_
+#define RTC_CLOCK_FUSION_H_
+
+#include <cstdint>
+
+namespace rtc {
+
+class DateTime;
+
+/**
+ * A best estimate of the time, with an uncertainty, fusing the SystemClock
+ * with an RTC and occasional references.
+ *
+ * A two-state Kalman filter tracks the offset of true time from the
+ * SystemClock and the SystemClock's frequency error:
+ *
+ * - The SystemClock interpolates between measurements with microsecond
+ *   resolution. Its frequency wander and noise grow the uncertainty over
+ *   time (Config::timer_wander, Config::timer_noise).
+ * - References, e.g. time from a host or GPS, are accurate but occasional.
+ *   Each comes with its own standard deviation.
+ * - PPS edges mark whole seconds to within Config::pps_jitter. The second
+ *   is resolved from the current estimate, so a PPS needs another source
+ *   to have set the time to within a quarter second first.
+ * - RTC readings are always available but count whole seconds, so each
+ *   is taken to be the middle of its second, with the variance of that
+ *   truncation (1/12 s²) plus Config::rtc_error². Readings should not be
+ *   in step with the RTC's seconds, or the truncation error won't average
+ *   out.
+ *
+ * Each measurement is weighted by its variance against the estimate's, so
+ * the filter follows references closely, and between them the RTC slowly
+ * corrects the SystemClock's drift. Measurements further than
+ * Config::outlier_gate standard deviations from the estimate are
+ * rejected, unless several follow in a row (e.g. after the time was
+ * changed), when the filter starts over from the latest.
+ *
+ * All times are SystemClock::microsSinceStart() timestamps, which must not
+ * go backwards. Fixed size, with no allocation. Not thread safe.
+ */
+class ClockFusion {
+ public:
+  struct Config {
+    /**
+     * Frequency random walk of the SystemClock (ppb per square root of a
+     * second).
+     */
+    float timer_wander = 10;
+
+    /**
+     * White phase noise of the SystemClock (µs per square root of a
+     * second).
+     */
+    float timer_noise = 1;
+
+    /**
+     * Standard deviation of the SystemClock's frequency error before any
+     * measurement (ppm).
+     */
+    float initial_frequency_error = 100;
+
+    /**
+     * Standard deviation of the RTC's time, beyond its resolution (µs).
+     */
+    int64_t rtc_error = 100000;
+
+    /**
+     * Standard deviation of PPS edge timestamps (µs).
+     */
+    int64_t pps_jitter = 10;
+
+    /**
+     * Measurements this many standard deviations or further from the
+     * estimate are rejected.
+     */
+    float outlier_gate = 5;
+
+    /**
+     * Consecutive rejections after which the filter starts over.
+     */
+    uint32_t max_rejections = 3;
+  };
+
+  struct Stats {
+    uint32_t updates = 0;     // Measurements used.
+    uint32_t rejections = 0;  // Measurements rejected as outliers.
+    uint32_t resets = 0;      // Starts over after repeated rejections.
+  };
+
+  explicit ClockFusion(const Config& config);
+  ClockFusion();
+
+  /**
+   * Add a reference time.
+   *
+   * @param local_micros When the reference was valid (SystemClock).
+   * @param unix_micros The reference time, in microseconds since 1970.
+   * @param stddev_micros The reference's standard deviation.
+   * @return True if used, false if rejected.
+   */
+  bool addReference(int64_t local_micros,
+                    int64_t unix_micros,
+                    int64_t stddev_micros);
+
+  /**
+   * Add a PPS edge, which marks the start of a second.
+   *
+   * @param local_micros When the edge was seen (SystemClock).
+   * @return True if used, false if rejected or the estimate is too
+   *         uncertain to tell which second it marks.
+   */
+  bool addPps(int64_t local_micros);
+
+  /**
+   * Add an RTC reading.
+   *
+   * @param local_micros When the RTC was read (SystemClock).
+   * @param now The RTC's time.
+   * @return True if used, false if rejected.
+   */
+  bool addRtc(int64_t local_micros, const DateTime& now);
+
+  /**
+   * The estimated time at a SystemClock timestamp.
+   *
+   * @param unix_micros The time, in microseconds since 1970.
+   * @param stddev_micros The estimate's standard deviation. Optional.
+   * @return False if there have been no measurements.
+   */
+  bool estimate(int64_t local_micros,
+                int64_t* unix_micros,
+                int64_t* stddev_micros) const;
+
+  /**
+   * The estimated time now.
+   */
+  bool now(int64_t* unix_micros, int64_t* stddev_micros) const;
+
+  /**
+   * The estimated frequency error of the SystemClock (ppb). Positive values
+   * are fast.
+   */
+  int32_t frequencyPpb() const;
+
+  bool initialized() const { return initialized_; }
+
+  const Stats& stats() const { return stats_; }
+
+  /**
+   * Forget all measurements.
+   */
+  void reset();
+
+ private:
+  bool update(int64_t local_micros, int64_t unix_micros, double variance);
+  void predict(double seconds, double* p00, double* p01, double* p11) const;
+
+  const Config config_;
+  bool initialized_ = false;
+  int64_t last_local_ = 0;  // Timestamp of the state.
+  int64_t offset_ = 0;      // True time minus the SystemClock (µs)...
+  double residual_ = 0;     // ...plus this fraction.
+  double frequency_ = 0;    // d(offset)/dt (ppm, i.e. µs/s).
+  double p00_ = 0;          // Covariance of offset and frequency.
+  double p01_ = 0;
+  double p11_ = 0;
+  uint32_t consecutive_rejections_ = 0;
+  Stats stats_;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_CLOCK_FUSION_H_
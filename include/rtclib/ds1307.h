@@ -12,6 +12,7 @@
 #define RTC_DS1307_H_
 
 #include <i2clib/master.h>
+#include "rtclib/byte_storage.h"
 
 namespace rtc {
 
@@ -31,6 +32,11 @@ class DS1307 {
     Rate32kHz  // 32kHz square wave.
   };
 
+  /**
+   * The number of registers, including the NVRAM, for dumpRegisters().
+   */
+  static constexpr size_t kNumRegisters = 0x40;
+
   DS1307(i2c::Master i2c);
 
   /**
@@ -65,6 +71,15 @@ class DS1307 {
    */
   bool now(DateTime* now);
 
+  /**
+   * Read just the seconds, in a one byte transaction: a cheap way to find
+   * when they roll over (see RtcTimestamper).
+   *
+   * @param seconds Set to the seconds, 0 to 59.
+   * @return true if successful, false if not.
+   */
+  bool readSeconds(uint8_t* seconds);
+
   /**
    * Read the current mode of the SQW pin.
    *
@@ -100,10 +115,67 @@ class DS1307 {
    */
   bool writeNVRAM(uint8_t address, const void* buf, size_t num_bytes);
 
+  /**
+   * Read the time, whether the clock is running, and part of the NVRAM in
+   * a single transaction, for a fast boot (see FastBoot).
+   *
+   * All registers up to the end of the NVRAM range are read, so keep boot
+   * data near the start of the NVRAM.
+   *
+   * @param now Set to the current date/time.
+   * @param running Set to true if the clock is running.
+   * @param address Starting NVRAM address, from 0 to 55.
+   * @param buf Receives |num_bytes| bytes of NVRAM.
+   * @param num_bytes Number of NVRAM bytes to read.
+   * @return true if successful, false if not.
+   */
+  bool readBootState(DateTime* now,
+                     bool* running,
+                     uint8_t address,
+                     void* buf,
+                     size_t num_bytes);
+
+  /**
+   * Read the whole register file, including the NVRAM, in one transaction.
+   *
+   * @param values Set to the kNumRegisters register values.
+   * @return true if successful, false if not.
+   */
+  bool dumpRegisters(uint8_t* values);
+
+  /**
+   * Restore the control register and NVRAM from dumpRegisters(), e.g. a
+   * golden configuration, in one write transaction, and read them back to
+   * verify.
+   *
+   * The time, and whether the clock is halted, are left unchanged: set the
+   * time with adjust().
+   *
+   * @param values kNumRegisters register values.
+   * @return true if successful, false upon I2C error or if the chip did not
+   *         read back the values.
+   */
+  bool restoreRegisters(const uint8_t* values);
+
  private:
   i2c::Master i2c_;
 };
 
+/**
+ * The DS1307's 56 bytes of battery backed NVRAM as ByteStorage.
+ */
+class DS1307Nvram : public ByteStorage {
+ public:
+  explicit DS1307Nvram(DS1307* rtc) : rtc_(rtc) {}
+
+  size_t size() const override { return 56; }
+  bool read(uint16_t address, void* buf, size_t num_bytes) override;
+  bool write(uint16_t address, const void* buf, size_t num_bytes) override;
+
+ private:
+  DS1307* rtc_;
+};
+
 }  // namespace rtc
 
 #endif  // RTC_DS1307_H_
@@ -0,0 +1,102 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_DS1307_REGISTERS_H_
+#define RTC_DS1307_REGISTERS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <rtclib/ds1307.h>
+#include <rtclib/register_map.h>
+
+namespace rtc {
+
+/**
+ * The DS1307 register map. See the datasheet, table 2.
+ */
+struct DS1307Registers {
+  static constexpr uint8_t kI2CAddress = 0x68;
+
+  // clang-format off
+  static constexpr uint8_t kSeconds      = 0x00;
+  static constexpr uint8_t kMinutes      = 0x01;
+  static constexpr uint8_t kHours        = 0x02;
+  static constexpr uint8_t kDay          = 0x03;
+  static constexpr uint8_t kDate         = 0x04;
+  static constexpr uint8_t kMonth        = 0x05;
+  static constexpr uint8_t kYear         = 0x06;
+  static constexpr uint8_t kControl      = 0x07;
+  static constexpr uint8_t kNvram        = 0x08;  // 56 bytes, 0x08..0x3F.
+  static constexpr size_t  kNvramSize    = 56;
+  static constexpr size_t  kNumRegisters = DS1307::kNumRegisters;
+
+  using CH      = RegisterField<kSeconds, 7>;     // Clock halt.
+  using Seconds = RegisterField<kSeconds, 0, 7>;  // BCD.
+
+  // Control. With SQWE clear, the SQW/OUT pin is driven to OUT.
+  using OUT  = RegisterField<kControl, 7>;     // Output level.
+  using SQWE = RegisterField<kControl, 4>;     // Square wave enable.
+  using RS   = RegisterField<kControl, 0, 2>;  // Square wave rate select.
+  // clang-format on
+
+  /**
+   * Control register values. OUT is only significant with SQWE clear, and
+   * RS with SQWE set.
+   */
+  static constexpr FieldValue<DS1307::SqwPinMode> kSqwPinModes[] = {
+      {DS1307::SqwPinMode::Off, 0},
+      {DS1307::SqwPinMode::On, OUT::kMask},
+      {DS1307::SqwPinMode::Rate1Hz, SQWE::set(RS::set(0, 0b00), 1)},
+      {DS1307::SqwPinMode::Rate4kHz, SQWE::set(RS::set(0, 0b01), 1)},
+      {DS1307::SqwPinMode::Rate8kHz, SQWE::set(RS::set(0, 0b10), 1)},
+      {DS1307::SqwPinMode::Rate32kHz, SQWE::set(RS::set(0, 0b11), 1)},
+  };
+
+  /**
+   * The mode of the |control| register value. RS counts the rates up from
+   * Rate1Hz, so this is an offset rather than a search of kSqwPinModes.
+   */
+  static constexpr DS1307::SqwPinMode sqwPinMode(uint8_t control) {
+    return SQWE::get(control)
+               ? static_cast<DS1307::SqwPinMode>(
+                     static_cast<int>(DS1307::SqwPinMode::Rate1Hz) +
+                     RS::get(control))
+               : OUT::get(control) ? DS1307::SqwPinMode::On
+                                   : DS1307::SqwPinMode::Off;
+  }
+
+  /**
+   * Restored configuration: control and the NVRAM.
+   */
+  static constexpr RegisterRestore kRestore[kNumRegisters] = {
+      // Time, including CH.
+      {}, {}, {}, {}, {}, {}, {},
+      {OUT::kMask | SQWE::kMask | RS::kMask},
+      // NVRAM.
+      {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF},
+      {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF},
+      {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF},
+      {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF},
+      {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF},
+      {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF},
+      {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF},
+  };
+};
+
+static_assert(encodingsOrdered(DS1307Registers::kSqwPinModes),
+              "Encodings out of order");
+static_assert(decodesField(DS1307Registers::kSqwPinModes,
+                           DS1307Registers::sqwPinMode),
+              "sqwPinMode() disagrees with the encodings");
+static_assert(DS1307Registers::kNvram + DS1307Registers::kNvramSize ==
+                  DS1307Registers::kNumRegisters,
+              "NVRAM must end the register file");
+
+}  // namespace rtc
+
+#endif  // RTC_DS1307_REGISTERS_H_
@@ -11,6 +11,9 @@
 #ifndef RTC_DS3231_H_
 #define RTC_DS3231_H_
 
+#include <cstddef>
+#include <cstdint>
+
 #include <i2clib/master.h>
 
 namespace rtc {
@@ -56,15 +59,31 @@ class DS3231 {
     A2   ///< Alarm 2.
   };
 
+  /**
+   * The number of registers, for dumpRegisters().
+   */
+  static constexpr size_t kNumRegisters = 0x13;
+
   DS3231(i2c::Master i2c);
 
   /**
    * Set the date and flip the Oscillator Stop Flag.
    *
+   * The status register is read first, unless prepareAdjust() already has,
+   * and the time and status are then written in a single transaction.
+   *
    * @param dt DateTime object containing the date/time to set.
    */
   bool adjust(const DateTime& dt);
 
+  /**
+   * Read the status register for the next adjust(), so that it only
+   * writes: for PrecisionSetter::Config::prepare, which times the write.
+   *
+   * @return True if successful, false upon I2C error.
+   */
+  bool prepareAdjust();
+
   /**
    * Start I2C for the DS3231 and test succesful connection.
    *
@@ -77,10 +96,19 @@ class DS3231 {
    * stopped due to power loss.
    *
    * @return True if the bit is set (oscillator stopped) or false if it is
-   * running.
+   * running. Also true if the flag can't be read.
    */
   bool lostPower();
 
+  /**
+   * Check the Oscillator Stop Flag, distinguishing an I2C error from a
+   * power loss.
+   *
+   * @param lost_power Set to true if the oscillator stopped.
+   * @return True if successful, false upon I2C error.
+   */
+  bool lostPower(bool* lost_power);
+
   /**
    * Retrieve the current time from the clock.
    *
@@ -89,6 +117,15 @@ class DS3231 {
    */
   bool now(DateTime* dt);
 
+  /**
+   * Read just the seconds, in a one byte transaction: a cheap way to find
+   * when they roll over (see RtcTimestamper).
+   *
+   * @param seconds Set to the seconds, 0 to 59.
+   * @return true if successful, false if not.
+   */
+  bool readSeconds(uint8_t* seconds);
+
   /**
    * Read the SQW pin mode.
    *
@@ -125,15 +162,17 @@ class DS3231 {
    * Disable the specified alarm.
    *
    * @param alarm The alarm to disable.
+   * @return True if successful, false if error.
    */
-  void disableAlarm(Alarm alarm);
+  bool disableAlarm(Alarm alarm);
 
   /**
    * Clear status the specified alarm.
    *
    * @param alarm The alarm to clear.
+   * @return True if successful, false if error.
    */
-  void clearAlarm(Alarm alarm);
+  bool clearAlarm(Alarm alarm);
 
   /**
    * Get alarm status.
@@ -143,6 +182,18 @@ class DS3231 {
    */
   bool isAlarmFired(Alarm alarm);
 
+  /**
+   * Read, and then clear, both alarm flags.
+   *
+   * Takes one status read, and one write only if an alarm has fired. A
+   * flag raised between the two is not lost.
+   *
+   * @param a1_fired Set to true if alarm 1 has fired.
+   * @param a2_fired Set to true if alarm 2 has fired.
+   * @return True if successful, false if error.
+   */
+  bool readAndClearAlarms(bool* a1_fired, bool* a2_fired);
+
   /**
    * Enable 32KHz Output.
    *
@@ -179,8 +230,57 @@ class DS3231 {
    */
   bool getAgingOffset(int8_t* aging_offset);
 
+  /**
+   * @brief Set the Aging Offset.
+   *
+   * Positive values slow the oscillator, by about 0.1 ppm per step at
+   * 25 degrees C. The new value takes effect at the next temperature
+   * conversion.
+   *
+   * @param aging_offset The new aging offset.
+   *
+   * @return True if successful, false upon error.
+   */
+  bool setAgingOffset(int8_t aging_offset);
+
+  /**
+   * Read the time, the oscillator stop flag and the aging offset in a
+   * single transaction, for a fast boot (see FastBoot).
+   *
+   * @param now Set to the current date/time.
+   * @param lost_power Set to true if the oscillator has stopped, and so
+   *                   the time is invalid.
+   * @param aging_offset Set to the aging offset.
+   * @return True if successful, false upon error.
+   */
+  bool readBootState(DateTime* now, bool* lost_power, int8_t* aging_offset);
+
+  /**
+   * Read the whole register file in one transaction.
+   *
+   * @param values Set to the kNumRegisters register values.
+   * @return True if successful, false upon I2C error.
+   */
+  bool dumpRegisters(uint8_t* values);
+
+  /**
+   * Restore the configuration from dumpRegisters(), e.g. a golden
+   * configuration, in one write transaction, and read it back to verify.
+   *
+   * Only configuration bits are written (see DS3231Registers::kRestore).
+   * The time, flags and read-only bits are left unchanged: set the time
+   * with adjust().
+   *
+   * @param values kNumRegisters register values.
+   * @return True if successful, false upon I2C error or if the chip did not
+   *         read back the configuration.
+   */
+  bool restoreRegisters(const uint8_t* values);
+
  private:
   i2c::Master i2c_;
+  uint8_t adjust_status_ = 0;     // From prepareAdjust().
+  bool adjust_prepared_ = false;  // adjust_status_ is for the next adjust().
 };
 
 }  // namespace rtc
@@ -0,0 +1,128 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_DS3231_ALARM_DISPATCHER_H_
+#define RTC_DS3231_ALARM_DISPATCHER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "rtclib/ds3231.h"
+#include "rtclib/interrupt_source.h"
+#include "rtclib/spsc_queue.h"
+
+namespace rtc {
+
+/**
+ * Interrupt-driven dispatch of DS3231 alarms to handlers.
+ *
+ * Instead of polling isAlarmFired(), an I2C read, the DS3231's INT/SQW
+ * output drives an interrupt. The ISR only timestamps the interrupt and
+ * pushes it onto a lock-free single-producer single-consumer queue. A
+ * worker (e.g. a task woken by the wakeup hook, or the main loop) calls
+ * service(), which drains the queue, takes one status read, clears the
+ * fired alarms, and runs their handlers.
+ *
+ * Interrupts which arrive faster than they are serviced are coalesced:
+ * the status read reports every alarm which has fired, so none are lost.
+ *
+ * The alarms themselves are set with DS3231::setAlarm1()/setAlarm2() as
+ * usual, with the square wave output disabled (INTCN set).
+ */
+class DS3231AlarmDispatcher {
+ public:
+  /**
+   * @param alarm The alarm which fired.
+   * @param micros SystemClock time at which the interrupt was raised.
+   */
+  using Handler = std::function<void(DS3231::Alarm alarm, int64_t micros)>;
+
+  /**
+   * @param rtc The RTC whose alarms to dispatch.
+   * @param source The interrupt source connected to the RTC's INT/SQW pin.
+   */
+  DS3231AlarmDispatcher(DS3231* rtc, InterruptSource* source);
+  ~DS3231AlarmDispatcher();
+
+  /**
+   * Register |handler| to run each time |alarm| fires. Not to be called
+   * concurrently with service(), but may be called from a handler, in which
+   * case |handler| first runs on the next service().
+   */
+  void addHandler(DS3231::Alarm alarm, Handler handler);
+
+  /**
+   * Set a function which the ISR calls, in interrupt context, after
+   * queueing an interrupt, e.g. to wake the worker task.
+   */
+  void setWakeup(InterruptSource::Isr wakeup, void* arg);
+
+  /**
+   * Attach the ISR. As the interrupt of an alarm which fired beforehand is
+   * already asserted, this queues a check of the alarm flags: call
+   * service() soon after. Calling begin() again re-attaches the ISR and
+   * queues another check.
+   *
+   * @return True if successful, false if not.
+   */
+  bool begin();
+
+  /**
+   * Detach the ISR.
+   */
+  void end();
+
+  /**
+   * Handle the queued interrupts, if any: read and clear the alarm flags,
+   * and run the handlers of the fired alarms. Call from the worker only.
+   *
+   * @return True if successful, false upon I2C error. The interrupt is
+   *         then handled by the next call.
+   */
+  bool service();
+
+  /**
+   * Are interrupts waiting for service()?
+   */
+  bool pending() const { return !events_.empty() || retry_; }
+
+  /**
+   * The number of interrupts which found the queue full. They were
+   * coalesced with queued ones.
+   */
+  uint32_t overflows() const {
+    return overflows_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Event {
+    int64_t micros;  // SystemClock time of the interrupt.
+  };
+
+  struct Entry {
+    DS3231::Alarm alarm;
+    Handler handler;
+  };
+
+  static void isr(void* arg);
+
+  DS3231* rtc_;
+  InterruptSource* source_;
+  SpscQueue<Event, 8> events_;
+  std::atomic<uint32_t> overflows_{0};
+  InterruptSource::Isr wakeup_ = nullptr;
+  void* wakeup_arg_ = nullptr;
+  std::vector<Entry> handlers_;
+  bool retry_ = false;        // Service failed: retry the interrupt
+  int64_t retry_micros_ = 0;  // raised at this time.
+};
+
+}  // namespace rtc
+
+#endif  // RTC_DS3231_ALARM_DISPATCHER_H_
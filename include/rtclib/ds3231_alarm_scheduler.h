@@ -0,0 +1,140 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_DS3231_ALARM_SCHEDULER_H_
+#define RTC_DS3231_ALARM_SCHEDULER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "rtclib/ds3231.h"
+
+namespace rtc {
+
+class DateTime;
+
+/**
+ * Any number of alarms multiplexed onto the DS3231's alarm 1.
+ *
+ * Alarms are kept in a binary min-heap ordered by time, and alarm 1 is
+ * always programmed with the earliest one. The MCU does not poll: connect
+ * the DS3231's INT/SQW pin to an interrupt and call service() (outside of
+ * the ISR, as it uses I2C) when it is asserted. service() runs the
+ * callbacks of all due alarms and re-arms alarm 1.
+ *
+ * Scheduling and cancellation are O(log n). The hardware is only
+ * reprogrammed when the earliest alarm changes.
+ *
+ * Alarm 1 is programmed in Alarm1Mode::Date, which cannot express a time
+ * more than a month ahead. Such alarms cause an early wakeup, after which
+ * service() simply re-arms.
+ *
+ * Alarm 2 is not used and remains available.
+ */
+class DS3231AlarmScheduler {
+ public:
+  /**
+   * Identifies a scheduled alarm. Never zero.
+   */
+  using AlarmId = uint64_t;
+
+  using Callback = std::function<void(AlarmId)>;
+
+  explicit DS3231AlarmScheduler(DS3231* rtc);
+
+  /**
+   * Take ownership of alarm 1, disabling it until an alarm is scheduled.
+   *
+   * @return True if successful, false upon I2C error.
+   */
+  bool begin();
+
+  /**
+   * Schedule an alarm.
+   *
+   * An alarm due at or before the current RTC time runs immediately,
+   * before this returns. Callbacks may schedule and cancel alarms.
+   *
+   * @param when The RTC time at which to run |callback|.
+   * @param callback Called with the alarm's id.
+   * @param id Set to the id of the new alarm. May be nullptr.
+   * @return True if successful, false upon I2C error. The alarm is
+   *         scheduled regardless, and the hardware is re-armed at the next
+   *         successful call.
+   */
+  bool schedule(const DateTime& when, Callback callback, AlarmId* id);
+
+  /**
+   * Cancel a scheduled alarm.
+   *
+   * @return True if successful, false if |id| is not scheduled or upon I2C
+   *         error.
+   */
+  bool cancel(AlarmId id);
+
+  /**
+   * Handle an alarm 1 interrupt: run all due alarms and re-arm.
+   *
+   * @return True if successful, false upon I2C error.
+   */
+  bool service();
+
+  /**
+   * The number of scheduled alarms.
+   */
+  size_t size() const { return heap_.size(); }
+
+  /**
+   * The time of the earliest scheduled alarm.
+   *
+   * @return False if no alarm is scheduled.
+   */
+  bool next(DateTime* when) const;
+
+ private:
+  struct Entry {
+    uint32_t when;  // Unixtime.
+    uint32_t seq;   // Insertion order, to run equal times FIFO.
+    uint32_t slot;
+  };
+
+  struct Slot {
+    Callback callback;
+    size_t heap_index;
+    uint32_t generation;
+    bool used;
+  };
+
+  static bool earlier(const Entry& a, const Entry& b);
+  AlarmId idOf(uint32_t slot) const;
+  bool lookup(AlarmId id, uint32_t* slot) const;
+
+  void place(size_t index, const Entry& entry);
+  void siftUp(size_t index);
+  void siftDown(size_t index);
+  void remove(size_t index);
+
+  /**
+   * Run due alarms, then program alarm 1 with the earliest remaining one.
+   */
+  bool rearm();
+
+  DS3231* rtc_;
+  std::vector<Entry> heap_;
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> free_slots_;
+  uint32_t next_seq_ = 0;
+  bool armed_ = false;       // Alarm 1 is enabled,
+  uint32_t armed_when_ = 0;  // for this time.
+  bool servicing_ = false;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_DS3231_ALARM_SCHEDULER_H_
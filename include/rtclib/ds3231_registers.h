@@ -0,0 +1,112 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_DS3231_REGISTERS_H_
+#define RTC_DS3231_REGISTERS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <rtclib/ds3231.h>
+#include <rtclib/register_map.h>
+
+namespace rtc {
+
+/**
+ * The DS3231 register map. See the datasheet, figure 1.
+ */
+struct DS3231Registers {
+  static constexpr uint8_t kI2CAddress = 0x68;
+
+  // clang-format off
+  static constexpr uint8_t kSeconds       = 0x00;
+  static constexpr uint8_t kMinutes       = 0x01;
+  static constexpr uint8_t kHours         = 0x02;
+  static constexpr uint8_t kDay           = 0x03;
+  static constexpr uint8_t kDate          = 0x04;
+  static constexpr uint8_t kMonth         = 0x05;
+  static constexpr uint8_t kYear          = 0x06;
+  static constexpr uint8_t kAlarm1Seconds = 0x07;
+  static constexpr uint8_t kAlarm1Minutes = 0x08;
+  static constexpr uint8_t kAlarm1Hours   = 0x09;
+  static constexpr uint8_t kAlarm1Day     = 0x0A;
+  static constexpr uint8_t kAlarm2Minutes = 0x0B;
+  static constexpr uint8_t kAlarm2Hours   = 0x0C;
+  static constexpr uint8_t kAlarm2Day     = 0x0D;
+  static constexpr uint8_t kControl       = 0x0E;
+  static constexpr uint8_t kStatus        = 0x0F;
+  static constexpr uint8_t kAgingOffset   = 0x10;
+  static constexpr uint8_t kTempMsb       = 0x11;
+  static constexpr uint8_t kTempLsb       = 0x12;
+  static constexpr size_t  kNumRegisters  = DS3231::kNumRegisters;
+
+  using Seconds = RegisterField<kSeconds, 0, 7>;  // BCD.
+
+  // Control.
+  using EOSC  = RegisterField<kControl, 7>;     // Oscillator off on battery.
+  using BBSQW = RegisterField<kControl, 6>;     // Battery backed square wave.
+  using CONV  = RegisterField<kControl, 5>;     // Convert temperature.
+  using RS    = RegisterField<kControl, 3, 2>;  // Square wave rate select.
+  using INTCN = RegisterField<kControl, 2>;     // Interrupt control.
+  using A2IE  = RegisterField<kControl, 1>;     // Alarm 2 interrupt enable.
+  using A1IE  = RegisterField<kControl, 0>;     // Alarm 1 interrupt enable.
+  // RS and INTCN together, as encoded by kSqwPinModes.
+  using SquareWave = RegisterField<kControl, 2, 3>;
+
+  // Status.
+  using OSF     = RegisterField<kStatus, 7>;  // Oscillator stop flag.
+  using EN32kHz = RegisterField<kStatus, 3>;  // Enable 32kHz output.
+  using BSY     = RegisterField<kStatus, 2>;  // Busy.
+  using A2F     = RegisterField<kStatus, 1>;  // Alarm 2 flag.
+  using A1F     = RegisterField<kStatus, 0>;  // Alarm 1 flag.
+
+  // Alarm mask bits (see datasheet table 2) and day/date selects.
+  using A1M1 = RegisterField<kAlarm1Seconds, 7>;
+  using A1M2 = RegisterField<kAlarm1Minutes, 7>;
+  using A1M3 = RegisterField<kAlarm1Hours, 7>;
+  using A1M4 = RegisterField<kAlarm1Day, 7>;
+  using A1DY = RegisterField<kAlarm1Day, 6>;
+  using A2M2 = RegisterField<kAlarm2Minutes, 7>;
+  using A2M3 = RegisterField<kAlarm2Hours, 7>;
+  using A2M4 = RegisterField<kAlarm2Day, 7>;
+  using A2DY = RegisterField<kAlarm2Day, 6>;
+  // clang-format on
+
+  /**
+   * SquareWave encodings. Any rate with INTCN set is Off.
+   */
+  static constexpr FieldValue<DS3231::SqwPinMode> kSqwPinModes[] = {
+      {DS3231::SqwPinMode::Off, 0b001},
+      {DS3231::SqwPinMode::Rate1Hz, 0b000},
+      {DS3231::SqwPinMode::Rate1kHz, 0b010},
+      {DS3231::SqwPinMode::Rate4kHz, 0b100},
+      {DS3231::SqwPinMode::Rate8kHz, 0b110},
+  };
+
+  /**
+   * Restored configuration: the alarms, control (but CONV), EN32kHz and
+   * the aging offset. Writing one sets OSF, so it keeps its current value.
+   */
+  static constexpr RegisterRestore kRestore[kNumRegisters] = {
+      // Time.
+      {}, {}, {}, {}, {}, {}, {},
+      // Alarms.
+      {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF}, {0xFF},
+      {static_cast<uint8_t>(~CONV::kMask)},
+      {EN32kHz::kMask, A2F::kMask | A1F::kMask, false, 0, OSF::kMask},
+      {0xFF},
+      // Temperature.
+      {}, {},
+  };
+};
+
+static_assert(encodingsOrdered(DS3231Registers::kSqwPinModes),
+              "Encodings out of order");
+
+}  // namespace rtc
+
+#endif  // RTC_DS3231_REGISTERS_H_
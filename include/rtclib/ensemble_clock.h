@@ -0,0 +1,133 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_ENSEMBLE_CLOCK_H_
+#define RTC_ENSEMBLE_CLOCK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace rtc {
+
+class DateTime;
+
+/**
+ * One time from several RTCs, e.g. a DS3231 and a PCF8523, tolerating the
+ * failure or drift of any one of them.
+ *
+ * Each now() reads every source back-to-back, timestamping each read with
+ * the SystemClock so that all are compared at the same instant. The
+ * sources' offsets from the SystemClock are then voted on:
+ *
+ * - Sources which fail to read are skipped.
+ * - Sources further than Config::outlier_threshold from the median offset
+ *   are rejected as outliers.
+ * - The remaining offsets are averaged, weighted by each source's
+ *   stability: the inverse of its running mean square deviation, both
+ *   from the median and from its own previous offset (i.e. steps against
+ *   the SystemClock). A chip which starts to drift or jump thus loses
+ *   influence before it is far enough out to be rejected.
+ *
+ * Should every source be rejected (e.g. two which disagree) the most
+ * stable one is trusted. RTCs count whole seconds, so each reading is
+ * taken to be the middle of its second, and the estimate is at best
+ * within half a second.
+ *
+ * As each reading is timestamped, the time taken by the others (e.g. on a
+ * slower bus) doesn't bias the comparison.
+ */
+class EnsembleClock {
+ public:
+  static constexpr size_t kMaxSources = 4;
+
+  /**
+   * Reads a source's current time, returning false upon error.
+   */
+  using Reader = std::function<bool(DateTime* now)>;
+
+  struct Config {
+    /**
+     * Sources this far (µs) or further from the median are rejected.
+     */
+    int64_t outlier_threshold = 1500000;
+
+    /**
+     * Weight of the latest deviation in the running mean square deviation,
+     * from 0 to 1. Smaller values average over more readings.
+     */
+    float stability_gain = 0.1f;
+  };
+
+  struct SourceStats {
+    uint32_t reads = 0;       // Successful reads.
+    uint32_t failures = 0;    // Failed reads.
+    uint32_t rejections = 0;  // Reads rejected as outliers.
+    bool accepted = false;    // Used by the latest estimate.
+    float weight = 0;         // Share of the latest estimate, 0 to 1.
+    float rms_deviation = 0;  // RMS deviation (seconds).
+  };
+
+  explicit EnsembleClock(const Config& config);
+  EnsembleClock();
+
+  /**
+   * Add a source.
+   *
+   * @return False if there are already kMaxSources sources.
+   */
+  bool addSource(Reader reader);
+
+  /**
+   * Add an RTC driver (DS1307, DS3231, PCF8523 or PCF8563) as a source.
+   */
+  template <typename RTC>
+  bool addRtc(RTC* rtc) {
+    return addSource([rtc](DateTime* now) { return rtc->now(now); });
+  }
+
+  /**
+   * The ensemble's time.
+   *
+   * @return True if successful, false if no source could be read.
+   */
+  bool now(DateTime* dt);
+
+  /**
+   * The ensemble's time, in microseconds since 1970.
+   *
+   * @return True if successful, false if no source could be read.
+   */
+  bool nowMicros(int64_t* unix_micros);
+
+  size_t numSources() const { return num_sources_; }
+
+  const SourceStats& stats(size_t source) const {
+    return sources_[source].stats;
+  }
+
+ private:
+  struct Source {
+    Reader reader;
+    SourceStats stats;
+    double mean_square = 0;   // Of the deviations (s²).
+    bool tracked = false;     // mean_square has been initialized.
+    bool valid = false;       // This round's reading succeeded.
+    int64_t offset = 0;       // This round's offset from the SystemClock.
+    int64_t last_offset = 0;  // The last valid reading's offset.
+  };
+
+  int64_t vote();
+
+  const Config config_;
+  Source sources_[kMaxSources];
+  size_t num_sources_ = 0;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_ENSEMBLE_CLOCK_H_
@@ -0,0 +1,135 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_EVENT_LOG_H_
+#define RTC_EVENT_LOG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "rtclib/datetime.h"
+
+namespace rtc {
+
+class ByteStorage;
+
+/**
+ * A ring buffer of timestamped events in non-volatile memory, such as the
+ * AT24C32 on DS3231 modules.
+ *
+ * The region is divided into blocks of kBlockSize bytes, filled in order
+ * and overwritten oldest first. Each block starts with a header holding a
+ * 16 bit sequence number and the absolute time of its first event, and is
+ * followed by records:
+ *
+ *     header: [0xE7] [sequence (2)] [unix time (4)] [CRC-8]
+ *     record: [length] [delta...] [payload...] [CRC-8]
+ *
+ * where delta is the seconds since the previous event as a varint (7 bits
+ * per byte, least significant first), so events a few seconds apart take
+ * three bytes plus their payload. All values are little endian. A length
+ * of 0xFF (or the end of the block) ends the block. A time earlier than
+ * the previous event starts a new block.
+ *
+ * Each append is a single write of the record and the end marker (and the
+ * header, when starting a block). A torn record fails its CRC and is
+ * overwritten by the next append.
+ *
+ * Block i of the current lap has sequence number seq(0) + i, and all
+ * blocks left from the previous lap fail that test, so begin() finds the
+ * newest block with a binary search of the headers: O(log n) small reads
+ * rather than reading the whole region.
+ *
+ * begin() and forEach() never write, so a log can also be decoded from a
+ * memory dump (see tools/decode_event_log.py).
+ */
+class EventLog {
+ public:
+  static constexpr size_t kBlockSize = 64;
+
+  /**
+   * The largest payload, in bytes.
+   */
+  static constexpr size_t kMaxPayloadSize = 16;
+
+  struct Event {
+    DateTime time;
+    const uint8_t* data;
+    size_t length;
+  };
+
+  using Visitor = std::function<void(const Event& event)>;
+
+  /**
+   * @param storage The memory holding the log.
+   * @param address The start of the log's region in |storage|.
+   * @param size The size of the region. Only whole blocks are used, and
+   *             there must be at least two.
+   */
+  EventLog(ByteStorage* storage, uint16_t address, uint16_t size);
+
+  /**
+   * Use the whole of |storage|.
+   */
+  explicit EventLog(ByteStorage* storage);
+
+  /**
+   * Find the newest event.
+   *
+   * @return True if successful, false upon I2C error or a bad region.
+   */
+  bool begin();
+
+  /**
+   * Append an event.
+   *
+   * @param time The event's time, typically from DS3231::now().
+   * @param data The payload.
+   * @param length The payload's length, at most kMaxPayloadSize.
+   * @return True if successful, false upon I2C error.
+   */
+  bool append(const DateTime& time, const void* data, size_t length);
+
+  /**
+   * Visit all events, oldest first.
+   *
+   * @return True if successful, false upon I2C error.
+   */
+  bool forEach(const Visitor& visitor);
+
+  /**
+   * Erase all events.
+   *
+   * @return True if successful, false upon I2C error.
+   */
+  bool clear();
+
+  /**
+   * Is the log empty?
+   */
+  bool empty() const { return empty_; }
+
+ private:
+  bool readHeader(size_t block, uint8_t* header);
+  bool findEnd();
+
+  ByteStorage* storage_;
+  const uint16_t address_;
+  const size_t num_blocks_;
+  bool loaded_ = false;
+  bool empty_ = true;
+  size_t head_ = 0;         // The newest block.
+  uint16_t head_seq_ = 0;   // Its sequence number.
+  uint8_t head_crc_ = 0;    // Its header's CRC.
+  size_t head_end_ = 0;     // The offset of its end marker.
+  uint32_t last_time_ = 0;  // Of the newest event.
+};
+
+}  // namespace rtc
+
+#endif  // RTC_EVENT_LOG_H_
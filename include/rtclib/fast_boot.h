@@ -0,0 +1,88 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_FAST_BOOT_H_
+#define RTC_FAST_BOOT_H_
+
+#include <cstdint>
+
+#include "rtclib/sync_state.h"
+
+namespace rtc {
+
+class ByteStorage;
+class DS1307;
+class DS3231;
+class SoftwareClock;
+
+/**
+ * Start a SoftwareClock, such as Micros', at boot from an RTC and a saved
+ * SyncState, replacing the usual begin(), lostPower(), now() and
+ * Micros::begin() round trips.
+ *
+ * The clock is started with the RTC time and the saved drift correction,
+ * so it runs at its learned rate from the start. To also resume
+ * disciplining it without relearning, pass the drift to
+ * ClockDiscipline::restore(), which then owns the clock's drift from
+ * there on. Save the state (with SyncStateStore) after each
+ * synchronization.
+ */
+class FastBoot {
+ public:
+  enum class Status {
+    Restored,     // Time and sync state restored.
+    NoSyncState,  // Time restored. No sync state was saved.
+    LostPower,    // The RTC lost power, so the clock was not set. Any
+                  // saved sync state was restored.
+  };
+
+  /**
+   * Boot from a DS1307 with the state saved in its NVRAM. The time, the
+   * clock halt bit and the state are read in one transaction.
+   *
+   * @param rtc The RTC.
+   * @param nvram_address The state's NVRAM address (see DS1307Nvram).
+   * @param clock The clock to start, e.g. Micros::softwareClock().
+   * @param state Set to the saved state, if any.
+   * @param status Set to the outcome.
+   * @return True if successful, false upon I2C error.
+   */
+  static bool restore(DS1307* rtc,
+                      uint8_t nvram_address,
+                      SoftwareClock* clock,
+                      SyncState* state,
+                      Status* status);
+
+  /**
+   * Boot from a DS3231 with the state saved in other storage, such as the
+   * module's AT24C32.
+   *
+   * The clock is started after the first transaction (time, oscillator
+   * stop flag and aging offset), and its rate set after the second (the
+   * state).
+   * Changing the rate does not step the clock. If the DS3231 lost power
+   * its aging offset was reset, and the saved calibration is written back.
+   *
+   * @param rtc The RTC.
+   * @param storage The memory holding the state.
+   * @param address The state's address in |storage|.
+   * @param clock The clock to start, e.g. Micros::softwareClock().
+   * @param state Set to the saved state, if any.
+   * @param status Set to the outcome.
+   * @return True if successful, false upon I2C error.
+   */
+  static bool restore(DS3231* rtc,
+                      ByteStorage* storage,
+                      uint16_t address,
+                      SoftwareClock* clock,
+                      SyncState* state,
+                      Status* status);
+};
+
+}  // namespace rtc
+
+#endif  // RTC_FAST_BOOT_H_
@@ -0,0 +1,123 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_I2C_RETRIER_H_
+#define RTC_I2C_RETRIER_H_
+
+#include <cstdint>
+#include <functional>
+
+#include <i2clib/master.h>
+
+namespace rtc {
+
+/**
+ * Retries a device's failed I2C operations, with exponential backoff and
+ * bus recovery.
+ *
+ * A failed attempt is diagnosed by pinging the device. If it acknowledges
+ * its address the failure was transient (e.g. a data byte NACKed by bus
+ * noise), and the operation is retried after a backoff which doubles with
+ * each attempt. If not, the bus may be stuck, with a slave holding SDA low,
+ * so the bus clear hook (if any) is run and the device pinged again.
+ * Should it still not respond, it is taken to be absent and the operation
+ * fails without further attempts, sparing the slow retries.
+ *
+ * Usage:
+ *
+ *     I2CRetrier retrier(i2c::Master(port, mutex), 0x68);  // A DS3231.
+ *     DateTime now;
+ *     if (!retrier.run([&] { return rtc.now(&now); }))
+ *       ...
+ *
+ * The operation should be idempotent, as it may partially succeed before
+ * failing. Not thread safe.
+ */
+class I2CRetrier {
+ public:
+  struct Config {
+    /**
+     * Attempts per operation, including the first.
+     */
+    int max_attempts = 3;
+
+    /**
+     * Wait before the first retry (µs). Doubled for each further retry.
+     */
+    int64_t initial_backoff = 500;
+
+    /**
+     * Longest wait before a retry (µs).
+     */
+    int64_t max_backoff = 8000;
+
+    /**
+     * Free a stuck bus, e.g. by clocking SCL nine times and sending a STOP,
+     * returning false if that failed. Optional.
+     */
+    std::function<bool()> bus_clear;
+  };
+
+  /**
+   * The diagnosis of the most recent failure.
+   */
+  enum class Fault {
+    None,       // The last operation succeeded.
+    Transient,  // The device acknowledged its address.
+    Absent,     // The device did not respond, even after a bus clear.
+  };
+
+  struct Metrics {
+    uint32_t operations = 0;  // Operations run.
+    uint32_t failures = 0;    // Operations failed after all attempts.
+    uint32_t attempts = 0;    // Attempts, including retries.
+    uint32_t retries = 0;     // Attempts after the first.
+    uint32_t transient = 0;   // Attempts failed with the device present.
+    uint32_t absent = 0;      // Attempts failed with the device absent.
+    uint32_t recoveries = 0;  // Bus clears after which the device replied.
+
+    /**
+     * The fraction of attempts which failed.
+     */
+    float errorRate() const;
+  };
+
+  using Operation = std::function<bool()>;
+
+  /**
+   * @param i2c The bus, used to ping the device.
+   * @param address The device's I2C address.
+   */
+  I2CRetrier(i2c::Master i2c, uint8_t address, const Config& config);
+  I2CRetrier(i2c::Master i2c, uint8_t address);
+
+  /**
+   * Run |op|, retrying it if it fails.
+   *
+   * @return True if an attempt succeeded.
+   */
+  bool run(const Operation& op);
+
+  Fault lastFault() const { return last_fault_; }
+
+  const Metrics& metrics() const { return metrics_; }
+
+  void resetMetrics() { metrics_ = Metrics(); }
+
+ private:
+  Fault diagnose();
+
+  i2c::Master i2c_;
+  const uint8_t address_;
+  const Config config_;
+  Fault last_fault_ = Fault::None;
+  Metrics metrics_;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_I2C_RETRIER_H_
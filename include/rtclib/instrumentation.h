@@ -0,0 +1,109 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_INSTRUMENTATION_H_
+#define RTC_INSTRUMENTATION_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rtc {
+
+/**
+ * Counters for one driver operation, e.g. DS3231 "now".
+ *
+ * Latencies are bucketed by powers of two: bucket 0 counts operations
+ * taking under 2 µs, bucket i (i > 0) those taking [2^i, 2^(i+1)) µs, and
+ * the last bucket everything longer.
+ */
+struct OpStats {
+  static constexpr size_t kNumBuckets = 20;
+
+  uint8_t address = 0;         // The device's I2C address.
+  const char* name = nullptr;  // The operation's name.
+  uint32_t calls = 0;          // Number of transactions.
+  uint32_t failures = 0;       // Number of failed transactions.
+  uint64_t bytes = 0;          // Bytes read or written.
+  uint64_t total_micros = 0;   // Total time on the bus.
+  uint32_t max_micros = 0;     // The slowest transaction.
+  uint32_t histogram[kNumBuckets] = {};
+
+  /**
+   * The bucket counting operations which took |micros|.
+   */
+  static size_t bucket(int64_t micros);
+};
+
+/**
+ * Per-operation counters and latency histograms for all drivers.
+ *
+ * Only collected when built with RTC_INSTRUMENTATION defined. Otherwise
+ * all of these are empty inline functions, and the drivers' I2C calls are
+ * made directly, so instrumentation costs nothing.
+ *
+ * Operations are identified by device address and name: the name passed
+ * to CreateReadOp()/CreateWriteOp() for multi-byte transactions, or the
+ * driver method for single register accesses. Up to kMaxOps operations
+ * are tracked; any others are not recorded.
+ */
+class Instrumentation {
+ public:
+  static constexpr size_t kMaxOps = 64;
+
+  /**
+   * True if built with RTC_INSTRUMENTATION.
+   */
+  static constexpr bool enabled() {
+#if defined(RTC_INSTRUMENTATION)
+    return true;
+#else
+    return false;
+#endif
+  }
+
+#if defined(RTC_INSTRUMENTATION)
+  /**
+   * Copy the counters of up to |max_stats| operations, in the order first
+   * recorded.
+   *
+   * @return The number of operations copied.
+   */
+  static size_t snapshot(OpStats* stats, size_t max_stats);
+
+  /**
+   * Forget all counters.
+   */
+  static void reset();
+
+  /**
+   * Record one transaction.
+   *
+   * @param address The device's I2C address.
+   * @param name The operation's name. Must outlive the counters.
+   * @param success True if the transaction succeeded.
+   * @param bytes The number of data bytes read or written.
+   * @param micros How long the transaction took.
+   */
+  static void record(uint8_t address,
+                     const char* name,
+                     bool success,
+                     size_t bytes,
+                     int64_t micros);
+#else
+  static size_t snapshot(OpStats* stats, size_t max_stats) { return 0; }
+  static void reset() {}
+  static void record(uint8_t address,
+                     const char* name,
+                     bool success,
+                     size_t bytes,
+                     int64_t micros) {}
+#endif
+};
+
+}  // namespace rtc
+
+#endif  // RTC_INSTRUMENTATION_H_
@@ -0,0 +1,97 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_INTERRUPT_SOURCE_H_
+#define RTC_INTERRUPT_SOURCE_H_
+
+#include <cstdint>
+
+#if defined(ESP_PLATFORM)
+#include <driver/gpio.h>
+#endif
+
+namespace rtc {
+
+/**
+ * A source of interrupts from an RTC's INT/SQW output.
+ *
+ * The default source on ESP-IDF is a GPIO. Other sources can be injected,
+ * e.g. to drive interrupt handling from a test.
+ */
+class InterruptSource {
+ public:
+  /**
+   * An interrupt service routine. Called in interrupt context: it must not
+   * block, allocate or use I2C.
+   */
+  using Isr = void (*)(void* arg);
+
+  virtual ~InterruptSource() = default;
+
+  /**
+   * Call |isr| with |arg| on each interrupt, replacing any attached ISR.
+   *
+   * @return True if successful, false if not.
+   */
+  virtual bool attach(Isr isr, void* arg) = 0;
+
+  /**
+   * Stop calling the attached ISR.
+   */
+  virtual void detach() = 0;
+};
+
+/**
+ * An interrupt source which interrupts when told to.
+ */
+class ManualInterruptSource : public InterruptSource {
+ public:
+  bool attach(Isr isr, void* arg) override;
+  void detach() override;
+
+  /**
+   * Raise an interrupt: the attached ISR is called in the caller's context.
+   */
+  void trigger() const;
+
+ private:
+  Isr isr_ = nullptr;
+  void* arg_ = nullptr;
+};
+
+#if defined(ESP_PLATFORM)
+
+/**
+ * Interrupts on the falling edge of a GPIO, connected to an RTC's
+ * active-low, open-drain INT/SQW output.
+ *
+ * The GPIO ISR service must already be installed with
+ * gpio_install_isr_service().
+ */
+class GpioInterruptSource : public InterruptSource {
+ public:
+  /**
+   * @param pin The GPIO connected to INT/SQW.
+   * @param pullup Enable the internal pull-up, if there is no external one.
+   */
+  explicit GpioInterruptSource(gpio_num_t pin, bool pullup = true);
+  ~GpioInterruptSource() override;
+
+  bool attach(Isr isr, void* arg) override;
+  void detach() override;
+
+ private:
+  const gpio_num_t pin_;
+  const bool pullup_;
+  bool attached_ = false;
+};
+
+#endif  // defined(ESP_PLATFORM)
+
+}  // namespace rtc
+
+#endif  // RTC_INTERRUPT_SOURCE_H_
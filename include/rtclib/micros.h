@@ -14,6 +14,7 @@
 #include <cstdint>
 
 #include "rtclib/datetime.h"
+#include "rtclib/software_clock.h"
 
 namespace rtc {
 
@@ -21,8 +22,12 @@ namespace rtc {
  * RTC using the internal micros() clock, has to be initialized before use.
  *
  * Unlike Millis, this can be tuned in order to compensate for the natural
- * drift of the system clock. Note that now() has to be called more frequently
- * than the micros() rollover period, which is approximately 71.6 minutes.
+ * drift of the system clock. The rate is kept in 32.32 fixed-point, giving
+ * a resolution well below 1 ppb, and changing it never steps the clock:
+ * time continues from its current value at the new rate.
+ *
+ * This is a process-wide SoftwareClock driven by the SystemClock. Use
+ * SoftwareClock directly for independent timebases.
  */
 class Micros {
  public:
@@ -48,6 +53,20 @@ class Micros {
    */
   static void adjustDrift(int ppm);
 
+  /**
+   * Adjust the RTC_Micros clock to compensate for system clock drift, with
+   * parts per billion resolution.
+   *
+   * @param ppb Adjustment to make. A positive adjustment makes the clock
+   * faster.
+   */
+  static void adjustDriftPpb(int32_t ppb);
+
+  /**
+   * The current drift adjustment, in parts per billion.
+   */
+  static int32_t driftPpb();
+
   /**
    * Get the current date/time from the RTC_Micros clock.
    *
@@ -55,13 +74,21 @@ class Micros {
    */
   static DateTime now();
 
+  /**
+   * Get the current time with microsecond resolution.
+   *
+   * @return Microseconds since 1970-01-01.
+   */
+  static int64_t nowMicros();
+
+  /**
+   * The underlying clock, to pass to ClockDiscipline, TemperatureCompensator
+   * or FastBoot.
+   */
+  static SoftwareClock* softwareClock() { return &clock; }
+
  protected:
-  static uint32_t microsPerSecond;  ///< Number of microseconds reported by
-                                    ///< micros() per "true" (calibrated) second
-  static uint32_t lastUnix;    ///< Unix time from the previous call to now() -
-                               ///< prevents rollover issues
-  static uint32_t lastMicros;  ///< micros() value corresponding to the last
-                               ///< full second of Unix time
+  static SoftwareClock clock;  ///< The process-wide clock.
 };
 
 }  // namespace rtc
@@ -20,7 +20,11 @@ namespace rtc {
 /**
  * RTC using the internal millis() clock, has to be initialized before  use.
  *
- * NOTE: this is immune to millis() rollover events.
+ * NOTE: this is immune to millis() rollover events, and there is no
+ * requirement on how often now() is called. It counts
+ * SystemClock::millisSinceStart(), so now() needs no 64-bit division. Use
+ * Micros, or SoftwareClock directly, for drift adjustment or independent
+ * timebases.
  */
 class Millis {
  public:
@@ -41,18 +45,13 @@ class Millis {
   /**
    *  Return a DateTime object containing the current date/time.
    *
-   * Note that computing (millis() - lastMillis) is rollover-safe as
-   * long as this method is called at least once every 49.7 days.
-   *
    * @return DateTime object containing current time
    */
   static DateTime now();
 
  protected:
-  static uint32_t lastUnix;    ///< Unix time from the previous call to now() -
-                               ///< prevents rollover issues
-  static uint32_t lastMillis;  ///< the millis() value corresponding to the last
-                               ///< **full second** of Unix time
+  static int64_t anchorMillis;  ///< millisSinceStart() when last adjusted.
+  static uint32_t anchorUnix;   ///< Unix time when last adjusted.
 };
 
 }  // namespace rtc
@@ -0,0 +1,163 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_NVRAM_STORE_H_
+#define RTC_NVRAM_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rtc {
+
+class ByteStorage;
+
+/**
+ * A small log-structured key-value store, e.g. in the DS1307's 56 bytes of
+ * NVRAM (see DS1307Nvram).
+ *
+ * Values are appended as CRC-protected records to a ring buffer, and never
+ * overwritten in place:
+ *
+ *     header: [head] [~head]
+ *     record: [key] [sequence] [length] [value...] [CRC-8]
+ *
+ * An update writes only its new record, of four bytes plus the value, in
+ * one burst (two if it wraps around the ring). The header, which locates
+ * the oldest record, is rewritten only when space is reclaimed: the oldest
+ * record is then dropped if superseded, or copied to the end of the log if
+ * still current. Writes therefore rotate through the whole region.
+ *
+ * A torn write leaves at worst a record which fails its CRC, and the
+ * previous value is recovered. On begin() the whole region is read in one
+ * burst into a RAM mirror, from which all reads are served.
+ *
+ * The region may be at most kMaxSize bytes. To always be able to copy the
+ * oldest record, free space for the largest record is kept in reserve.
+ */
+class NvramStore {
+ public:
+  /**
+   * The largest region, in bytes.
+   */
+  static constexpr size_t kMaxSize = 64;
+
+  /**
+   * The largest value, in bytes.
+   */
+  static constexpr size_t kMaxValueSize = 16;
+
+  /**
+   * @param storage The memory holding the store.
+   * @param address The start of the store's region in |storage|.
+   * @param size The size of the region, at most kMaxSize.
+   */
+  NvramStore(ByteStorage* storage, uint16_t address, uint16_t size);
+
+  /**
+   * Use the whole of |storage|, which must be at most kMaxSize bytes.
+   */
+  explicit NvramStore(ByteStorage* storage);
+
+  /**
+   * Load the store, formatting it if no valid log is found.
+   *
+   * @return True if successful, false upon I2C error or a bad region.
+   */
+  bool begin();
+
+  /**
+   * Erase all values.
+   *
+   * @return True if successful, false upon I2C error.
+   */
+  bool format();
+
+  /**
+   * Read a value from the RAM mirror.
+   *
+   * @param key The value's key.
+   * @param value Receives up to |size| bytes of the value.
+   * @param size The size of |value|.
+   * @param length Set to the value's length. May be nullptr.
+   * @return False if there is no value for |key|.
+   */
+  bool get(uint8_t key, void* value, size_t size, size_t* length) const;
+
+  /**
+   * Set a value. Nothing is written if the value is unchanged.
+   *
+   * @param key The value's key.
+   * @param value The value.
+   * @param length The value's length, at most kMaxValueSize.
+   * @return True if successful, false upon I2C error or if the store is
+   *         full.
+   */
+  bool put(uint8_t key, const void* value, size_t length);
+
+  /**
+   * Remove a value.
+   *
+   * @return True if successful (including if there was no value), false
+   *         upon I2C error or if the store is full.
+   */
+  bool remove(uint8_t key);
+
+  /**
+   * The number of keys with values.
+   */
+  size_t size() const { return num_keys_; }
+
+  /**
+   * The total number of bytes written to the storage since begin().
+   */
+  uint32_t bytesWritten() const { return bytes_written_; }
+
+ private:
+  static constexpr size_t kMaxRecords = kMaxSize / 4;
+
+  struct Entry {
+    uint8_t key;
+    uint8_t offset;  // Of the key's latest record in the ring.
+  };
+
+  uint8_t& ring(size_t offset);
+  uint8_t ring(size_t offset) const;
+  uint8_t recordCrc(size_t offset) const;
+  size_t recordSize(size_t offset) const;
+  bool validRecord(size_t offset) const;
+  size_t chainBytes(size_t head) const;
+  void parse(size_t head);
+  void apply(size_t offset);
+  const Entry* find(uint8_t key) const;
+  size_t liveBytes() const;
+  size_t largestLiveRecord() const;
+
+  bool load();
+  bool writeRing(size_t offset, size_t length);
+  bool writeHeader();
+  bool append(uint8_t key, const uint8_t* value, uint8_t length);
+  bool appendRecord(uint8_t key, const uint8_t* value, uint8_t length);
+  bool reclaimHead();
+
+  ByteStorage* storage_;
+  const uint16_t address_;
+  const uint16_t size_;
+  size_t ring_size_ = 0;
+  bool loaded_ = false;  // The mirror matches the storage.
+  uint8_t mirror_[kMaxSize];
+  Entry index_[kMaxRecords];
+  size_t num_keys_ = 0;
+  size_t head_ = 0;  // Offset of the oldest record.
+  size_t used_ = 0;  // Bytes of records from the head.
+  size_t tombstone_bytes_ = 0;
+  uint8_t next_seq_ = 0;
+  uint32_t bytes_written_ = 0;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_NVRAM_STORE_H_
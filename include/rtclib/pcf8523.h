@@ -11,6 +11,7 @@
 #ifndef RTC_PCF8523_H_
 #define RTC_PCF8523_H_
 
+#include <cstddef>
 #include <cstdint>
 
 #include <i2clib/master.h>
@@ -42,6 +43,12 @@ enum PCF8523TimerIntPulse {
   PCF8523_LowPulse14x64Hz = 7  /**< 218.750 ms  14/64ths second */
 };
 
+/** PCF8523 countdown timers */
+enum PCF8523Timer {
+  PCF8523_TimerA = 0, /**< Countdown timer A */
+  PCF8523_TimerB = 1, /**< Countdown timer B */
+};
+
 /** PCF8523 Offset modes for making temperature/aging/accuracy adjustments */
 enum Pcf8523OffsetMode {
   PCF8523_TwoHours = 0x00, /**< Offset made every two hours */
@@ -67,6 +74,11 @@ class PCF8523 {
     Rate32kHz,
   };
 
+  /**
+   * The number of registers, for dumpRegisters().
+   */
+  static constexpr size_t kNumRegisters = 0x14;
+
   PCF8523(i2c::Master i2c);
 
   /**
@@ -113,6 +125,15 @@ class PCF8523 {
    */
   bool now(DateTime* dt);
 
+  /**
+   * Read just the seconds, in a one byte transaction: a cheap way to find
+   * when they roll over (see RtcTimestamper).
+   *
+   * @param seconds Set to the seconds, 0 to 59.
+   * @return True if successful, false if not.
+   */
+  bool readSeconds(uint8_t* seconds);
+
   /**
    * Resets the STOP bit in register Control_1.
    *
@@ -216,6 +237,50 @@ class PCF8523 {
    */
   bool disableCountdownTimer();
 
+  /**
+   * Start a countdown on either timer, with a level interrupt.
+   *
+   * Unlike enableCountdownTimer() the interrupt stays asserted until the
+   * timer's flag is cleared (see readAndClearCountdownFlags()), and timers A
+   * and B can run independently. The timer is stopped and its flag cleared
+   * before the new countdown is loaded. The CLKOUT square wave is disabled,
+   * as it shares a pin with the interrupt.
+   *
+   * Note that the timer's source clock runs freely, so the first of the
+   * |numPeriods| periods is shortened by up to one period: the countdown
+   * lasts between numPeriods - 1 and numPeriods periods.
+   *
+   * The timer repeats until stopped with stopCountdownTimer().
+   *
+   * @param timer The timer to start.
+   * @param clkFreq The timer source clock frequency.
+   * @param numPeriods The number of clkFreq periods (1-255) to count down.
+   * @return True if successful, false if not.
+   */
+  bool startCountdownTimer(PCF8523Timer timer,
+                           PCF8523TimerClockFreq clkFreq,
+                           uint8_t numPeriods);
+
+  /**
+   * Stop a countdown timer. Its flag is left unchanged.
+   *
+   * @param timer The timer to stop.
+   * @return True if successful, false if not.
+   */
+  bool stopCountdownTimer(PCF8523Timer timer);
+
+  /**
+   * Read, and then clear, the countdown timer A and B flags (CTAF, CTBF).
+   *
+   * Both flags are read and cleared in one I2C transaction. Other flags in
+   * Control_2 are not affected.
+   *
+   * @param timer_a Set to true if timer A has expired.
+   * @param timer_b Set to true if timer B has expired.
+   * @return True if successful, false if not.
+   */
+  bool readAndClearCountdownFlags(bool* timer_a, bool* timer_b);
+
   /**
    * Stop all timers, clear their flags and settings on the PCF8523.
    *
@@ -258,6 +323,38 @@ class PCF8523 {
    */
   bool calibrate(Pcf8523OffsetMode mode, int8_t offset);
 
+  /**
+   * Read the current contents of the offset register.
+   *
+   * @param mode Location to write the correction mode.
+   * @param offset Location to write the correction amount (-64 to +63).
+   * @return True if successful, false if not.
+   */
+  bool getOffset(Pcf8523OffsetMode* mode, int8_t* offset);
+
+  /**
+   * Read the whole register file in one transaction.
+   *
+   * @param values Set to the kNumRegisters register values.
+   * @return True if successful, false if not.
+   */
+  bool dumpRegisters(uint8_t* values);
+
+  /**
+   * Restore the configuration from dumpRegisters(), e.g. a golden
+   * configuration, in one write transaction, and read it back to verify.
+   *
+   * Only configuration bits are written (see PCF8523Registers::kRestore).
+   * The time, flags and read-only bits are left unchanged: set the time
+   * with adjust(). A running countdown timer is started by a second write,
+   * once loaded, from the count which remained when dumped.
+   *
+   * @param values kNumRegisters register values.
+   * @return True if successful, false upon I2C error or if the chip did not
+   *         read back the configuration.
+   */
+  bool restoreRegisters(const uint8_t* values);
+
  private:
   i2c::Master i2c_;
 };
@@ -0,0 +1,180 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_PCF8523_CALIBRATOR_H_
+#define RTC_PCF8523_CALIBRATOR_H_
+
+#include <cstdint>
+
+#include "rtclib/constants.h"
+#include "rtclib/pcf8523.h"
+
+namespace rtc {
+
+class DateTime;
+
+/**
+ * The persisted state of a PCF8523Calibrator.
+ *
+ * The measurement window is the pair of (reference, RTC) times captured
+ * when the current offset register value was programmed.
+ */
+struct PCF8523Calibration {
+  uint32_t reference_start;  ///< Reference unixtime at start of the window.
+  uint32_t rtc_start;        ///< RTC unixtime at start of the window.
+  Pcf8523OffsetMode mode;    ///< Offset mode programmed into the RTC.
+  int8_t offset;             ///< Offset value programmed into the RTC.
+};
+
+/**
+ * Automatic calibration of the PCF8523 offset register.
+ *
+ * Measures the drift of a PCF8523 against a reference time source (NTP,
+ * GPS, a host, ...) and programs the offset register to compensate. The
+ * measurement continues after calibration, and the chip is recalibrated
+ * whenever the residual drift exceeds the configured threshold.
+ *
+ * Because the RTC only has a 1 second resolution the precision of a
+ * measurement is roughly 2 seconds divided by the window length; a window
+ * of a few days is required to resolve the ~4 ppm offset register unit.
+ *
+ * Typical use:
+ *
+ *     PCF8523Calibrator calibrator(&rtc, &store);
+ *     calibrator.begin(reference_now);
+ *     ...
+ *     // Whenever a reference time is available (e.g. after an NTP sync):
+ *     calibrator.update(reference_now);
+ */
+class PCF8523Calibrator {
+ public:
+  /**
+   * Persistent storage for the calibration state, so that the measurement
+   * window survives a reboot.
+   */
+  class Store {
+   public:
+    virtual ~Store() = default;
+
+    /**
+     * @return True if a previously saved calibration was loaded.
+     */
+    virtual bool load(PCF8523Calibration* calibration) = 0;
+
+    /**
+     * @return True if the calibration was saved.
+     */
+    virtual bool save(const PCF8523Calibration& calibration) = 0;
+  };
+
+  struct Config {
+    /**
+     * Recalibrate when the measured drift exceeds this (in ppm).
+     */
+    float threshold_ppm = 3.0f;
+
+    /**
+     * Minimum measurement window before drift is evaluated (seconds).
+     */
+    uint32_t min_interval = SECONDS_PER_DAY;
+
+    /**
+     * A window which stays within threshold is restarted after this many
+     * seconds so that slow changes (e.g. crystal aging) are tracked.
+     */
+    uint32_t max_interval = 30 * SECONDS_PER_DAY;
+  };
+
+  /**
+   * @param rtc The RTC to calibrate.
+   * @param store Calibration storage, may be null.
+   * @param config Calibration parameters.
+   */
+  PCF8523Calibrator(PCF8523* rtc, Store* store, const Config& config);
+
+  /**
+   * Create a calibrator using the default configuration.
+   *
+   * @param rtc The RTC to calibrate.
+   * @param store Calibration storage, may be null.
+   */
+  PCF8523Calibrator(PCF8523* rtc, Store* store);
+
+  /**
+   * Restore the persisted measurement window, or start a new one.
+   *
+   * A persisted window is only resumed if the RTC's offset register still
+   * matches the persisted calibration.
+   *
+   * @param reference The current reference time.
+   * @return True if successful, false upon I2C error.
+   */
+  bool begin(const DateTime& reference);
+
+  /**
+   * Measure the drift against the reference time, and recalibrate the RTC
+   * if necessary.
+   *
+   * @param reference The current reference time.
+   * @return True if successful, false upon I2C error.
+   */
+  bool update(const DateTime& reference);
+
+  /**
+   * The current calibration state.
+   */
+  const PCF8523Calibration& calibration() const { return calibration_; }
+
+  /**
+   * The residual drift of the RTC measured by the last call to update(), in
+   * ppm. Positive values mean the RTC is running fast.
+   */
+  float measuredPpm() const { return measured_ppm_; }
+
+  /**
+   * The uncertainty of measuredPpm() due to the RTC's 1 second resolution.
+   */
+  float uncertaintyPpm() const { return uncertainty_ppm_; }
+
+  /**
+   * The number of times the offset register has been reprogrammed.
+   */
+  uint32_t calibrations() const { return calibrations_; }
+
+  /**
+   * Select the offset mode and value which best correct a drift.
+   *
+   * The two hour mode is preferred, being the more energy-efficient, unless
+   * the one minute mode gives a smaller residual error.
+   *
+   * @param ppm The uncorrected drift of the crystal. Positive values mean
+   *            the crystal is fast.
+   * @param mode Location to write the selected mode.
+   * @param offset Location to write the selected offset.
+   */
+  static void selectOffset(float ppm, Pcf8523OffsetMode* mode, int8_t* offset);
+
+  /**
+   * The correction, in ppm, made by an offset register value.
+   */
+  static float offsetToPpm(Pcf8523OffsetMode mode, int8_t offset);
+
+ private:
+  bool startWindow(uint32_t reference);
+
+  PCF8523* rtc_;
+  Store* store_;
+  const Config config_;
+  PCF8523Calibration calibration_;
+  float measured_ppm_ = 0;
+  float uncertainty_ppm_ = 0;
+  uint32_t calibrations_ = 0;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_PCF8523_CALIBRATOR_H_
@@ -0,0 +1,125 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_PCF8523_REGISTERS_H_
+#define RTC_PCF8523_REGISTERS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <rtclib/pcf8523.h>
+#include <rtclib/register_map.h>
+
+namespace rtc {
+
+/**
+ * The PCF8523 register map. See the datasheet, section 8.1.
+ */
+struct PCF8523Registers {
+  static constexpr uint8_t kI2CAddress = 0x68;
+
+  // clang-format off
+  static constexpr uint8_t kControl1      = 0x00;
+  static constexpr uint8_t kControl2      = 0x01;
+  static constexpr uint8_t kControl3      = 0x02;
+  static constexpr uint8_t kSeconds       = 0x03;
+  static constexpr uint8_t kMinutes       = 0x04;
+  static constexpr uint8_t kHours         = 0x05;
+  static constexpr uint8_t kDays          = 0x06;
+  static constexpr uint8_t kWeekdays      = 0x07;
+  static constexpr uint8_t kMonths        = 0x08;
+  static constexpr uint8_t kYears         = 0x09;
+  static constexpr uint8_t kMinuteAlarm   = 0x0A;
+  static constexpr uint8_t kOffset        = 0x0E;
+  static constexpr uint8_t kTmrClkout     = 0x0F;
+  static constexpr uint8_t kTmrAFreq      = 0x10;
+  static constexpr uint8_t kTmrA          = 0x11;
+  static constexpr uint8_t kTmrBFreq      = 0x12;
+  static constexpr uint8_t kTmrB          = 0x13;
+  static constexpr size_t  kNumRegisters  = PCF8523::kNumRegisters;
+
+  // Control_1.
+  using STOP = RegisterField<kControl1, 5>;  // Stop the clock.
+  using SIE  = RegisterField<kControl1, 2>;  // Second interrupt enable.
+
+  // Control_2. The flags are cleared by writing zero.
+  using Flags = RegisterField<kControl2, 3, 5>;  // All flags.
+  using CTAF  = RegisterField<kControl2, 6>;     // Countdown timer A flag.
+  using CTBF  = RegisterField<kControl2, 5>;     // Countdown timer B flag.
+  using CTAIE = RegisterField<kControl2, 1>;     // Timer A interrupt enable.
+  using CTBIE = RegisterField<kControl2, 0>;     // Timer B interrupt enable.
+
+  // Control_3.
+  using PM = RegisterField<kControl3, 5, 3>;  // Power management.
+
+  using OS      = RegisterField<kSeconds, 7>;     // Oscillator stopped.
+  using Seconds = RegisterField<kSeconds, 0, 7>;  // BCD.
+
+  // Offset.
+  using MODE   = RegisterField<kOffset, 7>;     // Offset mode.
+  using OFFSET = RegisterField<kOffset, 0, 7>;  // Two's complement offset.
+
+  // Tmr_CLKOUT_ctrl.
+  using TAM = RegisterField<kTmrClkout, 7>;     // Timer A pulsed interrupt.
+  using TBM = RegisterField<kTmrClkout, 6>;     // Timer B pulsed interrupt.
+  using COF = RegisterField<kTmrClkout, 3, 3>;  // CLKOUT frequency.
+  using TAC = RegisterField<kTmrClkout, 1, 2>;  // Timer A control.
+  using TBC = RegisterField<kTmrClkout, 0>;     // Timer B enabled.
+  // clang-format on
+
+  /**
+   * PM with battery switch-over and low detection disabled: the power-on
+   * reset value.
+   */
+  static constexpr uint8_t kPmStandby = 0b111;
+
+  /**
+   * TAC with timer A as a countdown timer.
+   */
+  static constexpr uint8_t kTacCountdown = 0b01;
+
+  /**
+   * COF encodings.
+   */
+  static constexpr FieldValue<PCF8523::SqwPinMode> kSqwPinModes[] = {
+      {PCF8523::SqwPinMode::Off, 0b111},
+      {PCF8523::SqwPinMode::Rate1Hz, 0b110},
+      {PCF8523::SqwPinMode::Rate32Hz, 0b101},
+      {PCF8523::SqwPinMode::Rate1kHz, 0b100},
+      {PCF8523::SqwPinMode::Rate4kHz, 0b011},
+      {PCF8523::SqwPinMode::Rate8kHz, 0b010},
+      {PCF8523::SqwPinMode::Rate16kHz, 0b001},
+      {PCF8523::SqwPinMode::Rate32kHz, 0b000},
+  };
+
+  /**
+   * Restored configuration: the control bits, alarms, offset and timers.
+   * The timer value registers read back the count remaining, so a running
+   * timer restarts from what was left of its countdown when dumped.
+   */
+  static constexpr RegisterRestore kRestore[kNumRegisters] = {
+      {0xAF},                // Control_1, but T and SR.
+      {0x07, Flags::kMask},  // Control_2.
+      {0xE3, 0x08},          // Control_3, but BLF. BSF is a flag.
+      // Time.
+      {}, {}, {}, {}, {}, {}, {},
+      // Alarms.
+      {0xFF}, {0xFF}, {0xFF}, {0xFF},
+      {0xFF},  // Offset.
+      // Tmr_CLKOUT_ctrl. The timers start once loaded.
+      {0xFF, 0, false, TAC::kMask | TBC::kMask},
+      {0x07}, {0xFF, 0, true},  // Timer A.
+      {0x77}, {0xFF, 0, true},  // Timer B.
+  };
+};
+
+static_assert(encodingsOrdered(PCF8523Registers::kSqwPinModes),
+              "Encodings out of order");
+
+}  // namespace rtc
+
+#endif  // RTC_PCF8523_REGISTERS_H_
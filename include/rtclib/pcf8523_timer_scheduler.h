@@ -0,0 +1,132 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_PCF8523_TIMER_SCHEDULER_H_
+#define RTC_PCF8523_TIMER_SCHEDULER_H_
+
+#include <cstdint>
+#include <functional>
+
+#include "rtclib/pcf8523.h"
+
+namespace rtc {
+
+class TickSource;
+
+/**
+ * A high resolution one-shot wakeup using the PCF8523's countdown timers.
+ *
+ * A single countdown is either fine or long: 4.096 kHz periods reach only
+ * 62 ms, while hour periods reach 10 days. Worse, a timer's source clock
+ * runs freely, so the first period of a countdown is shortened by an
+ * unknown amount of up to one whole period.
+ *
+ * The scheduler therefore reaches a deadline in a cascade of stages. Each
+ * stage uses the finest source clock whose 255 periods cover the remaining
+ * time, and counts down no further than the deadline. When a stage
+ * expires the remaining time is measured with the MCU's tick source, and
+ * the next, finer, stage is started. Each stage leaves less than one of
+ * its periods (less than two for a stage limited to 255 periods) for the
+ * next, so a deadline days away takes about five stages. The last stage is
+ * at 4.096 kHz, and centered on the deadline: the deadline is met to within
+ * one 244 µs period, plus the interrupt latency.
+ *
+ * Stages alternate between timers A and B, so that each stage starts on a
+ * stopped timer and its interrupt is unambiguous.
+ *
+ * The MCU only wakes for each stage. Connect the PCF8523's INT1 pin to an
+ * interrupt and call service() (outside of the ISR, as it uses I2C) when
+ * it is asserted. The tick source must keep counting while the MCU sleeps
+ * (e.g. the ESP32's esp_timer in light sleep).
+ *
+ * Only one deadline is scheduled at a time. This takes ownership of both
+ * countdown timers, and disables the CLKOUT square wave.
+ */
+class PCF8523TimerScheduler {
+ public:
+  using Callback = std::function<void()>;
+
+  /**
+   * @param rtc The RTC whose timers to use.
+   * @param ticks The time base of deadlines. nullptr for the SystemClock.
+   */
+  explicit PCF8523TimerScheduler(PCF8523* rtc,
+                                 const TickSource* ticks = nullptr);
+
+  /**
+   * Take ownership of the countdown timers, stopping both.
+   *
+   * @return True if successful, false upon I2C error.
+   */
+  bool begin();
+
+  /**
+   * Schedule |callback| to run at a deadline, replacing any scheduled one.
+   *
+   * A deadline which has already passed runs immediately, before this
+   * returns.
+   *
+   * @param deadline Time of the tick source (microseconds).
+   * @param callback Called from service() at the deadline.
+   * @return True if successful, false upon I2C error.
+   */
+  bool scheduleAt(int64_t deadline, Callback callback);
+
+  /**
+   * Schedule |callback| to run |delay| microseconds from now.
+   *
+   * @return True if successful, false upon I2C error.
+   */
+  bool scheduleIn(int64_t delay, Callback callback);
+
+  /**
+   * Cancel the scheduled deadline, if any.
+   *
+   * @return True if successful, false upon I2C error.
+   */
+  bool cancel();
+
+  /**
+   * Handle a timer interrupt: start the next stage, or run the callback if
+   * the deadline has been reached.
+   *
+   * @return True if successful, false upon I2C error.
+   */
+  bool service();
+
+  /**
+   * Is a deadline scheduled?
+   */
+  bool pending() const { return static_cast<bool>(callback_); }
+
+  /**
+   * The number of stages started for the current (or last) deadline.
+   */
+  uint32_t stages() const { return stages_; }
+
+ private:
+  int64_t micros() const;
+
+  /**
+   * Start the stage for the remaining time, or run the callback if there
+   * is none left.
+   */
+  bool startStage();
+
+  PCF8523* rtc_;
+  const TickSource* ticks_;
+  Callback callback_;
+  int64_t deadline_ = 0;
+  PCF8523Timer timer_ = PCF8523_TimerA;  // The running stage's timer.
+  bool running_ = false;                 // A stage is counting down.
+  bool final_stage_ = false;             // The last stage was at 4.096 kHz.
+  uint32_t stages_ = 0;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_PCF8523_TIMER_SCHEDULER_H_
@@ -11,6 +11,7 @@
 #ifndef RTC_PCF8563_H_
 #define RTC_PCF8563_H_
 
+#include <cstddef>
 #include <cstdint>
 
 #include <i2clib/master.h>
@@ -19,6 +20,16 @@ namespace rtc {
 
 class DateTime;
 
+/** PCF8563 Timer Source Clock Frequencies */
+enum PCF8563TimerClockFreq {
+  PCF8563_Frequency4kHz = 0,   /**< 1/4096th second = 244 microseconds,
+                                    max 62.256 milliseconds */
+  PCF8563_Frequency64Hz = 1,   /**< 1/64th second = 15.625 milliseconds,
+                                    max 3.984375 seconds */
+  PCF8563_FrequencySecond = 2, /**< 1 second, max 255 seconds = 4.25 minutes */
+  PCF8563_FrequencyMinute = 3, /**< 1 minute, max 255 minutes = 4.25 hours */
+};
+
 /**
  * RTC based on the PCF8563 chip connected via I2C.
  */
@@ -32,6 +43,24 @@ class PCF8563 {
     Rate32kHz  ///< 32kHz square wave.
   };
 
+  /**
+   * Alarm matching modes. The PCF8563 alarm has a resolution of one minute:
+   * it fires when the seconds are zero. There is no "every minute" mode, as
+   * the chip disables an alarm with no enabled fields: use the countdown
+   * timer instead.
+   */
+  enum class AlarmMode {
+    Minute,  ///< Alarm when minutes match.
+    Hour,    ///< Alarm when hours and minutes match.
+    Date,    ///< Alarm when date (day of month), hours and minutes match.
+    Day      ///< Alarm when day (day of week), hours and minutes match.
+  };
+
+  /**
+   * The number of registers, for dumpRegisters().
+   */
+  static constexpr size_t kNumRegisters = 0x10;
+
   PCF8563(i2c::Master i2c);
 
   /**
@@ -70,6 +99,15 @@ class PCF8563 {
    */
   bool now(DateTime* dt);
 
+  /**
+   * Read just the seconds, in a one byte transaction: a cheap way to find
+   * when they roll over (see RtcTimestamper).
+   *
+   * @param seconds Set to the seconds, 0 to 59.
+   * @return True if successful, false upon error.
+   */
+  bool readSeconds(uint8_t* seconds);
+
   /**
    * Resets the STOP bit in register Control_1.
    *
@@ -107,6 +145,113 @@ class PCF8563 {
    */
   bool writeSqwPinMode(SqwPinMode mode);
 
+  /**
+   * Set the alarm, and enable its interrupt on the INT pin.
+   *
+   * The alarm flag is cleared. The INT pin stays asserted from when the
+   * alarm fires until the flag is cleared with clearAlarm().
+   *
+   * @param dt DateTime object (seconds are ignored).
+   * @param alarm_mode Desired mode.
+   * @return True if successful, false if error.
+   */
+  bool setAlarm(const DateTime& dt, AlarmMode alarm_mode);
+
+  /**
+   * Disable the alarm and its interrupt. The alarm flag is not cleared.
+   *
+   * @return True if successful, false if error.
+   */
+  bool disableAlarm();
+
+  /**
+   * Clear the alarm flag.
+   *
+   * @return True if successful, false if error.
+   */
+  bool clearAlarm();
+
+  /**
+   * Get alarm status.
+   *
+   * @return True if the alarm has been fired, otherwise false.
+   */
+  bool isAlarmFired();
+
+  /**
+   * Enable the countdown timer, and its interrupt on the INT pin.
+   *
+   * The timer repeats every |numPeriods| periods until disabled. The timer
+   * flag is cleared. Note that the source clock runs freely, so the first
+   * countdown may be up to one period short.
+   *
+   * @param clkFreq The timer source clock frequency. See the
+   *                #PCF8563TimerClockFreq enum for options and associated
+   *                time ranges.
+   * @param numPeriods The number of clkFreq periods (1-255) to count down.
+   * @param pulse If true the INT pin pulses each time the timer expires.
+   *              Otherwise it stays asserted until the flag is cleared with
+   *              clearCountdownTimer().
+   * @return True if successful, false if error.
+   */
+  bool enableCountdownTimer(PCF8563TimerClockFreq clkFreq,
+                            uint8_t numPeriods,
+                            bool pulse);
+
+  /**
+   * Enable the countdown timer with a pulsed interrupt.
+   *
+   * @param clkFreq The timer source clock frequency.
+   * @param numPeriods The number of clkFreq periods (1-255) to count down.
+   * @return True if successful, false if error.
+   */
+  bool enableCountdownTimer(PCF8563TimerClockFreq clkFreq, uint8_t numPeriods);
+
+  /**
+   * Stop the countdown timer and disable its interrupt. The timer flag is
+   * not cleared.
+   *
+   * @return True if successful, false if error.
+   */
+  bool disableCountdownTimer();
+
+  /**
+   * Clear the countdown timer flag.
+   *
+   * @return True if successful, false if error.
+   */
+  bool clearCountdownTimer();
+
+  /**
+   * Get countdown timer status.
+   *
+   * @return True if the timer has expired, otherwise false.
+   */
+  bool isCountdownTimerFired();
+
+  /**
+   * Read the whole register file in one transaction.
+   *
+   * @param values Set to the kNumRegisters register values.
+   * @return True if successful, false if error.
+   */
+  bool dumpRegisters(uint8_t* values);
+
+  /**
+   * Restore the configuration from dumpRegisters(), e.g. a golden
+   * configuration, in one write transaction, and read it back to verify.
+   *
+   * Only configuration bits are written (see PCF8563Registers::kRestore).
+   * The time, flags and read-only bits are left unchanged: set the time
+   * with adjust(). A running countdown timer is started by a second write,
+   * once loaded, from the count which remained when dumped.
+   *
+   * @param values kNumRegisters register values.
+   * @return True if successful, false upon I2C error or if the chip did not
+   *         read back the configuration.
+   */
+  bool restoreRegisters(const uint8_t* values);
+
  private:
   i2c::Master i2c_;
 };
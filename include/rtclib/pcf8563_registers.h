@@ -0,0 +1,129 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_PCF8563_REGISTERS_H_
+#define RTC_PCF8563_REGISTERS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <rtclib/pcf8563.h>
+#include <rtclib/register_map.h>
+
+namespace rtc {
+
+/**
+ * The PCF8563 register map. See the datasheet, section 8.
+ */
+struct PCF8563Registers {
+  static constexpr uint8_t kI2CAddress = 0x51;
+
+  // clang-format off
+  static constexpr uint8_t kControl1      = 0x00;
+  static constexpr uint8_t kControl2      = 0x01;
+  static constexpr uint8_t kVLSeconds     = 0x02;
+  static constexpr uint8_t kMinutes       = 0x03;
+  static constexpr uint8_t kHours         = 0x04;
+  static constexpr uint8_t kDays          = 0x05;
+  static constexpr uint8_t kWeekdays      = 0x06;
+  static constexpr uint8_t kCenturyMonths = 0x07;
+  static constexpr uint8_t kYears         = 0x08;
+  static constexpr uint8_t kMinuteAlarm   = 0x09;
+  static constexpr uint8_t kHourAlarm     = 0x0A;
+  static constexpr uint8_t kDayAlarm      = 0x0B;
+  static constexpr uint8_t kWeekdayAlarm  = 0x0C;
+  static constexpr uint8_t kClkoutControl = 0x0D;
+  static constexpr uint8_t kTimerControl  = 0x0E;
+  static constexpr uint8_t kTimer         = 0x0F;
+  static constexpr size_t  kNumRegisters  = PCF8563::kNumRegisters;
+
+  // Control_1.
+  using STOP = RegisterField<kControl1, 5>;  // Stop the clock.
+
+  // Control_2. AF and TF are cleared by writing zero.
+  using TI_TP = RegisterField<kControl2, 4>;  // Timer interrupt pulses.
+  using AF    = RegisterField<kControl2, 3>;  // Alarm flag.
+  using TF    = RegisterField<kControl2, 2>;  // Timer flag.
+  using AIE   = RegisterField<kControl2, 1>;  // Alarm interrupt enabled.
+  using TIE   = RegisterField<kControl2, 0>;  // Timer interrupt enabled.
+
+  // Time: BCD digits, and flags.
+  using VL      = RegisterField<kVLSeconds, 7>;        // Voltage low.
+  using Seconds = RegisterField<kVLSeconds, 0, 7>;
+  using Minutes = RegisterField<kMinutes, 0, 7>;
+  using Hours   = RegisterField<kHours, 0, 6>;
+  using Days    = RegisterField<kDays, 0, 6>;
+  using Century = RegisterField<kCenturyMonths, 7>;    // Century flag.
+  using Months  = RegisterField<kCenturyMonths, 0, 5>;
+
+  // Alarms: each field is disabled by its AE bit.
+  using AE_M = RegisterField<kMinuteAlarm, 7>;
+  using AE_H = RegisterField<kHourAlarm, 7>;
+  using AE_D = RegisterField<kDayAlarm, 7>;
+  using AE_W = RegisterField<kWeekdayAlarm, 7>;
+
+  // CLKOUT_control.
+  using FE = RegisterField<kClkoutControl, 7>;     // CLKOUT enabled.
+  using FD = RegisterField<kClkoutControl, 0, 2>;  // CLKOUT frequency.
+
+  // Timer_control.
+  using TE = RegisterField<kTimerControl, 7>;     // Timer enabled.
+  using TD = RegisterField<kTimerControl, 0, 2>;  // Timer source clock.
+  // clang-format on
+
+  /**
+   * CLKOUT_control values. See the datasheet, section 8.7.
+   */
+  static constexpr FieldValue<PCF8563::SqwPinMode> kSqwPinModes[] = {
+      {PCF8563::SqwPinMode::Off, 0},
+      {PCF8563::SqwPinMode::Rate1Hz, FE::set(FD::set(0, 0b11), 1)},
+      {PCF8563::SqwPinMode::Rate32Hz, FE::set(FD::set(0, 0b10), 1)},
+      {PCF8563::SqwPinMode::Rate1kHz, FE::set(FD::set(0, 0b01), 1)},
+      {PCF8563::SqwPinMode::Rate32kHz, FE::set(FD::set(0, 0b00), 1)},
+  };
+
+  /**
+   * The mode of the |clkout| register value. FD counts the rates down to
+   * Rate32kHz, so this is an offset rather than a search of kSqwPinModes.
+   */
+  static constexpr PCF8563::SqwPinMode sqwPinMode(uint8_t clkout) {
+    return FE::get(clkout)
+               ? static_cast<PCF8563::SqwPinMode>(
+                     static_cast<int>(PCF8563::SqwPinMode::Rate32kHz) -
+                     FD::get(clkout))
+               : PCF8563::SqwPinMode::Off;
+  }
+
+  /**
+   * Restored configuration: STOP, the interrupt controls, alarms, CLKOUT
+   * and the timer. The test bits are written as zero, for normal mode. The
+   * timer register reads back the count remaining, so a running timer
+   * restarts from what was left of its countdown when dumped.
+   */
+  static constexpr RegisterRestore kRestore[kNumRegisters] = {
+      {STOP::kMask},
+      {TI_TP::kMask | AIE::kMask | TIE::kMask, AF::kMask | TF::kMask},
+      // Time.
+      {}, {}, {}, {}, {}, {}, {},
+      // Alarms.
+      {0xFF}, {0xBF}, {0xBF}, {0x87},
+      {FE::kMask | FD::kMask},
+      // Timer_control. The timer starts once loaded.
+      {TE::kMask | TD::kMask, 0, false, TE::kMask},
+      {0xFF, 0, true},
+  };
+};
+
+static_assert(encodingsOrdered(PCF8563Registers::kSqwPinModes),
+              "Encodings out of order");
+static_assert(decodesField(PCF8563Registers::kSqwPinModes,
+                           PCF8563Registers::sqwPinMode),
+              "sqwPinMode() disagrees with the encodings");
+
+}  // namespace rtc
+
+#endif  // RTC_PCF8563_REGISTERS_H_
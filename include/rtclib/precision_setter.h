@@ -0,0 +1,129 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_PRECISION_SETTER_H_
+#define RTC_PRECISION_SETTER_H_
+
+#include <cstdint>
+#include <functional>
+
+namespace rtc {
+
+class DateTime;
+
+/**
+ * Sets an RTC to within a few milliseconds of a reference time.
+ *
+ * Writing an RTC's time restarts its current second (the chip resets its
+ * divider chain), so a plain adjust() leaves the RTC behind by however far
+ * into the second it was called, plus the bus latency: up to nearly a
+ * second. set() instead waits for the moment at which the write will
+ * complete on a whole second of the reference, and writes that second.
+ *
+ * The RTC restarts its second as it acknowledges the seconds byte, which
+ * each driver's adjust() writes at the start of its last transaction, and
+ * so Config::latch_lag before the write returns. The write's latency, from
+ * the call until it returns, is measured on each set() and averaged, and
+ * the write is started early enough for the seconds byte to land on the
+ * second. Any reads the write needs first are best done by Config::prepare,
+ * before the wait, so that the latency is of the write alone.
+ *
+ * The wait, of up to a second, sleeps with SystemClock::delayMicros() until
+ * Config::sleep_margin before the write, and then waits out the rest in
+ * short steps. Not thread safe.
+ */
+class PrecisionSetter {
+ public:
+  /**
+   * Writes the RTC's time, returning false upon error.
+   */
+  using Writer = std::function<bool(const DateTime& dt)>;
+
+  struct Config {
+    /**
+     * Write latency assumed before the first measurement (µs).
+     */
+    int64_t initial_latency = 1000;
+
+    /**
+     * Weight of the latest measurement in the average latency, from 0 to 1.
+     */
+    float latency_gain = 0.25f;
+
+    /**
+     * Sleeping stops this long (µs) before the write. At least a scheduler
+     * tick, as a sleep may overshoot by that much.
+     */
+    int64_t sleep_margin = 20000;
+
+    /**
+     * Time (µs) from the seconds byte's acknowledgement until the write
+     * returns. The default is six bytes at 100 kHz, the rest of the time
+     * registers, as the DS1307 and PCF8563 write. The DS3231 and PCF8523
+     * then write a control register too: three more bytes.
+     */
+    int64_t latch_lag = 540;
+
+    /**
+     * Called before each wait, e.g. DS3231::prepareAdjust(), returning
+     * false upon error. Optional.
+     */
+    std::function<bool()> prepare;
+  };
+
+  struct Stats {
+    uint32_t sets = 0;      // Successful set() calls.
+    uint32_t failures = 0;  // Failed preparations and writes.
+  };
+
+  PrecisionSetter(Writer writer, const Config& config);
+  explicit PrecisionSetter(Writer writer);
+
+  /**
+   * An RTC driver's (DS1307, DS3231, PCF8523 or PCF8563) adjust().
+   */
+  template <typename RTC>
+  static Writer adjuster(RTC* rtc) {
+    return [rtc](const DateTime& dt) { return rtc->adjust(dt); };
+  }
+
+  /**
+   * Set the RTC from a reference time, on the next whole second which can
+   * be written in time.
+   *
+   * @param local_micros When the reference was valid (SystemClock).
+   * @param unix_micros The reference time, in microseconds since 1970.
+   * @return True if successful, false upon I2C error.
+   */
+  bool set(int64_t local_micros, int64_t unix_micros);
+
+  /**
+   * The average write latency (µs).
+   */
+  int64_t latencyMicros() const { return latency_; }
+
+  /**
+   * How late (µs) the last successful write's seconds byte landed after its
+   * second, from the measured latency. The RTC is behind the reference by
+   * this much.
+   */
+  int64_t lastErrorMicros() const { return last_error_; }
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  const Writer writer_;
+  const Config config_;
+  int64_t latency_;
+  bool measured_ = false;
+  int64_t last_error_ = 0;
+  Stats stats_;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_PRECISION_SETTER_H_
@@ -0,0 +1,128 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_RECURRENCE_H_
+#define RTC_RECURRENCE_H_
+
+#include <cstdint>
+
+#include "rtclib/ds3231.h"
+
+namespace rtc {
+
+class DateTime;
+
+/**
+ * A cron-like recurrence rule: the set of times whose second, minute,
+ * hour, day of month, month and day of week are all in the rule's sets.
+ *
+ * Each set is a bitmask, e.g. hours(1 << 8 | 1 << 17) for 08:xx and
+ * 17:xx. A default constructed rule matches every second. Unlike cron, a
+ * day must match both the day of month and the day of week sets (as with
+ * the RTC alarms).
+ *
+ * next() jumps directly to the next matching month, day, hour, minute and
+ * second using bit scans, rather than stepping through time, so it takes
+ * near-constant time regardless of how far away the next occurrence is.
+ *
+ * Times are limited to the years 2000 to 2099, as for the RTCs.
+ */
+class Recurrence {
+ public:
+  static constexpr uint64_t kAllSeconds = (1ULL << 60) - 1;
+  static constexpr uint64_t kAllMinutes = (1ULL << 60) - 1;
+  static constexpr uint32_t kAllHours = (1UL << 24) - 1;
+  static constexpr uint32_t kAllDays = 0xFFFFFFFE;  // Bits 1..31.
+  static constexpr uint16_t kAllMonths = 0x1FFE;    // Bits 1..12.
+  static constexpr uint8_t kAllWeekdays = 0x7F;     // Bits 0 (Sunday)..6.
+
+  Recurrence() = default;
+
+  /**
+   * The rule matching a DS3231 alarm 1 set to |dt| in |mode|.
+   */
+  static Recurrence alarm1(const DateTime& dt, DS3231::Alarm1Mode mode);
+
+  /**
+   * The rule matching a DS3231 alarm 2 set to |dt| in |mode|.
+   */
+  static Recurrence alarm2(const DateTime& dt, DS3231::Alarm2Mode mode);
+
+  /**
+   * Set the seconds (bits 0..59) to match.
+   */
+  Recurrence& seconds(uint64_t mask) {
+    seconds_ = mask & kAllSeconds;
+    return *this;
+  }
+
+  /**
+   * Set the minutes (bits 0..59) to match.
+   */
+  Recurrence& minutes(uint64_t mask) {
+    minutes_ = mask & kAllMinutes;
+    return *this;
+  }
+
+  /**
+   * Set the hours (bits 0..23) to match.
+   */
+  Recurrence& hours(uint32_t mask) {
+    hours_ = mask & kAllHours;
+    return *this;
+  }
+
+  /**
+   * Set the days of the month (bits 1..31) to match.
+   */
+  Recurrence& days(uint32_t mask) {
+    days_ = mask & kAllDays;
+    return *this;
+  }
+
+  /**
+   * Set the months (bits 1..12) to match.
+   */
+  Recurrence& months(uint16_t mask) {
+    months_ = mask & kAllMonths;
+    return *this;
+  }
+
+  /**
+   * Set the days of the week (bits 0 = Sunday .. 6 = Saturday) to match.
+   */
+  Recurrence& weekdays(uint8_t mask) {
+    weekdays_ = mask & kAllWeekdays;
+    return *this;
+  }
+
+  /**
+   * Does |dt| match this rule?
+   */
+  bool matches(const DateTime& dt) const;
+
+  /**
+   * Compute the first matching time strictly after |after|.
+   *
+   * @param after The time to search from.
+   * @param next Set to the next matching time.
+   * @return False if there is no matching time before 2100.
+   */
+  bool next(const DateTime& after, DateTime* next) const;
+
+ private:
+  uint64_t seconds_ = kAllSeconds;
+  uint64_t minutes_ = kAllMinutes;
+  uint32_t hours_ = kAllHours;
+  uint32_t days_ = kAllDays;
+  uint16_t months_ = kAllMonths;
+  uint8_t weekdays_ = kAllWeekdays;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_RECURRENCE_H_
@@ -0,0 +1,169 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_REGISTER_MAP_H_
+#define RTC_REGISTER_MAP_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rtc {
+
+/**
+ * A field of an 8-bit device register: |Width| bits from bit |Shift| of the
+ * register at |Address|.
+ *
+ * Fields are types rather than values, so that get() and set() fold to the
+ * same masks and shifts as hand-written bit operations. A chip's fields are
+ * declared together in its register map (e.g. DS3231Registers), which the
+ * driver reads and writes through readField() and writeField(), and which
+ * other tools (register dumps, simulated chips) can share.
+ *
+ *     using INTCN = RegisterField<0x0E, 2>;
+ *     control = INTCN::set(control, 1);
+ */
+template <uint8_t Address, uint8_t Shift, uint8_t Width = 1>
+struct RegisterField {
+  static_assert(Width > 0 && Shift + Width <= 8, "Field exceeds the register");
+
+  static constexpr uint8_t kAddress = Address;
+  static constexpr uint8_t kShift = Shift;
+  static constexpr uint8_t kWidth = Width;
+  static constexpr uint8_t kMask =
+      static_cast<uint8_t>(((1u << Width) - 1) << Shift);
+
+  /**
+   * The field's value in |reg|.
+   */
+  static constexpr uint8_t get(uint8_t reg) {
+    return static_cast<uint8_t>((reg & kMask) >> Shift);
+  }
+
+  /**
+   * |reg| with the field set to |value|, and the other bits unchanged.
+   */
+  static constexpr uint8_t set(uint8_t reg, uint8_t value) {
+    return static_cast<uint8_t>((reg & ~kMask) | ((value << Shift) & kMask));
+  }
+};
+
+template <uint8_t Address, uint8_t Shift, uint8_t Width>
+constexpr uint8_t RegisterField<Address, Shift, Width>::kAddress;
+template <uint8_t Address, uint8_t Shift, uint8_t Width>
+constexpr uint8_t RegisterField<Address, Shift, Width>::kShift;
+template <uint8_t Address, uint8_t Shift, uint8_t Width>
+constexpr uint8_t RegisterField<Address, Shift, Width>::kWidth;
+template <uint8_t Address, uint8_t Shift, uint8_t Width>
+constexpr uint8_t RegisterField<Address, Shift, Width>::kMask;
+
+/**
+ * One encoding of a field: the bits which represent |value|.
+ *
+ * A field's encodings are listed in a table, ordered by value, so that
+ * encoding is an index rather than a search (see encodingsOrdered()).
+ */
+template <typename Enum>
+struct FieldValue {
+  Enum value;
+  uint8_t bits;
+};
+
+/**
+ * True if each of |values| is the enumerator after the one before, as
+ * encodeField() requires. For use in a static_assert().
+ */
+template <typename Enum, size_t N>
+constexpr bool encodingsOrdered(const FieldValue<Enum> (&values)[N],
+                                size_t i = 1) {
+  return i >= N || (static_cast<size_t>(values[i].value) ==
+                        static_cast<size_t>(values[0].value) + i &&
+                    encodingsOrdered(values, i + 1));
+}
+
+/**
+ * The bits which represent |value|, one of the enumerators in |values|. A
+ * value outside of the table (e.g. a cast integer) gets the first
+ * encoding.
+ */
+template <typename Enum, size_t N>
+constexpr uint8_t encodeField(const FieldValue<Enum> (&values)[N],
+                              Enum value) {
+  // Unsigned, so a value before the first wraps to out of range too.
+  return static_cast<size_t>(value) - static_cast<size_t>(values[0].value) <
+                 N
+             ? values[static_cast<size_t>(value) -
+                      static_cast<size_t>(values[0].value)]
+                   .bits
+             : values[0].bits;
+}
+
+/**
+ * The value which |bits| represent in |values|, or |fallback| if none.
+ */
+template <typename Enum, size_t N>
+constexpr Enum decodeField(const FieldValue<Enum> (&values)[N],
+                           uint8_t bits,
+                           Enum fallback,
+                           size_t i = 0) {
+  return i == N ? fallback
+                : values[i].bits == bits
+                      ? values[i].value
+                      : decodeField(values, bits, fallback, i + 1);
+}
+
+/**
+ * True if |decode| maps each encoding in |values| back to its value. For
+ * use in a static_assert(), where a field's encodings are regular enough
+ * for a driver to decode them with arithmetic rather than decodeField()'s
+ * search.
+ */
+template <typename Enum, size_t N>
+constexpr bool decodesField(const FieldValue<Enum> (&values)[N],
+                            Enum (*decode)(uint8_t),
+                            size_t i = 0) {
+  return i == N || (decode(values[i].bits) == values[i].value &&
+                    decodesField(values, decode, i + 1));
+}
+
+/**
+ * How a register is restored from a register dump (e.g. by
+ * DS3231::restoreRegisters()).
+ *
+ * Only the |config| bits are copied from the dump. Flags which are cleared
+ * by writing zero are written as one, leaving them unchanged, and the
+ * other bits (read-only, self-clearing or reserved) as zero. A register
+ * with no |config| bits, such as the time, is not written at all.
+ *
+ * The |enable| bits start a counter, which loads its value register as it
+ * starts. They are written clear with the rest of the configuration, then
+ * set once the value registers are written.
+ *
+ * The |preserve| bits, such as a flag which writing one sets, are written
+ * as the chip's current value, read just before the restore.
+ */
+struct RegisterRestore {
+  constexpr RegisterRestore(uint8_t config = 0,
+                            uint8_t flags = 0,
+                            bool counter = false,
+                            uint8_t enable = 0,
+                            uint8_t preserve = 0)
+      : config(config),
+        flags(flags),
+        counter(counter),
+        enable(enable),
+        preserve(preserve) {}
+
+  uint8_t config;    // Bits copied from the dump.
+  uint8_t flags;     // Bits written as one.
+  bool counter;      // Counts down once written, so isn't verified.
+  uint8_t enable;    // Config bits which start a counter, written last.
+  uint8_t preserve;  // Bits written as their current value.
+};
+
+}  // namespace rtc
+
+#endif  // RTC_REGISTER_MAP_H_
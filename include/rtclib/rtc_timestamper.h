@@ -0,0 +1,118 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_RTC_TIMESTAMPER_H_
+#define RTC_RTC_TIMESTAMPER_H_
+
+#include <cstdint>
+#include <functional>
+
+#include <rtclib/datetime.h>
+
+namespace rtc {
+
+/**
+ * Relates an RTC's time to the SystemClock, for sub-second synchronization
+ * between the two.
+ *
+ * An RTC latches its time somewhere within the read transaction, so
+ * read() timestamps each reading with the midpoint of the transaction on
+ * the SystemClock, give or take half its duration.
+ *
+ * A reading only gives the time to the second. waitForRollover() finds
+ * when the seconds change, by reading just the seconds register until they
+ * do: the new second started between the last read of the old second and
+ * the first read of the new. That timestamps the start of a second to
+ * within about a transaction, e.g. to check a PrecisionSetter, or as a
+ * ClockFusion::addReference() of the RTC.
+ *
+ * Not thread safe.
+ */
+class RtcTimestamper {
+ public:
+  /**
+   * Reads the RTC's time, returning false upon error.
+   */
+  using Reader = std::function<bool(DateTime* now)>;
+
+  /**
+   * Reads just the RTC's seconds, returning false upon error.
+   */
+  using SecondsReader = std::function<bool(uint8_t* seconds)>;
+
+  struct Config {
+    /**
+     * waitForRollover() gives up after this long (µs).
+     */
+    int64_t max_wait = 1100000;
+
+    /**
+     * Delay between reads of the seconds (µs). Zero reads back to back,
+     * for the best resolution.
+     */
+    int64_t poll_interval = 0;
+  };
+
+  /**
+   * A reading of the RTC, and when it was true.
+   */
+  struct Reading {
+    DateTime time;
+    int64_t local_micros = 0;        // SystemClock timestamp.
+    int64_t uncertainty_micros = 0;  // Of local_micros, either way.
+  };
+
+  RtcTimestamper(Reader reader,
+                 SecondsReader seconds_reader,
+                 const Config& config);
+  RtcTimestamper(Reader reader, SecondsReader seconds_reader);
+
+  /**
+   * For an RTC driver (DS1307, DS3231, PCF8523 or PCF8563).
+   */
+  template <typename RTC>
+  static RtcTimestamper forRtc(RTC* rtc, const Config& config) {
+    return RtcTimestamper([rtc](DateTime* now) { return rtc->now(now); },
+                          [rtc](uint8_t* seconds) {
+                            return rtc->readSeconds(seconds);
+                          },
+                          config);
+  }
+
+  template <typename RTC>
+  static RtcTimestamper forRtc(RTC* rtc) {
+    return forRtc(rtc, Config());
+  }
+
+  /**
+   * Read the RTC's time.
+   *
+   * @param reading Set to the time, timestamped with the middle of the
+   *                read.
+   * @return True if successful, false upon error.
+   */
+  bool read(Reading* reading);
+
+  /**
+   * Wait for the RTC's next second to start.
+   *
+   * @param reading Set to the new second, timestamped with its start.
+   * @return True if successful, false upon error, or if the seconds
+   *         didn't change within Config::max_wait (e.g. the RTC is
+   *         stopped).
+   */
+  bool waitForRollover(Reading* reading);
+
+ private:
+  const Reader reader_;
+  const SecondsReader seconds_reader_;
+  const Config config_;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_RTC_TIMESTAMPER_H_
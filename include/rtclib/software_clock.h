@@ -0,0 +1,103 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_SOFTWARE_CLOCK_H_
+#define RTC_SOFTWARE_CLOCK_H_
+
+#include <cstdint>
+
+#include "rtclib/datetime.h"
+
+namespace rtc {
+
+class TickSource;
+
+/**
+ * A software clock counting from a tick source, which can be tuned to
+ * compensate for the drift of that source.
+ *
+ * All state is 64-bit: there is no rollover, and so no requirement on how
+ * often the clock is read. The rate is kept in 32.32 fixed-point, giving a
+ * resolution well below 1 ppb, and changing it never steps the clock.
+ *
+ * Each instance is independent, so separate timebases can coexist. An
+ * instance is not itself thread-safe: guard it if it is shared between
+ * threads.
+ */
+class SoftwareClock {
+ public:
+  /**
+   * @param ticks The source of time. nullptr (the default) uses the
+   *              SystemClock. Not owned, and must outlive this clock.
+   */
+  constexpr explicit SoftwareClock(const TickSource* ticks = nullptr)
+      : ticks_(ticks),
+        rate_(1ULL << 32),
+        anchor_ticks_(0),
+        anchor_micros_(0) {}
+
+  /**
+   * Set the current date/time.
+   *
+   * @param dt DateTime object with the desired date and time
+   */
+  void adjust(const DateTime& dt);
+
+  /**
+   * Set the current time.
+   *
+   * @param unix_micros The current time, in microseconds since 1970.
+   */
+  void adjustMicros(int64_t unix_micros);
+
+  /**
+   * Set the drift adjustment, with parts per billion resolution. Time
+   * continues from its current value at the new rate.
+   *
+   * @param ppb Adjustment to make. A positive adjustment makes the clock
+   * faster.
+   */
+  void adjustDriftPpb(int32_t ppb);
+
+  /**
+   * The current drift adjustment, in parts per billion.
+   */
+  int32_t driftPpb() const;
+
+  /**
+   * Get the current date/time.
+   *
+   * @return DateTime object containing the current date/time
+   */
+  DateTime now() const;
+
+  /**
+   * Get the current time with microsecond resolution.
+   *
+   * @return Microseconds since 1970-01-01.
+   */
+  int64_t nowMicros() const;
+
+  /**
+   * The current time of the tick source, for measuring intervals in the
+   * timebase this clock runs from.
+   *
+   * @return Tick source microseconds. The epoch is arbitrary.
+   */
+  int64_t ticks() const;
+
+ private:
+  const TickSource* ticks_;
+  uint64_t rate_;  // Clock microseconds per tick microsecond, in 32.32.
+  int64_t anchor_ticks_;   // Tick source time at the anchor point.
+  int64_t anchor_micros_;  // Clock time (microseconds since 1970) at the
+                           // anchor point.
+};
+
+}  // namespace rtc
+
+#endif  // RTC_SOFTWARE_CLOCK_H_
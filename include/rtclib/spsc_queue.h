@@ -0,0 +1,81 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_SPSC_QUEUE_H_
+#define RTC_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace rtc {
+
+/**
+ * A fixed capacity, lock-free, single-producer single-consumer queue.
+ *
+ * push() may be called from one context (e.g. an interrupt handler) and
+ * pop() from one other context (e.g. a task) without any locking. Neither
+ * blocks nor allocates.
+ *
+ * The indices are free-running, and wrap around the item array, whose
+ * size must therefore be a power of two.
+ *
+ * @tparam T The item type.
+ * @tparam N The capacity. A power of two.
+ */
+template <typename T, size_t N>
+class SpscQueue {
+  static_assert(N && !(N & (N - 1)), "Capacity must be a power of two");
+
+ public:
+  /**
+   * Add an item. Producer only.
+   *
+   * @return False if the queue is full.
+   */
+  bool push(const T& item) {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == N)
+      return false;
+    items_[tail & (N - 1)] = item;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Remove the oldest item. Consumer only.
+   *
+   * @return False if the queue is empty.
+   */
+  bool pop(T* item) {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return false;
+    *item = items_[head & (N - 1)];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Is the queue empty? Exact only from the consumer.
+   */
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+  static constexpr size_t capacity() { return N; }
+
+ private:
+  T items_[N];
+  std::atomic<uint32_t> head_{0};  // Next to pop, written by the consumer.
+  std::atomic<uint32_t> tail_{0};  // Next to push, written by the producer.
+};
+
+}  // namespace rtc
+
+#endif  // RTC_SPSC_QUEUE_H_
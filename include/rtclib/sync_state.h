@@ -0,0 +1,93 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_SYNC_STATE_H_
+#define RTC_SYNC_STATE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rtc {
+
+class ByteStorage;
+
+/**
+ * What has been learned about the clocks, kept across reboots so that it
+ * need not be learned again.
+ */
+struct SyncState {
+  /**
+   * When the clock was last synchronized to a reference (seconds since
+   * 1970), or zero if never.
+   */
+  uint32_t last_sync = 0;
+
+  /**
+   * The learned rate correction of the Micros clock (ppb), e.g. from
+   * ClockDiscipline::frequencyPpb().
+   */
+  int32_t drift_ppb = 0;
+
+  /**
+   * The RTC's calibration, e.g. the DS3231 aging offset.
+   */
+  int8_t calibration = 0;
+};
+
+/**
+ * A SyncState saved in non-volatile memory as kSize bytes:
+ *
+ *     [0x5C] [last_sync (4)] [drift_ppb (4)] [calibration] [0] [CRC-8]
+ *
+ * with all values little endian.
+ */
+class SyncStateStore {
+ public:
+  static constexpr size_t kSize = 12;
+
+  /**
+   * @param storage The memory holding the state.
+   * @param address The state's address in |storage|.
+   */
+  SyncStateStore(ByteStorage* storage, uint16_t address);
+
+  /**
+   * Load the saved state.
+   *
+   * @return True if successful, false upon I2C error or if no valid state
+   *         is saved.
+   */
+  bool load(SyncState* state);
+
+  /**
+   * Save |state|.
+   *
+   * @return True if successful, false upon I2C error.
+   */
+  bool save(const SyncState& state);
+
+  /**
+   * Encode |state| into kSize bytes.
+   */
+  static void encode(const SyncState& state, uint8_t* bytes);
+
+  /**
+   * Decode kSize bytes, e.g. read along with the time by
+   * DS1307::readBootState().
+   *
+   * @return True if |bytes| hold a valid state.
+   */
+  static bool decode(const uint8_t* bytes, SyncState* state);
+
+ private:
+  ByteStorage* storage_;
+  const uint16_t address_;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_SYNC_STATE_H_
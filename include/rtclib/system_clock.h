@@ -8,10 +8,28 @@
  * https://github.com/adafruit/RTClib
  */
 
+#ifndef RTC_SYSTEM_CLOCK_H_
+#define RTC_SYSTEM_CLOCK_H_
+
 #include <cstdint>
 
 namespace rtc {
 
+/**
+ * The monotonic clock underlying the software clocks.
+ *
+ * The backend is selected at compile time by defining one of:
+ *
+ * - RTC_SYSTEM_CLOCK_ESP_TIMER: esp_timer_get_time(). The default for
+ *   ESP-IDF.
+ * - RTC_SYSTEM_CLOCK_POSIX: clock_gettime(CLOCK_MONOTONIC_RAW), which is
+ *   not slewed by NTP. The default elsewhere.
+ * - RTC_SYSTEM_CLOCK_TSC: the x86 time stamp counter, calibrated against
+ *   the POSIX clock on first use. x86-64 Linux only. Falls back to the
+ *   POSIX clock if the CPU has no invariant TSC.
+ * - RTC_SYSTEM_CLOCK_MANUAL: a virtual clock which only advances when told
+ *   to, for tests and simulations.
+ */
 class SystemClock {
  public:
   /**
@@ -21,8 +39,42 @@ class SystemClock {
 
   /**
    * The number of milliseconds since the system started.
+   *
+   * Equal to microsSinceStart() / 1000, but cheaper than the 64-bit
+   * division.
    */
   static int64_t millisSinceStart();
+
+  /**
+   * Wait at least |micros| microseconds. With RTC_SYSTEM_CLOCK_MANUAL this
+   * advances the clock instead, or calls the delay handler.
+   */
+  static void delayMicros(int64_t micros);
+
+#if defined(RTC_SYSTEM_CLOCK_MANUAL)
+  /**
+   * Set the time returned by microsSinceStart().
+   *
+   * Only available when built with RTC_SYSTEM_CLOCK_MANUAL, in which case
+   * the system clock only advances when told to. Used by host tests.
+   */
+  static void setMicrosSinceStart(int64_t micros);
+
+  /**
+   * Advance the time returned by microsSinceStart().
+   */
+  static void advanceMicros(int64_t micros);
+
+  /**
+   * Have delayMicros() call |handler| with |arg|, e.g. to run a simulation
+   * for that long, rather than advance the clock itself. nullptr restores
+   * the default.
+   */
+  static void setDelayHandler(void (*handler)(int64_t micros, void* arg),
+                              void* arg);
+#endif
 };
 
 }  // namespace rtc
+
+#endif  // RTC_SYSTEM_CLOCK_H_
@@ -0,0 +1,214 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_TEMPERATURE_COMPENSATOR_H_
+#define RTC_TEMPERATURE_COMPENSATOR_H_
+
+#include <cstdint>
+
+namespace rtc {
+
+class ClockDiscipline;
+class DS3231;
+class SoftwareClock;
+
+/**
+ * A learned model of a crystal's frequency error versus temperature.
+ *
+ * Tuning fork crystals, such as the one driving the system timer, have a
+ * parabolic frequency/temperature curve. This model fits
+ *
+ *     ppm = c0 + c1 * (t - 25) + c2 * (t - 25)^2
+ *
+ * to (temperature, ppm) samples with a recursive least squares fit. Only
+ * the running sums are kept, so the memory use is fixed regardless of the
+ * number of samples. Older samples can be exponentially forgotten so that
+ * the model tracks slow changes such as crystal aging.
+ *
+ * Until samples span a sufficient temperature range the fit falls back to
+ * a line, and then to a constant.
+ */
+class TemperatureDriftModel {
+ public:
+  /**
+   * @param forgetting Weight applied to all previous samples each time a new
+   *                   one is added, in (0, 1]. 1 never forgets.
+   */
+  explicit TemperatureDriftModel(float forgetting = 1.0f);
+
+  /**
+   * Add an observed frequency error at the given temperature.
+   *
+   * @param temperature Temperature (°C).
+   * @param ppm Observed frequency error. Positive values are fast.
+   */
+  void addSample(float temperature, float ppm);
+
+  /**
+   * The modeled frequency error at a temperature. Zero if no samples have
+   * been added.
+   */
+  float ppmAt(float temperature) const;
+
+  /**
+   * Forget all samples.
+   */
+  void reset();
+
+  /**
+   * The number of samples added since the last reset.
+   */
+  uint32_t numSamples() const { return num_samples_; }
+
+  /**
+   * The fitted coefficients c0, c1, c2 (see class description).
+   */
+  const float* coefficients() const { return coefficients_; }
+
+ private:
+  void fit();
+
+  const double forgetting_;
+  double sum_x_[5];   // Sum of weight * x^k for k = 0..4.
+  double sum_xy_[3];  // Sum of weight * x^k * ppm for k = 0..2.
+  uint32_t num_samples_;
+  float coefficients_[3];
+};
+
+/**
+ * Temperature compensation of a SoftwareClock, such as Micros'.
+ *
+ * Learns the drift of the clock's tick source versus temperature, using
+ * the DS3231's temperature sensor and occasional reference syncs, and
+ * continuously retunes the clock to the modeled drift at the current
+ * temperature. Intervals are timed with the clock's own ticks(). Between
+ * syncs the clock then tracks temperature changes without needing to
+ * re-read the time from the RTC.
+ *
+ * If the clock is also disciplined, pass the ClockDiscipline instead of
+ * the clock: the correction is then fed forward to it, rather than each
+ * overwriting the other's adjustment.
+ *
+ * The DS3231 only measures temperature every 64 seconds, so update()
+ * reads the temperature no more often than that.
+ */
+class TemperatureCompensator {
+ public:
+  struct Config {
+    /**
+     * Minimum interval between temperature reads (microseconds).
+     */
+    int64_t temperature_interval = 64 * 1000000LL;
+
+    /**
+     * Minimum interval between syncs for a drift sample (microseconds).
+     */
+    int64_t min_sync_interval = 10 * 60 * 1000000LL;
+
+    /**
+     * Discard a drift sample if the temperature varied more than this (°C)
+     * during its interval.
+     */
+    float max_temperature_spread = 1.0f;
+
+    /**
+     * Forgetting factor of the TemperatureDriftModel.
+     */
+    float forgetting = 0.995f;
+  };
+
+  /**
+   * @param rtc The RTC whose temperature sensor to use.
+   * @param clock The clock to retune. Not owned.
+   * @param config The compensation parameters.
+   */
+  TemperatureCompensator(DS3231* rtc,
+                         SoftwareClock* clock,
+                         const Config& config);
+  TemperatureCompensator(DS3231* rtc, SoftwareClock* clock);
+
+  /**
+   * @param rtc The RTC whose temperature sensor to use.
+   * @param discipline The discipline of the clock, to feed the correction
+   *                   forward to. Not owned.
+   * @param config The compensation parameters.
+   */
+  TemperatureCompensator(DS3231* rtc,
+                         ClockDiscipline* discipline,
+                         const Config& config);
+  TemperatureCompensator(DS3231* rtc, ClockDiscipline* discipline);
+
+  /**
+   * Start learning.
+   *
+   * @param reference_micros The current reference time in microseconds. Any
+   *                         epoch may be used, as long as it is consistent
+   *                         between calls.
+   * @return True if successful, false upon I2C error.
+   */
+  bool begin(int64_t reference_micros);
+
+  /**
+   * Read the temperature (if due) and retune the clock.
+   *
+   * Call periodically, e.g. from the main loop.
+   *
+   * @return True if successful, false upon I2C error.
+   */
+  bool update();
+
+  /**
+   * Record a sync with the reference time, adding a drift sample to the
+   * model if the interval since the previous sync is long enough. An
+   * interval during which the temperature changed too much is discarded.
+   *
+   * Note that this does not set the clock's time: call adjust() on it as
+   * usual.
+   *
+   * @param reference_micros The current reference time in microseconds.
+   * @return True if successful, false upon I2C error.
+   */
+  bool sync(int64_t reference_micros);
+
+  /**
+   * The most recently read temperature (°C).
+   */
+  float temperature() const { return temperature_; }
+
+  /**
+   * The drift correction (ppb) currently applied to the clock.
+   */
+  int32_t appliedPpb() const { return applied_ppb_; }
+
+  const TemperatureDriftModel& model() const { return model_; }
+
+ private:
+  bool readTemperature();
+  void startInterval(int64_t reference_micros);
+  void retune();
+
+  DS3231* rtc_;
+  SoftwareClock* const clock_;
+  ClockDiscipline* const discipline_;
+  const Config config_;
+  TemperatureDriftModel model_;
+  float temperature_ = 0;
+  int64_t last_read_ = 0;
+  int32_t applied_ppb_ = 0;
+
+  // The current sync interval.
+  int64_t reference_start_ = 0;
+  int64_t local_start_ = 0;
+  float temperature_sum_ = 0;
+  uint32_t temperature_count_ = 0;
+  float temperature_min_ = 0;
+  float temperature_max_ = 0;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_TEMPERATURE_COMPENSATOR_H_
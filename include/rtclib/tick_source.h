@@ -0,0 +1,57 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_TICK_SOURCE_H_
+#define RTC_TICK_SOURCE_H_
+
+#include <cstdint>
+
+namespace rtc {
+
+/**
+ * A monotonic source of time for the software clocks.
+ *
+ * The default source is the SystemClock. Other sources can be injected to
+ * give a clock an independent timebase, e.g. a per-simulation virtual
+ * clock.
+ */
+class TickSource {
+ public:
+  virtual ~TickSource() = default;
+
+  /**
+   * A monotonic time in microseconds. The epoch is arbitrary.
+   */
+  virtual int64_t micros() const = 0;
+};
+
+/**
+ * A tick source which only advances when told to.
+ */
+class ManualTickSource : public TickSource {
+ public:
+  explicit ManualTickSource(int64_t micros = 0) : micros_(micros) {}
+
+  int64_t micros() const override { return micros_; }
+
+  /**
+   * Set the current time (microseconds).
+   */
+  void set(int64_t micros) { micros_ = micros; }
+
+  /**
+   * Advance the current time by |micros| microseconds.
+   */
+  void advance(int64_t micros) { micros_ += micros; }
+
+ private:
+  int64_t micros_;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_TICK_SOURCE_H_
@@ -0,0 +1,141 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_TRACE_H_
+#define RTC_TRACE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if !defined(RTC_TRACE_CAPACITY)
+#define RTC_TRACE_CAPACITY 256
+#endif
+
+namespace rtc {
+
+/**
+ * The start or end of something traced.
+ */
+struct TraceEvent {
+  enum class Phase : uint8_t { Begin, End };
+
+  const char* category;  // e.g. "i2c".
+  const char* name;      // e.g. "now".
+  int64_t micros;        // SystemClock::microsSinceStart() when recorded.
+  uint32_t thread;       // Identifies the recording thread (or task).
+  int32_t arg;           // e.g. the I2C address, or Trace::kNoArg.
+  Phase phase;
+};
+
+/**
+ * A timeline of driver and clock activity: I2C operations, clock
+ * synchronization, alarm dispatch and calibration.
+ *
+ * Events are recorded into a fixed-size ring buffer, RTC_TRACE_CAPACITY
+ * events long, which overwrites the oldest events. Recording is lock-free
+ * and may be done from any thread. Applications may add their own events,
+ * e.g. around other devices' use of the I2C bus, to show contention.
+ *
+ * Only recorded when built with RTC_TRACING defined. Otherwise begin(),
+ * end() and TraceScope are empty inline functions which cost nothing.
+ *
+ * Recorded events are exported with toChromeJson(), which is loaded by
+ * chrome://tracing and the Perfetto UI (https://ui.perfetto.dev).
+ */
+class Trace {
+ public:
+  static constexpr size_t kCapacity = RTC_TRACE_CAPACITY;
+  static constexpr int32_t kNoArg = INT32_MIN;
+
+  static_assert(kCapacity && !(kCapacity & (kCapacity - 1)),
+                "RTC_TRACE_CAPACITY must be a power of two");
+
+  /**
+   * True if built with RTC_TRACING.
+   */
+  static constexpr bool enabled() {
+#if defined(RTC_TRACING)
+    return true;
+#else
+    return false;
+#endif
+  }
+
+#if defined(RTC_TRACING)
+  /**
+   * Record the start of |name|.
+   *
+   * @param category The kind of activity, e.g. "i2c".
+   * @param name What started. Must outlive the trace.
+   * @param arg An argument to show, e.g. the I2C address, or kNoArg.
+   */
+  static void begin(const char* category, const char* name, int32_t arg);
+
+  /**
+   * Record the end of |name|, the most recent begin() by this thread.
+   */
+  static void end(const char* category, const char* name);
+
+  /**
+   * Copy up to |max_events| of the recorded events, oldest first. Events
+   * being recorded during the copy are skipped.
+   *
+   * @return The number of events copied.
+   */
+  static size_t snapshot(TraceEvent* events, size_t max_events);
+
+  /**
+   * Forget all recorded events. Not to be called while recording.
+   */
+  static void clear();
+#else
+  static void begin(const char* category, const char* name, int32_t arg) {}
+  static void end(const char* category, const char* name) {}
+  static size_t snapshot(TraceEvent* events, size_t max_events) { return 0; }
+  static void clear() {}
+#endif
+
+  /**
+   * Format events in the Chrome trace event JSON format.
+   *
+   * An event ended without having begun (its start was overwritten) is
+   * dropped by the viewers, as is one begun but not yet ended.
+   */
+  static std::string toChromeJson(const TraceEvent* events, size_t count);
+};
+
+/**
+ * Traces the scope in which it lives.
+ */
+class TraceScope {
+ public:
+#if defined(RTC_TRACING)
+  TraceScope(const char* category, const char* name)
+      : TraceScope(category, name, Trace::kNoArg) {}
+  TraceScope(const char* category, const char* name, int32_t arg)
+      : category_(category), name_(name) {
+    Trace::begin(category, name, arg);
+  }
+  ~TraceScope() { Trace::end(category_, name_); }
+#else
+  TraceScope(const char* category, const char* name) {}
+  TraceScope(const char* category, const char* name, int32_t arg) {}
+#endif
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+#if defined(RTC_TRACING)
+ private:
+  const char* category_;
+  const char* name_;
+#endif
+};
+
+}  // namespace rtc
+
+#endif  // RTC_TRACE_H_
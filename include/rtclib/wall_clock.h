@@ -0,0 +1,127 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_WALL_CLOCK_H_
+#define RTC_WALL_CLOCK_H_
+
+#include <cstdint>
+
+#include "rtclib/datetime.h"
+
+namespace rtc {
+
+/**
+ * A wall clock kept as an offset from a monotonic timebase.
+ *
+ * Unlike Millis::adjust() and Micros::adjust(), which jump the clock
+ * immediately, corrections to a WallClock are slewed (as with adjtime()):
+ * the offset is changed gradually at a bounded rate, so the wall time
+ * never jumps and never goes backwards. Only corrections larger than the
+ * step threshold are applied immediately.
+ *
+ * The monotonic timebase (the system clock) is never affected by
+ * corrections, so intervals measured with monotonicMicros() stay accurate
+ * while the wall clock is resynced against an RTC.
+ */
+class WallClock {
+ public:
+  struct Config {
+    /**
+     * Maximum slew rate (ppm). Must be less than 1000000 for the wall time
+     * to keep moving forward while slewing backwards.
+     */
+    int32_t max_slew_ppm = 500;
+
+    /**
+     * Corrections larger than this (microseconds) are stepped.
+     */
+    int64_t step_threshold = 128000;
+  };
+
+  explicit WallClock(const Config& config);
+  WallClock();
+
+  /**
+   * Correct the wall clock to the given time, e.g. read from an RTC.
+   *
+   * The first correction is always stepped, to the middle of the second.
+   * |dt| only has a resolution of a second, so a wall time within its
+   * second is left alone, and larger errors are slewed towards the middle
+   * of the second, stepping only if the error exceeds the step threshold
+   * plus half a second.
+   *
+   * @param dt The correct current time, truncated to the second.
+   */
+  void adjust(const DateTime& dt);
+
+  /**
+   * Correct the wall clock to the given time.
+   *
+   * @param unix_micros The correct current time, in microseconds since 1970.
+   */
+  void adjustMicros(int64_t unix_micros);
+
+  /**
+   * Set the wall clock immediately, regardless of the step threshold.
+   *
+   * @param unix_micros The current time, in microseconds since 1970.
+   */
+  void step(int64_t unix_micros);
+
+  /**
+   * The current wall time.
+   */
+  DateTime now() const;
+
+  /**
+   * The current wall time, in microseconds since 1970.
+   */
+  int64_t nowMicros() const;
+
+  /**
+   * The monotonic timebase, in microseconds. Never adjusted.
+   */
+  static int64_t monotonicMicros();
+
+  /**
+   * The part of the last correction still to be slewed (microseconds).
+   */
+  int64_t remainingSlew() const;
+
+  /**
+   * Number of corrections which were stepped rather than slewed.
+   */
+  uint32_t steps() const { return steps_; }
+
+ private:
+  /**
+   * The wall clock offset from the monotonic timebase at |monotonic|.
+   */
+  int64_t offsetAt(int64_t monotonic) const;
+
+  /**
+   * The part of the current slew applied by |monotonic|.
+   */
+  int64_t slewedAt(int64_t monotonic) const;
+
+  /**
+   * Correct the wall clock to |unix_micros|, give or take |resolution|
+   * (microseconds).
+   */
+  void correct(int64_t unix_micros, int64_t resolution);
+
+  const Config config_;
+  bool set_ = false;
+  int64_t offset_ = 0;      // Offset, excluding the current slew.
+  int64_t slew_ = 0;        // Total correction of the current slew.
+  int64_t slew_start_ = 0;  // Monotonic time when the current slew started.
+  uint32_t steps_ = 0;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_WALL_CLOCK_H_
@@ -0,0 +1,106 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/at24c32.h>
+
+#include <utility>
+
+#include <i2clib/master.h>
+#include <i2clib/operation.h>
+#include <rtclib/system_clock.h>
+#include "instrumented_i2c.h"
+
+namespace rtc {
+
+namespace {
+
+// The longest write cycle (tWR) is 10 ms at 2.7 V and 20 ms at 1.8 V.
+constexpr int64_t kWriteCycleTimeoutMicros = 20000;
+
+}  // namespace
+
+AT24C32::AT24C32(i2c::Master i2c) : AT24C32(std::move(i2c), kDefaultAddress) {}
+
+AT24C32::AT24C32(i2c::Master i2c, uint8_t address)
+    : i2c_(std::move(i2c)), address_(address) {}
+
+bool AT24C32::begin() {
+  return waitReady();
+}
+
+bool AT24C32::waitReady() {
+  if (!busy_)
+    return ping(&i2c_, address_, __func__);
+  // Acknowledge polling: the EEPROM ignores its address until the write
+  // cycle completes.
+  const int64_t start = SystemClock::microsSinceStart();
+  while (!ping(&i2c_, address_, __func__)) {
+    if (SystemClock::microsSinceStart() - start > kWriteCycleTimeoutMicros)
+      return false;
+  }
+  busy_ = false;
+  return true;
+}
+
+bool AT24C32::read(uint16_t address, void* buf, size_t num_bytes) {
+  if (address + num_bytes > kSize)
+    return false;
+  if (busy_ && !waitReady())
+    return false;
+  // A random read: both bytes of the 12 bit address are written, high byte
+  // first (where i2clib sends a register), then a restart turns the bus
+  // around for the read.
+  auto op = createWriteOp(&i2c_, address_, address >> 8, "read");
+  if (!op.ready())
+    return false;
+  if (!op.WriteByte(address & 0xFF))
+    return false;
+  if (!op.Restart(i2c::Operation::Type::READ))
+    return false;
+  if (!op.Read(buf, num_bytes))
+    return false;
+  return op.Execute();
+}
+
+bool AT24C32::writePage(uint16_t address,
+                        const uint8_t* data,
+                        size_t num_bytes) {
+  if (busy_ && !waitReady())
+    return false;
+  auto op = createWriteOp(&i2c_, address_, address >> 8, "write");
+  if (!op.ready())
+    return false;
+  if (!op.WriteByte(address & 0xFF))
+    return false;
+  if (!op.Write(data, num_bytes))
+    return false;
+  if (!op.Execute())
+    return false;
+  busy_ = true;
+  page_writes_++;
+  return true;
+}
+
+bool AT24C32::write(uint16_t address, const void* buf, size_t num_bytes) {
+  if (address + num_bytes > kSize)
+    return false;
+  const uint8_t* data = static_cast<const uint8_t*>(buf);
+  while (num_bytes) {
+    // Within a page the address wraps, so never cross a page boundary.
+    size_t chunk = kPageSize - address % kPageSize;
+    if (chunk > num_bytes)
+      chunk = num_bytes;
+    if (!writePage(address, data, chunk))
+      return false;
+    address += chunk;
+    data += chunk;
+    num_bytes -= chunk;
+  }
+  return true;
+}
+
+}  // namespace rtc
@@ -0,0 +1,106 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/clock_discipline.h>
+
+#include <cmath>
+#include <cstdlib>
+
+#include <rtclib/software_clock.h>
+#include <rtclib/trace.h>
+
+namespace rtc {
+
+namespace {
+
+double clamp(double value, double limit) {
+  if (value > limit)
+    return limit;
+  if (value < -limit)
+    return -limit;
+  return value;
+}
+
+}  // namespace
+
+ClockDiscipline::ClockDiscipline(SoftwareClock* clock, const Config& config)
+    : clock_(clock), config_(config) {}
+
+ClockDiscipline::ClockDiscipline(SoftwareClock* clock)
+    : ClockDiscipline(clock, Config()) {}
+
+void ClockDiscipline::apply() {
+  clock_->adjustDriftPpb(
+      static_cast<int32_t>(std::lround(frequency_ + slew_ + feed_forward_)));
+}
+
+void ClockDiscipline::setFeedForwardPpb(int32_t ppb) {
+  feed_forward_ = ppb;
+  apply();
+}
+
+void ClockDiscipline::reset() {
+  frequency_ = 0;
+  slew_ = 0;
+  num_updates_ = 0;
+  fll_count_ = 0;
+  apply();
+}
+
+void ClockDiscipline::restore(int32_t frequency_ppb) {
+  frequency_ = clamp(frequency_ppb, config_.max_frequency);
+  slew_ = 0;
+  num_updates_ = 0;
+  fll_count_ = config_.fll_samples;
+  apply();
+}
+
+void ClockDiscipline::update(int64_t offset_micros) {
+  TraceScope trace("clock", "ClockDiscipline::update");
+  // Measured in the clock's own timebase, which is what its rate scales.
+  const int64_t now = clock_->ticks();
+  // Seconds since the previous update.
+  const double interval = (now - last_update_) * 1e-6;
+  // 1 µs/s is 1000 ppb.
+  const double offset_ppb_s = static_cast<double>(offset_micros) * 1000;
+
+  if (num_updates_ && interval > 0) {
+    if (locked() && std::llabs(offset_micros) > config_.fll_threshold)
+      fll_count_ = 0;
+
+    if (!locked()) {
+      // FLL: the change in offset over the interval is the difference
+      // between the required and the applied corrections. Both include the
+      // feed forward, which cancels out.
+      const double applied = frequency_ + slew_;
+      const double measured =
+          (offset_micros - last_offset_) * 1000 / interval + applied;
+      frequency_ = fll_count_ ? (frequency_ + measured) / 2 : measured;
+      fll_count_++;
+    } else {
+      // PLL: integrate the offset. Critically damped with the phase slew
+      // below.
+      const double tau = config_.time_constant;
+      frequency_ += offset_ppb_s * interval / (4 * tau * tau);
+    }
+    frequency_ = clamp(frequency_, config_.max_frequency);
+  }
+
+  // Slew the offset out over the time constant, or the measurement interval
+  // if longer, so that the slew doesn't overshoot before the next update.
+  const double tau = interval > config_.time_constant && num_updates_
+                         ? interval
+                         : config_.time_constant;
+  slew_ = clamp(offset_ppb_s / tau, config_.max_slew);
+
+  last_offset_ = offset_micros;
+  last_update_ = now;
+  num_updates_++;
+  apply();
+}
+
+}  // namespace rtc
@@ -0,0 +1,168 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/clock_fusion.h>
+
+#include <cmath>
+
+#include <rtclib/datetime.h>
+#include <rtclib/system_clock.h>
+
+namespace rtc {
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+
+// The variance of a reading truncated to whole seconds (µs²).
+constexpr double kQuantizationVariance = 1e12 / 12;
+
+// A PPS edge is only assigned a second when the estimate's standard
+// deviation is below this (µs).
+constexpr double kMaxPpsStddev = 250000.0 / 3;
+
+}  // namespace
+
+ClockFusion::ClockFusion(const Config& config) : config_(config) {}
+
+ClockFusion::ClockFusion() : ClockFusion(Config()) {}
+
+void ClockFusion::reset() {
+  initialized_ = false;
+  consecutive_rejections_ = 0;
+}
+
+// The covariance |seconds| from the state's timestamp: the offset moves by
+// frequency * seconds, and both grow by the SystemClock's noise either way.
+void ClockFusion::predict(double seconds,
+                          double* p00,
+                          double* p01,
+                          double* p11) const {
+  const double noise = static_cast<double>(config_.timer_noise) *
+                       config_.timer_noise;
+  const double wander_ppm = config_.timer_wander * 1e-3;
+  const double wander = wander_ppm * wander_ppm;
+  const double elapsed = std::fabs(seconds);
+  const double seconds2 = seconds * seconds;
+  *p00 = p00_ + 2 * seconds * p01_ + seconds2 * p11_ + noise * elapsed +
+         wander * seconds2 * elapsed / 3;
+  *p01 = p01_ + seconds * p11_ + wander * seconds * elapsed / 2;
+  *p11 = p11_ + wander * elapsed;
+}
+
+bool ClockFusion::update(int64_t local_micros,
+                         int64_t unix_micros,
+                         double variance) {
+  if (initialized_) {
+    if (local_micros < last_local_)
+      return false;
+    const double seconds =
+        static_cast<double>(local_micros - last_local_) / kMicrosPerSecond;
+    double p00, p01, p11;
+    predict(seconds, &p00, &p01, &p11);
+    const double offset = residual_ + frequency_ * seconds;
+    const double innovation =
+        static_cast<double>(unix_micros - local_micros - offset_) - offset;
+    const double innovation_variance = p00 + variance;
+    const double gate = config_.outlier_gate;
+    if (innovation * innovation < gate * gate * innovation_variance) {
+      const double k0 = p00 / innovation_variance;
+      const double k1 = p01 / innovation_variance;
+      residual_ = offset + k0 * innovation;
+      frequency_ += k1 * innovation;
+      p11_ = p11 - k1 * p01;
+      p00_ = (1 - k0) * p00;
+      p01_ = (1 - k0) * p01;
+      const double whole = std::floor(residual_);
+      offset_ += static_cast<int64_t>(whole);
+      residual_ -= whole;
+      last_local_ = local_micros;
+      consecutive_rejections_ = 0;
+      stats_.updates++;
+      return true;
+    }
+    stats_.rejections++;
+    if (++consecutive_rejections_ < config_.max_rejections)
+      return false;
+    stats_.resets++;
+  }
+  // Start over from this measurement, with the frequency unknown.
+  const double frequency_error = config_.initial_frequency_error;
+  initialized_ = true;
+  last_local_ = local_micros;
+  offset_ = unix_micros - local_micros;
+  residual_ = 0;
+  frequency_ = 0;
+  p00_ = variance;
+  p01_ = 0;
+  p11_ = frequency_error * frequency_error;
+  consecutive_rejections_ = 0;
+  stats_.updates++;
+  return true;
+}
+
+bool ClockFusion::addReference(int64_t local_micros,
+                               int64_t unix_micros,
+                               int64_t stddev_micros) {
+  const double stddev = static_cast<double>(stddev_micros);
+  // Floor the variance, so that an exact reference doesn't make the
+  // estimate singular.
+  return update(local_micros, unix_micros, stddev * stddev + 1);
+}
+
+bool ClockFusion::addPps(int64_t local_micros) {
+  int64_t unix_micros, stddev;
+  if (!estimate(local_micros, &unix_micros, &stddev) ||
+      stddev > kMaxPpsStddev) {
+    return false;
+  }
+  // The nearest whole second.
+  int64_t second = unix_micros / kMicrosPerSecond;
+  if (unix_micros % kMicrosPerSecond >= kMicrosPerSecond / 2)
+    second++;
+  const double jitter = static_cast<double>(config_.pps_jitter);
+  return update(local_micros, second * kMicrosPerSecond, jitter * jitter + 1);
+}
+
+bool ClockFusion::addRtc(int64_t local_micros, const DateTime& now) {
+  const double error = static_cast<double>(config_.rtc_error);
+  return update(
+      local_micros,
+      static_cast<int64_t>(now.unixtime()) * kMicrosPerSecond +
+          kMicrosPerSecond / 2,
+      kQuantizationVariance + error * error);
+}
+
+bool ClockFusion::estimate(int64_t local_micros,
+                           int64_t* unix_micros,
+                           int64_t* stddev_micros) const {
+  if (!initialized_)
+    return false;
+  const double seconds =
+      static_cast<double>(local_micros - last_local_) / kMicrosPerSecond;
+  *unix_micros = local_micros + offset_ +
+                 static_cast<int64_t>(
+                     std::llround(residual_ + frequency_ * seconds));
+  if (stddev_micros) {
+    double p00, p01, p11;
+    predict(seconds, &p00, &p01, &p11);
+    *stddev_micros = static_cast<int64_t>(std::ceil(std::sqrt(p00)));
+  }
+  return true;
+}
+
+bool ClockFusion::now(int64_t* unix_micros, int64_t* stddev_micros) const {
+  return estimate(SystemClock::microsSinceStart(), unix_micros,
+                  stddev_micros);
+}
+
+int32_t ClockFusion::frequencyPpb() const {
+  // The offset falls as a fast SystemClock gains on true time.
+  return static_cast<int32_t>(std::lround(-frequency_ * 1000));
+}
+
+}  // namespace rtc
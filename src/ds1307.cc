@@ -10,67 +10,61 @@
 
 #include <rtclib/ds1307.h>
 
+#include <cstring>
+
 #include <i2clib/master.h>
 #include <i2clib/operation.h>
 #include <rtclib/datetime.h>
+#include <rtclib/ds1307_registers.h>
+#include "instrumented_i2c.h"
+#include "register_dump.h"
 #include "rtc_util.h"
 
 namespace rtc {
 
 namespace {
 
-// clang-format off
-constexpr uint8_t DS1307_ADDRESS = 0x68;  ///< I2C address for DS1307
+using Registers = DS1307Registers;
 
-constexpr uint8_t REGISTER_TIME_SECONDS = 0x00;
-constexpr uint8_t REGISTER_TIME_MINUTES = 0x01;
-constexpr uint8_t REGISTER_TIME_HOURS   = 0x02;
-constexpr uint8_t REGISTER_TIME_DAY     = 0x03;
-constexpr uint8_t REGISTER_TIME_DATE    = 0x04;
-constexpr uint8_t REGISTER_TIME_MONTH   = 0x05;
-constexpr uint8_t REGISTER_TIME_YEAR    = 0x06;
-constexpr uint8_t REGISTER_CONTROL      = 0x07;
-constexpr uint8_t REGISTER_NVRAM        = 0x08; // NVRAM: 56 bytes, 0x08..0x3f.
+constexpr uint8_t DS1307_ADDRESS = Registers::kI2CAddress;
 
 /**
- * @brief controls the output level of the SQW/OUT pin when the square-wave
- *        output is disabled.
- * 
- * If SQWE = 0, the logic level on the SQW/OUT pin is 1 if OUT = 1 
- * and is 0 if OUT = 0.
+ * Decode the time registers, 0x00 - 0x06.
  */
-constexpr uint8_t CONTROL_OUT      = 0b10000000;
-constexpr uint8_t CONTROL_RESERVED = 0b01101100; // Unused register bits
-constexpr uint8_t CONTROL_SQWE     = 0b00010000;
-constexpr uint8_t CONTROL_RS1      = 0b00000010;
-constexpr uint8_t CONTROL_RS0      = 0b00000001;
-
-constexpr uint8_t CONTROL_SQW_OFF  = 0x0;
-constexpr uint8_t CONTROL_SQW_ON   = CONTROL_OUT;
-constexpr uint8_t CONTROL_SQW_1KH  = CONTROL_SQWE;
-constexpr uint8_t CONTROL_SQW_4KH  = CONTROL_SQWE | CONTROL_RS0;
-constexpr uint8_t CONTROL_SQW_8KH  = CONTROL_SQWE | CONTROL_RS1;
-constexpr uint8_t CONTROL_SQW_32KH = CONTROL_SQWE | CONTROL_RS0 | CONTROL_RS1;
+DateTime decodeTime(const uint8_t* values) {
+  const uint8_t ss =
+      bcd2bin(Registers::CH::set(values[Registers::kSeconds], 0));
+  const uint8_t mm = bcd2bin(values[Registers::kMinutes]);
+  const uint8_t hh = bcd2bin(values[Registers::kHours]);
+  // Skip day of week.
+  const uint8_t d = bcd2bin(values[Registers::kDate]);
+  const uint8_t m = bcd2bin(values[Registers::kMonth]);
+  const uint16_t y = 2000 + bcd2bin(values[Registers::kYear]);
 
-// clang-format on
+  return DateTime(y, m, d, hh, mm, ss);
+}
 
 }  // namespace
 
+constexpr FieldValue<DS1307::SqwPinMode> DS1307Registers::kSqwPinModes[];
+constexpr RegisterRestore DS1307Registers::kRestore[];
+
 DS1307::DS1307(i2c::Master i2c) : i2c_(std::move(i2c)) {}
 
 bool DS1307::begin(void) {
-  return i2c_.Ping(DS1307_ADDRESS);
+  return ping(&i2c_, DS1307_ADDRESS, __func__);
 }
 
 bool DS1307::isRunning(void) {
-  uint8_t value;
-  if (!i2c_.ReadRegister(DS1307_ADDRESS, REGISTER_TIME_SECONDS, &value))
+  uint8_t halted;
+  if (!readField<Registers::CH>(&i2c_, DS1307_ADDRESS, &halted, __func__))
     return false;
-  return !(value >> 7);
+  return !halted;
 }
 
 bool DS1307::adjust(const DateTime& dt) {
-  auto op = i2c_.CreateWriteOp(DS1307_ADDRESS, REGISTER_TIME_SECONDS, "adjust");
+  auto op = createWriteOp(&i2c_, DS1307_ADDRESS, Registers::kSeconds,
+                          "adjust");
   if (!op.ready())
     return false;
   const uint8_t values[7] = {
@@ -89,7 +83,7 @@ bool DS1307::adjust(const DateTime& dt) {
 }
 
 bool DS1307::now(DateTime* dt) {
-  auto op = i2c_.CreateReadOp(DS1307_ADDRESS, REGISTER_TIME_SECONDS, "now");
+  auto op = createReadOp(&i2c_, DS1307_ADDRESS, Registers::kSeconds, "now");
   if (!op.ready())
     return false;
   uint8_t values[7];  // for registers 0x00 - 0x06.
@@ -98,70 +92,61 @@ bool DS1307::now(DateTime* dt) {
   if (!op.Execute())
     return false;
 
-  const uint8_t ss = bcd2bin(values[REGISTER_TIME_SECONDS]);
-  const uint8_t mm = bcd2bin(values[REGISTER_TIME_MINUTES]);
-  const uint8_t hh = bcd2bin(values[REGISTER_TIME_HOURS]);
-  // Skip day of week.
-  const uint8_t d = bcd2bin(values[REGISTER_TIME_DATE]);
-  const uint8_t m = bcd2bin(values[REGISTER_TIME_MONTH]);
-  const uint16_t y = 2000 + bcd2bin(values[REGISTER_TIME_YEAR]);
+  *dt = decodeTime(values);
+  return true;
+}
 
-  *dt = DateTime(y, m, d, hh, mm, ss);
+bool DS1307::readSeconds(uint8_t* seconds) {
+  uint8_t bcd;
+  if (!readField<Registers::Seconds>(&i2c_, DS1307_ADDRESS, &bcd, __func__))
+    return false;
+  *seconds = bcd2bin(bcd);
+  return true;
+}
+
+bool DS1307::readBootState(DateTime* now,
+                           bool* running,
+                           uint8_t address,
+                           void* buf,
+                           size_t num_bytes) {
+  if (address + num_bytes > Registers::kNvramSize)
+    return false;
+  // Registers 0x00 to the end of the requested NVRAM.
+  uint8_t values[Registers::kNvram + Registers::kNvramSize];
+  const size_t count = Registers::kNvram + address + num_bytes;
+  auto op =
+      createReadOp(&i2c_, DS1307_ADDRESS, Registers::kSeconds, "bootState");
+  if (!op.ready())
+    return false;
+  if (!op.Read(values, count))
+    return false;
+  if (!op.Execute())
+    return false;
+
+  *now = decodeTime(values);
+  *running = !(values[Registers::kSeconds] & Registers::CH::kMask);
+  std::memcpy(buf, &values[Registers::kNvram + address], num_bytes);
   return true;
 }
 
 DS1307::SqwPinMode DS1307::readSqwPinMode() {
   uint8_t value;
-  if (!i2c_.ReadRegister(DS1307_ADDRESS, REGISTER_CONTROL, &value))
-    return DS1307::SqwPinMode::Off;
-
-  if (value & CONTROL_SQWE) {
-    switch (value & (CONTROL_RS0 | CONTROL_RS1)) {
-      case 0x0:
-        return SqwPinMode::Rate1Hz;
-      case CONTROL_RS0:
-        return SqwPinMode::Rate4kHz;
-      case CONTROL_RS1:
-        return SqwPinMode::Rate8kHz;
-      case CONTROL_RS1 | CONTROL_RS0:
-        return SqwPinMode::Rate32kHz;
-      default:
-        // unreachable
-        return SqwPinMode::Off;
-    }
-  } else {
-    return value & CONTROL_OUT ? SqwPinMode::On : SqwPinMode::Off;
+  if (!readRegister(&i2c_, DS1307_ADDRESS, Registers::kControl, &value,
+                    __func__)) {
+    return SqwPinMode::Off;
   }
+  return Registers::sqwPinMode(value);
 }
 
 bool DS1307::writeSqwPinMode(SqwPinMode mode) {
-  uint8_t reg_value = 0x0;
-  switch (mode) {
-    case SqwPinMode::Off:
-      reg_value = CONTROL_SQW_OFF;
-      break;
-    case SqwPinMode::On:
-      reg_value = CONTROL_SQW_ON;
-      break;
-    case SqwPinMode::Rate1Hz:
-      reg_value = CONTROL_SQW_1KH;
-      break;
-    case SqwPinMode::Rate4kHz:
-      reg_value = CONTROL_SQW_4KH;
-      break;
-    case SqwPinMode::Rate8kHz:
-      reg_value = CONTROL_SQW_8KH;
-      break;
-    case SqwPinMode::Rate32kHz:
-      reg_value = CONTROL_SQW_32KH;
-      break;
-  }
-  return i2c_.WriteRegister(DS1307_ADDRESS, REGISTER_CONTROL, reg_value);
+  // The other control register bits are unused.
+  return writeRegister(&i2c_, DS1307_ADDRESS, Registers::kControl,
+                       encodeField(Registers::kSqwPinModes, mode), __func__);
 }
 
 bool DS1307::readnvram(uint8_t address, void* buf, size_t num_bytes) {
-  auto op =
-      i2c_.CreateReadOp(DS1307_ADDRESS, REGISTER_NVRAM + address, "readnvram");
+  auto op = createReadOp(&i2c_, DS1307_ADDRESS, Registers::kNvram + address,
+                         "readnvram");
   if (!op.ready())
     return false;
   if (!op.Read(buf, num_bytes))
@@ -170,8 +155,8 @@ bool DS1307::readnvram(uint8_t address, void* buf, size_t num_bytes) {
 }
 
 bool DS1307::writeNVRAM(uint8_t address, const void* buf, size_t num_bytes) {
-  auto op = i2c_.CreateWriteOp(DS1307_ADDRESS, REGISTER_NVRAM + address,
-                               "writeNVRAM");
+  auto op = createWriteOp(&i2c_, DS1307_ADDRESS, Registers::kNvram + address,
+                          "writeNVRAM");
   if (!op.ready())
     return false;
   if (!op.Write(buf, num_bytes))
@@ -179,4 +164,26 @@ bool DS1307::writeNVRAM(uint8_t address, const void* buf, size_t num_bytes) {
   return op.Execute();
 }
 
+bool DS1307::dumpRegisters(uint8_t* values) {
+  return readRegisterDump(&i2c_, DS1307_ADDRESS, values, kNumRegisters,
+                          __func__);
+}
+
+bool DS1307::restoreRegisters(const uint8_t* values) {
+  return writeRegisterDump(&i2c_, DS1307_ADDRESS, values, Registers::kRestore,
+                           kNumRegisters, __func__);
+}
+
+bool DS1307Nvram::read(uint16_t address, void* buf, size_t num_bytes) {
+  if (address + num_bytes > size())
+    return false;
+  return rtc_->readnvram(static_cast<uint8_t>(address), buf, num_bytes);
+}
+
+bool DS1307Nvram::write(uint16_t address, const void* buf, size_t num_bytes) {
+  if (address + num_bytes > size())
+    return false;
+  return rtc_->writeNVRAM(static_cast<uint8_t>(address), buf, num_bytes);
+}
+
 }  // namespace rtc
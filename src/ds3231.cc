@@ -15,6 +15,9 @@
 #include <i2clib/master.h>
 #include <i2clib/operation.h>
 #include <rtclib/datetime.h>
+#include <rtclib/ds3231_registers.h>
+#include "instrumented_i2c.h"
+#include "register_dump.h"
 #include "rtc_util.h"
 
 using i2c::Operation;
@@ -23,69 +26,9 @@ namespace rtc {
 
 namespace {
 
-// clang-format off
-
-constexpr uint8_t DS3231_I2C_ADDRESS = 0x68;
-
-constexpr uint8_t REGISTER_TIME_SECONDS   = 0x00;
-constexpr uint8_t REGISTER_TIME_MINUTES   = 0x01;
-constexpr uint8_t REGISTER_TIME_HOURS     = 0x02;
-constexpr uint8_t REGISTER_TIME_DAY       = 0x03;
-constexpr uint8_t REGISTER_TIME_DATE      = 0x04;
-constexpr uint8_t REGISTER_TIME_MONTH     = 0x05;
-constexpr uint8_t REGISTER_TIME_YEAR      = 0x06;
-constexpr uint8_t REGISTER_ALARM1_SECONDS = 0x07;
-constexpr uint8_t REGISTER_ALARM2_MINUTES = 0x0B;
-constexpr uint8_t REGISTER_CONTROL        = 0x0E;
-constexpr uint8_t REGISTER_STATUS         = 0x0F;
-constexpr uint8_t REGISTER_AGING_OFFSET   = 0x10;
-constexpr uint8_t REGISTER_TEMP_MSB       = 0x11;
-constexpr uint8_t REGISTER_TEMP_LSB       = 0x12;
-
-constexpr uint8_t CONTROL_EOSC  = 0b10000000; // Enable oscillator.
-constexpr uint8_t CONTROL_BBSQW = 0b01000000; // Battery backed square wave.
-constexpr uint8_t CONTROL_CONV  = 0b00100000; // Convert temperature.
-constexpr uint8_t CONTROL_RS2   = 0b00010000; // Rate select bit 2.
-constexpr uint8_t CONTROL_RS1   = 0b00001000; // Rate select bit 1.
-constexpr uint8_t CONTROL_INTCN = 0b00000100; // Interrupt control.
-constexpr uint8_t CONTROL_A2IE  = 0b00000010; // Alarm 2 interrupt enable.
-constexpr uint8_t CONTROL_A1IE  = 0b00000001; // Alarm 1 interrupt enable.
-
-constexpr uint8_t STATUS_OSF     = 0b10000000; // Oscillator stop flag.
-constexpr uint8_t STATUS_UNUSED  = 0b01110000; // Unused register bits.
-constexpr uint8_t STATUS_EN32kHz = 0b00001000; // Enable 32kHz output.
-constexpr uint8_t STATUS_BSY     = 0b00000100; // Busy.
-constexpr uint8_t STATUS_A2F     = 0b00000010; // Alarm 2 flag.
-constexpr uint8_t STATUS_A1F     = 0b00000001; // Alarm 1 flag.
-
-constexpr uint8_t A1M1_ENABLE  = 0b10000000;
-constexpr uint8_t A1M1_SECONDS = 0b01111111;
-constexpr uint8_t A1M2_ENABLE  = 0b10000000;
-constexpr uint8_t A1M2_MINUTES = 0b01111111;
-constexpr uint8_t A1M3_ENABLE  = 0b10000000;
-constexpr uint8_t A1M3_12_24   = 0b01000000;
-constexpr uint8_t A1M3_AM_PM   = 0b00100000;
-constexpr uint8_t A1M3_HOURS   = 0b00011111;
-constexpr uint8_t A1M4_ENABLE  = 0b10000000;
-constexpr uint8_t A1M4_DY_DT   = 0b01000000;
-constexpr uint8_t A1M4_DATE    = 0b00111111;
-
-constexpr uint8_t A2M2_ENABLE  = 0b10000000;
-constexpr uint8_t A2M2_MINUTES = 0b01111111;
-constexpr uint8_t A2M3_ENABLE  = 0b10000000;
-constexpr uint8_t A2M3_12_24   = 0b01000000;
-constexpr uint8_t A2M3_AM_PM   = 0b00100000;
-constexpr uint8_t A2M3_HOURS   = 0b00011111;
-constexpr uint8_t A2M4_ENABLE  = 0b10000000;
-constexpr uint8_t A2M4_DY_DT   = 0b01000000;
-constexpr uint8_t A2M4_DATE    = 0b00111111;
-
-// clang-format on
-
-constexpr uint8_t kSquareWave1Hz = 0x0;
-constexpr uint8_t kSquareWave1kHz = CONTROL_RS1;
-constexpr uint8_t kSquareWave4kHz = CONTROL_RS2;
-constexpr uint8_t kSquareWave8kHz = CONTROL_RS2 | CONTROL_RS1;
+using Registers = DS3231Registers;
+
+constexpr uint8_t DS3231_I2C_ADDRESS = Registers::kI2CAddress;
 
 /**
  * Convert the day of the week to a representation suitable for
@@ -98,49 +41,86 @@ uint8_t dowToDS3231(uint8_t d) {
   return d == 0 ? 7 : d;
 }
 
+/**
+ * Decode the time registers, 0x00 - 0x06.
+ */
+DateTime decodeTime(const uint8_t* values) {
+  // BUG: Correctly handle the DY/DT flag. This assumes always date.
+  return DateTime(2000U + bcd2bin(values[Registers::kYear]),
+                  bcd2bin(values[Registers::kMonth]),
+                  bcd2bin(values[Registers::kDate]),
+                  bcd2bin(values[Registers::kHours]),
+                  bcd2bin(values[Registers::kMinutes]),
+                  bcd2bin(values[Registers::kSeconds]));
+}
+
 }  // anonymous namespace
 
+constexpr FieldValue<DS3231::SqwPinMode> DS3231Registers::kSqwPinModes[];
+constexpr RegisterRestore DS3231Registers::kRestore[];
+
 DS3231::DS3231(i2c::Master i2c) : i2c_(std::move(i2c)) {}
 
 bool DS3231::begin(void) {
-  return i2c_.Ping(DS3231_I2C_ADDRESS);
+  return ping(&i2c_, DS3231_I2C_ADDRESS, __func__);
 }
 
 bool DS3231::lostPower(void) {
-  uint8_t reg_val;
-  if (!i2c_.ReadRegister(DS3231_I2C_ADDRESS, REGISTER_STATUS, &reg_val))
+  bool lost_power;
+  if (!lostPower(&lost_power))
     return true;  // Can't read, assume true.
-  return reg_val & STATUS_OSF;
+  return lost_power;
 }
 
-bool DS3231::adjust(const DateTime& dt) {
-  {
-    auto op =
-        i2c_.CreateWriteOp(DS3231_I2C_ADDRESS, REGISTER_TIME_SECONDS, "adjust");
-    if (!op.ready())
-      return false;
-    const uint8_t values[7] = {
-        bin2bcd(dt.second()),       bin2bcd(dt.minute()),
-        bin2bcd(dt.hour()),         bin2bcd(dowToDS3231(dt.dayOfTheWeek())),
-        bin2bcd(dt.day()),          bin2bcd(dt.month()),
-        bin2bcd(dt.year() - 2000U),
-    };
-
-    op.Write(values, sizeof(values));
-    if (!op.Execute())
-      return false;
+bool DS3231::lostPower(bool* lost_power) {
+  uint8_t osf;
+  if (!readField<Registers::OSF>(&i2c_, DS3231_I2C_ADDRESS, &osf, __func__))
+    return false;
+  *lost_power = osf;
+  return true;
+}
+
+bool DS3231::prepareAdjust() {
+  if (!readRegister(&i2c_, DS3231_I2C_ADDRESS, Registers::kStatus,
+                    &adjust_status_, __func__)) {
+    return false;
   }
+  adjust_prepared_ = true;
+  return true;
+}
 
-  uint8_t status;
-  if (!i2c_.ReadRegister(DS3231_I2C_ADDRESS, REGISTER_STATUS, &status))
+bool DS3231::adjust(const DateTime& dt) {
+  if (!adjust_prepared_ && !prepareAdjust())
+    return false;
+  adjust_prepared_ = false;
+  // The countdown chain restarts as the seconds byte is written (see
+  // PrecisionSetter). OSF is cleared in the same transaction, so that it is
+  // only ever cleared along with the time.
+  auto op = createWriteOp(&i2c_, DS3231_I2C_ADDRESS, Registers::kSeconds,
+                          "adjust");
+  if (!op.ready())
     return false;
-  status &= ~STATUS_OSF;  // flip OSF bit
-  return i2c_.WriteRegister(DS3231_I2C_ADDRESS, REGISTER_STATUS, status);
+  const uint8_t values[7] = {
+      bin2bcd(dt.second()),       bin2bcd(dt.minute()),
+      bin2bcd(dt.hour()),         bin2bcd(dowToDS3231(dt.dayOfTheWeek())),
+      bin2bcd(dt.day()),          bin2bcd(dt.month()),
+      bin2bcd(dt.year() - 2000U),
+  };
+  op.Write(values, sizeof(values));
+
+  // The alarm flags can only be written to zero: writing one leaves them
+  // unchanged.
+  constexpr uint8_t kAlarmFlags =
+      Registers::A1F::kMask | Registers::A2F::kMask;
+  op.RestartReg(Registers::kStatus, Operation::Type::WRITE);
+  op.WriteByte(Registers::OSF::set(adjust_status_ | kAlarmFlags, 0));
+  return op.Execute();
 }
 
 bool DS3231::now(DateTime* dt) {
   uint8_t values[7];  // for registers 0x00 - 0x06.
-  auto op = i2c_.CreateReadOp(DS3231_I2C_ADDRESS, REGISTER_TIME_SECONDS, "now");
+  auto op = createReadOp(&i2c_, DS3231_I2C_ADDRESS, Registers::kSeconds,
+                         "now");
   if (!op.ready())
     return false;
   if (!op.Read(values, sizeof(values)))
@@ -148,68 +128,55 @@ bool DS3231::now(DateTime* dt) {
   if (!op.Execute())
     return false;
 
-  // BUG: Correctly handle the DY/DT flag. This assumes always date.
-  *dt = DateTime(2000U + bcd2bin(values[REGISTER_TIME_YEAR]),
-                 bcd2bin(values[REGISTER_TIME_MONTH]),
-                 bcd2bin(values[REGISTER_TIME_DATE]),
-                 bcd2bin(values[REGISTER_TIME_HOURS]),
-                 bcd2bin(values[REGISTER_TIME_MINUTES]),
-                 bcd2bin(values[REGISTER_TIME_SECONDS]));
+  *dt = decodeTime(values);
   return true;
 }
 
-DS3231::SqwPinMode DS3231::readSqwPinMode() {
-  uint8_t value;
-  if (!i2c_.ReadRegister(DS3231_I2C_ADDRESS, REGISTER_CONTROL, &value))
-    return SqwPinMode::Off;
-
-  if (value & CONTROL_INTCN)
-    return SqwPinMode::Off;
-
-  switch (value & (CONTROL_RS2 | CONTROL_RS1)) {
-    case kSquareWave1Hz:
-      return SqwPinMode::Rate1Hz;
-    case kSquareWave1kHz:
-      return SqwPinMode::Rate1kHz;
-    case kSquareWave4kHz:
-      return SqwPinMode::Rate4kHz;
-    case kSquareWave8kHz:
-      return SqwPinMode::Rate8kHz;
-  }
-
-  return static_cast<SqwPinMode>(value &
-                                 (CONTROL_RS2 | CONTROL_RS1 | CONTROL_INTCN));
+bool DS3231::readSeconds(uint8_t* seconds) {
+  uint8_t bcd;
+  if (!readField<Registers::Seconds>(&i2c_, DS3231_I2C_ADDRESS, &bcd, __func__))
+    return false;
+  *seconds = bcd2bin(bcd);
+  return true;
 }
 
-bool DS3231::writeSqwPinMode(SqwPinMode mode) {
-  uint8_t ctrl;
-  if (!i2c_.ReadRegister(DS3231_I2C_ADDRESS, REGISTER_CONTROL, &ctrl))
+bool DS3231::readBootState(DateTime* now,
+                           bool* lost_power,
+                           int8_t* aging_offset) {
+  uint8_t values[Registers::kAgingOffset + 1];  // for registers 0x00 - 0x10.
+  auto op = createReadOp(&i2c_, DS3231_I2C_ADDRESS, Registers::kSeconds,
+                         "bootState");
+  if (!op.ready())
+    return false;
+  if (!op.Read(values, sizeof(values)))
+    return false;
+  if (!op.Execute())
     return false;
 
-  CLEAR_BITS(ctrl, CONTROL_RS2 | CONTROL_RS1 | CONTROL_INTCN);
-  switch (mode) {
-    case SqwPinMode::Off:
-      SET_BITS(ctrl, CONTROL_INTCN);
-      break;
-    case SqwPinMode::Rate1Hz:
-      SET_BITS(ctrl, kSquareWave1Hz);
-      break;
-    case SqwPinMode::Rate1kHz:
-      SET_BITS(ctrl, kSquareWave1kHz);
-      break;
-    case SqwPinMode::Rate4kHz:
-      SET_BITS(ctrl, kSquareWave4kHz);
-      break;
-    case SqwPinMode::Rate8kHz:
-      SET_BITS(ctrl, kSquareWave8kHz);
-      break;
+  *now = decodeTime(values);
+  *lost_power = Registers::OSF::get(values[Registers::kStatus]);
+  *aging_offset = static_cast<int8_t>(values[Registers::kAgingOffset]);
+  return true;
+}
+
+DS3231::SqwPinMode DS3231::readSqwPinMode() {
+  uint8_t bits;
+  if (!readField<Registers::SquareWave>(&i2c_, DS3231_I2C_ADDRESS, &bits,
+                                        __func__)) {
+    return SqwPinMode::Off;
   }
+  return decodeField(Registers::kSqwPinModes, bits, SqwPinMode::Off);
+}
 
-  return i2c_.WriteRegister(DS3231_I2C_ADDRESS, REGISTER_CONTROL, ctrl);
+bool DS3231::writeSqwPinMode(SqwPinMode mode) {
+  return writeField<Registers::SquareWave>(
+      &i2c_, DS3231_I2C_ADDRESS, encodeField(Registers::kSqwPinModes, mode),
+      __func__);
 }
 
 float DS3231::getTemperature() {
-  auto op = i2c_.CreateReadOp(DS3231_I2C_ADDRESS, REGISTER_TEMP_MSB, "getTemp");
+  auto op = createReadOp(&i2c_, DS3231_I2C_ADDRESS, Registers::kTempMsb,
+                         "getTemp");
   if (!op.ready())
     return std::numeric_limits<int16_t>::max();
   uint8_t values[2];  // MSB and LSB respectively.
@@ -220,21 +187,28 @@ float DS3231::getTemperature() {
   // with 0.25°C accuracy. See DSD3231 spec pg. 15.
   // Multiply/divide by four as left-shifting a signed integer is undefined
   // according to the C++ spec.
-  const int16_t msb = static_cast<int16_t>(values[0]);
+  const int16_t msb = static_cast<int8_t>(values[0]);
   const uint8_t lsb = (values[1] >> 6);
   return static_cast<float>(msb * 4 + lsb) * 0.25f;
 }
 
 bool DS3231::getAgingOffset(int8_t* val) {
-  return i2c_.ReadRegister(DS3231_I2C_ADDRESS, REGISTER_AGING_OFFSET,
-                           reinterpret_cast<uint8_t*>(val));
+  return readRegister(&i2c_, DS3231_I2C_ADDRESS, Registers::kAgingOffset,
+                      reinterpret_cast<uint8_t*>(val), __func__);
+}
+
+bool DS3231::setAgingOffset(int8_t val) {
+  return writeRegister(&i2c_, DS3231_I2C_ADDRESS, Registers::kAgingOffset,
+                       static_cast<uint8_t>(val), __func__);
 }
 
 bool DS3231::setAlarm1(const DateTime& dt, Alarm1Mode alarm_mode) {
   uint8_t ctrl;
-  i2c_.ReadRegister(DS3231_I2C_ADDRESS, REGISTER_CONTROL, &ctrl);
-  if (!(ctrl & CONTROL_INTCN))
+  if (!readRegister(&i2c_, DS3231_I2C_ADDRESS, Registers::kControl, &ctrl,
+                    __func__) ||
+      !Registers::INTCN::get(ctrl)) {
     return false;
+  }
 
   uint8_t values[4] = {
       bin2bcd(dt.second()), bin2bcd(dt.minute()), bin2bcd(dt.hour()),
@@ -243,33 +217,33 @@ bool DS3231::setAlarm1(const DateTime& dt, Alarm1Mode alarm_mode) {
   // See table 2 in datasheet.
   switch (alarm_mode) {
     case Alarm1Mode::EverySecond:
-      SET_BITS(values[0], A1M1_ENABLE);
+      values[0] = Registers::A1M1::set(values[0], 1);
       // fallthrough.
     case Alarm1Mode::Second:
-      SET_BITS(values[1], A1M2_ENABLE);
+      values[1] = Registers::A1M2::set(values[1], 1);
       // fallthrough.
     case Alarm1Mode::Minute:
-      SET_BITS(values[2], A1M3_ENABLE);
+      values[2] = Registers::A1M3::set(values[2], 1);
       // fallthrough.
     case Alarm1Mode::Hour:
-      SET_BITS(values[3], A1M4_ENABLE);
+      values[3] = Registers::A1M4::set(values[3], 1);
       break;
     case Alarm1Mode::Date:
       // Do nothing. All bits should be clear.
       break;
     case Alarm1Mode::Day:
-      SET_BITS(values[3], A1M4_DY_DT);
+      values[3] = Registers::A1DY::set(values[3], 1);
       break;
   }
 
-  auto op = i2c_.CreateWriteOp(DS3231_I2C_ADDRESS, REGISTER_ALARM1_SECONDS,
-                               "setalm1");
+  auto op = createWriteOp(&i2c_, DS3231_I2C_ADDRESS, Registers::kAlarm1Seconds,
+                          "setalm1");
   if (!op.ready())
     return false;
   op.Write(values, sizeof(values));
 
-  op.RestartReg(REGISTER_CONTROL, Operation::Type::WRITE);
-  SET_BITS(ctrl, CONTROL_A1IE);
+  op.RestartReg(Registers::kControl, Operation::Type::WRITE);
+  ctrl = Registers::A1IE::set(ctrl, 1);
   op.WriteByte(ctrl);
 
   return op.Execute();
@@ -277,9 +251,11 @@ bool DS3231::setAlarm1(const DateTime& dt, Alarm1Mode alarm_mode) {
 
 bool DS3231::setAlarm2(const DateTime& dt, Alarm2Mode alarm_mode) {
   uint8_t ctrl;
-  i2c_.ReadRegister(DS3231_I2C_ADDRESS, REGISTER_CONTROL, &ctrl);
-  if (!(ctrl & CONTROL_INTCN))
+  if (!readRegister(&i2c_, DS3231_I2C_ADDRESS, Registers::kControl, &ctrl,
+                    __func__) ||
+      !Registers::INTCN::get(ctrl)) {
     return false;
+  }
 
   uint8_t values[3] = {
       bin2bcd(dt.minute()), bin2bcd(dt.hour()),
@@ -287,84 +263,119 @@ bool DS3231::setAlarm2(const DateTime& dt, Alarm2Mode alarm_mode) {
 
   switch (alarm_mode) {
     case Alarm2Mode::EveryMinute:
-      SET_BITS(values[0], A2M2_ENABLE);
+      values[0] = Registers::A2M2::set(values[0], 1);
       // fallthrough.
     case Alarm2Mode::Minute:
-      SET_BITS(values[1], A2M3_ENABLE);
+      values[1] = Registers::A2M3::set(values[1], 1);
       // fallthrough.
     case Alarm2Mode::Hour:
-      SET_BITS(values[2], A2M4_ENABLE);
+      values[2] = Registers::A2M4::set(values[2], 1);
       break;
     case Alarm2Mode::Date:
       // Do nothing. All bits should be clear.
       break;
     case Alarm2Mode::Day:
-      SET_BITS(values[2], A2M4_DY_DT);
+      values[2] = Registers::A2DY::set(values[2], 1);
       break;
   }
 
-  auto op = i2c_.CreateWriteOp(DS3231_I2C_ADDRESS, REGISTER_ALARM2_MINUTES,
-                               "setalm2");
+  auto op = createWriteOp(&i2c_, DS3231_I2C_ADDRESS, Registers::kAlarm2Minutes,
+                          "setalm2");
   if (!op.ready())
     return false;
   op.Write(values, sizeof(values));
 
-  op.RestartReg(REGISTER_CONTROL, Operation::Type::WRITE);
-  SET_BITS(ctrl, CONTROL_A2IE);
+  op.RestartReg(Registers::kControl, Operation::Type::WRITE);
+  ctrl = Registers::A2IE::set(ctrl, 1);
   op.WriteByte(ctrl);
 
   return op.Execute();
 }
 
-void DS3231::disableAlarm(Alarm alarm) {
-  uint8_t ctrl = 0;
-  i2c_.ReadRegister(DS3231_I2C_ADDRESS, REGISTER_CONTROL, &ctrl);
+bool DS3231::disableAlarm(Alarm alarm) {
+  uint8_t ctrl;
+  if (!readRegister(&i2c_, DS3231_I2C_ADDRESS, Registers::kControl, &ctrl,
+                    __func__)) {
+    return false;
+  }
   if (alarm == Alarm::A1)
-    CLEAR_BITS(ctrl, CONTROL_A1IE);
+    ctrl = Registers::A1IE::set(ctrl, 0);
   else
-    CLEAR_BITS(ctrl, CONTROL_A2IE);
-  i2c_.WriteRegister(DS3231_I2C_ADDRESS, REGISTER_CONTROL, ctrl);
+    ctrl = Registers::A2IE::set(ctrl, 0);
+  return writeRegister(&i2c_, DS3231_I2C_ADDRESS, Registers::kControl, ctrl,
+                       __func__);
 }
 
-void DS3231::clearAlarm(Alarm alarm) {
+bool DS3231::clearAlarm(Alarm alarm) {
   uint8_t status;
-  if (!i2c_.ReadRegister(DS3231_I2C_ADDRESS, REGISTER_STATUS, &status))
-    return;
+  if (!readRegister(&i2c_, DS3231_I2C_ADDRESS, Registers::kStatus, &status,
+                    __func__)) {
+    return false;
+  }
   if (alarm == Alarm::A1)
-    CLEAR_BITS(status, STATUS_A1F);
+    status = Registers::A1F::set(status, 0);
   else
-    CLEAR_BITS(status, STATUS_A2F);
-  i2c_.WriteRegister(DS3231_I2C_ADDRESS, REGISTER_STATUS, status);
+    status = Registers::A2F::set(status, 0);
+  return writeRegister(&i2c_, DS3231_I2C_ADDRESS, Registers::kStatus, status,
+                       __func__);
 }
 
 bool DS3231::isAlarmFired(Alarm alarm) {
   uint8_t status;
-  if (!i2c_.ReadRegister(DS3231_I2C_ADDRESS, REGISTER_STATUS, &status))
+  if (!readRegister(&i2c_, DS3231_I2C_ADDRESS, Registers::kStatus, &status,
+                    __func__)) {
     return false;
-  return alarm == Alarm::A1 ? status & STATUS_A1F : status & STATUS_A2F;
+  }
+  return alarm == Alarm::A1 ? Registers::A1F::get(status)
+                            : Registers::A2F::get(status);
 }
 
-void DS3231::enable32K(void) {
+bool DS3231::readAndClearAlarms(bool* a1_fired, bool* a2_fired) {
   uint8_t status;
-  if (!i2c_.ReadRegister(DS3231_I2C_ADDRESS, REGISTER_STATUS, &status))
-    return;
-  SET_BITS(status, STATUS_EN32kHz);
-  i2c_.WriteRegister(DS3231_I2C_ADDRESS, REGISTER_STATUS, status);
+  if (!readRegister(&i2c_, DS3231_I2C_ADDRESS, Registers::kStatus, &status,
+                    __func__)) {
+    return false;
+  }
+  constexpr uint8_t kFlags = Registers::A1F::kMask | Registers::A2F::kMask;
+  const uint8_t fired = status & kFlags;
+  *a1_fired = Registers::A1F::get(fired);
+  *a2_fired = Registers::A2F::get(fired);
+  if (!fired)
+    return true;
+  // The alarm flags can only be written to zero: writing one to the flag
+  // which hasn't fired leaves it unchanged.
+  return writeRegister(&i2c_, DS3231_I2C_ADDRESS, Registers::kStatus,
+                       (status | kFlags) & ~fired, __func__);
+}
+
+void DS3231::enable32K(void) {
+  adjust_prepared_ = false;  // The status changes.
+  writeField<Registers::EN32kHz>(&i2c_, DS3231_I2C_ADDRESS, 1, __func__);
 }
 
 void DS3231::disable32K(void) {
-  uint8_t status;
-  if (!i2c_.ReadRegister(DS3231_I2C_ADDRESS, REGISTER_STATUS, &status))
-    return;
-  CLEAR_BITS(status, STATUS_EN32kHz);
-  i2c_.WriteRegister(DS3231_I2C_ADDRESS, REGISTER_STATUS, status);
+  adjust_prepared_ = false;  // The status changes.
+  writeField<Registers::EN32kHz>(&i2c_, DS3231_I2C_ADDRESS, 0, __func__);
 }
 
 bool DS3231::isEnabled32K(void) {
-  uint8_t status;
-  if (!i2c_.ReadRegister(DS3231_I2C_ADDRESS, REGISTER_STATUS, &status))
+  uint8_t enabled;
+  if (!readField<Registers::EN32kHz>(&i2c_, DS3231_I2C_ADDRESS, &enabled,
+                                     __func__)) {
     return false;
-  return status & STATUS_EN32kHz;
+  }
+  return enabled;
+}
+
+bool DS3231::dumpRegisters(uint8_t* values) {
+  return readRegisterDump(&i2c_, DS3231_I2C_ADDRESS, values, kNumRegisters,
+                          __func__);
+}
+
+bool DS3231::restoreRegisters(const uint8_t* values) {
+  adjust_prepared_ = false;  // The status changes.
+  return writeRegisterDump(&i2c_, DS3231_I2C_ADDRESS, values,
+                           Registers::kRestore, kNumRegisters, __func__);
 }
 
 }  // namespace rtc
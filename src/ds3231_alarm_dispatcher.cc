@@ -0,0 +1,94 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/ds3231_alarm_dispatcher.h>
+
+#include <utility>
+
+#include <rtclib/system_clock.h>
+#include <rtclib/trace.h>
+
+namespace rtc {
+
+DS3231AlarmDispatcher::DS3231AlarmDispatcher(DS3231* rtc,
+                                             InterruptSource* source)
+    : rtc_(rtc), source_(source) {}
+
+DS3231AlarmDispatcher::~DS3231AlarmDispatcher() {
+  end();
+}
+
+void DS3231AlarmDispatcher::addHandler(DS3231::Alarm alarm, Handler handler) {
+  handlers_.push_back({alarm, std::move(handler)});
+}
+
+void DS3231AlarmDispatcher::setWakeup(InterruptSource::Isr wakeup,
+                                      void* arg) {
+  wakeup_ = wakeup;
+  wakeup_arg_ = arg;
+}
+
+// static
+void DS3231AlarmDispatcher::isr(void* arg) {
+  DS3231AlarmDispatcher* dispatcher = static_cast<DS3231AlarmDispatcher*>(arg);
+  if (!dispatcher->events_.push({SystemClock::microsSinceStart()}))
+    dispatcher->overflows_.fetch_add(1, std::memory_order_relaxed);
+  if (dispatcher->wakeup_)
+    dispatcher->wakeup_(dispatcher->wakeup_arg_);
+}
+
+bool DS3231AlarmDispatcher::begin() {
+  // INT/SQW may already be asserted, in which case there will be no edge:
+  // queue a check. The queue has a single producer, so the ISR must not be
+  // attached, as it is if begin() is called again.
+  source_->detach();
+  events_.push({SystemClock::microsSinceStart()});
+  return source_->attach(&DS3231AlarmDispatcher::isr, this);
+}
+
+void DS3231AlarmDispatcher::end() {
+  source_->detach();
+}
+
+bool DS3231AlarmDispatcher::service() {
+  // All queued interrupts are handled by one status read. The earliest
+  // timestamp is the best estimate of when the alarms fired.
+  bool interrupted = retry_;
+  int64_t micros = retry_micros_;
+  Event event;
+  while (events_.pop(&event)) {
+    if (!interrupted)
+      micros = event.micros;
+    interrupted = true;
+  }
+  if (!interrupted)
+    return true;
+
+  TraceScope trace("alarm", "DS3231AlarmDispatcher::service");
+  bool a1, a2;
+  if (!rtc_->readAndClearAlarms(&a1, &a2)) {
+    retry_ = true;
+    retry_micros_ = micros;
+    return false;
+  }
+  retry_ = false;
+
+  // Handlers may add handlers, which can reallocate handlers_: run a copy
+  // of each, and only those present before the first ran.
+  const size_t num_handlers = handlers_.size();
+  for (size_t i = 0; i < num_handlers; i++) {
+    const DS3231::Alarm alarm = handlers_[i].alarm;
+    if ((alarm == DS3231::Alarm::A1 && a1) ||
+        (alarm == DS3231::Alarm::A2 && a2)) {
+      const Handler handler = handlers_[i].handler;
+      handler(alarm, micros);
+    }
+  }
+  return true;
+}
+
+}  // namespace rtc
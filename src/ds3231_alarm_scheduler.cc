@@ -0,0 +1,208 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/ds3231_alarm_scheduler.h>
+
+#include <utility>
+
+#include <rtclib/datetime.h>
+
+namespace rtc {
+
+namespace {
+
+// An AlarmId is the slot generation in the high 32 bits and the slot
+// index + 1 in the low 32 bits, so that a stale id never matches a reused
+// slot. An Entry holds a 32-bit slot index, so ids never alias.
+constexpr uint64_t kSlotMask = 0xFFFFFFFF;
+constexpr int kGenerationShift = 32;
+
+}  // namespace
+
+DS3231AlarmScheduler::DS3231AlarmScheduler(DS3231* rtc) : rtc_(rtc) {}
+
+bool DS3231AlarmScheduler::begin() {
+  armed_ = false;
+  return rtc_->disableAlarm(DS3231::Alarm::A1) &&
+         rtc_->clearAlarm(DS3231::Alarm::A1);
+}
+
+// static
+bool DS3231AlarmScheduler::earlier(const Entry& a, const Entry& b) {
+  if (a.when != b.when)
+    return a.when < b.when;
+  return static_cast<int32_t>(a.seq - b.seq) < 0;
+}
+
+DS3231AlarmScheduler::AlarmId DS3231AlarmScheduler::idOf(
+    uint32_t slot) const {
+  return (static_cast<uint64_t>(slots_[slot].generation) << kGenerationShift) |
+         (static_cast<uint64_t>(slot) + 1);
+}
+
+bool DS3231AlarmScheduler::lookup(AlarmId id, uint32_t* slot) const {
+  const uint64_t index = (id & kSlotMask) - 1;
+  if ((id & kSlotMask) == 0 || index >= slots_.size())
+    return false;
+  const Slot& s = slots_[index];
+  if (!s.used || s.generation != (id >> kGenerationShift))
+    return false;
+  *slot = static_cast<uint32_t>(index);
+  return true;
+}
+
+void DS3231AlarmScheduler::place(size_t index, const Entry& entry) {
+  heap_[index] = entry;
+  slots_[entry.slot].heap_index = index;
+}
+
+void DS3231AlarmScheduler::siftUp(size_t index) {
+  const Entry entry = heap_[index];
+  while (index > 0) {
+    const size_t parent = (index - 1) / 2;
+    if (!earlier(entry, heap_[parent]))
+      break;
+    place(index, heap_[parent]);
+    index = parent;
+  }
+  place(index, entry);
+}
+
+void DS3231AlarmScheduler::siftDown(size_t index) {
+  const Entry entry = heap_[index];
+  const size_t size = heap_.size();
+  while (true) {
+    size_t child = 2 * index + 1;
+    if (child >= size)
+      break;
+    if (child + 1 < size && earlier(heap_[child + 1], heap_[child]))
+      child++;
+    if (!earlier(heap_[child], entry))
+      break;
+    place(index, heap_[child]);
+    index = child;
+  }
+  place(index, entry);
+}
+
+void DS3231AlarmScheduler::remove(size_t index) {
+  Slot& slot = slots_[heap_[index].slot];
+  slot.callback = nullptr;
+  slot.used = false;
+  slot.generation++;
+  free_slots_.push_back(heap_[index].slot);
+
+  const Entry last = heap_.back();
+  heap_.pop_back();
+  if (index == heap_.size())
+    return;
+  place(index, last);
+  if (index > 0 && earlier(last, heap_[(index - 1) / 2]))
+    siftUp(index);
+  else
+    siftDown(index);
+}
+
+bool DS3231AlarmScheduler::schedule(const DateTime& when,
+                                    Callback callback,
+                                    AlarmId* id) {
+  uint32_t slot;
+  if (!free_slots_.empty()) {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    slot = static_cast<uint32_t>(slots_.size());
+    slots_.push_back({nullptr, 0, 0, false});
+  }
+  slots_[slot].callback = std::move(callback);
+  slots_[slot].used = true;
+
+  heap_.push_back({when.unixtime(), next_seq_++, slot});
+  siftUp(heap_.size() - 1);
+  if (id)
+    *id = idOf(slot);
+
+  if (armed_ && heap_[0].when == armed_when_)
+    return true;
+  return rearm();
+}
+
+bool DS3231AlarmScheduler::cancel(AlarmId id) {
+  uint32_t slot;
+  if (!lookup(id, &slot))
+    return false;
+  remove(slots_[slot].heap_index);
+
+  if (armed_ ? !heap_.empty() && heap_[0].when == armed_when_
+             : heap_.empty()) {
+    return true;
+  }
+  return rearm();
+}
+
+bool DS3231AlarmScheduler::service() {
+  // Clear the flag first, so that an alarm matching while the callbacks
+  // run asserts the interrupt again.
+  const bool cleared = rtc_->clearAlarm(DS3231::Alarm::A1);
+  return rearm() && cleared;
+}
+
+bool DS3231AlarmScheduler::rearm() {
+  // Called again from a callback: the outer call re-arms once the
+  // callbacks have run.
+  if (servicing_)
+    return true;
+  servicing_ = true;
+
+  bool ok = true;
+  while (true) {
+    DateTime now;
+    if (!rtc_->now(&now)) {
+      ok = false;
+      break;
+    }
+    while (!heap_.empty() && heap_[0].when <= now.unixtime()) {
+      Callback callback = std::move(slots_[heap_[0].slot].callback);
+      const AlarmId id = idOf(heap_[0].slot);
+      remove(0);
+      callback(id);
+    }
+
+    if (heap_.empty()) {
+      if (armed_) {
+        ok = rtc_->disableAlarm(DS3231::Alarm::A1);
+        armed_ = !ok;
+      }
+      break;
+    }
+    if (armed_ && heap_[0].when == armed_when_)
+      break;
+
+    armed_ = false;
+    if (!rtc_->clearAlarm(DS3231::Alarm::A1) ||
+        !rtc_->setAlarm1(DateTime(heap_[0].when),
+                         DS3231::Alarm1Mode::Date)) {
+      ok = false;
+      break;
+    }
+    armed_ = true;
+    armed_when_ = heap_[0].when;
+    // Loop to check that the alarm time didn't pass while programming it.
+  }
+
+  servicing_ = false;
+  return ok;
+}
+
+bool DS3231AlarmScheduler::next(DateTime* when) const {
+  if (heap_.empty())
+    return false;
+  *when = DateTime(heap_[0].when);
+  return true;
+}
+
+}  // namespace rtc
@@ -0,0 +1,157 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/ensemble_clock.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+#include <rtclib/datetime.h>
+#include <rtclib/system_clock.h>
+
+namespace rtc {
+
+namespace {
+
+// The variance of a reading truncated to whole seconds (s²). Added to each
+// source's mean square deviation, so that sources which have agreed so far
+// aren't given unbounded weight.
+constexpr double kQuantizationVariance = 1.0 / 12;
+
+// Sort a few values in place.
+void sort(int64_t* values, size_t count) {
+  for (size_t i = 1; i < count; i++) {
+    const int64_t value = values[i];
+    size_t j = i;
+    for (; j && values[j - 1] > value; j--)
+      values[j] = values[j - 1];
+    values[j] = value;
+  }
+}
+
+}  // namespace
+
+constexpr size_t EnsembleClock::kMaxSources;
+
+EnsembleClock::EnsembleClock(const Config& config) : config_(config) {}
+
+EnsembleClock::EnsembleClock() : EnsembleClock(Config()) {}
+
+bool EnsembleClock::addSource(Reader reader) {
+  if (num_sources_ == kMaxSources)
+    return false;
+  sources_[num_sources_++].reader = std::move(reader);
+  return true;
+}
+
+int64_t EnsembleClock::vote() {
+  int64_t offsets[kMaxSources];
+  size_t count = 0;
+  for (size_t i = 0; i < num_sources_; i++) {
+    if (sources_[i].valid)
+      offsets[count++] = sources_[i].offset;
+  }
+  sort(offsets, count);
+  const int64_t median =
+      count % 2 ? offsets[count / 2]
+                : offsets[count / 2 - 1] +
+                      (offsets[count / 2] - offsets[count / 2 - 1]) / 2;
+
+  Source* most_stable = nullptr;
+  size_t num_accepted = 0;
+  for (size_t i = 0; i < num_sources_; i++) {
+    Source& source = sources_[i];
+    source.stats.accepted = false;
+    source.stats.weight = 0;
+    if (!source.valid)
+      continue;
+    // The deviation from the others, plus the step since the last reading
+    // against the SystemClock, which tells two sources apart.
+    const int64_t deviation = source.offset - median;
+    const double seconds = deviation * 1e-6;
+    double square = seconds * seconds;
+    if (source.tracked) {
+      const double step = (source.offset - source.last_offset) * 1e-6;
+      square += step * step;
+      source.mean_square +=
+          config_.stability_gain * (square - source.mean_square);
+    } else {
+      source.mean_square = square;
+      source.tracked = true;
+    }
+    source.last_offset = source.offset;
+    source.stats.rms_deviation =
+        static_cast<float>(std::sqrt(source.mean_square));
+    if (!most_stable || source.mean_square < most_stable->mean_square)
+      most_stable = &source;
+    if (std::llabs(deviation) < config_.outlier_threshold) {
+      source.stats.accepted = true;
+      num_accepted++;
+    } else {
+      source.stats.rejections++;
+    }
+  }
+  if (!num_accepted)
+    most_stable->stats.accepted = true;
+
+  // The weighted mean, relative to the median to keep the precision.
+  double total_weight = 0;
+  double sum = 0;
+  for (size_t i = 0; i < num_sources_; i++) {
+    const Source& source = sources_[i];
+    if (!source.stats.accepted)
+      continue;
+    const double weight = 1 / (source.mean_square + kQuantizationVariance);
+    total_weight += weight;
+    sum += weight * (source.offset - median);
+  }
+  for (size_t i = 0; i < num_sources_; i++) {
+    Source& source = sources_[i];
+    if (source.stats.accepted) {
+      source.stats.weight = static_cast<float>(
+          1 / (source.mean_square + kQuantizationVariance) / total_weight);
+    }
+  }
+  return median + std::llround(sum / total_weight);
+}
+
+bool EnsembleClock::nowMicros(int64_t* unix_micros) {
+  size_t num_valid = 0;
+  for (size_t i = 0; i < num_sources_; i++) {
+    Source& source = sources_[i];
+    DateTime now;
+    const int64_t before = SystemClock::microsSinceStart();
+    source.valid = source.reader(&now);
+    const int64_t after = SystemClock::microsSinceStart();
+    if (!source.valid) {
+      source.stats.failures++;
+      source.stats.accepted = false;
+      source.stats.weight = 0;
+      continue;
+    }
+    source.stats.reads++;
+    // The RTC truncates to the second: assume the middle of it.
+    source.offset = static_cast<int64_t>(now.unixtime()) * 1000000 + 500000 -
+                    (before + (after - before) / 2);
+    num_valid++;
+  }
+  if (!num_valid)
+    return false;
+  *unix_micros = SystemClock::microsSinceStart() + vote();
+  return true;
+}
+
+bool EnsembleClock::now(DateTime* dt) {
+  int64_t unix_micros;
+  if (!nowMicros(&unix_micros))
+    return false;
+  *dt = DateTime(static_cast<uint32_t>(unix_micros / 1000000));
+  return true;
+}
+
+}  // namespace rtc
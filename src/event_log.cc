@@ -0,0 +1,324 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/event_log.h>
+
+#include <rtclib/byte_storage.h>
+#include "rtc_util.h"
+
+namespace rtc {
+
+namespace {
+
+constexpr uint8_t kMagic = 0xE7;
+constexpr size_t kHeaderSize = 8;
+constexpr uint8_t kEndMarker = 0xFF;
+
+// Length, the longest (5 byte) delta, and CRC.
+constexpr size_t kMaxRecordSize = 1 + 5 + EventLog::kMaxPayloadSize + 1;
+static_assert(kHeaderSize + kMaxRecordSize <= EventLog::kBlockSize,
+              "A block must hold the largest record");
+
+uint8_t crc(uint8_t crc, const uint8_t* data, size_t num_bytes) {
+  for (size_t i = 0; i < num_bytes; i++)
+    crc = crc8(crc, data[i]);
+  return crc;
+}
+
+uint32_t readU32(const uint8_t* p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+/**
+ * Is |header| valid? Sets |seq| and |time| if so.
+ */
+bool parseHeader(const uint8_t* header, uint16_t* seq, uint32_t* time) {
+  if (header[0] != kMagic ||
+      header[kHeaderSize - 1] != crc(0xFF, header, kHeaderSize - 1)) {
+    return false;
+  }
+  *seq = header[1] | header[2] << 8;
+  *time = readU32(&header[3]);
+  return true;
+}
+
+void makeHeader(uint16_t seq, uint32_t time, uint8_t* header) {
+  header[0] = kMagic;
+  header[1] = seq & 0xFF;
+  header[2] = seq >> 8;
+  for (int i = 0; i < 4; i++)
+    header[3 + i] = (time >> (8 * i)) & 0xFF;
+  header[kHeaderSize - 1] = crc(0xFF, header, kHeaderSize - 1);
+}
+
+/**
+ * The CRC of a record is seeded with its offset and the block header's CRC
+ * so that a stale record, left from the block's previous use, never
+ * validates in the current one.
+ */
+uint8_t recordCrc(const uint8_t* block,
+                  size_t offset,
+                  const uint8_t* record,
+                  size_t num_bytes) {
+  const uint8_t seed = crc8(block[kHeaderSize - 1], offset);
+  return crc(seed, record, num_bytes);
+}
+
+size_t recordSize(uint32_t delta, size_t length) {
+  size_t size = 1 + 1 + length + 1;
+  while (delta >>= 7)
+    size++;
+  return size;
+}
+
+/**
+ * Encode a record at |offset| in |block|.
+ *
+ * @return The record's size.
+ */
+size_t makeRecord(uint8_t* block,
+                  size_t offset,
+                  uint32_t delta,
+                  const void* data,
+                  size_t length) {
+  uint8_t* record = &block[offset];
+  size_t size = 0;
+  record[size++] = static_cast<uint8_t>(length);
+  do {
+    record[size++] = (delta & 0x7F) | (delta > 0x7F ? 0x80 : 0);
+    delta >>= 7;
+  } while (delta);
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < length; i++)
+    record[size++] = bytes[i];
+  record[size] = recordCrc(block, offset, record, size);
+  return size + 1;
+}
+
+/**
+ * Decode the record at |offset| in |block|.
+ *
+ * @return The record's size, or zero at the end of the block.
+ */
+size_t parseRecord(const uint8_t* block,
+                   size_t offset,
+                   uint32_t* delta,
+                   size_t* length) {
+  const uint8_t* record = &block[offset];
+  const size_t available = EventLog::kBlockSize - offset;
+  if (available < 3 || record[0] > EventLog::kMaxPayloadSize)
+    return 0;
+  *length = record[0];
+  *delta = 0;
+  size_t size = 1;
+  for (int shift = 0;; shift += 7) {
+    if (size >= available || shift > 28)
+      return 0;
+    const uint8_t byte = record[size++];
+    *delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      break;
+  }
+  size += *length;
+  if (size >= available || record[size] != recordCrc(block, offset, record,
+                                                     size)) {
+    return 0;
+  }
+  return size + 1;
+}
+
+}  // namespace
+
+EventLog::EventLog(ByteStorage* storage, uint16_t address, uint16_t size)
+    : storage_(storage), address_(address), num_blocks_(size / kBlockSize) {}
+
+EventLog::EventLog(ByteStorage* storage)
+    : EventLog(storage, 0, static_cast<uint16_t>(storage->size())) {}
+
+bool EventLog::readHeader(size_t block, uint8_t* header) {
+  return storage_->read(address_ + block * kBlockSize, header, kHeaderSize);
+}
+
+bool EventLog::begin() {
+  loaded_ = false;
+  empty_ = true;
+  if (num_blocks_ < 2 || address_ + num_blocks_ * kBlockSize >
+                             storage_->size()) {
+    return false;
+  }
+
+  uint8_t header[kHeaderSize];
+  uint16_t seq0;
+  uint32_t time;
+  if (!readHeader(0, header))
+    return false;
+  if (parseHeader(header, &seq0, &time)) {
+    // Block i (i > 0) is in the same lap as block 0, so newer, exactly when
+    // its sequence number is seq0 + i. Those blocks form a prefix.
+    size_t newest = 0;
+    size_t older = num_blocks_;
+    while (older - newest > 1) {
+      const size_t mid = newest + (older - newest) / 2;
+      uint16_t seq;
+      if (!readHeader(mid, header))
+        return false;
+      if (parseHeader(header, &seq, &time) &&
+          seq == static_cast<uint16_t>(seq0 + mid)) {
+        newest = mid;
+      } else {
+        older = mid;
+      }
+    }
+    head_ = newest;
+    head_seq_ = static_cast<uint16_t>(seq0 + newest);
+    empty_ = false;
+  } else {
+    // Either empty, or starting block 0 failed after a full lap, leaving
+    // the last block newest.
+    const size_t last = num_blocks_ - 1;
+    if (!readHeader(last, header))
+      return false;
+    if (parseHeader(header, &head_seq_, &time)) {
+      head_ = last;
+      empty_ = false;
+    }
+  }
+  if (!empty_ && !findEnd())
+    return false;
+  loaded_ = true;
+  return true;
+}
+
+bool EventLog::findEnd() {
+  uint8_t block[kBlockSize];
+  if (!storage_->read(address_ + head_ * kBlockSize, block, sizeof(block)))
+    return false;
+  uint16_t seq;
+  parseHeader(block, &seq, &last_time_);
+  head_crc_ = block[kHeaderSize - 1];
+  size_t offset = kHeaderSize;
+  uint32_t delta;
+  size_t length;
+  while (size_t size = parseRecord(block, offset, &delta, &length)) {
+    last_time_ += delta;
+    offset += size;
+  }
+  head_end_ = offset;
+  return true;
+}
+
+bool EventLog::append(const DateTime& time, const void* data, size_t length) {
+  if (length > kMaxPayloadSize)
+    return false;
+  if (!loaded_ && !begin())
+    return false;
+
+  const uint32_t t = time.unixtime();
+  uint8_t block[kBlockSize];
+  size_t index = head_;
+  uint16_t seq = head_seq_;
+  size_t start;
+  size_t end;
+  if (!empty_ && t >= last_time_ &&
+      head_end_ + recordSize(t - last_time_, length) <= kBlockSize) {
+    // Append to the newest block. Only the record is written, its CRC
+    // seeded by the header's.
+    block[kHeaderSize - 1] = head_crc_;
+    start = head_end_;
+    end = start + makeRecord(block, start, t - last_time_, data, length);
+  } else {
+    // Start a new block.
+    if (!empty_) {
+      index = (head_ + 1) % num_blocks_;
+      seq++;
+    }
+    makeHeader(seq, t, block);
+    start = 0;
+    end = kHeaderSize + makeRecord(block, kHeaderSize, 0, data, length);
+  }
+  const size_t marker = end < kBlockSize ? 1 : 0;
+  if (marker)
+    block[end] = kEndMarker;
+  if (!storage_->write(address_ + index * kBlockSize + start, &block[start],
+                       end + marker - start)) {
+    loaded_ = false;
+    return false;
+  }
+  head_ = index;
+  head_seq_ = seq;
+  head_crc_ = block[kHeaderSize - 1];
+  head_end_ = end;
+  last_time_ = t;
+  empty_ = false;
+  return true;
+}
+
+bool EventLog::forEach(const Visitor& visitor) {
+  if (!loaded_ && !begin())
+    return false;
+  if (empty_)
+    return true;
+
+  // The oldest block follows the newest if it is from the previous lap.
+  size_t oldest = 0;
+  size_t count = head_ + 1;
+  const size_t next = (head_ + 1) % num_blocks_;
+  if (next != 0) {
+    uint8_t header[kHeaderSize];
+    uint16_t seq;
+    uint32_t time;
+    if (!readHeader(next, header))
+      return false;
+    if (parseHeader(header, &seq, &time) &&
+        seq == static_cast<uint16_t>(head_seq_ - (num_blocks_ - 1))) {
+      oldest = next;
+      count = num_blocks_;
+    }
+  } else {
+    count = num_blocks_;
+    oldest = 0;
+  }
+
+  uint8_t block[kBlockSize];
+  for (size_t i = 0; i < count; i++) {
+    const size_t index = (oldest + i) % num_blocks_;
+    if (!storage_->read(address_ + index * kBlockSize, block, sizeof(block)))
+      return false;
+    uint16_t seq;
+    uint32_t time;
+    if (!parseHeader(block, &seq, &time))
+      continue;
+    size_t offset = kHeaderSize;
+    uint32_t delta;
+    size_t length;
+    while (size_t size = parseRecord(block, offset, &delta, &length)) {
+      time += delta;
+      const size_t payload = offset + size - 1 - length;
+      visitor({DateTime(time), &block[payload], length});
+      offset += size;
+    }
+  }
+  return true;
+}
+
+bool EventLog::clear() {
+  const uint8_t invalid = 0;
+  for (size_t i = 0; i < num_blocks_; i++) {
+    if (!storage_->write(address_ + i * kBlockSize, &invalid, 1)) {
+      loaded_ = false;
+      return false;
+    }
+  }
+  empty_ = true;
+  loaded_ = true;
+  head_ = 0;
+  head_seq_ = 0;
+  head_end_ = 0;
+  return true;
+}
+
+}  // namespace rtc
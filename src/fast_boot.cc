@@ -0,0 +1,74 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/fast_boot.h>
+
+#include <rtclib/byte_storage.h>
+#include <rtclib/datetime.h>
+#include <rtclib/ds1307.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/software_clock.h>
+
+namespace rtc {
+
+bool FastBoot::restore(DS1307* rtc,
+                       uint8_t nvram_address,
+                       SoftwareClock* clock,
+                       SyncState* state,
+                       Status* status) {
+  DateTime now;
+  bool running;
+  uint8_t bytes[SyncStateStore::kSize];
+  if (!rtc->readBootState(&now, &running, nvram_address, bytes,
+                          sizeof(bytes))) {
+    return false;
+  }
+  const bool restored = SyncStateStore::decode(bytes, state);
+  if (restored)
+    clock->adjustDriftPpb(state->drift_ppb);
+  if (!running) {
+    *status = Status::LostPower;
+    return true;
+  }
+  clock->adjust(now);
+  *status = restored ? Status::Restored : Status::NoSyncState;
+  return true;
+}
+
+bool FastBoot::restore(DS3231* rtc,
+                       ByteStorage* storage,
+                       uint16_t address,
+                       SoftwareClock* clock,
+                       SyncState* state,
+                       Status* status) {
+  DateTime now;
+  bool lost_power;
+  int8_t aging_offset;
+  if (!rtc->readBootState(&now, &lost_power, &aging_offset))
+    return false;
+  if (!lost_power)
+    clock->adjust(now);
+
+  uint8_t bytes[SyncStateStore::kSize];
+  if (!storage->read(address, bytes, sizeof(bytes)))
+    return false;
+  const bool restored = SyncStateStore::decode(bytes, state);
+  if (restored) {
+    clock->adjustDriftPpb(state->drift_ppb);
+    if (lost_power && aging_offset != state->calibration &&
+        !rtc->setAgingOffset(state->calibration)) {
+      return false;
+    }
+  }
+  if (lost_power)
+    *status = Status::LostPower;
+  else
+    *status = restored ? Status::Restored : Status::NoSyncState;
+  return true;
+}
+
+}  // namespace rtc
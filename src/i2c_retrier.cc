@@ -0,0 +1,66 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/i2c_retrier.h>
+
+#include <utility>
+
+#include <rtclib/system_clock.h>
+#include "instrumented_i2c.h"
+
+namespace rtc {
+
+float I2CRetrier::Metrics::errorRate() const {
+  if (!attempts)
+    return 0;
+  return static_cast<float>(transient + absent) / attempts;
+}
+
+I2CRetrier::I2CRetrier(i2c::Master i2c, uint8_t address, const Config& config)
+    : i2c_(std::move(i2c)), address_(address), config_(config) {}
+
+I2CRetrier::I2CRetrier(i2c::Master i2c, uint8_t address)
+    : I2CRetrier(std::move(i2c), address, Config()) {}
+
+I2CRetrier::Fault I2CRetrier::diagnose() {
+  if (ping(&i2c_, address_, "diagnose"))
+    return Fault::Transient;
+  if (!config_.bus_clear || !config_.bus_clear() ||
+      !ping(&i2c_, address_, "diagnose")) {
+    return Fault::Absent;
+  }
+  metrics_.recoveries++;
+  return Fault::Transient;
+}
+
+bool I2CRetrier::run(const Operation& op) {
+  metrics_.operations++;
+  int64_t backoff = config_.initial_backoff;
+  for (int attempt = 1;; attempt++) {
+    metrics_.attempts++;
+    if (op()) {
+      last_fault_ = Fault::None;
+      return true;
+    }
+    last_fault_ = diagnose();
+    if (last_fault_ == Fault::Absent) {
+      metrics_.absent++;
+      break;
+    }
+    metrics_.transient++;
+    if (attempt >= config_.max_attempts)
+      break;
+    SystemClock::delayMicros(backoff);
+    backoff = backoff * 2 < config_.max_backoff ? backoff * 2
+                                                 : config_.max_backoff;
+    metrics_.retries++;
+  }
+  metrics_.failures++;
+  return false;
+}
+
+}  // namespace rtc
@@ -0,0 +1,95 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/instrumentation.h>
+
+#include <cstring>
+#include <mutex>
+
+namespace rtc {
+
+constexpr size_t OpStats::kNumBuckets;
+constexpr size_t Instrumentation::kMaxOps;
+
+// static
+size_t OpStats::bucket(int64_t micros) {
+  size_t bucket = 0;
+  while (micros >= 2 && bucket < kNumBuckets - 1) {
+    micros >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+#if defined(RTC_INSTRUMENTATION)
+
+namespace {
+
+std::mutex g_mutex;
+OpStats g_stats[Instrumentation::kMaxOps];
+size_t g_num_stats = 0;
+
+OpStats* find(uint8_t address, const char* name) {
+  for (size_t i = 0; i < g_num_stats; i++) {
+    OpStats& stats = g_stats[i];
+    if (stats.address == address &&
+        (stats.name == name || !strcmp(stats.name, name))) {
+      return &stats;
+    }
+  }
+  if (g_num_stats == Instrumentation::kMaxOps)
+    return nullptr;
+  OpStats& stats = g_stats[g_num_stats++];
+  stats.address = address;
+  stats.name = name;
+  return &stats;
+}
+
+}  // namespace
+
+// static
+size_t Instrumentation::snapshot(OpStats* stats, size_t max_stats) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  const size_t count = max_stats < g_num_stats ? max_stats : g_num_stats;
+  for (size_t i = 0; i < count; i++)
+    stats[i] = g_stats[i];
+  return count;
+}
+
+// static
+void Instrumentation::reset() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  for (size_t i = 0; i < g_num_stats; i++)
+    g_stats[i] = OpStats();
+  g_num_stats = 0;
+}
+
+// static
+void Instrumentation::record(uint8_t address,
+                             const char* name,
+                             bool success,
+                             size_t bytes,
+                             int64_t micros) {
+  if (micros < 0)
+    micros = 0;
+  std::lock_guard<std::mutex> lock(g_mutex);
+  OpStats* stats = find(address, name);
+  if (!stats)
+    return;
+  stats->calls++;
+  if (!success)
+    stats->failures++;
+  stats->bytes += bytes;
+  stats->total_micros += micros;
+  if (micros > stats->max_micros)
+    stats->max_micros = micros > UINT32_MAX ? UINT32_MAX : micros;
+  stats->histogram[OpStats::bucket(micros)]++;
+}
+
+#endif  // defined(RTC_INSTRUMENTATION)
+
+}  // namespace rtc
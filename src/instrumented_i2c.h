@@ -0,0 +1,216 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_INSTRUMENTED_I2C_H_
+#define RTC_INSTRUMENTED_I2C_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <i2clib/master.h>
+#include <i2clib/operation.h>
+#include <rtclib/register_map.h>
+
+#if defined(RTC_INSTRUMENTATION) || defined(RTC_TRACING)
+#include <rtclib/instrumentation.h>
+#include <rtclib/system_clock.h>
+#include <rtclib/trace.h>
+#endif
+
+// The drivers' access to the I2C bus. Each call forwards to i2c::Master,
+// and when built with RTC_INSTRUMENTATION or RTC_TRACING is also recorded
+// by Instrumentation and Trace under the given operation name. Fields of a
+// chip's register map are accessed with readField() and writeField().
+
+namespace rtc {
+
+#if defined(RTC_INSTRUMENTATION) || defined(RTC_TRACING)
+
+/**
+ * Records one transaction, from construction to finish().
+ */
+class I2CRecorder {
+ public:
+  I2CRecorder(uint8_t address, const char* name)
+      : address_(address),
+        name_(name),
+        start_(SystemClock::microsSinceStart()) {
+    Trace::begin("i2c", name, address);
+  }
+
+  bool finish(bool success, size_t bytes) {
+    Trace::end("i2c", name_);
+    Instrumentation::record(address_, name_, success, bytes,
+                            SystemClock::microsSinceStart() - start_);
+    return success;
+  }
+
+ private:
+  const uint8_t address_;
+  const char* name_;
+  const int64_t start_;
+};
+
+/**
+ * An i2c::Operation which records its Execute().
+ */
+class I2COperation {
+ public:
+  I2COperation(i2c::Operation op, uint8_t address, const char* name)
+      : op_(std::move(op)), address_(address), name_(name) {}
+  I2COperation(I2COperation&&) = default;
+  I2COperation& operator=(I2COperation&&) = default;
+
+  bool ready() const { return op_.ready(); }
+
+  bool Read(void* dst, size_t num_bytes) {
+    bytes_ += num_bytes;
+    return op_.Read(dst, num_bytes);
+  }
+
+  bool Write(const void* data, size_t num_bytes) {
+    bytes_ += num_bytes;
+    return op_.Write(data, num_bytes);
+  }
+
+  bool WriteByte(uint8_t val) {
+    bytes_++;
+    return op_.WriteByte(val);
+  }
+
+  bool RestartReg(uint8_t reg, i2c::Operation::Type type) {
+    return op_.RestartReg(reg, type);
+  }
+
+  bool Restart(i2c::Operation::Type type) { return op_.Restart(type); }
+
+  bool Execute() {
+    I2CRecorder recorder(address_, name_);
+    return recorder.finish(op_.Execute(), bytes_);
+  }
+
+ private:
+  i2c::Operation op_;
+  uint8_t address_;
+  const char* name_;
+  size_t bytes_ = 0;
+};
+
+inline I2COperation createReadOp(i2c::Master* i2c,
+                                 uint8_t address,
+                                 uint8_t reg,
+                                 const char* name) {
+  return I2COperation(i2c->CreateReadOp(address, reg, name), address, name);
+}
+
+inline I2COperation createWriteOp(i2c::Master* i2c,
+                                  uint8_t address,
+                                  uint8_t reg,
+                                  const char* name) {
+  return I2COperation(i2c->CreateWriteOp(address, reg, name), address, name);
+}
+
+inline bool readRegister(i2c::Master* i2c,
+                         uint8_t address,
+                         uint8_t reg,
+                         uint8_t* val,
+                         const char* name) {
+  I2CRecorder recorder(address, name);
+  return recorder.finish(i2c->ReadRegister(address, reg, val), 1);
+}
+
+inline bool writeRegister(i2c::Master* i2c,
+                          uint8_t address,
+                          uint8_t reg,
+                          uint8_t val,
+                          const char* name) {
+  I2CRecorder recorder(address, name);
+  return recorder.finish(i2c->WriteRegister(address, reg, val), 1);
+}
+
+inline bool ping(i2c::Master* i2c, uint8_t address, const char* name) {
+  I2CRecorder recorder(address, name);
+  return recorder.finish(i2c->Ping(address), 0);
+}
+
+#else  // defined(RTC_INSTRUMENTATION) || defined(RTC_TRACING)
+
+using I2COperation = i2c::Operation;
+
+inline I2COperation createReadOp(i2c::Master* i2c,
+                                 uint8_t address,
+                                 uint8_t reg,
+                                 const char* name) {
+  return i2c->CreateReadOp(address, reg, name);
+}
+
+inline I2COperation createWriteOp(i2c::Master* i2c,
+                                  uint8_t address,
+                                  uint8_t reg,
+                                  const char* name) {
+  return i2c->CreateWriteOp(address, reg, name);
+}
+
+inline bool readRegister(i2c::Master* i2c,
+                         uint8_t address,
+                         uint8_t reg,
+                         uint8_t* val,
+                         const char* name) {
+  return i2c->ReadRegister(address, reg, val);
+}
+
+inline bool writeRegister(i2c::Master* i2c,
+                          uint8_t address,
+                          uint8_t reg,
+                          uint8_t val,
+                          const char* name) {
+  return i2c->WriteRegister(address, reg, val);
+}
+
+inline bool ping(i2c::Master* i2c, uint8_t address, const char* name) {
+  return i2c->Ping(address);
+}
+
+#endif  // defined(RTC_INSTRUMENTATION) || defined(RTC_TRACING)
+
+/**
+ * Read a RegisterField of the device at |address|.
+ */
+template <typename Field>
+bool readField(i2c::Master* i2c,
+               uint8_t address,
+               uint8_t* value,
+               const char* name) {
+  uint8_t reg;
+  if (!readRegister(i2c, address, Field::kAddress, &reg, name))
+    return false;
+  *value = Field::get(reg);
+  return true;
+}
+
+/**
+ * Write a RegisterField of the device at |address|, leaving the rest of its
+ * register unchanged. A field of the whole register is written directly.
+ */
+template <typename Field>
+bool writeField(i2c::Master* i2c,
+                uint8_t address,
+                uint8_t value,
+                const char* name) {
+  uint8_t reg = 0;
+  if (Field::kMask != 0xFF &&
+      !readRegister(i2c, address, Field::kAddress, &reg, name)) {
+    return false;
+  }
+  return writeRegister(i2c, address, Field::kAddress, Field::set(reg, value),
+                       name);
+}
+
+}  // namespace rtc
+
+#endif  // RTC_INSTRUMENTED_I2C_H_
@@ -0,0 +1,62 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/interrupt_source.h>
+
+namespace rtc {
+
+bool ManualInterruptSource::attach(Isr isr, void* arg) {
+  isr_ = isr;
+  arg_ = arg;
+  return true;
+}
+
+void ManualInterruptSource::detach() {
+  isr_ = nullptr;
+  arg_ = nullptr;
+}
+
+void ManualInterruptSource::trigger() const {
+  if (isr_)
+    isr_(arg_);
+}
+
+#if defined(ESP_PLATFORM)
+
+GpioInterruptSource::GpioInterruptSource(gpio_num_t pin, bool pullup)
+    : pin_(pin), pullup_(pullup) {}
+
+GpioInterruptSource::~GpioInterruptSource() {
+  detach();
+}
+
+bool GpioInterruptSource::attach(Isr isr, void* arg) {
+  detach();
+  gpio_config_t config = {};
+  config.pin_bit_mask = 1ULL << pin_;
+  config.mode = GPIO_MODE_INPUT;
+  config.pull_up_en = pullup_ ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE;
+  config.pull_down_en = GPIO_PULLDOWN_DISABLE;
+  config.intr_type = GPIO_INTR_NEGEDGE;
+  if (gpio_config(&config) != ESP_OK)
+    return false;
+  if (gpio_isr_handler_add(pin_, isr, arg) != ESP_OK)
+    return false;
+  attached_ = true;
+  return true;
+}
+
+void GpioInterruptSource::detach() {
+  if (!attached_)
+    return;
+  gpio_isr_handler_remove(pin_);
+  attached_ = false;
+}
+
+#endif  // defined(ESP_PLATFORM)
+
+}  // namespace rtc
@@ -10,38 +10,35 @@
 
 #include <rtclib/micros.h>
 
-#include <cstdint>
-
-#include <rtclib/system_clock.h>
-
 namespace rtc {
 
 /**
- * Number of microseconds reported by micros() per "true" (calibrated) second.
- */
-uint32_t Micros::microsPerSecond = 1000000;
-
-/**
- * The timing logic is identical to RTC_Millis.
+ * Constant initialized, so it can be used during static initialization.
  */
-uint32_t Micros::lastMicros;
-uint32_t Micros::lastUnix;
+SoftwareClock Micros::clock;
 
 void Micros::adjust(const DateTime& dt) {
-  lastMicros = SystemClock::microsSinceStart();
-  lastUnix = dt.unixtime();
+  clock.adjust(dt);
 }
 
 void Micros::adjustDrift(int ppm) {
-  microsPerSecond = 1000000 - ppm;
+  clock.adjustDriftPpb(ppm * 1000);
+}
+
+void Micros::adjustDriftPpb(int32_t ppb) {
+  clock.adjustDriftPpb(ppb);
+}
+
+int32_t Micros::driftPpb() {
+  return clock.driftPpb();
+}
+
+int64_t Micros::nowMicros() {
+  return clock.nowMicros();
 }
 
 DateTime Micros::now() {
-  const uint32_t elapsedSeconds =
-      (SystemClock::microsSinceStart() - lastMicros) / microsPerSecond;
-  lastMicros += elapsedSeconds * microsPerSecond;
-  lastUnix += elapsedSeconds;
-  return lastUnix;
+  return clock.now();
 }
 
 }  // namespace rtc
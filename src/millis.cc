@@ -11,28 +11,24 @@
 #include <rtclib/millis.h>
 
 #include <rtclib/system_clock.h>
+#include "rtc_util.h"
 
 namespace rtc {
 
-/** Alignment between the milis() timescale and the Unix timescale. These
-  two variables are updated on each call to now(), which prevents
-  rollover issues. Note that lastMillis is **not** the millis() value
-  of the last call to now(): it's the millis() value corresponding to
-  the last **full second** of Unix time. */
-uint32_t Millis::lastMillis;
-uint32_t Millis::lastUnix;
+/**
+ * Constant initialized, so they can be used during static initialization.
+ */
+int64_t Millis::anchorMillis = 0;
+uint32_t Millis::anchorUnix = 0;
 
 void Millis::adjust(const DateTime& dt) {
-  lastMillis = SystemClock::millisSinceStart();
-  lastUnix = dt.unixtime();
+  anchorMillis = SystemClock::millisSinceStart();
+  anchorUnix = dt.unixtime();
 }
 
 DateTime Millis::now() {
-  const uint32_t elapsedSeconds =
-      (SystemClock::millisSinceStart() - lastMillis) / 1000;
-  lastMillis += elapsedSeconds * 1000;
-  lastUnix += elapsedSeconds;
-  return lastUnix;
+  const int64_t elapsed = SystemClock::millisSinceStart() - anchorMillis;
+  return DateTime(anchorUnix + static_cast<uint32_t>(div1000(elapsed)));
 }
 
 }  // namespace rtc
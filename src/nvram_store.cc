@@ -0,0 +1,325 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/nvram_store.h>
+
+#include <cstring>
+
+#include <rtclib/byte_storage.h>
+#include "rtc_util.h"
+
+namespace rtc {
+
+namespace {
+
+constexpr size_t kHeaderSize = 2;
+
+// Key, sequence number, length and CRC.
+constexpr size_t kRecordOverhead = 4;
+
+// The length of a record removing its key.
+constexpr uint8_t kTombstone = 0xFF;
+
+}  // namespace
+
+NvramStore::NvramStore(ByteStorage* storage, uint16_t address, uint16_t size)
+    : storage_(storage), address_(address), size_(size) {}
+
+NvramStore::NvramStore(ByteStorage* storage)
+    : NvramStore(storage, 0, static_cast<uint16_t>(storage->size())) {}
+
+uint8_t& NvramStore::ring(size_t offset) {
+  return mirror_[kHeaderSize + offset % ring_size_];
+}
+
+uint8_t NvramStore::ring(size_t offset) const {
+  return mirror_[kHeaderSize + offset % ring_size_];
+}
+
+size_t NvramStore::recordSize(size_t offset) const {
+  const uint8_t length = ring(offset + 2);
+  return kRecordOverhead + (length == kTombstone ? 0 : length);
+}
+
+uint8_t NvramStore::recordCrc(size_t offset) const {
+  // The offset is included so that a stale copy of a record elsewhere in
+  // the ring is never valid.
+  uint8_t crc = crc8(0xFF, static_cast<uint8_t>(offset));
+  const size_t size = recordSize(offset);
+  for (size_t i = 0; i < size - 1; i++)
+    crc = crc8(crc, ring(offset + i));
+  return crc;
+}
+
+bool NvramStore::validRecord(size_t offset) const {
+  const uint8_t length = ring(offset + 2);
+  if (length != kTombstone && length > kMaxValueSize)
+    return false;
+  const size_t size = recordSize(offset);
+  if (size > ring_size_)
+    return false;
+  return ring(offset + size - 1) == recordCrc(offset);
+}
+
+size_t NvramStore::chainBytes(size_t head) const {
+  size_t total = 0;
+  size_t offset = head;
+  uint8_t seq = ring(head + 1);
+  while (total + kRecordOverhead <= ring_size_ && validRecord(offset) &&
+         ring(offset + 1) == seq) {
+    const size_t size = recordSize(offset);
+    if (total + size > ring_size_)
+      break;
+    total += size;
+    offset = (offset + size) % ring_size_;
+    seq++;
+  }
+  return total;
+}
+
+const NvramStore::Entry* NvramStore::find(uint8_t key) const {
+  for (size_t i = 0; i < num_keys_; i++) {
+    if (index_[i].key == key)
+      return &index_[i];
+  }
+  return nullptr;
+}
+
+void NvramStore::apply(size_t offset) {
+  const uint8_t key = ring(offset);
+  Entry* entry = const_cast<Entry*>(find(key));
+  if (ring(offset + 2) == kTombstone) {
+    tombstone_bytes_ += kRecordOverhead;
+    if (entry)
+      *entry = index_[--num_keys_];
+    return;
+  }
+  if (!entry) {
+    // Each live key has a record in the ring, so this can't overflow.
+    entry = &index_[num_keys_++];
+    entry->key = key;
+  }
+  entry->offset = static_cast<uint8_t>(offset);
+}
+
+void NvramStore::parse(size_t head) {
+  num_keys_ = 0;
+  tombstone_bytes_ = 0;
+  head_ = head;
+  used_ = chainBytes(head);
+  next_seq_ = ring(head + 1);
+  for (size_t offset = head; offset < head + used_;) {
+    apply(offset % ring_size_);
+    offset += recordSize(offset);
+    next_seq_++;
+  }
+}
+
+size_t NvramStore::liveBytes() const {
+  size_t bytes = tombstone_bytes_;
+  for (size_t i = 0; i < num_keys_; i++)
+    bytes += recordSize(index_[i].offset);
+  return bytes;
+}
+
+size_t NvramStore::largestLiveRecord() const {
+  size_t largest = 0;
+  for (size_t i = 0; i < num_keys_; i++) {
+    const size_t size = recordSize(index_[i].offset);
+    if (size > largest)
+      largest = size;
+  }
+  return largest;
+}
+
+bool NvramStore::begin() {
+  loaded_ = false;
+  if (size_ > kMaxSize || size_ < kHeaderSize + kRecordOverhead ||
+      address_ + size_ > storage_->size()) {
+    return false;
+  }
+  ring_size_ = size_ - kHeaderSize;
+  return load();
+}
+
+bool NvramStore::load() {
+  if (!storage_->read(address_, mirror_, size_))
+    return false;
+
+  const uint8_t head = mirror_[0];
+  if (head < ring_size_ && mirror_[1] == static_cast<uint8_t>(~head)) {
+    parse(head);
+    loaded_ = true;
+    return true;
+  }
+
+  // The header is corrupt (e.g. a torn write): recover the longest chain
+  // of records.
+  size_t best_head = 0;
+  size_t best_bytes = 0;
+  for (size_t offset = 0; offset < ring_size_; offset++) {
+    const size_t bytes = chainBytes(offset);
+    if (bytes > best_bytes) {
+      best_head = offset;
+      best_bytes = bytes;
+    }
+  }
+  if (!best_bytes)
+    return format();
+  parse(best_head);
+  loaded_ = true;
+  return writeHeader();
+}
+
+bool NvramStore::format() {
+  if (!ring_size_)
+    return false;
+  std::memset(mirror_, 0, size_);
+  num_keys_ = 0;
+  tombstone_bytes_ = 0;
+  head_ = 0;
+  used_ = 0;
+  next_seq_ = 0;
+  mirror_[0] = 0;
+  mirror_[1] = 0xFF;
+  loaded_ = storage_->write(address_, mirror_, size_);
+  if (loaded_)
+    bytes_written_ += size_;
+  return loaded_;
+}
+
+bool NvramStore::writeRing(size_t offset, size_t length) {
+  const size_t first =
+      offset + length > ring_size_ ? ring_size_ - offset : length;
+  if (!storage_->write(address_ + kHeaderSize + offset,
+                       &mirror_[kHeaderSize + offset], first)) {
+    return false;
+  }
+  if (first < length &&
+      !storage_->write(address_ + kHeaderSize, &mirror_[kHeaderSize],
+                       length - first)) {
+    return false;
+  }
+  bytes_written_ += length;
+  return true;
+}
+
+bool NvramStore::writeHeader() {
+  mirror_[0] = static_cast<uint8_t>(head_);
+  mirror_[1] = static_cast<uint8_t>(~head_);
+  if (!storage_->write(address_, mirror_, kHeaderSize))
+    return false;
+  bytes_written_ += kHeaderSize;
+  return true;
+}
+
+bool NvramStore::appendRecord(uint8_t key,
+                              const uint8_t* value,
+                              uint8_t length) {
+  const size_t offset = (head_ + used_) % ring_size_;
+  ring(offset) = key;
+  ring(offset + 1) = next_seq_;
+  ring(offset + 2) = length;
+  const size_t size = recordSize(offset);
+  for (size_t i = 0; i < size - kRecordOverhead; i++)
+    ring(offset + 3 + i) = value[i];
+  ring(offset + size - 1) = recordCrc(offset);
+  if (!writeRing(offset, size))
+    return false;
+  used_ += size;
+  next_seq_++;
+  apply(offset);
+  return true;
+}
+
+bool NvramStore::reclaimHead() {
+  const size_t size = recordSize(head_);
+  const Entry* entry = find(ring(head_));
+  if (entry && entry->offset == head_) {
+    // Still current: copy it to the end of the log first.
+    if (ring_size_ - used_ < size)
+      return false;
+    uint8_t value[kMaxValueSize];
+    for (size_t i = 0; i < size - kRecordOverhead; i++)
+      value[i] = ring(head_ + 3 + i);
+    if (!appendRecord(ring(head_), value, ring(head_ + 2)))
+      return false;
+  } else if (ring(head_ + 2) == kTombstone) {
+    // Nothing older remains for the tombstone to remove.
+    tombstone_bytes_ -= kRecordOverhead;
+  }
+  head_ = (head_ + size) % ring_size_;
+  used_ -= size;
+  return writeHeader();
+}
+
+bool NvramStore::append(uint8_t key, const uint8_t* value, uint8_t length) {
+  if (!loaded_ && !(ring_size_ && load()))
+    return false;
+
+  const size_t size =
+      kRecordOverhead + (length == kTombstone ? 0 : length);
+  size_t reserve = largestLiveRecord();
+  if (size > reserve)
+    reserve = size;
+  if (liveBytes() + size + reserve > ring_size_)
+    return false;
+
+  // Once every superseded record is reclaimed this holds, so each live
+  // record is copied at most once.
+  for (size_t reclaimed = 0; ring_size_ - used_ < size + reserve;
+       reclaimed += kRecordOverhead) {
+    if (reclaimed > 2 * ring_size_ || !reclaimHead()) {
+      loaded_ = false;
+      return false;
+    }
+  }
+  if (!appendRecord(key, value, length)) {
+    loaded_ = false;
+    return false;
+  }
+  return true;
+}
+
+bool NvramStore::get(uint8_t key,
+                     void* value,
+                     size_t size,
+                     size_t* length) const {
+  const Entry* entry = find(key);
+  if (!entry)
+    return false;
+  const size_t value_length = ring(entry->offset + 2);
+  uint8_t* out = static_cast<uint8_t*>(value);
+  for (size_t i = 0; i < value_length && i < size; i++)
+    out[i] = ring(entry->offset + 3 + i);
+  if (length)
+    *length = value_length;
+  return true;
+}
+
+bool NvramStore::put(uint8_t key, const void* value, size_t length) {
+  if (length > kMaxValueSize)
+    return false;
+  const uint8_t* bytes = static_cast<const uint8_t*>(value);
+  const Entry* entry = find(key);
+  if (loaded_ && entry && ring(entry->offset + 2) == length) {
+    size_t i = 0;
+    while (i < length && ring(entry->offset + 3 + i) == bytes[i])
+      i++;
+    if (i == length)
+      return true;
+  }
+  return append(key, bytes, static_cast<uint8_t>(length));
+}
+
+bool NvramStore::remove(uint8_t key) {
+  if (loaded_ && !find(key))
+    return true;
+  return append(key, nullptr, kTombstone);
+}
+
+}  // namespace rtc
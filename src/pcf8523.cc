@@ -13,6 +13,9 @@
 #include <i2clib/master.h>
 #include <i2clib/operation.h>
 #include <rtclib/datetime.h>
+#include <rtclib/pcf8523_registers.h>
+#include "instrumented_i2c.h"
+#include "register_dump.h"
 #include "rtc_util.h"
 
 using i2c::Operation;
@@ -21,54 +24,42 @@ namespace rtc {
 
 namespace {
 
-// clang-format off
-constexpr uint8_t PCF8523_ADDRESS = 0x68;        ///< I2C address for PCF8523
-
-constexpr uint8_t PCF8523_CLKOUTCONTROL = 0x0F;  ///< Timer and CLKOUT control register
-constexpr uint8_t PCF8523_CONTROL_1 = 0x00;      ///< Control and status register 1
-constexpr uint8_t PCF8523_CONTROL_2 = 0x01;      ///< Control and status register 2
-constexpr uint8_t PCF8523_CONTROL_3 = 0x02;      ///< Control and status register 3
-constexpr uint8_t PCF8523_TIMER_B_FRCTL = 0x12;  ///< Timer B source clock frequency control
-constexpr uint8_t PCF8523_TIMER_B_VALUE = 0x13;  ///< Timer B value (number clock periods)
-constexpr uint8_t PCF8523_OFFSET = 0x0E;         ///< Offset register
-constexpr uint8_t PCF8523_STATUSREG = 0x03;      ///< Status register
-
-constexpr uint8_t CLKOUT_SQW_32kHz = 0b00000000;
-constexpr uint8_t CLKOUT_SQW_16kHz = 0b00001000;
-constexpr uint8_t CLKOUT_SQW_8kHz  = 0b00010000;
-constexpr uint8_t CLKOUT_SQW_4kHz  = 0b00011000;
-constexpr uint8_t CLKOUT_SQW_1kHz  = 0b00100000;
-constexpr uint8_t CLKOUT_SQW_32Hz  = 0b00101000;
-constexpr uint8_t CLKOUT_SQW_1Hz   = 0b00110000;
-constexpr uint8_t CLKOUT_SQW_Off   = 0b00111000;
-constexpr uint8_t CLKOUT_SQW_MASK  = 0b00111000;
-
-// clang-format on
+using Registers = PCF8523Registers;
+
+constexpr uint8_t PCF8523_ADDRESS = Registers::kI2CAddress;
+
+// COF with CLKOUT disabled.
+constexpr uint8_t kClkoutOff =
+    encodeField(Registers::kSqwPinModes, PCF8523::SqwPinMode::Off);
 
 }  // anonymous namespace
 
+constexpr FieldValue<PCF8523::SqwPinMode> PCF8523Registers::kSqwPinModes[];
+constexpr RegisterRestore PCF8523Registers::kRestore[];
+
 PCF8523::PCF8523(i2c::Master i2c) : i2c_(std::move(i2c)) {}
 
 bool PCF8523::begin(void) {
-  return i2c_.Ping(PCF8523_ADDRESS);
+  return ping(&i2c_, PCF8523_ADDRESS, __func__);
 }
 
 bool PCF8523::lostPower(void) {
-  uint8_t value;
-  if (!i2c_.ReadRegister(PCF8523_ADDRESS, PCF8523_STATUSREG, &value))
+  uint8_t stopped;
+  if (!readField<Registers::OS>(&i2c_, PCF8523_ADDRESS, &stopped, __func__))
     return false;
-  return value >> 7;
+  return stopped;
 }
 
 bool PCF8523::initialized(void) {
-  uint8_t value;
-  if (!i2c_.ReadRegister(PCF8523_ADDRESS, PCF8523_CONTROL_3, &value))
+  uint8_t pm;
+  if (!readField<Registers::PM>(&i2c_, PCF8523_ADDRESS, &pm, __func__))
     return false;
-  return ((value & 0xE0) != 0xE0);  // 0xE0 = standby mode, set after power out
+  return pm != Registers::kPmStandby;  // Set after power out.
 }
 
 bool PCF8523::adjust(const DateTime& dt) {
-  auto op = i2c_.CreateWriteOp(PCF8523_ADDRESS, 0x3, "adjust");
+  auto op =
+      createWriteOp(&i2c_, PCF8523_ADDRESS, Registers::kSeconds, "adjust");
   if (!op.ready())
     return false;
 
@@ -85,22 +76,22 @@ bool PCF8523::adjust(const DateTime& dt) {
   op.Write(values, sizeof(values));
 
   // set to battery switchover mode
-  op.RestartReg(PCF8523_CONTROL_3, Operation::Type::WRITE);
+  op.RestartReg(Registers::kControl3, Operation::Type::WRITE);
   op.WriteByte(0x0);
   return op.Execute();
 }
 
 bool PCF8523::now(DateTime* dt) {
-  auto op = i2c_.CreateReadOp(PCF8523_ADDRESS, 0x3, "now");
+  auto op = createReadOp(&i2c_, PCF8523_ADDRESS, Registers::kSeconds, "now");
   if (!op.ready())
     return false;
-  uint8_t values[7];  // for registers 0x00 - 0x06.
+  uint8_t values[7];  // for registers 0x03 - 0x09.
   if (!op.Read(values, sizeof(values)))
     return false;
   if (!op.Execute())
     return false;
 
-  const uint8_t ss = bcd2bin(values[0] & 0x7F);
+  const uint8_t ss = bcd2bin(Registers::OS::set(values[0], 0));
   const uint8_t mm = bcd2bin(values[1]);
   const uint8_t hh = bcd2bin(values[2]);
   const uint8_t d = bcd2bin(values[3]);
@@ -112,99 +103,46 @@ bool PCF8523::now(DateTime* dt) {
   return true;
 }
 
-bool PCF8523::start(void) {
-  uint8_t ctlreg;
-  if (!i2c_.ReadRegister(PCF8523_ADDRESS, PCF8523_CONTROL_1, &ctlreg))
+bool PCF8523::readSeconds(uint8_t* seconds) {
+  uint8_t bcd;
+  if (!readField<Registers::Seconds>(&i2c_, PCF8523_ADDRESS, &bcd, __func__))
     return false;
-  if (ctlreg & (1 << 5)) {
-    return i2c_.WriteRegister(PCF8523_ADDRESS, PCF8523_CONTROL_1,
-                              ctlreg & ~(1 << 5));
-  }
+  *seconds = bcd2bin(bcd);
   return true;
 }
 
+bool PCF8523::start(void) {
+  return writeField<Registers::STOP>(&i2c_, PCF8523_ADDRESS, 0, __func__);
+}
+
 bool PCF8523::stop(void) {
-  uint8_t ctlreg;
-  if (!i2c_.ReadRegister(PCF8523_ADDRESS, PCF8523_CONTROL_1, &ctlreg))
-    return false;
-  if (!(ctlreg & (1 << 5))) {
-    return i2c_.WriteRegister(PCF8523_ADDRESS, PCF8523_CONTROL_1,
-                              ctlreg | (1 << 5));
-  }
-  return true;
+  return writeField<Registers::STOP>(&i2c_, PCF8523_ADDRESS, 1, __func__);
 }
 
 bool PCF8523::isRunning() {
-  uint8_t ctlreg;
-  if (!i2c_.ReadRegister(PCF8523_ADDRESS, PCF8523_CONTROL_1, &ctlreg))
+  uint8_t stopped;
+  if (!readField<Registers::STOP>(&i2c_, PCF8523_ADDRESS, &stopped, __func__))
     return false;
-
-  return !((ctlreg >> 5) & 1);
+  return !stopped;
 }
 
 PCF8523::SqwPinMode PCF8523::readSqwPinMode() {
-  uint8_t mode;
-  if (!i2c_.ReadRegister(PCF8523_ADDRESS, PCF8523_CLKOUTCONTROL, &mode))
+  uint8_t cof;
+  if (!readField<Registers::COF>(&i2c_, PCF8523_ADDRESS, &cof, __func__))
     return SqwPinMode::Off;
-
-  switch (mode & CLKOUT_SQW_MASK) {  // COF[2:0]
-    case CLKOUT_SQW_32kHz:
-      return SqwPinMode::Rate32kHz;
-    case CLKOUT_SQW_16kHz:
-      return SqwPinMode::Rate16kHz;
-    case CLKOUT_SQW_8kHz:
-      return SqwPinMode::Rate8kHz;
-    case CLKOUT_SQW_4kHz:
-      return SqwPinMode::Rate4kHz;
-    case CLKOUT_SQW_1kHz:
-      return SqwPinMode::Rate1kHz;
-    case CLKOUT_SQW_32Hz:
-      return SqwPinMode::Rate32Hz;
-    case CLKOUT_SQW_1Hz:
-      return SqwPinMode::Rate1Hz;
-    case CLKOUT_SQW_Off:
-      // Fallthrough
-    default:
-      return SqwPinMode::Off;
-  }
+  return decodeField(Registers::kSqwPinModes, cof, SqwPinMode::Off);
 }
 
 bool PCF8523::writeSqwPinMode(PCF8523::SqwPinMode mode) {
-  uint8_t reg = 0x0;
-
-  // TODO: Should this function preserve the other PCF8523_CLKOUTCONTROL
-  // register bits? Most of those are alarm bits, and it's doubtful that
-  // one would want to use alarms as well as the square wave feature.
-  // Should probably **only** set the square wave bits (i.e. COF[2:0])
-  // in this function, and provide API to set the others.
-
-  switch (mode) {
-    case SqwPinMode::Off:
-      SET_BITS(reg, CLKOUT_SQW_Off);
-      break;
-    case SqwPinMode::Rate1Hz:
-      SET_BITS(reg, CLKOUT_SQW_1Hz);
-      break;
-    case SqwPinMode::Rate32Hz:
-      SET_BITS(reg, CLKOUT_SQW_32Hz);
-      break;
-    case SqwPinMode::Rate1kHz:
-      SET_BITS(reg, CLKOUT_SQW_1kHz);
-      break;
-    case SqwPinMode::Rate4kHz:
-      SET_BITS(reg, CLKOUT_SQW_4kHz);
-      break;
-    case SqwPinMode::Rate8kHz:
-      SET_BITS(reg, CLKOUT_SQW_8kHz);
-      break;
-    case SqwPinMode::Rate16kHz:
-      SET_BITS(reg, CLKOUT_SQW_16kHz);
-      break;
-    case SqwPinMode::Rate32kHz:
-      SET_BITS(reg, CLKOUT_SQW_32kHz);
-      break;
-  }
-  return i2c_.WriteRegister(PCF8523_ADDRESS, PCF8523_CLKOUTCONTROL, reg);
+  // TODO: Should this function preserve the other Tmr_CLKOUT_ctrl register
+  // bits? Most of those are alarm bits, and it's doubtful that one would
+  // want to use alarms as well as the square wave feature. Should probably
+  // **only** set the square wave bits (i.e. COF[2:0]) in this function, and
+  // provide API to set the others.
+  const uint8_t reg =
+      Registers::COF::set(0, encodeField(Registers::kSqwPinModes, mode));
+  return writeRegister(&i2c_, PCF8523_ADDRESS, Registers::kTmrClkout, reg,
+                       __func__);
 }
 
 bool PCF8523::enableSecondTimer() {
@@ -212,39 +150,33 @@ bool PCF8523::enableSecondTimer() {
   uint8_t clkreg;
 
   {
-    auto op = i2c_.CreateReadOp(PCF8523_ADDRESS, PCF8523_CONTROL_1,
-                                "enableSecondTimer:read");
+    auto op = createReadOp(&i2c_, PCF8523_ADDRESS, Registers::kControl1,
+                           "enableSecondTimer:read");
     if (!op.ready())
       return false;
     op.Read(&ctlreg, sizeof(ctlreg));
-    op.RestartReg(PCF8523_CLKOUTCONTROL, Operation::Type::READ);
+    op.RestartReg(Registers::kTmrClkout, Operation::Type::READ);
     op.Read(&clkreg, sizeof(clkreg));
     if (!op.Execute())
       return false;
   }
 
-  auto op = i2c_.CreateWriteOp(PCF8523_ADDRESS, PCF8523_CLKOUTCONTROL,
-                               "enableSecondTimer:write");
+  auto op = createWriteOp(&i2c_, PCF8523_ADDRESS, Registers::kTmrClkout,
+                          "enableSecondTimer:write");
   if (!op.ready())
     return false;
   // TAM pulse int. mode (shared with Timer A), CLKOUT (aka SQW) disabled
-  op.WriteByte(clkreg | 0xB8);
+  op.WriteByte(Registers::COF::set(Registers::TAM::set(clkreg, 1), kClkoutOff));
 
   // SIE Second timer int. enable
-  op.RestartReg(PCF8523_CONTROL_1, Operation::Type::WRITE);
-  op.WriteByte(ctlreg | (1 << 2));
+  op.RestartReg(Registers::kControl1, Operation::Type::WRITE);
+  op.WriteByte(Registers::SIE::set(ctlreg, 1));
   return op.Execute();
 }
 
 bool PCF8523::disableSecondTimer() {
-  // Leave compatible settings intact
-  uint8_t ctlreg;
-  if (!i2c_.ReadRegister(PCF8523_ADDRESS, PCF8523_CONTROL_1, &ctlreg))
-    return false;
-
-  // SIE Second timer int. disable
-  return i2c_.WriteRegister(PCF8523_ADDRESS, PCF8523_CONTROL_1,
-                            ctlreg & ~(1 << 2));
+  // Leave compatible settings intact. SIE Second timer int. disable
+  return writeField<Registers::SIE>(&i2c_, PCF8523_ADDRESS, 0, __func__);
 }
 
 bool PCF8523::enableCountdownTimer(PCF8523TimerClockFreq clkFreq,
@@ -260,38 +192,39 @@ bool PCF8523::enableCountdownTimer(PCF8523TimerClockFreq clkFreq,
   uint8_t clkreg;
 
   {
-    auto op = i2c_.CreateReadOp(PCF8523_ADDRESS, PCF8523_CONTROL_2,
-                                "enableCountdownTimer:read");
+    auto op = createReadOp(&i2c_, PCF8523_ADDRESS, Registers::kControl2,
+                           "enableCountdownTimer:read");
     if (!op.ready())
       return false;
     op.Read(&ctlreg, sizeof(ctlreg));
 
-    op.RestartReg(PCF8523_CLKOUTCONTROL, Operation::Type::READ);
+    op.RestartReg(Registers::kTmrClkout, Operation::Type::READ);
     op.Read(&clkreg, sizeof(clkreg));
 
     if (!op.Execute())
       return false;
   }
 
-  auto op = i2c_.CreateWriteOp(PCF8523_ADDRESS, PCF8523_CONTROL_2,
-                               "enableCountdownTimer:write");
+  auto op = createWriteOp(&i2c_, PCF8523_ADDRESS, Registers::kControl2,
+                          "enableCountdownTimer:write");
   if (!op.ready())
     return false;
 
   // CTBIE Countdown Timer B Interrupt Enabled
-  op.WriteByte(ctlreg |= 0x01);
+  op.WriteByte(Registers::CTBIE::set(ctlreg, 1));
 
   // Timer B source clock frequency, optionally int. low pulse width
-  op.RestartReg(PCF8523_TIMER_B_FRCTL, Operation::Type::WRITE);
+  op.RestartReg(Registers::kTmrBFreq, Operation::Type::WRITE);
   op.WriteByte(lowPulseWidth << 4 | clkFreq);
 
   // Timer B value (number of source clock periods)
-  op.RestartReg(PCF8523_TIMER_B_VALUE, Operation::Type::WRITE);
+  op.RestartReg(Registers::kTmrB, Operation::Type::WRITE);
   op.WriteByte(numPeriods);
 
   // TBM Timer B pulse int. mode, CLKOUT (aka SQW) disabled, TBC start Timer B
-  op.RestartReg(PCF8523_CLKOUTCONTROL, Operation::Type::WRITE);
-  op.WriteByte(clkreg | 0x79);
+  op.RestartReg(Registers::kTmrClkout, Operation::Type::WRITE);
+  clkreg = Registers::COF::set(Registers::TBM::set(clkreg, 1), kClkoutOff);
+  op.WriteByte(Registers::TBC::set(clkreg, 1));
 
   return op.Execute();
 }
@@ -302,39 +235,146 @@ bool PCF8523::enableCountdownTimer(PCF8523TimerClockFreq clkFreq,
 }
 
 bool PCF8523::disableCountdownTimer() {
+  return writeField<Registers::TBC>(&i2c_, PCF8523_ADDRESS, 0, __func__);
+}
+
+bool PCF8523::startCountdownTimer(PCF8523Timer timer,
+                                  PCF8523TimerClockFreq clkFreq,
+                                  uint8_t numPeriods) {
+  uint8_t ctlreg;
+  uint8_t clkreg;
+
+  {
+    auto op = createReadOp(&i2c_, PCF8523_ADDRESS, Registers::kControl2,
+                           "startCountdownTimer:read");
+    if (!op.ready())
+      return false;
+    op.Read(&ctlreg, sizeof(ctlreg));
+
+    op.RestartReg(Registers::kTmrClkout, Operation::Type::READ);
+    op.Read(&clkreg, sizeof(clkreg));
+
+    if (!op.Execute())
+      return false;
+  }
+
+  const bool a = timer == PCF8523_TimerA;
+  // Flags are only cleared by writing zero: writing one to the others leaves
+  // them unchanged, even if raised since they were read.
+  ctlreg |= Registers::Flags::kMask;
+  // Level interrupt, CLKOUT disabled.
+  clkreg = Registers::COF::set(clkreg, kClkoutOff);
+  uint8_t stopped, started;
+  if (a) {
+    ctlreg = Registers::CTAIE::set(Registers::CTAF::set(ctlreg, 0), 1);
+    stopped = Registers::TAC::set(Registers::TAM::set(clkreg, 0), 0);
+    started = Registers::TAC::set(stopped, Registers::kTacCountdown);
+  } else {
+    ctlreg = Registers::CTBIE::set(Registers::CTBF::set(ctlreg, 0), 1);
+    stopped = Registers::TBC::set(Registers::TBM::set(clkreg, 0), 0);
+    started = Registers::TBC::set(stopped, 1);
+  }
+
+  auto op = createWriteOp(&i2c_, PCF8523_ADDRESS, Registers::kTmrClkout,
+                          "startCountdownTimer:write");
+  if (!op.ready())
+    return false;
+
+  // The datasheet cautions against updating the value while running.
+  op.WriteByte(stopped);
+
+  op.RestartReg(Registers::kControl2, Operation::Type::WRITE);
+  op.WriteByte(ctlreg);
+
+  op.RestartReg(a ? Registers::kTmrAFreq : Registers::kTmrBFreq,
+                Operation::Type::WRITE);
+  op.WriteByte(clkFreq);
+  op.WriteByte(numPeriods);  // Value register follows the frequency.
+
+  op.RestartReg(Registers::kTmrClkout, Operation::Type::WRITE);
+  op.WriteByte(started);
+
+  return op.Execute();
+}
+
+bool PCF8523::stopCountdownTimer(PCF8523Timer timer) {
   uint8_t clkreg;
-  if (!i2c_.ReadRegister(PCF8523_ADDRESS, PCF8523_CLKOUTCONTROL, &clkreg))
+  if (!readRegister(&i2c_, PCF8523_ADDRESS, Registers::kTmrClkout, &clkreg,
+                    __func__)) {
+    return false;
+  }
+  clkreg = timer == PCF8523_TimerA ? Registers::TAC::set(clkreg, 0)
+                                   : Registers::TBC::set(clkreg, 0);
+  return writeRegister(&i2c_, PCF8523_ADDRESS, Registers::kTmrClkout, clkreg,
+                       __func__);
+}
+
+bool PCF8523::readAndClearCountdownFlags(bool* timer_a, bool* timer_b) {
+  uint8_t ctlreg;
+  if (!readRegister(&i2c_, PCF8523_ADDRESS, Registers::kControl2, &ctlreg,
+                    __func__)) {
     return false;
-  return i2c_.WriteRegister(PCF8523_ADDRESS, PCF8523_CLKOUTCONTROL,
-                            ~1 & clkreg);
+  }
+  const uint8_t expired =
+      ctlreg & (Registers::CTAF::kMask | Registers::CTBF::kMask);
+  *timer_a = Registers::CTAF::get(expired);
+  *timer_b = Registers::CTBF::get(expired);
+  if (!expired)
+    return true;
+  // Clear only the flags which were read as set.
+  return writeRegister(&i2c_, PCF8523_ADDRESS, Registers::kControl2,
+                       (ctlreg | Registers::Flags::kMask) & ~expired,
+                       __func__);
 }
 
 bool PCF8523::deconfigureAllTimers() {
   disableSecondTimer();  // Surgically clears CONTROL_1
 
-  auto op = i2c_.CreateWriteOp(PCF8523_ADDRESS, PCF8523_CONTROL_2,
-                               "deconfigureAllTimers");
+  auto op = createWriteOp(&i2c_, PCF8523_ADDRESS, Registers::kControl2,
+                          "deconfigureAllTimers");
   if (!op.ready())
     return false;
 
   op.WriteByte(0);
 
-  op.RestartReg(PCF8523_CLKOUTCONTROL, Operation::Type::WRITE);
+  op.RestartReg(Registers::kTmrClkout, Operation::Type::WRITE);
   op.WriteByte(0);
 
-  op.RestartReg(PCF8523_TIMER_B_FRCTL, Operation::Type::WRITE);
+  op.RestartReg(Registers::kTmrBFreq, Operation::Type::WRITE);
   op.WriteByte(0);
 
-  op.RestartReg(PCF8523_TIMER_B_VALUE, Operation::Type::WRITE);
+  op.RestartReg(Registers::kTmrB, Operation::Type::WRITE);
   op.WriteByte(0);
 
   return op.Execute();
 }
 
 bool PCF8523::calibrate(Pcf8523OffsetMode mode, int8_t offset) {
-  uint8_t reg = (uint8_t)offset & 0x7F;
+  uint8_t reg = Registers::OFFSET::set(0, static_cast<uint8_t>(offset));
   reg |= mode;
-  return i2c_.WriteRegister(PCF8523_ADDRESS, PCF8523_OFFSET, reg);
+  return writeRegister(&i2c_, PCF8523_ADDRESS, Registers::kOffset, reg,
+                       __func__);
+}
+
+bool PCF8523::getOffset(Pcf8523OffsetMode* mode, int8_t* offset) {
+  uint8_t reg;
+  if (!readRegister(&i2c_, PCF8523_ADDRESS, Registers::kOffset, &reg, __func__))
+    return false;
+  *mode = static_cast<Pcf8523OffsetMode>(reg & Registers::MODE::kMask);
+  // Sign-extend the 7-bit two's complement offset.
+  const uint8_t value = Registers::OFFSET::get(reg);
+  *offset = static_cast<int8_t>(value & 0x40 ? value | 0x80 : value);
+  return true;
+}
+
+bool PCF8523::dumpRegisters(uint8_t* values) {
+  return readRegisterDump(&i2c_, PCF8523_ADDRESS, values, kNumRegisters,
+                          __func__);
+}
+
+bool PCF8523::restoreRegisters(const uint8_t* values) {
+  return writeRegisterDump(&i2c_, PCF8523_ADDRESS, values, Registers::kRestore,
+                           kNumRegisters, __func__);
 }
 
 }  // namespace rtc
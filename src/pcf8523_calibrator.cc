@@ -0,0 +1,153 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/pcf8523_calibrator.h>
+
+#include <cmath>
+#include <cstdlib>
+
+#include <rtclib/datetime.h>
+#include <rtclib/trace.h>
+
+namespace rtc {
+
+namespace {
+
+// Offset register units, see PCF8523 datasheet table 29.
+constexpr float kTwoHoursUnitPpm = 4.340f;
+constexpr float kOneMinuteUnitPpm = 4.069f;
+
+constexpr int kMinOffset = -64;
+constexpr int kMaxOffset = 63;
+
+/**
+ * The worst case measurement error, in seconds, of a window. Both the start
+ * and end RTC readings are truncated to the whole second.
+ */
+constexpr float kWindowErrorSeconds = 2.0f;
+
+int8_t nearestOffset(float ppm, float unit_ppm) {
+  long offset = std::lround(ppm / unit_ppm);
+  if (offset < kMinOffset)
+    offset = kMinOffset;
+  else if (offset > kMaxOffset)
+    offset = kMaxOffset;
+  return static_cast<int8_t>(offset);
+}
+
+}  // namespace
+
+PCF8523Calibrator::PCF8523Calibrator(PCF8523* rtc,
+                                     Store* store,
+                                     const Config& config)
+    : rtc_(rtc), store_(store), config_(config), calibration_() {}
+
+PCF8523Calibrator::PCF8523Calibrator(PCF8523* rtc, Store* store)
+    : PCF8523Calibrator(rtc, store, Config()) {}
+
+// static
+float PCF8523Calibrator::offsetToPpm(Pcf8523OffsetMode mode, int8_t offset) {
+  return offset *
+         (mode == PCF8523_OneMinute ? kOneMinuteUnitPpm : kTwoHoursUnitPpm);
+}
+
+// static
+void PCF8523Calibrator::selectOffset(float ppm,
+                                     Pcf8523OffsetMode* mode,
+                                     int8_t* offset) {
+  const int8_t two_hours = nearestOffset(ppm, kTwoHoursUnitPpm);
+  const int8_t one_minute = nearestOffset(ppm, kOneMinuteUnitPpm);
+  const float two_hours_error =
+      std::fabs(ppm - offsetToPpm(PCF8523_TwoHours, two_hours));
+  const float one_minute_error =
+      std::fabs(ppm - offsetToPpm(PCF8523_OneMinute, one_minute));
+  if (one_minute_error < two_hours_error) {
+    *mode = PCF8523_OneMinute;
+    *offset = one_minute;
+  } else {
+    *mode = PCF8523_TwoHours;
+    *offset = two_hours;
+  }
+}
+
+bool PCF8523Calibrator::startWindow(uint32_t reference) {
+  DateTime rtc_now;
+  if (!rtc_->now(&rtc_now))
+    return false;
+  calibration_.reference_start = reference;
+  calibration_.rtc_start = rtc_now.unixtime();
+  if (store_)
+    store_->save(calibration_);
+  return true;
+}
+
+bool PCF8523Calibrator::begin(const DateTime& reference) {
+  Pcf8523OffsetMode mode;
+  int8_t offset;
+  if (!rtc_->getOffset(&mode, &offset))
+    return false;
+
+  PCF8523Calibration saved;
+  if (store_ && store_->load(&saved) && saved.mode == mode &&
+      saved.offset == offset &&
+      saved.reference_start <= reference.unixtime()) {
+    calibration_ = saved;
+    return true;
+  }
+
+  calibration_.mode = mode;
+  calibration_.offset = offset;
+  return startWindow(reference.unixtime());
+}
+
+bool PCF8523Calibrator::update(const DateTime& reference) {
+  TraceScope trace("calibration", "PCF8523Calibrator::update");
+  DateTime rtc_now;
+  if (!rtc_->now(&rtc_now))
+    return false;
+
+  const uint32_t ref = reference.unixtime();
+  if (ref < calibration_.reference_start ||
+      rtc_now.unixtime() < calibration_.rtc_start) {
+    // Reference or RTC moved backwards (e.g. the RTC lost power or was
+    // adjusted): the window is meaningless.
+    return startWindow(ref);
+  }
+
+  const int64_t ref_elapsed = ref - calibration_.reference_start;
+  if (ref_elapsed < config_.min_interval)
+    return true;
+
+  const int64_t rtc_elapsed = rtc_now.unixtime() - calibration_.rtc_start;
+  measured_ppm_ = static_cast<float>(rtc_elapsed - ref_elapsed) * 1e6f /
+                  static_cast<float>(ref_elapsed);
+  uncertainty_ppm_ =
+      kWindowErrorSeconds * 1e6f / static_cast<float>(ref_elapsed);
+
+  const float error = std::fabs(measured_ppm_);
+  if (error <= config_.threshold_ppm || error <= uncertainty_ppm_) {
+    if (ref_elapsed >= config_.max_interval)
+      return startWindow(ref);
+    return true;
+  }
+
+  // The measured drift is the residual after the current correction, so
+  // the crystal's uncorrected drift is the sum of the two.
+  const float crystal_ppm =
+      measured_ppm_ + offsetToPpm(calibration_.mode, calibration_.offset);
+  Pcf8523OffsetMode mode;
+  int8_t offset;
+  selectOffset(crystal_ppm, &mode, &offset);
+  if (!rtc_->calibrate(mode, offset))
+    return false;
+  calibration_.mode = mode;
+  calibration_.offset = offset;
+  calibrations_++;
+  return startWindow(ref);
+}
+
+}  // namespace rtc
@@ -0,0 +1,131 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/pcf8523_timer_scheduler.h>
+
+#include <utility>
+
+#include <rtclib/system_clock.h>
+#include <rtclib/tick_source.h>
+
+namespace rtc {
+
+namespace {
+
+/**
+ * Source clock periods, in 1/64 µs so that the 4.096 kHz period is exact,
+ * indexed by PCF8523TimerClockFreq.
+ */
+constexpr int64_t kPeriods[] = {
+    15625,                  // 4.096 kHz.
+    1000000,                // 64 Hz.
+    64 * 1000000LL,         // Second.
+    60 * 64 * 1000000LL,    // Minute.
+    3600 * 64 * 1000000LL,  // Hour.
+};
+
+constexpr int64_t kMaxPeriods = 255;
+
+}  // namespace
+
+PCF8523TimerScheduler::PCF8523TimerScheduler(PCF8523* rtc,
+                                             const TickSource* ticks)
+    : rtc_(rtc), ticks_(ticks) {}
+
+int64_t PCF8523TimerScheduler::micros() const {
+  return ticks_ ? ticks_->micros() : SystemClock::microsSinceStart();
+}
+
+bool PCF8523TimerScheduler::begin() {
+  callback_ = nullptr;
+  running_ = false;
+  bool a, b;
+  return rtc_->stopCountdownTimer(PCF8523_TimerA) &&
+         rtc_->stopCountdownTimer(PCF8523_TimerB) &&
+         rtc_->readAndClearCountdownFlags(&a, &b);
+}
+
+bool PCF8523TimerScheduler::scheduleAt(int64_t deadline, Callback callback) {
+  if (running_ && !cancel())
+    return false;
+  callback_ = std::move(callback);
+  deadline_ = deadline;
+  stages_ = 0;
+  final_stage_ = false;
+  return startStage();
+}
+
+bool PCF8523TimerScheduler::scheduleIn(int64_t delay, Callback callback) {
+  return scheduleAt(micros() + delay, std::move(callback));
+}
+
+bool PCF8523TimerScheduler::cancel() {
+  callback_ = nullptr;
+  if (!running_)
+    return true;
+  if (!rtc_->stopCountdownTimer(timer_))
+    return false;
+  running_ = false;
+  return true;
+}
+
+bool PCF8523TimerScheduler::startStage() {
+  // In 1/64 µs, as kPeriods.
+  const int64_t remaining = (deadline_ - micros()) * 64;
+  if (remaining < kPeriods[PCF8523_Frequency4kHz] / 2 || final_stage_) {
+    Callback callback = std::move(callback_);
+    callback_ = nullptr;
+    if (callback)
+      callback();
+    return true;
+  }
+
+  // The finest source clock which covers the remaining time.
+  int freq = PCF8523_Frequency4kHz;
+  while (freq < PCF8523_FrequencyHour &&
+         remaining > kMaxPeriods * kPeriods[freq]) {
+    freq++;
+  }
+
+  const int64_t period = kPeriods[freq];
+  int64_t periods = remaining / period;
+  if (freq == PCF8523_Frequency4kHz) {
+    // The countdown lasts between periods - 1 and periods: straddle the
+    // deadline.
+    periods++;
+  }
+  if (periods > kMaxPeriods)
+    periods = kMaxPeriods;
+
+  // Alternate timers, so that the next stage starts on a stopped timer.
+  if (stages_)
+    timer_ = timer_ == PCF8523_TimerA ? PCF8523_TimerB : PCF8523_TimerA;
+  final_stage_ = freq == PCF8523_Frequency4kHz;
+  stages_++;
+  if (!rtc_->startCountdownTimer(timer_,
+                                 static_cast<PCF8523TimerClockFreq>(freq),
+                                 static_cast<uint8_t>(periods))) {
+    return false;
+  }
+  running_ = true;
+  return true;
+}
+
+bool PCF8523TimerScheduler::service() {
+  bool a, b;
+  if (!rtc_->readAndClearCountdownFlags(&a, &b))
+    return false;
+  if (!running_ || !(timer_ == PCF8523_TimerA ? a : b))
+    return true;
+  // Timers repeat: stop this one before it expires again.
+  if (!rtc_->stopCountdownTimer(timer_))
+    return false;
+  running_ = false;
+  return startStage();
+}
+
+}  // namespace rtc
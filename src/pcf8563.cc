@@ -13,47 +13,52 @@
 #include <i2clib/master.h>
 #include <i2clib/operation.h>
 #include <rtclib/datetime.h>
+#include <rtclib/pcf8563_registers.h>
+#include "instrumented_i2c.h"
+#include "register_dump.h"
 #include "rtc_util.h"
 
+using i2c::Operation;
+
 namespace rtc {
 
 namespace {
 
-// clang-format off
-constexpr uint8_t PCF8563_I2C_ADDRESS = 0x51;
+using Registers = PCF8563Registers;
 
-constexpr uint8_t REGISTER_CLKOUTCONTROL = 0x0D;
-constexpr uint8_t REGISTER_CONTROL_1     = 0x00;
-constexpr uint8_t REGISTER_CONTROL_2     = 0x01;
-constexpr uint8_t REGISTER_VL_SECONDS    = 0x02;
+constexpr uint8_t PCF8563_I2C_ADDRESS = Registers::kI2CAddress;
 
-// Datasheet section 8.7:
-constexpr uint8_t kSquareWaveOff   = 0x0;
-constexpr uint8_t kSquareWave1Hz   = 0b10000011;
-constexpr uint8_t kSquareWave32Hz  = 0b10000010;
-constexpr uint8_t kSquareWave1kHz  = 0b10000001;
-constexpr uint8_t kSquareWave32kHz = 0b10000000;
-constexpr uint8_t kSquareWaveMask  = 0b10000011;
-// clang-format on
+/**
+ * The Control_2 value which clears |flags|. AF and TF are only cleared by
+ * writing zero, so the other flag is written as one to leave it unchanged.
+ */
+uint8_t clearFlags(uint8_t ctlreg, uint8_t flags) {
+  return (ctlreg | Registers::AF::kMask | Registers::TF::kMask) & ~flags;
+}
 
 }  // namespace
 
+constexpr FieldValue<PCF8563::SqwPinMode> PCF8563Registers::kSqwPinModes[];
+constexpr RegisterRestore PCF8563Registers::kRestore[];
+
 PCF8563::PCF8563(i2c::Master i2c) : i2c_(std::move(i2c)) {}
 
 bool PCF8563::begin() {
-  return i2c_.Ping(PCF8563_I2C_ADDRESS);
+  return ping(&i2c_, PCF8563_I2C_ADDRESS, __func__);
 }
 
 bool PCF8563::lostPower() {
-  uint8_t value;
-  if (!i2c_.ReadRegister(PCF8563_I2C_ADDRESS, REGISTER_VL_SECONDS, &value))
+  uint8_t voltage_low;
+  if (!readField<Registers::VL>(&i2c_, PCF8563_I2C_ADDRESS, &voltage_low,
+                                __func__)) {
     return false;
-  return value >> 7;
+  }
+  return voltage_low;
 }
 
 bool PCF8563::adjust(const DateTime& dt) {
-  auto op =
-      i2c_.CreateWriteOp(PCF8563_I2C_ADDRESS, REGISTER_VL_SECONDS, "adjust");
+  auto op = createWriteOp(&i2c_, PCF8563_I2C_ADDRESS, Registers::kVLSeconds,
+                          "adjust");
   if (!op.ready())
     return false;
   const uint8_t values[7] = {
@@ -61,7 +66,7 @@ bool PCF8563::adjust(const DateTime& dt) {
       bin2bcd(dt.minute()),
       bin2bcd(dt.hour()),
       bin2bcd(dt.day()),
-      0x0,
+      bin2bcd(dt.dayOfTheWeek()),
       bin2bcd(dt.month()),
       bin2bcd(dt.year() - 2000),
   };
@@ -70,7 +75,8 @@ bool PCF8563::adjust(const DateTime& dt) {
 }
 
 bool PCF8563::now(DateTime* dt) {
-  auto op = i2c_.CreateReadOp(PCF8563_I2C_ADDRESS, REGISTER_VL_SECONDS, "now");
+  auto op = createReadOp(&i2c_, PCF8563_I2C_ADDRESS, Registers::kVLSeconds,
+                         "now");
   if (!op.ready())
     return false;
   uint8_t values[7];
@@ -78,85 +84,235 @@ bool PCF8563::now(DateTime* dt) {
   if (!op.Execute())
     return false;
 
-  const uint8_t ss = bcd2bin(values[0] & 0x7F);
-  const uint8_t mm = bcd2bin(values[1] & 0x7F);
-  const uint8_t hh = bcd2bin(values[2] & 0x3F);
-  const uint8_t d = bcd2bin(values[3] & 0x3F);
+  const uint8_t ss = bcd2bin(Registers::Seconds::get(values[0]));
+  const uint8_t mm = bcd2bin(Registers::Minutes::get(values[1]));
+  const uint8_t hh = bcd2bin(Registers::Hours::get(values[2]));
+  const uint8_t d = bcd2bin(Registers::Days::get(values[3]));
   // skip 'weekdays'
-  const uint8_t m = bcd2bin(values[5] & 0x1F);
+  const uint8_t m = bcd2bin(Registers::Months::get(values[5]));
   const uint16_t y = bcd2bin(values[6]) + 2000;
 
   *dt = DateTime(y, m, d, hh, mm, ss);
   return true;
 }
 
-bool PCF8563::start() {
-  uint8_t ctlreg;
-  if (!i2c_.ReadRegister(PCF8563_I2C_ADDRESS, REGISTER_CONTROL_1, &ctlreg))
+bool PCF8563::readSeconds(uint8_t* seconds) {
+  uint8_t bcd;
+  if (!readField<Registers::Seconds>(&i2c_, PCF8563_I2C_ADDRESS, &bcd,
+                                     __func__)) {
     return false;
+  }
+  *seconds = bcd2bin(bcd);
+  return true;
+}
 
-  return i2c_.WriteRegister(PCF8563_I2C_ADDRESS, REGISTER_CONTROL_1,
-                            ctlreg & ~(1 << 5));
+bool PCF8563::start() {
+  return writeField<Registers::STOP>(&i2c_, PCF8563_I2C_ADDRESS, 0, __func__);
 }
 
 bool PCF8563::stop() {
-  uint8_t ctlreg;
-  if (!i2c_.ReadRegister(PCF8563_I2C_ADDRESS, REGISTER_CONTROL_1, &ctlreg))
-    return false;
-
-  return i2c_.WriteRegister(PCF8563_I2C_ADDRESS, REGISTER_CONTROL_1,
-                            ctlreg | (1 << 5));
+  return writeField<Registers::STOP>(&i2c_, PCF8563_I2C_ADDRESS, 1, __func__);
 }
 
 bool PCF8563::isRunning() {
-  uint8_t ctlreg;
-  if (!i2c_.ReadRegister(PCF8563_I2C_ADDRESS, REGISTER_CONTROL_1, &ctlreg))
+  uint8_t stopped;
+  if (!readField<Registers::STOP>(&i2c_, PCF8563_I2C_ADDRESS, &stopped,
+                                  __func__)) {
     return false;
-  return !((ctlreg >> 5) & 1);
+  }
+  return !stopped;
 }
 
 PCF8563::SqwPinMode PCF8563::readSqwPinMode() {
-  uint8_t mode;
-  if (!i2c_.ReadRegister(PCF8563_I2C_ADDRESS, REGISTER_CLKOUTCONTROL, &mode))
-    return PCF8563::SqwPinMode::Off;
-  switch (mode & kSquareWaveMask) {
-    case kSquareWaveOff:
-      return SqwPinMode::Off;
-    case kSquareWave1Hz:
-      return SqwPinMode::Rate1Hz;
-    case kSquareWave32Hz:
-      return SqwPinMode::Rate32Hz;
-    case kSquareWave1kHz:
-      return SqwPinMode::Rate1kHz;
-    case kSquareWave32kHz:
-      return SqwPinMode::Rate32kHz;
-    default:
-      return SqwPinMode::Off;
+  uint8_t value;
+  if (!readRegister(&i2c_, PCF8563_I2C_ADDRESS, Registers::kClkoutControl,
+                    &value, __func__)) {
+    return SqwPinMode::Off;
   }
+  return Registers::sqwPinMode(value);
 }
 
 bool PCF8563::writeSqwPinMode(SqwPinMode mode) {
-  uint8_t reg_value = kSquareWaveOff;
-  switch (mode) {
-    case SqwPinMode::Off:
-      reg_value = kSquareWaveOff;
-      break;
-    case SqwPinMode::Rate1Hz:
-      reg_value = kSquareWave1Hz;
-      break;
-    case SqwPinMode::Rate32Hz:
-      reg_value = kSquareWave32Hz;
+  // Bits 6..2 are unused, setting to all zeros.
+  return writeRegister(&i2c_, PCF8563_I2C_ADDRESS, Registers::kClkoutControl,
+                       encodeField(Registers::kSqwPinModes, mode), __func__);
+}
+
+bool PCF8563::setAlarm(const DateTime& dt, AlarmMode alarm_mode) {
+  uint8_t ctlreg;
+  if (!readRegister(&i2c_, PCF8563_I2C_ADDRESS, Registers::kControl2, &ctlreg,
+                    __func__)) {
+    return false;
+  }
+
+  uint8_t alarm[4] = {
+      bin2bcd(dt.minute()),
+      bin2bcd(dt.hour()),
+      bin2bcd(dt.day()),
+      bin2bcd(dt.dayOfTheWeek()),
+  };
+  switch (alarm_mode) {
+    case AlarmMode::Minute:
+      alarm[1] = Registers::AE_H::set(alarm[1], 1);
+      // fallthrough.
+    case AlarmMode::Hour:
+      alarm[2] = Registers::AE_D::set(alarm[2], 1);
+      alarm[3] = Registers::AE_W::set(alarm[3], 1);
       break;
-    case SqwPinMode::Rate1kHz:
-      reg_value = kSquareWave1kHz;
+    case AlarmMode::Date:
+      alarm[3] = Registers::AE_W::set(alarm[3], 1);
       break;
-    case SqwPinMode::Rate32kHz:
-      reg_value = kSquareWave32kHz;
+    case AlarmMode::Day:
+      alarm[2] = Registers::AE_D::set(alarm[2], 1);
       break;
   }
-  // Bits 6..2 are unused, setting to all zeros.
-  return i2c_.WriteRegister(PCF8563_I2C_ADDRESS, REGISTER_CLKOUTCONTROL,
-                            reg_value);
+
+  auto op = createWriteOp(&i2c_, PCF8563_I2C_ADDRESS, Registers::kMinuteAlarm,
+                          "setAlarm");
+  if (!op.ready())
+    return false;
+  op.Write(alarm, sizeof(alarm));
+
+  op.RestartReg(Registers::kControl2, Operation::Type::WRITE);
+  op.WriteByte(
+      Registers::AIE::set(clearFlags(ctlreg, Registers::AF::kMask), 1));
+
+  return op.Execute();
+}
+
+bool PCF8563::disableAlarm() {
+  uint8_t ctlreg;
+  if (!readRegister(&i2c_, PCF8563_I2C_ADDRESS, Registers::kControl2, &ctlreg,
+                    __func__)) {
+    return false;
+  }
+
+  auto op = createWriteOp(&i2c_, PCF8563_I2C_ADDRESS, Registers::kControl2,
+                          "disableAlarm");
+  if (!op.ready())
+    return false;
+  op.WriteByte(Registers::AIE::set(clearFlags(ctlreg, 0), 0));
+
+  op.RestartReg(Registers::kMinuteAlarm, Operation::Type::WRITE);
+  const uint8_t disabled[4] = {
+      Registers::AE_M::kMask, Registers::AE_H::kMask, Registers::AE_D::kMask,
+      Registers::AE_W::kMask};
+  op.Write(disabled, sizeof(disabled));
+
+  return op.Execute();
+}
+
+bool PCF8563::clearAlarm() {
+  uint8_t ctlreg;
+  if (!readRegister(&i2c_, PCF8563_I2C_ADDRESS, Registers::kControl2, &ctlreg,
+                    __func__)) {
+    return false;
+  }
+  return writeRegister(&i2c_, PCF8563_I2C_ADDRESS, Registers::kControl2,
+                       clearFlags(ctlreg, Registers::AF::kMask), __func__);
+}
+
+bool PCF8563::isAlarmFired() {
+  uint8_t ctlreg;
+  if (!readRegister(&i2c_, PCF8563_I2C_ADDRESS, Registers::kControl2, &ctlreg,
+                    __func__)) {
+    return false;
+  }
+  return Registers::AF::get(ctlreg);
+}
+
+bool PCF8563::enableCountdownTimer(PCF8563TimerClockFreq clkFreq,
+                                   uint8_t numPeriods,
+                                   bool pulse) {
+  uint8_t ctlreg;
+  if (!readRegister(&i2c_, PCF8563_I2C_ADDRESS, Registers::kControl2, &ctlreg,
+                    __func__)) {
+    return false;
+  }
+
+  ctlreg = Registers::TIE::set(clearFlags(ctlreg, Registers::TF::kMask), 1);
+  ctlreg = Registers::TI_TP::set(ctlreg, pulse);
+
+  auto op = createWriteOp(&i2c_, PCF8563_I2C_ADDRESS, Registers::kTimerControl,
+                          "enableCountdownTimer");
+  if (!op.ready())
+    return false;
+
+  // Stop the timer while its value is updated.
+  op.WriteByte(clkFreq);
+  op.WriteByte(numPeriods);  // Timer register follows Timer_control.
+
+  op.RestartReg(Registers::kControl2, Operation::Type::WRITE);
+  op.WriteByte(ctlreg);
+
+  op.RestartReg(Registers::kTimerControl, Operation::Type::WRITE);
+  op.WriteByte(Registers::TE::set(clkFreq, 1));
+
+  return op.Execute();
+}
+
+bool PCF8563::enableCountdownTimer(PCF8563TimerClockFreq clkFreq,
+                                   uint8_t numPeriods) {
+  return enableCountdownTimer(clkFreq, numPeriods, /*pulse=*/true);
+}
+
+bool PCF8563::disableCountdownTimer() {
+  uint8_t ctlreg;
+  uint8_t timerreg;
+
+  {
+    auto op = createReadOp(&i2c_, PCF8563_I2C_ADDRESS, Registers::kControl2,
+                           "disableCountdownTimer:read");
+    if (!op.ready())
+      return false;
+    op.Read(&ctlreg, sizeof(ctlreg));
+
+    op.RestartReg(Registers::kTimerControl, Operation::Type::READ);
+    op.Read(&timerreg, sizeof(timerreg));
+
+    if (!op.Execute())
+      return false;
+  }
+
+  auto op = createWriteOp(&i2c_, PCF8563_I2C_ADDRESS, Registers::kTimerControl,
+                          "disableCountdownTimer:write");
+  if (!op.ready())
+    return false;
+  op.WriteByte(Registers::TE::set(timerreg, 0));
+
+  op.RestartReg(Registers::kControl2, Operation::Type::WRITE);
+  op.WriteByte(Registers::TIE::set(clearFlags(ctlreg, 0), 0));
+
+  return op.Execute();
+}
+
+bool PCF8563::clearCountdownTimer() {
+  uint8_t ctlreg;
+  if (!readRegister(&i2c_, PCF8563_I2C_ADDRESS, Registers::kControl2, &ctlreg,
+                    __func__)) {
+    return false;
+  }
+  return writeRegister(&i2c_, PCF8563_I2C_ADDRESS, Registers::kControl2,
+                       clearFlags(ctlreg, Registers::TF::kMask), __func__);
+}
+
+bool PCF8563::isCountdownTimerFired() {
+  uint8_t ctlreg;
+  if (!readRegister(&i2c_, PCF8563_I2C_ADDRESS, Registers::kControl2, &ctlreg,
+                    __func__)) {
+    return false;
+  }
+  return Registers::TF::get(ctlreg);
+}
+
+bool PCF8563::dumpRegisters(uint8_t* values) {
+  return readRegisterDump(&i2c_, PCF8563_I2C_ADDRESS, values, kNumRegisters,
+                          __func__);
+}
+
+bool PCF8563::restoreRegisters(const uint8_t* values) {
+  return writeRegisterDump(&i2c_, PCF8563_I2C_ADDRESS, values,
+                           Registers::kRestore, kNumRegisters, __func__);
 }
 
 }  // namespace rtc
@@ -0,0 +1,83 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/precision_setter.h>
+
+#include <algorithm>
+#include <utility>
+
+#include <rtclib/datetime.h>
+#include <rtclib/system_clock.h>
+
+namespace rtc {
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+
+// The step in which the last of the wait is waited out (µs).
+constexpr int64_t kWaitStepMicros = 100;
+
+// Time allowed to prepare the write after choosing its second (µs).
+constexpr int64_t kLeadMicros = 1000;
+
+}  // namespace
+
+PrecisionSetter::PrecisionSetter(Writer writer, const Config& config)
+    : writer_(std::move(writer)),
+      config_(config),
+      latency_(config.initial_latency) {}
+
+PrecisionSetter::PrecisionSetter(Writer writer)
+    : PrecisionSetter(std::move(writer), Config()) {}
+
+bool PrecisionSetter::set(int64_t local_micros, int64_t unix_micros) {
+  if (config_.prepare && !config_.prepare()) {
+    stats_.failures++;
+    return false;
+  }
+
+  // The reference time, in µs since 1970, at a SystemClock timestamp.
+  const int64_t offset = unix_micros - local_micros;
+  // From the start of the write until the seconds byte.
+  const int64_t lead = latency_ - config_.latch_lag;
+
+  // The first whole second the seconds byte can land on.
+  const int64_t earliest =
+      SystemClock::microsSinceStart() + offset + lead + kLeadMicros;
+  const int64_t second =
+      (earliest + kMicrosPerSecond - 1) / kMicrosPerSecond;
+  const int64_t start = second * kMicrosPerSecond - lead - offset;
+
+  int64_t remaining = start - SystemClock::microsSinceStart();
+  if (remaining > config_.sleep_margin)
+    SystemClock::delayMicros(remaining - config_.sleep_margin);
+  while ((remaining = start - SystemClock::microsSinceStart()) > 0)
+    SystemClock::delayMicros(std::min(remaining, kWaitStepMicros));
+
+  const int64_t before = SystemClock::microsSinceStart();
+  if (!writer_(DateTime(static_cast<uint32_t>(second)))) {
+    stats_.failures++;
+    return false;
+  }
+  const int64_t after = SystemClock::microsSinceStart();
+
+  const int64_t latency = after - before;
+  if (measured_) {
+    latency_ += static_cast<int64_t>(config_.latency_gain *
+                                     static_cast<float>(latency - latency_));
+  } else {
+    latency_ = latency;
+    measured_ = true;
+  }
+  last_error_ =
+      after - config_.latch_lag + offset - second * kMicrosPerSecond;
+  stats_.sets++;
+  return true;
+}
+
+}  // namespace rtc
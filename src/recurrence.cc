@@ -0,0 +1,194 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/recurrence.h>
+
+#include <rtclib/datetime.h>
+
+namespace rtc {
+
+namespace {
+
+constexpr uint16_t kLastYear = 2099;
+
+constexpr uint8_t kDaysInMonth[12] = {31, 28, 31, 30, 31, 30,
+                                      31, 31, 30, 31, 30, 31};
+
+uint8_t daysInMonth(uint16_t year, uint8_t month) {
+  // 2000..2099: every fourth year is a leap year.
+  return month == 2 && year % 4 == 0 ? 29 : kDaysInMonth[month - 1];
+}
+
+/**
+ * The lowest set bit of |mask| at or above |from|, or -1 if none.
+ */
+int nextBit(uint64_t mask, int from) {
+  if (from >= 64)
+    return -1;
+  mask &= ~0ULL << from;
+  return mask ? __builtin_ctzll(mask) : -1;
+}
+
+/**
+ * The days of |month| (bits 1..31) falling on one of |weekdays|.
+ */
+uint32_t weekdayDays(uint16_t year, uint8_t month, uint8_t weekdays) {
+  if (weekdays == Recurrence::kAllWeekdays)
+    return Recurrence::kAllDays;
+  // Rotate the weekday mask so that bit 0 is the weekday of the 1st, then
+  // repeat it for each week of the month.
+  const uint8_t first = DateTime(year, month, 1).dayOfTheWeek();
+  const uint32_t week =
+      ((weekdays >> first) | (weekdays << (7 - first))) & 0x7F;
+  const uint64_t month_days = week | week << 7 | week << 14 |
+                              static_cast<uint64_t>(week) << 21 |
+                              static_cast<uint64_t>(week) << 28;
+  return static_cast<uint32_t>(month_days << 1);
+}
+
+}  // namespace
+
+// static
+Recurrence Recurrence::alarm1(const DateTime& dt, DS3231::Alarm1Mode mode) {
+  Recurrence rule;
+  switch (mode) {
+    case DS3231::Alarm1Mode::Day:
+      rule.weekdays(1 << dt.dayOfTheWeek());
+      // fallthrough.
+    case DS3231::Alarm1Mode::Hour:
+      rule.hours(1UL << dt.hour());
+      // fallthrough.
+    case DS3231::Alarm1Mode::Minute:
+      rule.minutes(1ULL << dt.minute());
+      // fallthrough.
+    case DS3231::Alarm1Mode::Second:
+      rule.seconds(1ULL << dt.second());
+      // fallthrough.
+    case DS3231::Alarm1Mode::EverySecond:
+      break;
+    case DS3231::Alarm1Mode::Date:
+      rule.days(1UL << dt.day())
+          .hours(1UL << dt.hour())
+          .minutes(1ULL << dt.minute())
+          .seconds(1ULL << dt.second());
+      break;
+  }
+  return rule;
+}
+
+// static
+Recurrence Recurrence::alarm2(const DateTime& dt, DS3231::Alarm2Mode mode) {
+  Recurrence rule;
+  rule.seconds(1);
+  switch (mode) {
+    case DS3231::Alarm2Mode::Day:
+      rule.weekdays(1 << dt.dayOfTheWeek());
+      // fallthrough.
+    case DS3231::Alarm2Mode::Hour:
+      rule.hours(1UL << dt.hour());
+      // fallthrough.
+    case DS3231::Alarm2Mode::Minute:
+      rule.minutes(1ULL << dt.minute());
+      // fallthrough.
+    case DS3231::Alarm2Mode::EveryMinute:
+      break;
+    case DS3231::Alarm2Mode::Date:
+      rule.days(1UL << dt.day())
+          .hours(1UL << dt.hour())
+          .minutes(1ULL << dt.minute());
+      break;
+  }
+  return rule;
+}
+
+bool Recurrence::matches(const DateTime& dt) const {
+  return (seconds_ >> dt.second() & 1) && (minutes_ >> dt.minute() & 1) &&
+         (hours_ >> dt.hour() & 1) && (days_ >> dt.day() & 1) &&
+         (months_ >> dt.month() & 1) && (weekdays_ >> dt.dayOfTheWeek() & 1);
+}
+
+bool Recurrence::next(const DateTime& after, DateTime* next) const {
+  if (!seconds_ || !minutes_ || !hours_ || !days_ || !months_ || !weekdays_)
+    return false;
+
+  const DateTime start(after.unixtime() + 1);
+  int year = start.year();
+  int month = start.month();
+  int day = start.day();
+  int hour = start.hour();
+  int minute = start.minute();
+  int second = start.second();
+
+  // Find the first match at each level, from months down to seconds. When
+  // a level has no match left, carry into the level above and restart the
+  // levels below at their lowest value.
+  while (year <= kLastYear) {
+    const int m = nextBit(months_, month);
+    if (m < 0) {
+      year++;
+      month = 1;
+      day = 1;
+      hour = minute = second = 0;
+      continue;
+    }
+    if (m != month) {
+      month = m;
+      day = 1;
+      hour = minute = second = 0;
+    }
+
+    const uint32_t month_days =
+        days_ & weekdayDays(year, month, weekdays_) &
+        (~0U >> (31 - daysInMonth(year, month)));
+    const int d = nextBit(month_days, day);
+    if (d < 0) {
+      month++;
+      day = 1;
+      hour = minute = second = 0;
+      continue;
+    }
+    if (d != day) {
+      day = d;
+      hour = minute = second = 0;
+    }
+
+    const int h = nextBit(hours_, hour);
+    if (h < 0) {
+      day++;
+      hour = minute = second = 0;
+      continue;
+    }
+    if (h != hour) {
+      hour = h;
+      minute = second = 0;
+    }
+
+    const int mi = nextBit(minutes_, minute);
+    if (mi < 0) {
+      hour++;
+      minute = second = 0;
+      continue;
+    }
+    if (mi != minute) {
+      minute = mi;
+      second = 0;
+    }
+
+    const int s = nextBit(seconds_, second);
+    if (s < 0) {
+      minute++;
+      second = 0;
+      continue;
+    }
+
+    *next = DateTime(year, month, day, hour, minute, s);
+    return true;
+  }
+  return false;
+}
+
+}  // namespace rtc
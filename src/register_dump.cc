@@ -0,0 +1,122 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include "register_dump.h"
+
+#include <i2clib/operation.h>
+#include "instrumented_i2c.h"
+
+using i2c::Operation;
+
+namespace rtc {
+
+namespace {
+
+/**
+ * Is register |i| written by writeRuns()? The configuration, or, when
+ * |starting|, the registers with counters to start.
+ */
+bool selected(const uint8_t* values,
+              const RegisterRestore* restore,
+              size_t i,
+              bool starting) {
+  return starting ? (values[i] & restore[i].enable) != 0
+                  : restore[i].config != 0;
+}
+
+/**
+ * Write the selected registers in one transaction, each run of them from a
+ * restart at its first.
+ */
+bool writeRuns(i2c::Master* i2c,
+               uint8_t address,
+               const uint8_t* values,
+               const RegisterRestore* restore,
+               size_t num_registers,
+               bool starting,
+               const char* name) {
+  size_t reg = 0;
+  while (reg < num_registers && !selected(values, restore, reg, starting))
+    reg++;
+  if (reg == num_registers)
+    return true;
+  auto op = createWriteOp(i2c, address, static_cast<uint8_t>(reg), name);
+  if (!op.ready())
+    return false;
+  while (reg < num_registers) {
+    size_t end = reg;
+    while (end < num_registers && selected(values, restore, end, starting))
+      end++;
+    op.Write(&values[reg], end - reg);
+    reg = end;
+    while (reg < num_registers && !selected(values, restore, reg, starting))
+      reg++;
+    if (reg < num_registers)
+      op.RestartReg(static_cast<uint8_t>(reg), Operation::Type::WRITE);
+  }
+  return op.Execute();
+}
+
+}  // namespace
+
+bool readRegisterDump(i2c::Master* i2c,
+                      uint8_t address,
+                      uint8_t* values,
+                      size_t num_registers,
+                      const char* name) {
+  auto op = createReadOp(i2c, address, 0, name);
+  if (!op.ready())
+    return false;
+  if (!op.Read(values, num_registers))
+    return false;
+  return op.Execute();
+}
+
+bool writeRegisterDump(i2c::Master* i2c,
+                       uint8_t address,
+                       const uint8_t* values,
+                       const RegisterRestore* restore,
+                       size_t num_registers,
+                       const char* name) {
+  if (num_registers > kMaxRegisterDumpSize)
+    return false;
+  uint8_t current[kMaxRegisterDumpSize] = {};
+  for (size_t i = 0; i < num_registers; i++) {
+    if (restore[i].preserve) {
+      if (!readRegisterDump(i2c, address, current, num_registers, name))
+        return false;
+      break;
+    }
+  }
+  uint8_t masked[kMaxRegisterDumpSize] = {};
+  for (size_t i = 0; i < num_registers; i++) {
+    masked[i] = static_cast<uint8_t>(
+        (values[i] & restore[i].config & ~restore[i].enable) |
+        (current[i] & restore[i].preserve) | restore[i].flags);
+  }
+  // The counters are stopped while their value registers are written, then
+  // started, loading them.
+  if (!writeRuns(i2c, address, masked, restore, num_registers, false, name))
+    return false;
+  for (size_t i = 0; i < num_registers; i++)
+    masked[i] |= values[i] & restore[i].enable;
+  if (!writeRuns(i2c, address, masked, restore, num_registers, true, name))
+    return false;
+
+  uint8_t actual[kMaxRegisterDumpSize];
+  if (!readRegisterDump(i2c, address, actual, num_registers, name))
+    return false;
+  for (size_t i = 0; i < num_registers; i++) {
+    if (!restore[i].counter &&
+        ((actual[i] ^ values[i]) & restore[i].config)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace rtc
@@ -0,0 +1,55 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_REGISTER_DUMP_H_
+#define RTC_REGISTER_DUMP_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <i2clib/master.h>
+#include <rtclib/register_map.h>
+
+// The drivers' dumpRegisters() and restoreRegisters().
+
+namespace rtc {
+
+/**
+ * The largest register file, the DS1307's with its NVRAM.
+ */
+constexpr size_t kMaxRegisterDumpSize = 64;
+
+/**
+ * Read registers 0 to |num_registers| - 1 of the device at |address| in one
+ * transaction.
+ */
+bool readRegisterDump(i2c::Master* i2c,
+                      uint8_t address,
+                      uint8_t* values,
+                      size_t num_registers,
+                      const char* name);
+
+/**
+ * Write the configuration in |values|, masked by |restore|, in one
+ * transaction which skips the registers not restored, then read it back.
+ * Counters are started by a second transaction, once loaded (see
+ * RegisterRestore::enable). If any bits are preserved, the registers are
+ * first read for their current values.
+ *
+ * @return True if successful, false upon I2C error or if a configuration
+ *         bit read back differently.
+ */
+bool writeRegisterDump(i2c::Master* i2c,
+                       uint8_t address,
+                       const uint8_t* values,
+                       const RegisterRestore* restore,
+                       size_t num_registers,
+                       const char* name);
+
+}  // namespace rtc
+
+#endif  // RTC_REGISTER_DUMP_H_
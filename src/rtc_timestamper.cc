@@ -0,0 +1,66 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/rtc_timestamper.h>
+
+#include <utility>
+
+#include <rtclib/system_clock.h>
+
+namespace rtc {
+
+RtcTimestamper::RtcTimestamper(Reader reader,
+                               SecondsReader seconds_reader,
+                               const Config& config)
+    : reader_(std::move(reader)),
+      seconds_reader_(std::move(seconds_reader)),
+      config_(config) {}
+
+RtcTimestamper::RtcTimestamper(Reader reader, SecondsReader seconds_reader)
+    : RtcTimestamper(std::move(reader), std::move(seconds_reader), Config()) {}
+
+bool RtcTimestamper::read(Reading* reading) {
+  const int64_t before = SystemClock::microsSinceStart();
+  if (!reader_(&reading->time))
+    return false;
+  const int64_t after = SystemClock::microsSinceStart();
+  reading->local_micros = before + (after - before) / 2;
+  reading->uncertainty_micros = (after - before + 1) / 2;
+  return true;
+}
+
+bool RtcTimestamper::waitForRollover(Reading* reading) {
+  uint8_t first;
+  int64_t last_before = SystemClock::microsSinceStart();
+  if (!seconds_reader_(&first))
+    return false;
+  const int64_t deadline = last_before + config_.max_wait;
+
+  uint8_t seconds;
+  int64_t before, after;
+  while (true) {
+    SystemClock::delayMicros(config_.poll_interval);
+    before = SystemClock::microsSinceStart();
+    if (!seconds_reader_(&seconds))
+      return false;
+    after = SystemClock::microsSinceStart();
+    if (seconds != first)
+      break;
+    if (after > deadline)
+      return false;
+    last_before = before;
+  }
+
+  // The full time, which should still be in the new second.
+  if (!reader_(&reading->time) || reading->time.second() != seconds)
+    return false;
+  reading->local_micros = last_before + (after - last_before) / 2;
+  reading->uncertainty_micros = (after - last_before + 1) / 2;
+  return true;
+}
+
+}  // namespace rtc
@@ -17,3 +17,43 @@ uint8_t bcd2bin(uint8_t val) {
 uint8_t bin2bcd(uint8_t val) {
   return val + 6 * (val / 10);
 }
+
+int64_t mulQ32(int64_t value, uint64_t q32) {
+  if (value < 0)
+    return -mulQ32(-value, q32);
+  const uint64_t v = static_cast<uint64_t>(value);
+  const uint64_t v_hi = v >> 32;
+  const uint64_t v_lo = v & 0xFFFFFFFF;
+  const uint64_t q_int = q32 >> 32;
+  const uint64_t q_frac = q32 & 0xFFFFFFFF;
+  return static_cast<int64_t>(v * q_int + v_hi * q_frac +
+                              ((v_lo * q_frac) >> 32));
+}
+
+int64_t div1000(int64_t value) {
+  // The magnitude, in unsigned arithmetic so that INT64_MIN is valid.
+  const uint64_t v = value < 0 ? 0 - static_cast<uint64_t>(value)
+                               : static_cast<uint64_t>(value);
+  // Multiply by floor(2^64 / 1000), keeping the high 64 bits of the
+  // product. The reciprocal is 0.616 / 2^64 short, and the product is
+  // exact, so the quotient is at most one too small.
+  constexpr uint64_t kReciprocal = 18446744073709551ULL;
+  const uint64_t v_hi = v >> 32;
+  const uint64_t v_lo = v & 0xFFFFFFFF;
+  const uint64_t r_hi = kReciprocal >> 32;
+  const uint64_t r_lo = kReciprocal & 0xFFFFFFFF;
+  const uint64_t mid = v_hi * r_lo + ((v_lo * r_lo) >> 32);
+  const uint64_t mid2 = v_lo * r_hi + (mid & 0xFFFFFFFF);
+  uint64_t q = v_hi * r_hi + (mid >> 32) + (mid2 >> 32);
+  if (v - q * 1000 >= 1000)
+    q++;
+  // At most 2^63 / 1000, so this can't overflow.
+  return value < 0 ? -static_cast<int64_t>(q) : static_cast<int64_t>(q);
+}
+
+uint8_t crc8(uint8_t crc, uint8_t byte) {
+  crc ^= byte;
+  for (int bit = 0; bit < 8; bit++)
+    crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : crc << 1;
+  return crc;
+}
@@ -40,4 +40,35 @@ uint8_t bcd2bin(uint8_t val);
 /**************************************************************************/
 uint8_t bin2bcd(uint8_t val);
 
+/**************************************************************************/
+/*!
+    @brief  Multiply a value by a 32.32 fixed-point factor without
+            overflowing the intermediate product.
+    @param value Value to scale.
+    @param q32 Factor, in 32.32 fixed-point.
+    @return value * q32 / 2^32, truncated towards zero.
+*/
+/**************************************************************************/
+int64_t mulQ32(int64_t value, uint64_t q32);
+
+/**************************************************************************/
+/*!
+    @brief  Divide by 1000 without a 64-bit division, which is a slow
+            library call on 32-bit targets.
+    @param value Value to divide.
+    @return value / 1000, truncated towards zero.
+*/
+/**************************************************************************/
+int64_t div1000(int64_t value);
+
+/**************************************************************************/
+/*!
+    @brief  Update a CRC-8 (polynomial 0x07) with one byte.
+    @param crc The CRC so far. Start with 0xFF.
+    @param byte The next byte.
+    @return The updated CRC.
+*/
+/**************************************************************************/
+uint8_t crc8(uint8_t crc, uint8_t byte);
+
 #endif  // #define RTC_UTIL_H_
\ No newline at end of file
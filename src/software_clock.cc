@@ -0,0 +1,66 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/software_clock.h>
+
+#include <rtclib/system_clock.h>
+#include <rtclib/tick_source.h>
+#include "rtc_util.h"
+
+namespace rtc {
+
+namespace {
+
+constexpr uint64_t kUnityRate = 1ULL << 32;
+constexpr int64_t kPpbPerUnit = 1000000000;
+
+}  // namespace
+
+int64_t SoftwareClock::ticks() const {
+  // The system clock is called directly to avoid a virtual call in the
+  // common case.
+  return ticks_ ? ticks_->micros() : SystemClock::microsSinceStart();
+}
+
+void SoftwareClock::adjust(const DateTime& dt) {
+  adjustMicros(static_cast<int64_t>(dt.unixtime()) * 1000000);
+}
+
+void SoftwareClock::adjustMicros(int64_t unix_micros) {
+  anchor_ticks_ = ticks();
+  anchor_micros_ = unix_micros;
+}
+
+void SoftwareClock::adjustDriftPpb(int32_t ppb) {
+  // Re-anchor at the current time so the new rate only applies from now on.
+  const int64_t tick_micros = ticks();
+  anchor_micros_ += mulQ32(tick_micros - anchor_ticks_, rate_);
+  anchor_ticks_ = tick_micros;
+
+  const int64_t scaled =
+      static_cast<int64_t>(ppb) * static_cast<int64_t>(kUnityRate);
+  const int64_t half = ppb < 0 ? -kPpbPerUnit / 2 : kPpbPerUnit / 2;
+  rate_ = kUnityRate + static_cast<uint64_t>((scaled + half) / kPpbPerUnit);
+}
+
+int32_t SoftwareClock::driftPpb() const {
+  const int64_t delta = static_cast<int64_t>(rate_ - kUnityRate);
+  const int64_t scaled = delta * kPpbPerUnit;
+  const int64_t half = static_cast<int64_t>(kUnityRate / 2);
+  return static_cast<int32_t>((scaled + (delta < 0 ? -half : half)) /
+                              static_cast<int64_t>(kUnityRate));
+}
+
+int64_t SoftwareClock::nowMicros() const {
+  return anchor_micros_ + mulQ32(ticks() - anchor_ticks_, rate_);
+}
+
+DateTime SoftwareClock::now() const {
+  return DateTime(static_cast<uint32_t>(nowMicros() / 1000000));
+}
+
+}  // namespace rtc
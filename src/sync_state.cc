@@ -0,0 +1,72 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/sync_state.h>
+
+#include <rtclib/byte_storage.h>
+#include "rtc_util.h"
+
+namespace rtc {
+
+namespace {
+
+constexpr uint8_t kMagic = 0x5C;
+
+void writeU32(uint32_t value, uint8_t* bytes) {
+  for (int i = 0; i < 4; i++)
+    bytes[i] = (value >> (8 * i)) & 0xFF;
+}
+
+uint32_t readU32(const uint8_t* bytes) {
+  return bytes[0] | bytes[1] << 8 | bytes[2] << 16 |
+         static_cast<uint32_t>(bytes[3]) << 24;
+}
+
+uint8_t checksum(const uint8_t* bytes) {
+  uint8_t crc = 0xFF;
+  for (size_t i = 0; i < SyncStateStore::kSize - 1; i++)
+    crc = crc8(crc, bytes[i]);
+  return crc;
+}
+
+}  // namespace
+
+SyncStateStore::SyncStateStore(ByteStorage* storage, uint16_t address)
+    : storage_(storage), address_(address) {}
+
+void SyncStateStore::encode(const SyncState& state, uint8_t* bytes) {
+  bytes[0] = kMagic;
+  writeU32(state.last_sync, &bytes[1]);
+  writeU32(static_cast<uint32_t>(state.drift_ppb), &bytes[5]);
+  bytes[9] = static_cast<uint8_t>(state.calibration);
+  bytes[10] = 0;
+  bytes[11] = checksum(bytes);
+}
+
+bool SyncStateStore::decode(const uint8_t* bytes, SyncState* state) {
+  if (bytes[0] != kMagic || bytes[kSize - 1] != checksum(bytes))
+    return false;
+  state->last_sync = readU32(&bytes[1]);
+  state->drift_ppb = static_cast<int32_t>(readU32(&bytes[5]));
+  state->calibration = static_cast<int8_t>(bytes[9]);
+  return true;
+}
+
+bool SyncStateStore::load(SyncState* state) {
+  uint8_t bytes[kSize];
+  if (!storage_->read(address_, bytes, sizeof(bytes)))
+    return false;
+  return decode(bytes, state);
+}
+
+bool SyncStateStore::save(const SyncState& state) {
+  uint8_t bytes[kSize];
+  encode(state, bytes);
+  return storage_->write(address_, bytes, sizeof(bytes));
+}
+
+}  // namespace rtc
@@ -12,16 +12,260 @@
 
 #include <cstdint>
 
+#include "rtc_util.h"
+
+// Default backend when none is selected.
+#if !defined(RTC_SYSTEM_CLOCK_ESP_TIMER) && \
+    !defined(RTC_SYSTEM_CLOCK_POSIX) && !defined(RTC_SYSTEM_CLOCK_TSC) && \
+    !defined(RTC_SYSTEM_CLOCK_MANUAL)
+#if defined(ESP_PLATFORM)
+#define RTC_SYSTEM_CLOCK_ESP_TIMER
+#else
+#define RTC_SYSTEM_CLOCK_POSIX
+#endif
+#endif
+
+#if defined(RTC_SYSTEM_CLOCK_ESP_TIMER) + defined(RTC_SYSTEM_CLOCK_POSIX) + \
+        defined(RTC_SYSTEM_CLOCK_TSC) + defined(RTC_SYSTEM_CLOCK_MANUAL) != \
+    1
+#error "Select exactly one RTC_SYSTEM_CLOCK_* backend."
+#endif
+
+#if defined(RTC_SYSTEM_CLOCK_TSC) && \
+    !(defined(__linux__) && defined(__x86_64__))
+#error "RTC_SYSTEM_CLOCK_TSC is only supported on x86-64 Linux."
+#endif
+
+#if defined(RTC_SYSTEM_CLOCK_ESP_TIMER)
 #include <esp_timer.h>
+#include <unistd.h>
+#elif defined(RTC_SYSTEM_CLOCK_POSIX) || defined(RTC_SYSTEM_CLOCK_TSC)
+#include <time.h>
+#endif
+
+#if defined(RTC_SYSTEM_CLOCK_TSC)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
 
 namespace rtc {
 
+#if defined(RTC_SYSTEM_CLOCK_ESP_TIMER)
+
 int64_t SystemClock::microsSinceStart() {
   return esp_timer_get_time();
 }
 
 int64_t SystemClock::millisSinceStart() {
-  return microsSinceStart() / 1000;
+  return div1000(esp_timer_get_time());
+}
+
+void SystemClock::delayMicros(int64_t micros) {
+  // Yields to other tasks for a tick or more, else busy-waits.
+  if (micros > 0)
+    usleep(static_cast<useconds_t>(micros));
+}
+
+#elif defined(RTC_SYSTEM_CLOCK_POSIX) || defined(RTC_SYSTEM_CLOCK_TSC)
+
+namespace {
+
+#if defined(CLOCK_MONOTONIC_RAW)
+// Not slewed by NTP, so the raw drift of the hardware clock can be
+// compensated by the software clocks.
+constexpr clockid_t kClockId = CLOCK_MONOTONIC_RAW;
+#else
+constexpr clockid_t kClockId = CLOCK_MONOTONIC;
+#endif
+
+int64_t posixMicros() {
+  struct timespec ts;
+  clock_gettime(kClockId, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+#if defined(RTC_SYSTEM_CLOCK_POSIX)
+
+int64_t posixMillis() {
+  struct timespec ts;
+  clock_gettime(kClockId, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+#else  // RTC_SYSTEM_CLOCK_TSC
+
+/**
+ * Fixed-point shift of the TSC scale factors. Large enough for a precision
+ * better than 1 ppb in milliseconds per tick with a 4 GHz TSC.
+ */
+constexpr int kTscShift = 52;
+
+/**
+ * Duration of the TSC calibration against the POSIX clock (nanoseconds).
+ */
+constexpr int64_t kTscCalibrationNanos = 20000000;
+
+int64_t posixNanos() {
+  struct timespec ts;
+  clock_gettime(kClockId, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
 }
 
+/**
+ * Read the TSC together with the POSIX time (nanoseconds) at which it was
+ * read, taken as the midpoint of POSIX reads either side.
+ */
+uint64_t readTsc(int64_t* nanos) {
+  const int64_t before = posixNanos();
+  const uint64_t tsc = __rdtsc();
+  const int64_t after = posixNanos();
+  *nanos = before + (after - before) / 2;
+  return tsc;
+}
+
+/**
+ * Conversion from TSC ticks, calibrated against the POSIX clock once, on
+ * first use.
+ */
+class Tsc {
+ public:
+  Tsc() {
+    // Without an invariant TSC the tick rate changes with the CPU
+    // frequency, so fall back to the POSIX clock.
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) ||
+        !(edx & (1 << 8))) {
+      return;
+    }
+
+    // Measure the TSC frequency, and align the TSC with the POSIX clock.
+    int64_t posix_start;
+    int64_t posix_end;
+    readTsc(&posix_start);  // Warm up.
+    const uint64_t tsc_start = readTsc(&posix_start);
+    uint64_t tsc_end;
+    do {
+      tsc_end = readTsc(&posix_end);
+    } while (posix_end - posix_start < kTscCalibrationNanos);
+
+    const double ticks_per_nano =
+        static_cast<double>(tsc_end - tsc_start) / (posix_end - posix_start);
+    micros_scale_ =
+        static_cast<uint64_t>((1ULL << kTscShift) / (ticks_per_nano * 1e3));
+    millis_scale_ =
+        static_cast<uint64_t>((1ULL << kTscShift) / (ticks_per_nano * 1e6));
+    // Base each count on the preceding whole unit, so that both truncate
+    // like the POSIX clock and millis agrees with micros / 1000.
+    micros_base_ = posix_end / 1000;
+    micros_tsc_base_ =
+        tsc_end - static_cast<uint64_t>((posix_end % 1000) * ticks_per_nano);
+    millis_base_ = posix_end / 1000000;
+    millis_tsc_base_ = tsc_end - static_cast<uint64_t>((posix_end % 1000000) *
+                                                       ticks_per_nano);
+    calibrated_ = true;
+  }
+
+  int64_t micros() const {
+    if (!calibrated_)
+      return posixMicros();
+    return micros_base_ + scale(micros_tsc_base_, micros_scale_);
+  }
+
+  int64_t millis() const {
+    if (!calibrated_)
+      return div1000(posixMicros());
+    return millis_base_ + scale(millis_tsc_base_, millis_scale_);
+  }
+
+ private:
+  static int64_t scale(uint64_t tsc_base, uint64_t factor) {
+    const unsigned __int128 ticks = __rdtsc() - tsc_base;
+    return static_cast<int64_t>((ticks * factor) >> kTscShift);
+  }
+
+  bool calibrated_ = false;
+  uint64_t micros_scale_ = 0;  // Microseconds per tick << kTscShift.
+  uint64_t millis_scale_ = 0;  // Milliseconds per tick << kTscShift.
+  uint64_t micros_tsc_base_ = 0;  // TSC at micros_base_.
+  int64_t micros_base_ = 0;
+  uint64_t millis_tsc_base_ = 0;  // TSC at millis_base_.
+  int64_t millis_base_ = 0;
+};
+
+const Tsc& tsc() {
+  static const Tsc tsc;
+  return tsc;
+}
+
+#endif  // defined(RTC_SYSTEM_CLOCK_POSIX)
+
+}  // namespace
+
+int64_t SystemClock::microsSinceStart() {
+#if defined(RTC_SYSTEM_CLOCK_POSIX)
+  return posixMicros();
+#else
+  return tsc().micros();
+#endif
+}
+
+int64_t SystemClock::millisSinceStart() {
+#if defined(RTC_SYSTEM_CLOCK_POSIX)
+  return posixMillis();
+#else
+  return tsc().millis();
+#endif
+}
+
+void SystemClock::delayMicros(int64_t micros) {
+  if (micros <= 0)
+    return;
+  struct timespec ts;
+  ts.tv_sec = micros / 1000000;
+  ts.tv_nsec = (micros % 1000000) * 1000;
+  while (nanosleep(&ts, &ts))
+    ;
+}
+
+#elif defined(RTC_SYSTEM_CLOCK_MANUAL)
+
+namespace {
+int64_t g_manual_micros = 0;
+void (*g_delay_handler)(int64_t micros, void* arg) = nullptr;
+void* g_delay_arg = nullptr;
+}  // namespace
+
+int64_t SystemClock::microsSinceStart() {
+  return g_manual_micros;
+}
+
+int64_t SystemClock::millisSinceStart() {
+  return div1000(g_manual_micros);
+}
+
+void SystemClock::setMicrosSinceStart(int64_t micros) {
+  g_manual_micros = micros;
+}
+
+void SystemClock::advanceMicros(int64_t micros) {
+  g_manual_micros += micros;
+}
+
+void SystemClock::setDelayHandler(void (*handler)(int64_t micros, void* arg),
+                                  void* arg) {
+  g_delay_handler = handler;
+  g_delay_arg = arg;
+}
+
+void SystemClock::delayMicros(int64_t micros) {
+  if (micros <= 0)
+    return;
+  if (g_delay_handler)
+    g_delay_handler(micros, g_delay_arg);
+  else
+    g_manual_micros += micros;
+}
+
+#endif
+
 }  // namespace rtc
@@ -0,0 +1,230 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/temperature_compensator.h>
+
+#include <cmath>
+#include <limits>
+
+#include <rtclib/clock_discipline.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/software_clock.h>
+#include <rtclib/trace.h>
+
+namespace rtc {
+
+namespace {
+
+/**
+ * The temperature about which the model is fitted. Tuning fork crystals
+ * have their turnover point close to this.
+ */
+constexpr float kTurnoverCelsius = 25.0f;
+
+/**
+ * Minimum variance (°C^2) of the sample temperatures for a linear fit.
+ */
+constexpr double kMinLinearVariance = 1.0;
+
+/**
+ * Minimum variance (°C^2) of the sample temperatures for a quadratic fit.
+ */
+constexpr double kMinQuadraticVariance = 4.0;
+
+/**
+ * The determinant of the 3x3 matrix [a b c; d e f; g h i].
+ */
+double det3(double a,
+            double b,
+            double c,
+            double d,
+            double e,
+            double f,
+            double g,
+            double h,
+            double i) {
+  return a * (e * i - f * h) - b * (d * i - f * g) + c * (d * h - e * g);
+}
+
+}  // namespace
+
+TemperatureDriftModel::TemperatureDriftModel(float forgetting)
+    : forgetting_(forgetting) {
+  reset();
+}
+
+void TemperatureDriftModel::reset() {
+  for (double& sum : sum_x_)
+    sum = 0;
+  for (double& sum : sum_xy_)
+    sum = 0;
+  for (float& c : coefficients_)
+    c = 0;
+  num_samples_ = 0;
+}
+
+void TemperatureDriftModel::addSample(float temperature, float ppm) {
+  const double x = temperature - kTurnoverCelsius;
+  double xk = 1;
+  for (int k = 0; k < 5; k++) {
+    sum_x_[k] = sum_x_[k] * forgetting_ + xk;
+    if (k < 3)
+      sum_xy_[k] = sum_xy_[k] * forgetting_ + xk * ppm;
+    xk *= x;
+  }
+  num_samples_++;
+  fit();
+}
+
+void TemperatureDriftModel::fit() {
+  const double* s = sum_x_;
+  const double* y = sum_xy_;
+  const double mean = s[1] / s[0];
+  const double variance = s[2] / s[0] - mean * mean;
+
+  coefficients_[1] = 0;
+  coefficients_[2] = 0;
+
+  if (num_samples_ >= 3 && variance >= kMinQuadraticVariance) {
+    // Solve the 3x3 normal equations with Cramer's rule.
+    const double det =
+        det3(s[0], s[1], s[2], s[1], s[2], s[3], s[2], s[3], s[4]);
+    if (std::fabs(det) > 1e-9 * s[0] * s[2] * s[4]) {
+      coefficients_[0] = static_cast<float>(
+          det3(y[0], s[1], s[2], y[1], s[2], s[3], y[2], s[3], s[4]) / det);
+      coefficients_[1] = static_cast<float>(
+          det3(s[0], y[0], s[2], s[1], y[1], s[3], s[2], y[2], s[4]) / det);
+      coefficients_[2] = static_cast<float>(
+          det3(s[0], s[1], y[0], s[1], s[2], y[1], s[2], s[3], y[2]) / det);
+      return;
+    }
+  }
+
+  if (num_samples_ >= 2 && variance >= kMinLinearVariance) {
+    const double det = s[0] * s[2] - s[1] * s[1];
+    coefficients_[0] = static_cast<float>((y[0] * s[2] - s[1] * y[1]) / det);
+    coefficients_[1] = static_cast<float>((s[0] * y[1] - s[1] * y[0]) / det);
+    return;
+  }
+
+  coefficients_[0] = static_cast<float>(y[0] / s[0]);
+}
+
+float TemperatureDriftModel::ppmAt(float temperature) const {
+  const float x = temperature - kTurnoverCelsius;
+  return coefficients_[0] + x * (coefficients_[1] + x * coefficients_[2]);
+}
+
+TemperatureCompensator::TemperatureCompensator(DS3231* rtc,
+                                               SoftwareClock* clock,
+                                               const Config& config)
+    : rtc_(rtc),
+      clock_(clock),
+      discipline_(nullptr),
+      config_(config),
+      model_(config.forgetting) {}
+
+TemperatureCompensator::TemperatureCompensator(DS3231* rtc,
+                                               SoftwareClock* clock)
+    : TemperatureCompensator(rtc, clock, Config()) {}
+
+TemperatureCompensator::TemperatureCompensator(DS3231* rtc,
+                                               ClockDiscipline* discipline,
+                                               const Config& config)
+    : rtc_(rtc),
+      clock_(discipline->clock()),
+      discipline_(discipline),
+      config_(config),
+      model_(config.forgetting) {}
+
+TemperatureCompensator::TemperatureCompensator(DS3231* rtc,
+                                               ClockDiscipline* discipline)
+    : TemperatureCompensator(rtc, discipline, Config()) {}
+
+bool TemperatureCompensator::readTemperature() {
+  const float temperature = rtc_->getTemperature();
+  if (temperature == std::numeric_limits<int16_t>::max())
+    return false;
+  temperature_ = temperature;
+  last_read_ = clock_->ticks();
+  temperature_sum_ += temperature;
+  temperature_count_++;
+  if (temperature < temperature_min_)
+    temperature_min_ = temperature;
+  if (temperature > temperature_max_)
+    temperature_max_ = temperature;
+  return true;
+}
+
+void TemperatureCompensator::startInterval(int64_t reference_micros) {
+  reference_start_ = reference_micros;
+  local_start_ = clock_->ticks();
+  temperature_sum_ = temperature_;
+  temperature_count_ = 1;
+  temperature_min_ = temperature_;
+  temperature_max_ = temperature_;
+}
+
+void TemperatureCompensator::retune() {
+  if (!model_.numSamples())
+    return;
+  // A fast timer needs a negative (slowing) adjustment.
+  const int32_t ppb =
+      -static_cast<int32_t>(std::lround(model_.ppmAt(temperature_) * 1000));
+  if (ppb == applied_ppb_)
+    return;
+  if (discipline_)
+    discipline_->setFeedForwardPpb(ppb);
+  else
+    clock_->adjustDriftPpb(ppb);
+  applied_ppb_ = ppb;
+}
+
+bool TemperatureCompensator::begin(int64_t reference_micros) {
+  if (!readTemperature())
+    return false;
+  startInterval(reference_micros);
+  return true;
+}
+
+bool TemperatureCompensator::update() {
+  TraceScope trace("calibration", "TemperatureCompensator::update");
+  if (clock_->ticks() - last_read_ >= config_.temperature_interval) {
+    if (!readTemperature())
+      return false;
+  }
+  retune();
+  return true;
+}
+
+bool TemperatureCompensator::sync(int64_t reference_micros) {
+  TraceScope trace("calibration", "TemperatureCompensator::sync");
+  const int64_t local_elapsed = clock_->ticks() - local_start_;
+  if (!readTemperature())
+    return false;
+
+  if (temperature_max_ - temperature_min_ > config_.max_temperature_spread) {
+    // The drift over this interval doesn't correspond to one temperature.
+    startInterval(reference_micros);
+    return true;
+  }
+
+  const int64_t reference_elapsed = reference_micros - reference_start_;
+  if (reference_elapsed < config_.min_sync_interval)
+    return true;
+
+  const double ppm =
+      static_cast<double>(local_elapsed - reference_elapsed) * 1e6 /
+      reference_elapsed;
+  model_.addSample(temperature_sum_ / temperature_count_,
+                   static_cast<float>(ppm));
+  retune();
+  startInterval(reference_micros);
+  return true;
+}
+
+}  // namespace rtc
@@ -0,0 +1,148 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/trace.h>
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+
+#include <rtclib/system_clock.h>
+
+namespace rtc {
+
+constexpr size_t Trace::kCapacity;
+constexpr int32_t Trace::kNoArg;
+
+#if defined(RTC_TRACING)
+
+namespace {
+
+// Each slot is guarded by its sequence number: the event's index plus one
+// once written, and zero while being written. A reader copies the event
+// and keeps it only if the sequence number was the expected one both
+// before and after the copy.
+struct Slot {
+  std::atomic<uint32_t> sequence{0};
+  TraceEvent event;
+};
+
+Slot g_slots[Trace::kCapacity];
+std::atomic<uint32_t> g_next{0};     // Index of the next event.
+std::atomic<uint32_t> g_threads{0};  // Thread IDs handed out.
+
+uint32_t threadId() {
+  thread_local uint32_t id = g_threads.fetch_add(1) + 1;
+  return id;
+}
+
+void record(const char* category,
+            const char* name,
+            int32_t arg,
+            TraceEvent::Phase phase) {
+  const int64_t micros = SystemClock::microsSinceStart();
+  const uint32_t index = g_next.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = g_slots[index & (Trace::kCapacity - 1)];
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.event = {category, name, micros, threadId(), arg, phase};
+  slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+}  // namespace
+
+// static
+void Trace::begin(const char* category, const char* name, int32_t arg) {
+  record(category, name, arg, TraceEvent::Phase::Begin);
+}
+
+// static
+void Trace::end(const char* category, const char* name) {
+  record(category, name, kNoArg, TraceEvent::Phase::End);
+}
+
+// static
+size_t Trace::snapshot(TraceEvent* events, size_t max_events) {
+  const uint32_t next = g_next.load(std::memory_order_acquire);
+  const uint32_t recorded = next < kCapacity ? next : kCapacity;
+  size_t count = 0;
+  for (uint32_t index = next - recorded; index != next; index++) {
+    if (count == max_events)
+      break;
+    const Slot& slot = g_slots[index & (kCapacity - 1)];
+    const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != index + 1)
+      continue;
+    events[count] = slot.event;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+      continue;
+    count++;
+  }
+  return count;
+}
+
+// static
+void Trace::clear() {
+  for (Slot& slot : g_slots)
+    slot.sequence.store(0, std::memory_order_relaxed);
+  g_next.store(0, std::memory_order_release);
+}
+
+#endif  // defined(RTC_TRACING)
+
+namespace {
+
+void appendString(const char* str, std::string* json) {
+  json->push_back('"');
+  for (; *str; str++) {
+    const char c = *str;
+    if (c == '"' || c == '\\') {
+      json->push_back('\\');
+      json->push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      json->append(escaped);
+    } else {
+      json->push_back(c);
+    }
+  }
+  json->push_back('"');
+}
+
+}  // namespace
+
+// static
+std::string Trace::toChromeJson(const TraceEvent* events, size_t count) {
+  std::string json = "{\"traceEvents\":[";
+  for (size_t i = 0; i < count; i++) {
+    const TraceEvent& event = events[i];
+    if (i)
+      json.push_back(',');
+    json.append("\n{\"name\":");
+    appendString(event.name, &json);
+    json.append(",\"cat\":");
+    appendString(event.category, &json);
+    char fields[96];
+    snprintf(fields, sizeof(fields),
+             ",\"ph\":\"%c\",\"ts\":%" PRId64 ",\"pid\":1,\"tid\":%" PRIu32,
+             event.phase == TraceEvent::Phase::Begin ? 'B' : 'E',
+             event.micros, event.thread);
+    json.append(fields);
+    if (event.arg != kNoArg) {
+      snprintf(fields, sizeof(fields), ",\"args\":{\"arg\":%" PRId32 "}",
+               event.arg);
+      json.append(fields);
+    }
+    json.push_back('}');
+  }
+  json.append("\n],\"displayTimeUnit\":\"ms\"}\n");
+  return json;
+}
+
+}  // namespace rtc
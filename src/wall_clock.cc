@@ -0,0 +1,87 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <rtclib/wall_clock.h>
+
+#include <cstdlib>
+
+#include <rtclib/system_clock.h>
+#include <rtclib/trace.h>
+
+namespace rtc {
+
+WallClock::WallClock(const Config& config) : config_(config) {}
+
+WallClock::WallClock() : WallClock(Config()) {}
+
+// static
+int64_t WallClock::monotonicMicros() {
+  return SystemClock::microsSinceStart();
+}
+
+int64_t WallClock::slewedAt(int64_t monotonic) const {
+  const int64_t max =
+      (monotonic - slew_start_) * config_.max_slew_ppm / 1000000;
+  if (std::llabs(slew_) <= max)
+    return slew_;
+  return slew_ < 0 ? -max : max;
+}
+
+int64_t WallClock::offsetAt(int64_t monotonic) const {
+  return offset_ + slewedAt(monotonic);
+}
+
+void WallClock::step(int64_t unix_micros) {
+  const int64_t monotonic = monotonicMicros();
+  offset_ = unix_micros - monotonic;
+  slew_ = 0;
+  slew_start_ = monotonic;
+  set_ = true;
+  steps_++;
+}
+
+void WallClock::adjust(const DateTime& dt) {
+  // The time is anywhere within the second: on average, in the middle.
+  correct(static_cast<int64_t>(dt.unixtime()) * 1000000 + 500000, 500000);
+}
+
+void WallClock::adjustMicros(int64_t unix_micros) {
+  correct(unix_micros, 0);
+}
+
+void WallClock::correct(int64_t unix_micros, int64_t resolution) {
+  TraceScope trace("clock", "WallClock::adjust");
+  const int64_t monotonic = monotonicMicros();
+  const int64_t current = offsetAt(monotonic);
+  const int64_t correction = unix_micros - monotonic - current;
+  if (!set_ ||
+      std::llabs(correction) > config_.step_threshold + resolution) {
+    step(unix_micros);
+    return;
+  }
+  // Fold the progress of the previous slew into the offset, and replace
+  // the remainder with the new correction: none if the wall time is
+  // already within the resolution.
+  offset_ = current;
+  slew_ = std::llabs(correction) <= resolution ? 0 : correction;
+  slew_start_ = monotonic;
+}
+
+int64_t WallClock::nowMicros() const {
+  const int64_t monotonic = monotonicMicros();
+  return monotonic + offsetAt(monotonic);
+}
+
+DateTime WallClock::now() const {
+  return DateTime(static_cast<uint32_t>(nowMicros() / 1000000));
+}
+
+int64_t WallClock::remainingSlew() const {
+  return slew_ - slewedAt(monotonicMicros());
+}
+
+}  // namespace rtc
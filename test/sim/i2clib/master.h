@@ -0,0 +1,75 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_SIM_I2CLIB_MASTER_H_
+#define RTC_SIM_I2CLIB_MASTER_H_
+
+#include <cstdint>
+
+#include "i2clib/operation.h"
+#include "sim_bus.h"
+
+namespace i2c {
+
+/**
+ * Host stand-in for i2clib's Master.
+ *
+ * Only built for the native (Linux) test environment. Provides the subset
+ * of the i2clib API used by RTClib, routing all traffic to the simulated
+ * devices attached to rtc::sim::Bus::get(port).
+ */
+class Master {
+ public:
+  struct InitParams {
+    int i2c_bus;
+    int sda_gpio;
+    int scl_gpio;
+    uint32_t clk_speed;
+    bool sda_pullup_enable;
+    bool scl_pullup_enable;
+  };
+
+  static bool Initialize(const InitParams& params) { return true; }
+  static void Shutdown(int i2c_bus) {}
+
+  Master(int i2c_bus, void* i2c_mutex) : port_(i2c_bus) {}
+  Master(Master&&) = default;
+  Master& operator=(Master&&) = default;
+
+  bool Ping(uint8_t slave_addr) {
+    auto& bus = rtc::sim::Bus::get(port_);
+    bus.countTransaction();
+    return !bus.stuck() && bus.find(slave_addr) != nullptr;
+  }
+
+  bool WriteRegister(uint8_t slave_addr, uint8_t reg, uint8_t val) {
+    Operation op = CreateWriteOp(slave_addr, reg, "WriteRegister");
+    op.WriteByte(val);
+    return op.Execute();
+  }
+
+  bool ReadRegister(uint8_t slave_addr, uint8_t reg, uint8_t* val) {
+    Operation op = CreateReadOp(slave_addr, reg, "ReadRegister");
+    op.Read(val, sizeof(*val));
+    return op.Execute();
+  }
+
+  Operation CreateWriteOp(uint8_t slave_addr, uint8_t reg, const char* name) {
+    return Operation(port_, slave_addr, reg, Operation::Type::WRITE);
+  }
+
+  Operation CreateReadOp(uint8_t slave_addr, uint8_t reg, const char* name) {
+    return Operation(port_, slave_addr, reg, Operation::Type::READ);
+  }
+
+ private:
+  int port_;
+};
+
+}  // namespace i2c
+
+#endif  // RTC_SIM_I2CLIB_MASTER_H_
@@ -0,0 +1,154 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_SIM_I2CLIB_OPERATION_H_
+#define RTC_SIM_I2CLIB_OPERATION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <rtclib/system_clock.h>
+#include "sim_bus.h"
+
+namespace i2c {
+
+/**
+ * Host stand-in for i2clib's Operation.
+ *
+ * Reads and writes are queued, exactly as with the real library, and are
+ * performed against the simulated devices on the port's rtc::sim::Bus when
+ * Execute() is called.
+ *
+ * As on the bus, the direction is set by the last (re)start: a read op
+ * sends its register, then restarts in read mode. Writing in read mode, or
+ * reading in write mode, fails the operation.
+ */
+class Operation {
+ public:
+  enum class Type { READ, WRITE };
+
+  Operation() = default;
+  Operation(int port, uint8_t address, uint8_t reg, Type type)
+      : port_(port), address_(address), ready_(true), type_(type) {
+    steps_.push_back({Step::Kind::SET_REG, reg, nullptr, 0, {}});
+  }
+  Operation(Operation&&) = default;
+  Operation& operator=(Operation&&) = default;
+
+  bool ready() const { return ready_; }
+
+  bool Read(void* dst, size_t num_bytes) {
+    if (type_ != Type::READ)
+      ready_ = false;
+    steps_.push_back(
+        {Step::Kind::READ, 0, static_cast<uint8_t*>(dst), num_bytes, {}});
+    return ready_;
+  }
+
+  bool Write(const void* data, size_t num_bytes) {
+    if (type_ != Type::WRITE)
+      ready_ = false;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    steps_.push_back({Step::Kind::WRITE, 0, nullptr, num_bytes,
+                      std::vector<uint8_t>(bytes, bytes + num_bytes)});
+    return ready_;
+  }
+
+  bool WriteByte(uint8_t val) { return Write(&val, sizeof(val)); }
+
+  bool RestartReg(uint8_t reg, Type type) {
+    type_ = type;
+    steps_.push_back({Step::Kind::SET_REG, reg, nullptr, 0, {}});
+    return ready_;
+  }
+
+  /**
+   * Restart in |type| mode without sending a register, e.g. for a device
+   * with a two byte address.
+   */
+  bool Restart(Type type) {
+    type_ = type;
+    steps_.push_back({Step::Kind::RESTART, 0, nullptr, 0, {}});
+    return ready_;
+  }
+
+  bool Execute() {
+    if (!ready_)
+      return false;
+    ready_ = false;
+    rtc::sim::Bus& bus = rtc::sim::Bus::get(port_);
+    bus.countTransaction();
+    if (bus.stuck())
+      return false;
+    rtc::sim::Device* device = bus.find(address_);
+    if (!device || bus.takeFault(address_))
+      return false;
+    device->begin();
+    // Each byte takes effect as it is acknowledged, after its time on the
+    // bus (e.g. a clock chip restarts its second on the seconds byte).
+    rtc::SystemClock::delayMicros(bus.transferMicros(0));
+    uint8_t reg = 0;
+    for (const Step& step : steps_) {
+      // The address, then the register or data.
+      switch (step.kind) {
+        case Step::Kind::SET_REG:
+          transfer(bus, 2);
+          reg = step.reg;
+          break;
+        case Step::Kind::RESTART:
+          transfer(bus, 1);
+          break;
+        case Step::Kind::READ:
+          for (size_t i = 0; i < step.size; i++) {
+            transfer(bus, 1);
+            step.dst[i] = device->read(reg);
+            reg = device->next(reg);
+          }
+          break;
+        case Step::Kind::WRITE:
+          for (uint8_t value : step.bytes) {
+            transfer(bus, 1);
+            device->write(reg, value);
+            reg = device->next(reg);
+          }
+          break;
+      }
+    }
+    device->end();
+    return true;
+  }
+
+ private:
+  /**
+   * Spend the bus time of |num_bytes| bytes.
+   */
+  static void transfer(const rtc::sim::Bus& bus, size_t num_bytes) {
+    rtc::SystemClock::delayMicros(bus.transferMicros(num_bytes) -
+                                  bus.transferMicros(0));
+  }
+
+  struct Step {
+    enum class Kind { SET_REG, RESTART, READ, WRITE };
+    Kind kind;
+    uint8_t reg;
+    uint8_t* dst;
+    size_t size;
+    std::vector<uint8_t> bytes;
+  };
+
+  int port_ = 0;
+  uint8_t address_ = 0;
+  bool ready_ = false;
+  Type type_ = Type::WRITE;
+  std::vector<Step> steps_;
+};
+
+}  // namespace i2c
+
+#endif  // RTC_SIM_I2CLIB_OPERATION_H_
@@ -0,0 +1,135 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_SIM_AT24C32_H_
+#define RTC_SIM_AT24C32_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <i2clib/master.h>
+#include <rtclib/at24c32.h>
+#include <rtclib/system_clock.h>
+#include "sim_bus.h"
+
+namespace rtc {
+namespace sim {
+
+/**
+ * Simulated AT24C32 4 KiB EEPROM.
+ *
+ * The first byte written in a transaction is the high address byte, which
+ * the simulated i2c::Master passes as the register, and the second the low
+ * byte. A read (after a restart) continues from the address pointer.
+ * Further written bytes are latched into the addressed page, the
+ * address wrapping within the page as on the real chip, and programmed on
+ * STOP. The chip then does not acknowledge its address for the write cycle
+ * time, measured by the (manual) SystemClock. Each unacknowledged address
+ * advances the SystemClock by the time taken to send it. Reads are
+ * sequential, wrapping at the end of the memory.
+ */
+class AT24C32 : public Device {
+ public:
+  static constexpr uint8_t kAddress = 0x57;
+  static constexpr size_t kSize = 4096;
+  static constexpr size_t kPageSize = 32;
+
+  // Typical write cycle time, and the time to address the chip at 100 kHz.
+  static constexpr int64_t kWriteCycleMicros = 5000;
+  static constexpr int64_t kAddressMicros = 100;
+
+  AT24C32() : memory_() {}
+
+  void begin() override {
+    address_bytes_ = 0;
+    latched_ = 0;
+  }
+
+  uint8_t read(uint8_t reg) override {
+    const uint8_t value = memory_[pointer_];
+    pointer_ = (pointer_ + 1) % kSize;
+    return value;
+  }
+
+  void write(uint8_t reg, uint8_t value) override {
+    if (address_bytes_ == 0) {
+      // |reg| was the high address byte.
+      pointer_ = ((reg << 8) | value) % kSize;
+      address_bytes_ = 2;
+      return;
+    }
+    const uint16_t page = pointer_ - pointer_ % kPageSize;
+    pending_[latched_ % kPageSize] = {pointer_, value};
+    latched_++;
+    pointer_ = page + (pointer_ + 1) % kPageSize;
+  }
+
+  void end() override {
+    if (!latched_)
+      return;
+    const size_t count = latched_ < kPageSize ? latched_ : kPageSize;
+    for (size_t i = 0; i < count; i++)
+      memory_[pending_[i].address] = pending_[i].value;
+    write_cycles_++;
+    busy_until_ = SystemClock::microsSinceStart() + kWriteCycleMicros;
+  }
+
+  bool acknowledges() const override {
+    if (SystemClock::microsSinceStart() >= busy_until_)
+      return true;
+    SystemClock::advanceMicros(kAddressMicros);
+    return false;
+  }
+
+  /**
+   * Direct (non-bus) access to the memory for test inspection.
+   */
+  uint8_t& byte(uint16_t address) { return memory_[address]; }
+
+  /**
+   * Number of page programming cycles.
+   */
+  uint32_t writeCycles() const { return write_cycles_; }
+
+ private:
+  struct Latched {
+    uint16_t address;
+    uint8_t value;
+  };
+
+  uint8_t memory_[kSize];
+  uint16_t pointer_ = 0;
+  int address_bytes_ = 0;
+  Latched pending_[kPageSize];
+  size_t latched_ = 0;
+  uint32_t write_cycles_ = 0;
+  int64_t busy_until_ = 0;
+};
+
+/**
+ * A simulated AT24C32 on the bus of |port|, and a driver for it.
+ */
+struct AT24C32Fixture {
+  explicit AT24C32Fixture(int port)
+      : chip(port), eeprom(i2c::Master(port, nullptr)), port_(port) {}
+
+  /**
+   * Number of transactions on the bus, for counting round trips.
+   */
+  uint32_t transactions() const { return Bus::get(port_).transactions(); }
+
+  Attached<AT24C32> chip;
+  rtc::AT24C32 eeprom;
+
+ private:
+  const int port_;
+};
+
+}  // namespace sim
+}  // namespace rtc
+
+#endif  // RTC_SIM_AT24C32_H_
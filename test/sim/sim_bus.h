@@ -0,0 +1,228 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_SIM_BUS_H_
+#define RTC_SIM_BUS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+namespace rtc {
+namespace sim {
+
+/**
+ * Convert a binary value to the BCD format used by the RTC registers.
+ */
+inline uint8_t toBcd(uint8_t val) {
+  return val + 6 * (val / 10);
+}
+
+/**
+ * Convert a BCD register value to binary.
+ */
+inline uint8_t fromBcd(uint8_t val) {
+  return val - 6 * (val >> 4);
+}
+
+/**
+ * A simulated I2C slave device.
+ *
+ * The simulated i2c::Master calls begin() on a START condition addressed
+ * to this device, read()/write() for each data byte (advancing the register
+ * pointer with next()), and end() on the STOP condition.
+ */
+class Device {
+ public:
+  virtual ~Device() = default;
+
+  /**
+   * Called when a transaction addressed to this device starts.
+   */
+  virtual void begin() {}
+
+  /**
+   * Read the register at |reg|.
+   */
+  virtual uint8_t read(uint8_t reg) = 0;
+
+  /**
+   * Write |value| to the register at |reg|.
+   */
+  virtual void write(uint8_t reg, uint8_t value) = 0;
+
+  /**
+   * Called when a transaction addressed to this device ends.
+   */
+  virtual void end() {}
+
+  /**
+   * The register address following |reg| (i.e. auto-increment behavior).
+   */
+  virtual uint8_t next(uint8_t reg) const { return reg + 1; }
+
+  /**
+   * Does the device acknowledge its address? False, for example, while the
+   * device is unpowered.
+   */
+  virtual bool acknowledges() const { return true; }
+};
+
+/**
+ * A Device backed by a plain array of |N| registers.
+ *
+ * The register pointer wraps to zero after the last register.
+ */
+template <size_t N>
+class RegisterFile : public Device {
+ public:
+  RegisterFile() : regs_() {}
+
+  uint8_t read(uint8_t reg) override { return reg < N ? regs_[reg] : 0xFF; }
+
+  void write(uint8_t reg, uint8_t value) override {
+    if (reg < N)
+      regs_[reg] = value;
+  }
+
+  uint8_t next(uint8_t reg) const override { return (reg + 1) % N; }
+
+  /**
+   * Direct (non-bus) access to the registers for test inspection.
+   */
+  uint8_t& reg(uint8_t reg) { return regs_[reg]; }
+
+  static constexpr size_t kNumRegisters = N;
+
+ protected:
+  uint8_t regs_[N];
+};
+
+/**
+ * A simulated I2C bus: a collection of devices indexed by slave address.
+ *
+ * There is one bus per I2C port, retrieved with Bus::get(). The simulated
+ * i2c::Master routes all transactions through the bus of its port.
+ */
+class Bus {
+ public:
+  static Bus& get(int port) {
+    static std::map<int, Bus> buses;
+    return buses[port];
+  }
+
+  void attach(uint8_t address, Device* device) { devices_[address] = device; }
+
+  void detach(uint8_t address) { devices_.erase(address); }
+
+  void detachAll() {
+    devices_.clear();
+    transactions_ = 0;
+    faults_.clear();
+    stuck_ = false;
+    transaction_micros_ = 0;
+    byte_micros_ = 0;
+  }
+
+  /**
+   * Make each transaction take |transaction_micros|, plus |byte_micros|
+   * for each byte (address, register and data) on the bus. The time is
+   * spent in SystemClock::delayMicros() (so a Simulator runs for that
+   * long): the transaction's at its start, and each byte's before it takes
+   * effect. Transactions take no time by default.
+   */
+  void setTiming(int64_t transaction_micros, int64_t byte_micros) {
+    transaction_micros_ = transaction_micros;
+    byte_micros_ = byte_micros;
+  }
+
+  /**
+   * The duration of a transaction of |num_bytes|.
+   */
+  int64_t transferMicros(size_t num_bytes) const {
+    return transaction_micros_ +
+           byte_micros_ * static_cast<int64_t>(num_bytes);
+  }
+
+  /**
+   * Fail the next |count| data transactions addressed to |address|, as if
+   * a byte were NACKed because of bus noise. The device still
+   * acknowledges its address, so pings succeed.
+   */
+  void injectFaults(uint8_t address, uint32_t count) {
+    faults_[address] = count;
+  }
+
+  /**
+   * Consume one injected fault for |address|, if any.
+   */
+  bool takeFault(uint8_t address) {
+    auto it = faults_.find(address);
+    if (it == faults_.end() || !it->second)
+      return false;
+    it->second--;
+    return true;
+  }
+
+  /**
+   * Hold SDA low, as a slave interrupted mid-byte does, failing every
+   * transaction until released (e.g. by a bus clear).
+   */
+  void setStuck(bool stuck) { stuck_ = stuck; }
+
+  bool stuck() const { return stuck_; }
+
+  /**
+   * The device acknowledging |address|, or nullptr if none.
+   */
+  Device* find(uint8_t address) const {
+    auto it = devices_.find(address);
+    if (it == devices_.end() || !it->second->acknowledges())
+      return nullptr;
+    return it->second;
+  }
+
+  /**
+   * Number of executed transactions, for tests that count bus round trips.
+   */
+  uint32_t transactions() const { return transactions_; }
+
+  void countTransaction() { transactions_++; }
+
+ private:
+  std::map<uint8_t, Device*> devices_;
+  std::map<uint8_t, uint32_t> faults_;
+  uint32_t transactions_ = 0;
+  bool stuck_ = false;
+  int64_t transaction_micros_ = 0;
+  int64_t byte_micros_ = 0;
+};
+
+/**
+ * A simulated |Chip| attached to the bus of |port|, at its kAddress, for
+ * its lifetime.
+ */
+template <typename Chip>
+class Attached : public Chip {
+ public:
+  explicit Attached(int port) : port_(port) {
+    Bus::get(port_).attach(Chip::kAddress, this);
+  }
+
+  ~Attached() override { Bus::get(port_).detach(Chip::kAddress); }
+
+  Attached(const Attached&) = delete;
+  Attached& operator=(const Attached&) = delete;
+
+ private:
+  const int port_;
+};
+
+}  // namespace sim
+}  // namespace rtc
+
+#endif  // RTC_SIM_BUS_H_
@@ -0,0 +1,372 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_SIM_CLOCK_CHIP_H_
+#define RTC_SIM_CLOCK_CHIP_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include <rtclib/datetime.h>
+#include "sim_bus.h"
+
+namespace rtc {
+namespace sim {
+
+/**
+ * The interface through which the Simulator drives a simulated RTC.
+ */
+class Timekeeper {
+ public:
+  virtual ~Timekeeper() = default;
+
+  /**
+   * Advance simulated time by |micros| microseconds of true time.
+   */
+  virtual void advance(int64_t micros) = 0;
+
+  /**
+   * Microseconds of true time until the chip's next internal event (the
+   * next second, or a timer expiring), or INT64_MAX if the oscillator is
+   * stopped.
+   */
+  virtual int64_t microsToNextEvent() const = 0;
+
+  /**
+   * Is the chip's interrupt output asserted?
+   */
+  virtual bool interrupt() const { return false; }
+
+  /**
+   * Remove the main (VDD) supply. The chip stops responding on the bus, and
+   * keeps time only if it is battery backed.
+   */
+  virtual void powerOff() = 0;
+
+  /**
+   * Restore the main supply. A chip which lost all power comes back in its
+   * power-on reset state.
+   */
+  virtual void powerOn() = 0;
+};
+
+/**
+ * Time keeping shared by all simulated RTC register files.
+ *
+ * Time advances only when advance() is called, at a rate set by the
+ * configured crystal error and the chip's own trimming (see
+ * correctionPpm()). The seven BCD time registers are latched from the
+ * internal time at the start of each transaction, and written back to it
+ * at the end of a transaction which wrote any of them. The second itself
+ * restarts as the seconds register is written.
+ */
+template <size_t N>
+class ClockChip : public RegisterFile<N>, public Timekeeper {
+ public:
+  /**
+   * Set the crystal frequency error. Positive values make the clock fast.
+   */
+  void setCrystalError(double ppm) { crystal_ppm_ = ppm; }
+
+  /**
+   * The chip's effective rate error, after applying the chip's trimming.
+   */
+  double effectivePpm() const { return (rate() - 1.0) * 1e6; }
+
+  void advance(int64_t micros) override {
+    if (!ticking())
+      return;
+    const double seconds = static_cast<double>(micros) * 1e-6 * rate();
+    const double before = oscillator_seconds_;
+    oscillator_seconds_ += seconds;
+    onOscillator(before, oscillator_seconds_);
+    phase_ += seconds;
+    while (phase_ >= 1.0) {
+      phase_ -= 1.0;
+      unix_++;
+      onSecond(DateTime(unix_));
+    }
+  }
+
+  int64_t microsToNextEvent() const override {
+    if (!ticking())
+      return std::numeric_limits<int64_t>::max();
+    const double seconds = std::min(1.0 - phase_, secondsToNextEvent());
+    return static_cast<int64_t>(std::ceil(seconds * 1e6 / rate()));
+  }
+
+  void powerOff() override {
+    powered_ = false;
+    if (!batteryBacked())
+      state_lost_ = true;
+  }
+
+  void powerOn() override {
+    powered_ = true;
+    if (state_lost_)
+      powerOnReset();
+  }
+
+  /**
+   * Insert or remove the backup battery.
+   */
+  void setBattery(bool present) {
+    battery_ = present;
+    if (!powered_ && !batteryBacked())
+      state_lost_ = true;
+  }
+
+  bool acknowledges() const override { return powered_; }
+
+  /**
+   * The chip's current time, bypassing the bus.
+   */
+  DateTime time() const { return DateTime(unix_); }
+
+  /**
+   * Set the chip's current time, bypassing the bus.
+   */
+  void setTime(const DateTime& dt) {
+    unix_ = dt.unixtime();
+    phase_ = 0;
+  }
+
+  /**
+   * Fraction of the current second already elapsed, in [0, 1).
+   */
+  double phase() const { return phase_; }
+
+  void begin() override { latchTime(); }
+
+  void write(uint8_t reg, uint8_t value) override {
+    RegisterFile<N>::write(reg, value);
+    if (reg >= seconds_reg_ && reg < seconds_reg_ + 7)
+      time_written_ = true;
+    // Writing the seconds resets the chip's sub-second divider.
+    if (reg == seconds_reg_)
+      phase_ = 0;
+  }
+
+  void end() override {
+    if (!time_written_)
+      return;
+    time_written_ = false;
+    const uint8_t* t = &this->regs_[seconds_reg_];
+    const uint8_t day = weekday_first_ ? t[4] : t[3];
+    const DateTime dt(2000 + fromBcd(t[6]), fromBcd(t[5] & 0x1F),
+                      fromBcd(day & 0x3F), fromBcd(t[2] & 0x3F),
+                      fromBcd(t[1] & 0x7F), fromBcd(t[0] & 0x7F));
+    unix_ = dt.unixtime();
+    onTimeWritten();
+  }
+
+ protected:
+  /**
+   * @param seconds_reg Address of the seconds register. The minutes, hours,
+   *                    day/weekday, month and year registers follow it.
+   * @param weekday_first True if the weekday register precedes the day of
+   *                      month register.
+   * @param crystal_ppm Initial crystal frequency error.
+   */
+  ClockChip(uint8_t seconds_reg, bool weekday_first, double crystal_ppm)
+      : crystal_ppm_(crystal_ppm),
+        unix_(SECONDS_FROM_1970_TO_2000),
+        seconds_reg_(seconds_reg),
+        weekday_first_(weekday_first) {}
+
+  /**
+   * Is the oscillator running?
+   */
+  virtual bool running() const { return true; }
+
+  /**
+   * Does the chip keep time from the battery while the main supply is
+   * off?
+   */
+  virtual bool batteryBacked() const { return battery_; }
+
+  /**
+   * Rate correction made by the chip's trimming registers, in ppm. Positive
+   * values make the clock slower.
+   */
+  virtual double correctionPpm() const { return 0; }
+
+  /**
+   * Value stored in the weekday register for |dt|.
+   */
+  virtual uint8_t weekday(const DateTime& dt) const {
+    return dt.dayOfTheWeek();
+  }
+
+  /**
+   * Called after the time registers have been written over the bus.
+   */
+  virtual void onTimeWritten() {}
+
+  /**
+   * Called each time the clock reaches a new second |dt|, e.g. to match
+   * alarms.
+   */
+  virtual void onSecond(const DateTime& dt) {}
+
+  /**
+   * Called when the oscillator has run from |from| to |to|, measured in
+   * seconds of the chip's own time since the simulation started. Unlike the
+   * time registers this never jumps, so it drives the chip's prescaler
+   * (e.g. for timers).
+   */
+  virtual void onOscillator(double from, double to) {}
+
+  /**
+   * Seconds of chip time until the next event other than a new second,
+   * e.g. a timer expiring.
+   */
+  virtual double secondsToNextEvent() const {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  /**
+   * The oscillator time, as passed to onOscillator().
+   */
+  double oscillatorSeconds() const { return oscillator_seconds_; }
+
+  /**
+   * Set the registers to their power-on reset values. Called from the
+   * constructor of each chip, and after the chip lost all power.
+   */
+  virtual void resetRegisters() {}
+
+  /**
+   * The main supply is on, as opposed to the chip running from its battery.
+   */
+  bool powered() const { return powered_; }
+
+  bool battery() const { return battery_; }
+
+ private:
+  double rate() const {
+    return (1.0 + crystal_ppm_ * 1e-6) * (1.0 - correctionPpm() * 1e-6);
+  }
+
+  bool ticking() const {
+    return !state_lost_ && (powered_ || batteryBacked()) && running();
+  }
+
+  void powerOnReset() {
+    state_lost_ = false;
+    for (uint8_t& reg : this->regs_)
+      reg = 0;
+    unix_ = SECONDS_FROM_1970_TO_2000;
+    phase_ = 0;
+    resetRegisters();
+  }
+
+  void latchTime() {
+    const DateTime dt(unix_);
+    uint8_t* t = &this->regs_[seconds_reg_];
+    // Preserve the flag (OS, VL, CH) in bit 7 of the seconds register.
+    t[0] = (t[0] & 0x80) | toBcd(dt.second());
+    t[1] = toBcd(dt.minute());
+    t[2] = toBcd(dt.hour());
+    t[weekday_first_ ? 3 : 4] = weekday(dt);
+    t[weekday_first_ ? 4 : 3] = toBcd(dt.day());
+    t[5] = toBcd(dt.month());
+    t[6] = toBcd(dt.year() - 2000);
+  }
+
+  double crystal_ppm_;
+  uint32_t unix_;
+  double phase_ = 0;
+  double oscillator_seconds_ = 0;
+  bool time_written_ = false;
+  bool powered_ = true;
+  bool battery_ = true;
+  bool state_lost_ = false;
+  const uint8_t seconds_reg_;
+  const bool weekday_first_;
+};
+
+/**
+ * Does the alarm register value |reg| match |value|? Bit 7 of an alarm
+ * register disables (masks) the comparison, in which case it always
+ * matches.
+ */
+inline bool alarmFieldMatches(uint8_t reg, uint8_t mask, uint8_t value) {
+  return (reg & 0x80) || fromBcd(reg & mask) == value;
+}
+
+/**
+ * A countdown timer clocked from a chip's free-running prescaler.
+ *
+ * The source clock ticks at multiples of its period of oscillator time, so
+ * the first period of a countdown is shortened by the phase at which it
+ * was started. The timer reloads and repeats when it expires.
+ */
+class CountdownTimer {
+ public:
+  /**
+   * Load and start a countdown.
+   *
+   * @param period Source clock period (seconds).
+   * @param periods Number of periods. Zero does not count.
+   */
+  void start(double period, uint8_t periods) {
+    period_ = period;
+    reload_ = periods;
+    count_ = periods;
+  }
+
+  /**
+   * Is a non-zero countdown loaded?
+   */
+  bool loaded() const { return reload_ != 0; }
+
+  /**
+   * Source clock periods left.
+   */
+  uint8_t count() const { return count_; }
+
+  /**
+   * Count the source clock ticks in (from, to] of oscillator time.
+   *
+   * @return True if the timer expired.
+   */
+  bool advance(double from, double to) {
+    if (!reload_)
+      return false;
+    const int64_t ticks = static_cast<int64_t>(std::floor(to / period_)) -
+                          static_cast<int64_t>(std::floor(from / period_));
+    if (ticks < count_) {
+      count_ -= ticks;
+      return false;
+    }
+    const int64_t after = ticks - count_;
+    count_ = reload_ - after % reload_;
+    return true;
+  }
+
+  /**
+   * Seconds of oscillator time from |now| until the timer expires.
+   */
+  double secondsToExpiry(double now) const {
+    if (!reload_)
+      return std::numeric_limits<double>::infinity();
+    return (std::floor(now / period_) + count_) * period_ - now;
+  }
+
+ private:
+  double period_ = 1;
+  uint8_t reload_ = 0;
+  uint8_t count_ = 0;
+};
+
+}  // namespace sim
+}  // namespace rtc
+
+#endif  // RTC_SIM_CLOCK_CHIP_H_
@@ -0,0 +1,55 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_SIM_DS1307_H_
+#define RTC_SIM_DS1307_H_
+
+#include <cstdint>
+
+#include "sim_clock_chip.h"
+
+namespace rtc {
+namespace sim {
+
+/**
+ * Simulated DS1307 register file: the time keeping registers, the control
+ * register and 56 bytes of battery backed NVRAM (0x08..0x3F).
+ *
+ * The clock halt (CH) bit stops the oscillator. After a power-on reset the
+ * NVRAM, which is random on the real chip, is zeroed.
+ */
+class DS1307 : public ClockChip<0x40> {
+ public:
+  static constexpr uint8_t kAddress = 0x68;
+
+  explicit DS1307(double crystal_ppm = 0)
+      : ClockChip(kSeconds, /*weekday_first=*/true, crystal_ppm) {
+    resetRegisters();
+  }
+
+ protected:
+  bool running() const override { return !(regs_[kSeconds] & 0x80); }
+
+  uint8_t weekday(const DateTime& dt) const override {
+    // The day register is user defined: it simply counts 1..7.
+    return dt.dayOfTheWeek() + 1;
+  }
+
+  void resetRegisters() override {
+    regs_[kSeconds] = 0x80;  // Clock halted.
+    regs_[kControl] = 0x03;  // RS1/RS0 set, square wave off.
+  }
+
+ private:
+  static constexpr uint8_t kSeconds = 0x00;
+  static constexpr uint8_t kControl = 0x07;
+};
+
+}  // namespace sim
+}  // namespace rtc
+
+#endif  // RTC_SIM_DS1307_H_
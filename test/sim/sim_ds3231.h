@@ -0,0 +1,122 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_SIM_DS3231_H_
+#define RTC_SIM_DS3231_H_
+
+#include <cmath>
+#include <cstdint>
+
+#include "sim_clock_chip.h"
+
+namespace rtc {
+namespace sim {
+
+/**
+ * Simulated DS3231 register file.
+ *
+ * The temperature registers report whatever was last set with
+ * setTemperature(), and the aging offset register trims the rate by
+ * roughly 0.1 ppm per LSB. Both alarms are matched each second, in 24 hour
+ * mode only, and drive the INT output when INTCN is set.
+ */
+class DS3231 : public ClockChip<0x13> {
+ public:
+  static constexpr uint8_t kAddress = 0x68;
+
+  explicit DS3231(double crystal_ppm = 0)
+      : ClockChip(kSeconds, /*weekday_first=*/true, crystal_ppm) {
+    resetRegisters();
+  }
+
+  /**
+   * Set the die temperature (°C). Quantized to the chip's 0.25°C resolution.
+   */
+  void setTemperature(float celsius) {
+    temperature_ = celsius;
+    const int quarters = static_cast<int>(std::lround(celsius * 4));
+    regs_[kTempMsb] = static_cast<uint8_t>(quarters >> 2);
+    regs_[kTempLsb] = static_cast<uint8_t>((quarters & 0x3) << 6);
+  }
+
+  void write(uint8_t reg, uint8_t value) override {
+    if (reg == kStatus) {
+      // The alarm flags can only be cleared. OSF takes the value written.
+      value = (regs_[kStatus] & value & kFlags) | (value & ~kFlags);
+    }
+    ClockChip::write(reg, value);
+  }
+
+  bool interrupt() const override {
+    const uint8_t control = regs_[kControl];
+    const uint8_t status = regs_[kStatus];
+    return (control & kIntcn) &&
+           (((control & kA1ie) && (status & kA1f)) ||
+            ((control & kA2ie) && (status & kA2f)));
+  }
+
+ protected:
+  double correctionPpm() const override {
+    return 0.1 * static_cast<int8_t>(regs_[kAgingOffset]);
+  }
+
+  uint8_t weekday(const DateTime& dt) const override {
+    return dt.dayOfTheWeek() == 0 ? 7 : dt.dayOfTheWeek();
+  }
+
+  void onSecond(const DateTime& dt) override {
+    if (alarmMatches(&regs_[kAlarm1], dt) &&
+        alarmFieldMatches(regs_[kAlarm1], 0x7F, dt.second())) {
+      regs_[kStatus] |= kA1f;
+    }
+    if (dt.second() == 0 && alarmMatches(&regs_[kAlarm2 - 1], dt))
+      regs_[kStatus] |= kA2f;
+  }
+
+  void resetRegisters() override {
+    regs_[kControl] = 0x1C;  // INTCN and RS2/RS1 set at power-on.
+    regs_[kStatus] = 0x88;   // OSF and EN32kHz set at power-on.
+    setTemperature(temperature_);
+  }
+
+ private:
+  static constexpr uint8_t kSeconds = 0x00;
+  static constexpr uint8_t kAlarm1 = 0x07;
+  static constexpr uint8_t kAlarm2 = 0x0B;
+  static constexpr uint8_t kControl = 0x0E;
+  static constexpr uint8_t kStatus = 0x0F;
+  static constexpr uint8_t kAgingOffset = 0x10;
+  static constexpr uint8_t kTempMsb = 0x11;
+  static constexpr uint8_t kTempLsb = 0x12;
+
+  static constexpr uint8_t kIntcn = 0x04;
+  static constexpr uint8_t kA2ie = 0x02;
+  static constexpr uint8_t kA1ie = 0x01;
+  static constexpr uint8_t kA2f = 0x02;
+  static constexpr uint8_t kA1f = 0x01;
+  static constexpr uint8_t kFlags = 0x03;  // A2F, A1F.
+
+  /**
+   * Match the minutes, hours and day/date alarm registers at |alarm|[1..3]
+   * (i.e. alarm 1's layout; alarm 2 is passed as one register earlier).
+   */
+  bool alarmMatches(const uint8_t* alarm, const DateTime& dt) const {
+    const uint8_t day = alarm[3];
+    const bool day_matches =
+        (day & 0x80) || ((day & 0x40) ? (day & 0x0F) == weekday(dt)
+                                      : fromBcd(day & 0x3F) == dt.day());
+    return alarmFieldMatches(alarm[1], 0x7F, dt.minute()) &&
+           alarmFieldMatches(alarm[2], 0x3F, dt.hour()) && day_matches;
+  }
+
+  float temperature_ = 25.0f;
+};
+
+}  // namespace sim
+}  // namespace rtc
+
+#endif  // RTC_SIM_DS3231_H_
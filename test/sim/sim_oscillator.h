@@ -0,0 +1,96 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_SIM_OSCILLATOR_H_
+#define RTC_SIM_OSCILLATOR_H_
+
+#include <cmath>
+#include <cstdint>
+
+namespace rtc {
+namespace sim {
+
+/**
+ * Deterministic pseudo-random numbers (xorshift32) for simulations.
+ */
+class Random {
+ public:
+  explicit Random(uint32_t seed) : state_(seed ? seed : 1) {}
+
+  uint32_t next() {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 17;
+    state_ ^= state_ << 5;
+    return state_;
+  }
+
+  /**
+   * Uniformly distributed in [0, 1).
+   */
+  double uniform() { return next() / 4294967296.0; }
+
+  /**
+   * Normally distributed with mean zero and the given standard deviation.
+   */
+  double gaussian(double sigma) {
+    // Box-Muller.
+    const double u1 = 1.0 - uniform();
+    const double u2 = uniform();
+    return sigma * std::sqrt(-2.0 * std::log(u1)) *
+           std::cos(2.0 * 3.14159265358979323846 * u2);
+  }
+
+ private:
+  uint32_t state_;
+};
+
+/**
+ * A synthetic oscillator with a fixed frequency error plus random walk
+ * frequency wander.
+ */
+class Oscillator {
+ public:
+  /**
+   * @param ppm Initial frequency error. Positive values are fast.
+   * @param wander_ppb Standard deviation of the frequency random walk, in
+   *                   ppb per square root of a second.
+   * @param seed Random seed.
+   */
+  Oscillator(double ppm, double wander_ppb, uint32_t seed)
+      : ppm_(ppm), wander_ppb_(wander_ppb), random_(seed) {}
+
+  /**
+   * Advance by |micros| microseconds of true time.
+   *
+   * @return The number of microseconds counted by the oscillator.
+   */
+  int64_t advance(int64_t micros) {
+    const double seconds = micros * 1e-6;
+    if (wander_ppb_ > 0)
+      ppm_ += random_.gaussian(wander_ppb_ * 1e-3 * std::sqrt(seconds));
+    fraction_ += micros * (1.0 + ppm_ * 1e-6);
+    const double whole = std::floor(fraction_);
+    fraction_ -= whole;
+    return static_cast<int64_t>(whole);
+  }
+
+  /**
+   * The current frequency error (ppm).
+   */
+  double ppm() const { return ppm_; }
+
+ private:
+  double ppm_;
+  const double wander_ppb_;
+  Random random_;
+  double fraction_ = 0;
+};
+
+}  // namespace sim
+}  // namespace rtc
+
+#endif  // RTC_SIM_OSCILLATOR_H_
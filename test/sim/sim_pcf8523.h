@@ -0,0 +1,179 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_SIM_PCF8523_H_
+#define RTC_SIM_PCF8523_H_
+
+#include <cstdint>
+#include <limits>
+
+#include "sim_clock_chip.h"
+
+namespace rtc {
+namespace sim {
+
+/**
+ * Simulated PCF8523 register file.
+ *
+ * The offset register correction is modeled as a continuous rate change
+ * rather than the chip's periodic pulse insertion/removal, which is
+ * indistinguishable at the 1 second resolution of the time registers.
+ *
+ * The battery only backs the chip once battery switch-over has been
+ * enabled in Control_3: after a power-on reset it is disabled.
+ *
+ * Countdown timers A and B are modeled with free-running source clocks,
+ * so that (as on the chip) the first period of a countdown is shortened.
+ * Their interrupts are always modeled as levels: pulsed mode (TAM/TBM) is
+ * not distinguished.
+ */
+class PCF8523 : public ClockChip<0x14> {
+ public:
+  static constexpr uint8_t kAddress = 0x68;
+
+  explicit PCF8523(double crystal_ppm = 0)
+      : ClockChip(kSeconds, /*weekday_first=*/false, crystal_ppm) {
+    resetRegisters();
+  }
+
+  bool interrupt() const override {
+    const uint8_t control2 = regs_[kControl2];
+    return ((regs_[kControl1] & kAie) && (control2 & kAf)) ||
+           ((control2 & kCtaie) && (control2 & kCtaf)) ||
+           ((control2 & kCtbie) && (control2 & kCtbf));
+  }
+
+  uint8_t read(uint8_t reg) override {
+    // The value registers read back the current count.
+    if (reg == kTimerAValue && timerARunning())
+      return timers_[0].count();
+    if (reg == kTimerBValue && timerBRunning())
+      return timers_[1].count();
+    return ClockChip::read(reg);
+  }
+
+  void write(uint8_t reg, uint8_t value) override {
+    if (reg == kControl2) {
+      // Flags can only be cleared.
+      value = (regs_[kControl2] & value & kFlags) | (value & ~kFlags);
+    }
+    const bool a_was_enabled = timerAEnabled();
+    const bool b_was_enabled = timerBEnabled();
+    ClockChip::write(reg, value);
+    if (!a_was_enabled && timerAEnabled())
+      startTimer(&timers_[0], kTimerAFreq);
+    if (!b_was_enabled && timerBEnabled())
+      startTimer(&timers_[1], kTimerBFreq);
+  }
+
+  void powerOff() override {
+    if (batteryBacked())
+      regs_[kControl3] |= kBsf;
+    ClockChip::powerOff();
+  }
+
+ protected:
+  bool running() const override { return !(regs_[kControl1] & 0x20); }
+
+  bool batteryBacked() const override {
+    // PM[1] set disables the battery switch-over.
+    return battery() && !(regs_[kControl3] & 0x40);
+  }
+
+  double correctionPpm() const override {
+    const uint8_t reg = regs_[kOffset];
+    // Sign-extend the 7-bit two's complement offset.
+    const int offset = (reg & 0x40) ? static_cast<int>(reg & 0x7F) - 128
+                                    : static_cast<int>(reg & 0x7F);
+    return offset * ((reg & 0x80) ? 4.069 : 4.340);
+  }
+
+  void onTimeWritten() override { regs_[kSeconds] &= 0x7F; }
+
+  void onSecond(const DateTime& dt) override {
+    if (dt.second() != 0)
+      return;
+    const uint8_t* alarm = &regs_[kMinuteAlarm];
+    if ((alarm[0] & alarm[1] & alarm[2] & alarm[3]) & 0x80)
+      return;  // All disabled.
+    if (alarmFieldMatches(alarm[0], 0x7F, dt.minute()) &&
+        alarmFieldMatches(alarm[1], 0x3F, dt.hour()) &&
+        alarmFieldMatches(alarm[2], 0x3F, dt.day()) &&
+        alarmFieldMatches(alarm[3], 0x07, dt.dayOfTheWeek())) {
+      regs_[kControl2] |= kAf;
+    }
+  }
+
+  void onOscillator(double from, double to) override {
+    if (timerAEnabled() && timers_[0].advance(from, to))
+      regs_[kControl2] |= kCtaf;
+    if (timerBEnabled() && timers_[1].advance(from, to))
+      regs_[kControl2] |= kCtbf;
+  }
+
+  double secondsToNextEvent() const override {
+    double seconds = std::numeric_limits<double>::infinity();
+    const double now = oscillatorSeconds();
+    if (timerAEnabled())
+      seconds = std::min(seconds, timers_[0].secondsToExpiry(now));
+    if (timerBEnabled())
+      seconds = std::min(seconds, timers_[1].secondsToExpiry(now));
+    return seconds;
+  }
+
+  void resetRegisters() override {
+    regs_[kControl3] = 0xE0;  // Standby mode after power-on.
+    regs_[kSeconds] = 0x80;   // Oscillator stop flag set.
+    for (uint8_t reg = kMinuteAlarm; reg < kMinuteAlarm + 4; reg++)
+      regs_[reg] = 0x80;  // Alarms disabled.
+  }
+
+ private:
+  static constexpr uint8_t kControl1 = 0x00;
+  static constexpr uint8_t kControl2 = 0x01;
+  static constexpr uint8_t kControl3 = 0x02;
+  static constexpr uint8_t kSeconds = 0x03;
+  static constexpr uint8_t kMinuteAlarm = 0x0A;
+  static constexpr uint8_t kOffset = 0x0E;
+  static constexpr uint8_t kTimerControl = 0x0F;
+  static constexpr uint8_t kTimerAFreq = 0x10;
+  static constexpr uint8_t kTimerAValue = 0x11;
+  static constexpr uint8_t kTimerBFreq = 0x12;
+  static constexpr uint8_t kTimerBValue = 0x13;
+
+  static constexpr uint8_t kAie = 0x02;    // Control_1.
+  static constexpr uint8_t kCtaf = 0x40;   // Control_2.
+  static constexpr uint8_t kCtbf = 0x20;   // Control_2.
+  static constexpr uint8_t kAf = 0x08;     // Control_2.
+  static constexpr uint8_t kCtaie = 0x02;  // Control_2.
+  static constexpr uint8_t kCtbie = 0x01;  // Control_2.
+  static constexpr uint8_t kFlags = 0xF8;  // Control_2.
+  static constexpr uint8_t kBsf = 0x08;    // Control_3.
+
+  bool timerAEnabled() const {
+    return (regs_[kTimerControl] & 0x06) == 0x02;  // TAC: countdown.
+  }
+
+  bool timerBEnabled() const { return regs_[kTimerControl] & 0x01; }
+
+  bool timerARunning() const { return timerAEnabled() && timers_[0].loaded(); }
+
+  bool timerBRunning() const { return timerBEnabled() && timers_[1].loaded(); }
+
+  void startTimer(CountdownTimer* timer, uint8_t freq_reg) {
+    static const double kPeriods[] = {1.0 / 4096, 1.0 / 64, 1, 60, 3600};
+    const uint8_t freq = regs_[freq_reg] & 0x07;
+    timer->start(kPeriods[freq < 4 ? freq : 4], regs_[freq_reg + 1]);
+  }
+
+  CountdownTimer timers_[2];
+};
+
+}  // namespace sim
+}  // namespace rtc
+
+#endif  // RTC_SIM_PCF8523_H_
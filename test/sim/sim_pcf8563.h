@@ -0,0 +1,139 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_SIM_PCF8563_H_
+#define RTC_SIM_PCF8563_H_
+
+#include <cstdint>
+#include <limits>
+
+#include "sim_clock_chip.h"
+
+namespace rtc {
+namespace sim {
+
+/**
+ * Simulated PCF8563 register file.
+ *
+ * The alarm is matched at the start of each minute and drives the INT
+ * output when AIE is set.
+ *
+ * The countdown timer drives the INT output when TIE is set: until TF is
+ * cleared, or in pulse mode (TI_TP) for the pulse width.
+ */
+class PCF8563 : public ClockChip<0x10> {
+ public:
+  static constexpr uint8_t kAddress = 0x51;
+
+  explicit PCF8563(double crystal_ppm = 0)
+      : ClockChip(kSeconds, /*weekday_first=*/false, crystal_ppm) {
+    resetRegisters();
+  }
+
+  bool interrupt() const override {
+    const uint8_t control2 = regs_[kControl2];
+    if ((control2 & kAie) && (control2 & kAf))
+      return true;
+    if (!(control2 & kTie))
+      return false;
+    return (control2 & kTiTp) ? timer_pulse_ : (control2 & kTf);
+  }
+
+  uint8_t read(uint8_t reg) override {
+    // The timer register reads back the current count.
+    if (reg == kTimer && timerEnabled())
+      return timer_.count();
+    return ClockChip::read(reg);
+  }
+
+  void write(uint8_t reg, uint8_t value) override {
+    if (reg == kControl2) {
+      // AF and TF can only be cleared.
+      value = (regs_[kControl2] & value & kFlags) | (value & ~kFlags);
+    }
+    const bool was_enabled = timerEnabled();
+    ClockChip::write(reg, value);
+    if (!was_enabled && timerEnabled()) {
+      static const double kPeriods[] = {1.0 / 4096, 1.0 / 64, 1, 60};
+      timer_.start(kPeriods[regs_[kTimerControl] & 0x03], regs_[kTimer]);
+    }
+  }
+
+ protected:
+  bool running() const override { return !(regs_[kControl1] & 0x20); }
+
+  void onTimeWritten() override { regs_[kSeconds] &= 0x7F; }
+
+  void onSecond(const DateTime& dt) override {
+    if (dt.second() != 0)
+      return;
+    const uint8_t* alarm = &regs_[kMinuteAlarm];
+    if ((alarm[0] & alarm[1] & alarm[2] & alarm[3]) & 0x80)
+      return;  // All disabled.
+    if (alarmFieldMatches(alarm[0], 0x7F, dt.minute()) &&
+        alarmFieldMatches(alarm[1], 0x3F, dt.hour()) &&
+        alarmFieldMatches(alarm[2], 0x3F, dt.day()) &&
+        alarmFieldMatches(alarm[3], 0x07, dt.dayOfTheWeek())) {
+      regs_[kControl2] |= kAf;
+    }
+  }
+
+  void onOscillator(double from, double to) override {
+    if (timer_pulse_ && to >= pulse_end_)
+      timer_pulse_ = false;
+    if (timerEnabled() && timer_.advance(from, to)) {
+      regs_[kControl2] |= kTf;
+      // Pulse widths per source clock, from the datasheet.
+      static const double kWidths[] = {1.0 / 8192, 1.0 / 128, 1.0 / 64,
+                                       1.0 / 64};
+      timer_pulse_ = true;
+      pulse_end_ = to + kWidths[regs_[kTimerControl] & 0x03];
+    }
+  }
+
+  double secondsToNextEvent() const override {
+    double seconds = std::numeric_limits<double>::infinity();
+    const double now = oscillatorSeconds();
+    if (timer_pulse_)
+      seconds = pulse_end_ - now;
+    if (timerEnabled())
+      seconds = std::min(seconds, timer_.secondsToExpiry(now));
+    return seconds;
+  }
+
+  void resetRegisters() override {
+    regs_[kSeconds] = 0x80;  // Voltage low (clock integrity) flag set.
+    for (uint8_t reg = kMinuteAlarm; reg < kMinuteAlarm + 4; reg++)
+      regs_[reg] = 0x80;  // Alarm disabled.
+  }
+
+ private:
+  static constexpr uint8_t kControl1 = 0x00;
+  static constexpr uint8_t kControl2 = 0x01;
+  static constexpr uint8_t kSeconds = 0x02;
+  static constexpr uint8_t kMinuteAlarm = 0x09;
+  static constexpr uint8_t kTimerControl = 0x0E;
+  static constexpr uint8_t kTimer = 0x0F;
+
+  static constexpr uint8_t kTiTp = 0x10;   // Control_2.
+  static constexpr uint8_t kAf = 0x08;     // Control_2.
+  static constexpr uint8_t kTf = 0x04;     // Control_2.
+  static constexpr uint8_t kAie = 0x02;    // Control_2.
+  static constexpr uint8_t kTie = 0x01;    // Control_2.
+  static constexpr uint8_t kFlags = 0x0C;  // Control_2.
+
+  bool timerEnabled() const { return regs_[kTimerControl] & 0x80; }
+
+  CountdownTimer timer_;
+  bool timer_pulse_ = false;
+  double pulse_end_ = 0;  // Oscillator time.
+};
+
+}  // namespace sim
+}  // namespace rtc
+
+#endif  // RTC_SIM_PCF8563_H_
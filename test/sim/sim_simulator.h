@@ -0,0 +1,241 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_SIM_SIMULATOR_H_
+#define RTC_SIM_SIMULATOR_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <rtclib/system_clock.h>
+#include "sim_clock_chip.h"
+#include "sim_oscillator.h"
+
+namespace rtc {
+namespace sim {
+
+/**
+ * A discrete-event virtual time engine.
+ *
+ * Drives the simulated RTCs and the SystemClock (which must be built with
+ * RTC_SYSTEM_CLOCK_MANUAL) together from one virtual "true" time. Time
+ * jumps straight from one event to the next, so long periods simulate in
+ * a fraction of the real time, and runs are fully deterministic.
+ *
+ * Events scheduled for the same time run in the order scheduled. Interrupt
+ * handlers are called when a chip's interrupt output becomes asserted: the
+ * engine steps to each internal event (second, timer expiry) of a watched
+ * chip so that handlers run at the exact time the chip raised the
+ * interrupt.
+ */
+class Simulator {
+ public:
+  using Callback = std::function<void()>;
+  using EventId = uint64_t;
+
+  /**
+   * Start the simulation, with the SystemClock reading zero. While the
+   * simulator exists, SystemClock::delayMicros() runs it for that long.
+   */
+  Simulator() {
+    SystemClock::setMicrosSinceStart(0);
+    SystemClock::setDelayHandler(&Simulator::delay, this);
+  }
+
+  ~Simulator() { SystemClock::setDelayHandler(nullptr, nullptr); }
+
+  Simulator(const Simulator&) = delete;
+  Simulator& operator=(const Simulator&) = delete;
+
+  /**
+   * True time since the start of the simulation (microseconds).
+   */
+  int64_t now() const { return now_; }
+
+  /**
+   * Add an RTC to be advanced with the simulation. Not owned.
+   */
+  void addChip(Timekeeper* chip) { chips_.push_back(chip); }
+
+  /**
+   * Drive the SystemClock from |oscillator| rather than true time, to
+   * simulate the drift of the system timer. Not owned.
+   */
+  void setSystemOscillator(Oscillator* oscillator) {
+    system_oscillator_ = oscillator;
+  }
+
+  /**
+   * Call |callback| at true time |at| (microseconds).
+   */
+  EventId schedule(int64_t at, Callback callback) {
+    const EventId id = next_id_++;
+    events_[std::make_pair(std::max(at, now_), id)] = std::move(callback);
+    return id;
+  }
+
+  /**
+   * Call |callback| after |delay| microseconds.
+   */
+  EventId scheduleIn(int64_t delay, Callback callback) {
+    return schedule(now_ + delay, std::move(callback));
+  }
+
+  /**
+   * Call |callback| every |period| microseconds, starting one period from
+   * now, until cancelled with the returned id.
+   */
+  EventId scheduleEvery(int64_t period, Callback callback) {
+    const EventId id = next_id_++;
+    periodic_[id] = std::make_pair(period, std::move(callback));
+    events_[std::make_pair(now_ + period, id)] = nullptr;
+    return id;
+  }
+
+  /**
+   * Cancel a scheduled event.
+   */
+  void cancel(EventId id) {
+    periodic_.erase(id);
+    for (auto it = events_.begin(); it != events_.end(); ++it) {
+      if (it->first.second == id) {
+        events_.erase(it);
+        return;
+      }
+    }
+  }
+
+  /**
+   * Call |handler| whenever |chip|'s interrupt output becomes asserted.
+   */
+  void onInterrupt(Timekeeper* chip, Callback handler) {
+    watches_.push_back({chip, std::move(handler), chip->interrupt()});
+  }
+
+  /**
+   * Remove the main supply from all chips and halt the system (i.e. the
+   * SystemClock stops).
+   */
+  void powerOff() {
+    for (Timekeeper* chip : chips_)
+      chip->powerOff();
+    system_running_ = false;
+  }
+
+  /**
+   * Restore the main supply. The system reboots: the SystemClock restarts
+   * from zero.
+   */
+  void powerOn() {
+    for (Timekeeper* chip : chips_)
+      chip->powerOn();
+    system_running_ = true;
+    SystemClock::setMicrosSinceStart(0);
+  }
+
+  /**
+   * Run all events up to and including true time |end|.
+   */
+  void runUntil(int64_t end) {
+    while (true) {
+      int64_t next = end;
+      if (!events_.empty())
+        next = std::min(next, events_.begin()->first.first);
+      for (const Watch& watch : watches_)
+        next = std::min(next, now_ + watch.chip->microsToNextEvent());
+      advanceTo(next);
+      checkInterrupts();
+      if (!events_.empty() && events_.begin()->first.first <= now_) {
+        runEvent();
+        checkInterrupts();
+      } else if (now_ >= end) {
+        return;
+      }
+    }
+  }
+
+  /**
+   * Run all events for the next |duration| microseconds.
+   */
+  void runFor(int64_t duration) { runUntil(now_ + duration); }
+
+  /**
+   * Advance time by |duration| microseconds without running events, e.g.
+   * for time spent within a call.
+   */
+  void elapse(int64_t duration) { advanceTo(now_ + duration); }
+
+ private:
+  struct Watch {
+    Timekeeper* chip;
+    Callback handler;
+    bool asserted;
+  };
+
+  static void delay(int64_t micros, void* simulator) {
+    static_cast<Simulator*>(simulator)->elapse(micros);
+  }
+
+  void advanceTo(int64_t time) {
+    if (time <= now_)
+      return;
+    const int64_t delta = time - now_;
+    for (Timekeeper* chip : chips_)
+      chip->advance(delta);
+    if (system_running_) {
+      SystemClock::advanceMicros(
+          system_oscillator_ ? system_oscillator_->advance(delta) : delta);
+    }
+    now_ = time;
+  }
+
+  void checkInterrupts() {
+    // Indexed, as a handler may add watches.
+    for (size_t i = 0; i < watches_.size(); i++) {
+      const bool asserted = watches_[i].chip->interrupt();
+      if (asserted && !watches_[i].asserted)
+        watches_[i].handler();
+      // Re-read: the handler may have cleared it.
+      watches_[i].asserted = watches_[i].chip->interrupt();
+    }
+  }
+
+  void runEvent() {
+    auto it = events_.begin();
+    const EventId id = it->first.second;
+    Callback callback = std::move(it->second);
+    events_.erase(it);
+    auto periodic = periodic_.find(id);
+    if (periodic != periodic_.end()) {
+      events_[std::make_pair(now_ + periodic->second.first, id)] = nullptr;
+      // Copy, as the callback may cancel itself.
+      Callback periodic_callback = periodic->second.second;
+      periodic_callback();
+      return;
+    }
+    callback();
+  }
+
+  int64_t now_ = 0;
+  EventId next_id_ = 1;
+  bool system_running_ = true;
+  Oscillator* system_oscillator_ = nullptr;
+  std::vector<Timekeeper*> chips_;
+  std::vector<Watch> watches_;
+  // Keyed by (time, id), so events at the same time run in schedule order.
+  std::map<std::pair<int64_t, EventId>, Callback> events_;
+  std::map<EventId, std::pair<int64_t, Callback>> periodic_;
+};
+
+}  // namespace sim
+}  // namespace rtc
+
+#endif  // RTC_SIM_SIMULATOR_H_
@@ -0,0 +1,134 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+
+#include <i2clib/master.h>
+#include <i2clib/operation.h>
+#include <rtclib/at24c32.h>
+#include <rtclib/nvram_store.h>
+#include <rtclib/system_clock.h>
+#include "sim_at24c32.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+/**
+ * An AT24C32 on the test bus.
+ */
+struct Fixture : sim::AT24C32Fixture {
+  Fixture() : sim::AT24C32Fixture(kTestI2CPort) {}
+};
+
+void test_at24c32_page_writes() {
+  Fixture f;
+  TEST_ASSERT_TRUE(f.eeprom.begin());
+  uint8_t data[100];
+  for (size_t i = 0; i < sizeof(data); i++)
+    data[i] = static_cast<uint8_t>(i + 1);
+
+  // 20..119 spans four pages: 20..31, 32..63, 64..95 and 96..119.
+  const int64_t start = SystemClock::microsSinceStart();
+  TEST_ASSERT_TRUE(f.eeprom.write(20, data, sizeof(data)));
+  TEST_ASSERT_EQUAL(4, f.chip.writeCycles());
+  TEST_ASSERT_EQUAL(4, f.eeprom.pageWrites());
+  for (size_t i = 0; i < sizeof(data); i++)
+    TEST_ASSERT_EQUAL(data[i], f.chip.byte(20 + i));
+  TEST_ASSERT_EQUAL(0, f.chip.byte(19));
+  TEST_ASSERT_EQUAL(0, f.chip.byte(120));
+
+  // Each page waited for the previous write cycle, and no longer.
+  const int64_t elapsed = SystemClock::microsSinceStart() - start;
+  TEST_ASSERT_GREATER_OR_EQUAL(3 * sim::AT24C32::kWriteCycleMicros, elapsed);
+  TEST_ASSERT_LESS_OR_EQUAL(3 * (sim::AT24C32::kWriteCycleMicros +
+                                 sim::AT24C32::kAddressMicros),
+                            elapsed);
+
+  // One sequential read, after polling for the last write cycle.
+  uint8_t read[sizeof(data)] = {};
+  TEST_ASSERT_TRUE(f.eeprom.read(20, read, sizeof(read)));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, read, sizeof(data));
+  const uint32_t before = f.transactions();
+  TEST_ASSERT_TRUE(f.eeprom.read(0, read, sizeof(read)));
+  TEST_ASSERT_EQUAL(1, f.transactions() - before);
+  TEST_ASSERT_EQUAL(0, read[0]);
+  TEST_ASSERT_EQUAL(1, read[20]);
+}
+
+void test_at24c32_bounds_and_errors() {
+  Fixture f;
+  const uint8_t data[4] = {1, 2, 3, 4};
+  uint8_t read[4];
+  TEST_ASSERT_TRUE(f.eeprom.write(AT24C32::kSize - 4, data, sizeof(data)));
+  TEST_ASSERT_TRUE(f.eeprom.read(AT24C32::kSize - 4, read, sizeof(read)));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, read, sizeof(data));
+  TEST_ASSERT_FALSE(f.eeprom.write(AT24C32::kSize - 3, data, sizeof(data)));
+  TEST_ASSERT_FALSE(f.eeprom.read(AT24C32::kSize - 3, read, sizeof(read)));
+
+  // Straddling a page boundary takes two page writes.
+  TEST_ASSERT_TRUE(f.eeprom.write(30, data, sizeof(data)));
+  TEST_ASSERT_EQUAL(3, f.chip.writeCycles());
+  TEST_ASSERT_EQUAL(3, f.chip.byte(32));
+  TEST_ASSERT_EQUAL(0, f.chip.byte(0));
+  TEST_ASSERT_TRUE(f.eeprom.waitReady());
+
+  sim::Bus::get(kTestI2CPort).detach(sim::AT24C32::kAddress);
+  TEST_ASSERT_FALSE(f.eeprom.begin());
+  TEST_ASSERT_FALSE(f.eeprom.write(0, data, sizeof(data)));
+  TEST_ASSERT_FALSE(f.eeprom.read(0, read, sizeof(read)));
+}
+
+void test_at24c32_byte_storage() {
+  Fixture f;
+  // An NvramStore in the last 64 bytes.
+  NvramStore store(&f.eeprom, AT24C32::kSize - 64, 64);
+  TEST_ASSERT_TRUE(store.begin());
+  for (uint32_t i = 0; i < 50; i++)
+    TEST_ASSERT_TRUE(store.put(static_cast<uint8_t>(i % 3), &i, sizeof(i)));
+
+  NvramStore reloaded(&f.eeprom, AT24C32::kSize - 64, 64);
+  TEST_ASSERT_TRUE(reloaded.begin());
+  TEST_ASSERT_EQUAL(3, reloaded.size());
+  uint32_t value = 0;
+  TEST_ASSERT_TRUE(reloaded.get(1, &value, sizeof(value), nullptr));
+  TEST_ASSERT_EQUAL(49, value);
+}
+
+void test_at24c32_read_addressing() {
+  Fixture f;
+  f.chip.byte(0x123) = 0xA5;
+  f.chip.byte(0x124) = 0x5A;
+
+  // Both address bytes are written before turning the bus around, so a
+  // read doesn't start a write cycle.
+  uint8_t read[2];
+  TEST_ASSERT_TRUE(f.eeprom.read(0x123, read, sizeof(read)));
+  TEST_ASSERT_EQUAL_HEX8(0xA5, read[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x5A, read[1]);
+  TEST_ASSERT_EQUAL(0, f.chip.writeCycles());
+
+  // The low address byte can't be sent once the EEPROM is transmitting.
+  Master master(kTestI2CPort, nullptr);
+  i2c::Operation op =
+      master.CreateReadOp(sim::AT24C32::kAddress, 0x01, "read");
+  TEST_ASSERT_FALSE(op.WriteByte(0x23));
+  TEST_ASSERT_FALSE(op.Execute());
+}
+
+}  // namespace
+
+void run_at24c32_tests() {
+  RUN_TEST(test_at24c32_page_writes);
+  RUN_TEST(test_at24c32_bounds_and_errors);
+  RUN_TEST(test_at24c32_byte_storage);
+  RUN_TEST(test_at24c32_read_addressing);
+}
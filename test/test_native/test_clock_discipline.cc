@@ -0,0 +1,274 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <rtclib/clock_discipline.h>
+#include <rtclib/datetime.h>
+#include <rtclib/micros.h>
+#include <rtclib/software_clock.h>
+#include <rtclib/system_clock.h>
+#include <rtclib/tick_source.h>
+#include "sim_oscillator.h"
+#include "tests.h"
+
+using namespace rtc;
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+
+/**
+ * Result of a discipline simulation run.
+ */
+struct SimulationResult {
+  double convergence_seconds;  // Time after which |offset| stayed in bounds.
+  double residual_rms_micros;  // RMS offset over the second half of the run.
+  double frequency_error_ppb;  // Final frequency correction error.
+};
+
+/**
+ * Simulate the discipline of Micros driven by |oscillator|, measuring the
+ * offset against true time every |poll_seconds| with Gaussian measurement
+ * noise.
+ */
+SimulationResult simulate(sim::Oscillator* oscillator,
+                          const ClockDiscipline::Config& config,
+                          int poll_seconds,
+                          int duration_seconds,
+                          double noise_micros,
+                          int64_t bound_micros) {
+  sim::Random noise(1234);
+  SystemClock::setMicrosSinceStart(0);
+  Micros::adjustDriftPpb(0);
+  int64_t reference = static_cast<int64_t>(DateTime(2021, 1, 1).unixtime()) *
+                      kMicrosPerSecond;
+  Micros::adjust(DateTime(2021, 1, 1));
+  ClockDiscipline discipline(Micros::softwareClock(), config);
+
+  SimulationResult result = {0, 0, 0};
+  double sum_squares = 0;
+  int num_residuals = 0;
+  for (int t = 0; t < duration_seconds; t += poll_seconds) {
+    const int64_t step = poll_seconds * kMicrosPerSecond;
+    reference += step;
+    SystemClock::advanceMicros(oscillator->advance(step));
+
+    const int64_t offset = reference - Micros::nowMicros();
+    if (std::llabs(offset) > bound_micros)
+      result.convergence_seconds = t + poll_seconds;
+    if (t >= duration_seconds / 2) {
+      sum_squares += static_cast<double>(offset) * offset;
+      num_residuals++;
+    }
+    discipline.update(offset + std::llround(noise.gaussian(noise_micros)));
+  }
+  result.residual_rms_micros = std::sqrt(sum_squares / num_residuals);
+  // The required correction is the inverse of the oscillator error.
+  result.frequency_error_ppb =
+      discipline.frequencyPpb() + oscillator->ppm() * 1000;
+  Micros::adjustDriftPpb(0);
+  return result;
+}
+
+void report(const char* name, const SimulationResult& result) {
+  char message[160];
+  snprintf(message, sizeof(message),
+           "%s: converged in %.0f s, residual %.1f us RMS, "
+           "frequency error %.1f ppb",
+           name, result.convergence_seconds, result.residual_rms_micros,
+           result.frequency_error_ppb);
+  TEST_MESSAGE(message);
+}
+
+void test_micros_rate_change_does_not_step() {
+  SystemClock::setMicrosSinceStart(0);
+  Micros::adjust(DateTime(2021, 1, 1));
+  SystemClock::advanceMicros(123456789);
+
+  const int64_t before = Micros::nowMicros();
+  Micros::adjustDriftPpb(250000);
+  TEST_ASSERT_EQUAL_INT64(before, Micros::nowMicros());
+  Micros::adjustDriftPpb(-250000);
+  TEST_ASSERT_EQUAL_INT64(before, Micros::nowMicros());
+  Micros::adjustDriftPpb(0);
+}
+
+void test_micros_ppb_resolution() {
+  SystemClock::setMicrosSinceStart(0);
+  Micros::adjust(DateTime(2021, 1, 1));
+  const int64_t start = Micros::nowMicros();
+
+  // 7 ppb over 10^9 µs is 7 µs (less the truncated fraction of a µs).
+  Micros::adjustDriftPpb(7);
+  TEST_ASSERT_EQUAL_INT32(7, Micros::driftPpb());
+  SystemClock::advanceMicros(1000000000);
+  TEST_ASSERT_INT64_WITHIN(1, 1000000000 + 7, Micros::nowMicros() - start);
+
+  Micros::adjustDriftPpb(-7);
+  TEST_ASSERT_EQUAL_INT32(-7, Micros::driftPpb());
+  SystemClock::advanceMicros(1000000000);
+  TEST_ASSERT_INT64_WITHIN(1, 2000000000, Micros::nowMicros() - start);
+
+  Micros::adjustDrift(-12);
+  TEST_ASSERT_EQUAL_INT32(-12000, Micros::driftPpb());
+  Micros::adjustDriftPpb(0);
+}
+
+void test_micros_no_call_frequency_requirement() {
+  SystemClock::setMicrosSinceStart(0);
+  const DateTime start(2021, 1, 1);
+  Micros::adjust(start);
+  // Much longer than the 71.6 minute rollover of a 32-bit micros().
+  SystemClock::advanceMicros(10LL * 24 * 3600 * kMicrosPerSecond);
+  TEST_ASSERT_EQUAL_UINT32(start.unixtime() + 10 * 24 * 3600,
+                           Micros::now().unixtime());
+}
+
+void test_clock_discipline_slews_without_steps() {
+  SystemClock::setMicrosSinceStart(0);
+  Micros::adjust(DateTime(2021, 1, 1));
+  ClockDiscipline discipline(Micros::softwareClock());
+
+  // A 50 ms offset must be slewed out, never stepped: each second of system
+  // time may only differ from a second by the maximum slew + frequency.
+  const ClockDiscipline::Config config;
+  const int64_t max_change =
+      (static_cast<int64_t>(config.max_slew) + config.max_frequency) / 1000;
+  discipline.update(50000);
+  int64_t last = Micros::nowMicros();
+  for (int i = 0; i < 60; i++) {
+    SystemClock::advanceMicros(kMicrosPerSecond);
+    const int64_t now = Micros::nowMicros();
+    TEST_ASSERT_GREATER_THAN(last, now);
+    TEST_ASSERT_INT64_WITHIN(max_change + 1, kMicrosPerSecond, now - last);
+    last = now;
+  }
+  TEST_ASSERT_GREATER_THAN(0, discipline.slewPpb());
+  Micros::adjustDriftPpb(0);
+}
+
+/**
+ * The simulation harness: a fast oscillator with frequency wander and
+ * noisy (e.g. NTP-grade) offset measurements.
+ */
+void test_clock_discipline_simulation() {
+  sim::Oscillator oscillator(/*ppm=*/37.5, /*wander_ppb=*/0.5, /*seed=*/42);
+  ClockDiscipline::Config config;
+  config.time_constant = 64;
+  const SimulationResult result =
+      simulate(&oscillator, config, /*poll_seconds=*/16,
+               /*duration_seconds=*/4 * 3600, /*noise_micros=*/20,
+               /*bound_micros=*/200);
+  report("37.5 ppm, 16 s poll, 20 us noise", result);
+  TEST_ASSERT_LESS_THAN(1800, result.convergence_seconds);
+  TEST_ASSERT_LESS_THAN(50, result.residual_rms_micros);
+  TEST_ASSERT_LESS_THAN(500, std::fabs(result.frequency_error_ppb));
+}
+
+void test_clock_discipline_simulation_slow_oscillator() {
+  sim::Oscillator oscillator(/*ppm=*/-180, /*wander_ppb=*/1, /*seed=*/7);
+  ClockDiscipline::Config config;
+  config.time_constant = 256;
+  const SimulationResult result =
+      simulate(&oscillator, config, /*poll_seconds=*/64,
+               /*duration_seconds=*/12 * 3600, /*noise_micros=*/100,
+               /*bound_micros=*/1000);
+  report("-180 ppm, 64 s poll, 100 us noise", result);
+  TEST_ASSERT_LESS_THAN(3 * 3600, result.convergence_seconds);
+  TEST_ASSERT_LESS_THAN(200, result.residual_rms_micros);
+  TEST_ASSERT_LESS_THAN(500, std::fabs(result.frequency_error_ppb));
+}
+
+void test_clock_discipline_restore() {
+  ClockDiscipline discipline(Micros::softwareClock());
+  discipline.restore(-7000);
+  TEST_ASSERT_TRUE(discipline.locked());
+  TEST_ASSERT_EQUAL(-7000, discipline.frequencyPpb());
+  TEST_ASSERT_EQUAL(-7000, Micros::driftPpb());
+  discipline.reset();
+  TEST_ASSERT_FALSE(discipline.locked());
+  TEST_ASSERT_EQUAL(0, Micros::driftPpb());
+}
+
+void test_clock_discipline_feed_forward() {
+  // A clock of its own, leaving Micros alone.
+  SystemClock::setMicrosSinceStart(0);
+  Micros::adjustDriftPpb(0);
+  SoftwareClock clock;
+  clock.adjust(DateTime(2021, 1, 1));
+  int64_t reference = static_cast<int64_t>(DateTime(2021, 1, 1).unixtime()) *
+                      kMicrosPerSecond;
+  ClockDiscipline discipline(&clock);
+
+  // Two thirds of a 30 ppm error is known, e.g. from temperature.
+  discipline.setFeedForwardPpb(-20000);
+  TEST_ASSERT_EQUAL(-20000, clock.driftPpb());
+  sim::Oscillator oscillator(/*ppm=*/30, /*wander_ppb=*/0, /*seed=*/1);
+  for (int i = 0; i < 240; i++) {
+    const int64_t step = 16 * kMicrosPerSecond;
+    reference += step;
+    SystemClock::advanceMicros(oscillator.advance(step));
+    discipline.update(reference - clock.nowMicros());
+  }
+
+  // The discipline learns the rest.
+  TEST_ASSERT_INT_WITHIN(500, -10000, discipline.frequencyPpb());
+  TEST_ASSERT_INT_WITHIN(500, -30000, clock.driftPpb());
+  TEST_ASSERT_EQUAL(-20000, discipline.feedForwardPpb());
+  TEST_ASSERT_EQUAL(0, Micros::driftPpb());
+
+  discipline.reset();
+  TEST_ASSERT_EQUAL(-20000, clock.driftPpb());
+}
+
+void test_clock_discipline_own_timebase() {
+  // A clock running from a virtual timebase, with the system clock running
+  // at half its rate: the discipline must only use the clock's own ticks.
+  SystemClock::setMicrosSinceStart(0);
+  ManualTickSource source;
+  SoftwareClock clock(&source);
+  clock.adjust(DateTime(2021, 1, 1));
+  int64_t reference = static_cast<int64_t>(DateTime(2021, 1, 1).unixtime()) *
+                      kMicrosPerSecond;
+  ClockDiscipline discipline(&clock);
+
+  sim::Oscillator oscillator(/*ppm=*/30, /*wander_ppb=*/0, /*seed=*/1);
+  for (int i = 0; i < 240; i++) {
+    const int64_t step = 16 * kMicrosPerSecond;
+    reference += step;
+    source.advance(oscillator.advance(step));
+    SystemClock::advanceMicros(step / 2);
+    discipline.update(reference - clock.nowMicros());
+    // The FLL measures the frequency over the clock's own intervals.
+    if (i == 4) {
+      TEST_ASSERT_TRUE(discipline.locked());
+      TEST_ASSERT_INT_WITHIN(500, -30000, discipline.frequencyPpb());
+    }
+  }
+
+  TEST_ASSERT_INT_WITHIN(500, -30000, discipline.frequencyPpb());
+  TEST_ASSERT_INT_WITHIN(1000, 0, reference - clock.nowMicros());
+}
+
+}  // namespace
+
+void run_clock_discipline_tests() {
+  RUN_TEST(test_micros_rate_change_does_not_step);
+  RUN_TEST(test_micros_ppb_resolution);
+  RUN_TEST(test_micros_no_call_frequency_requirement);
+  RUN_TEST(test_clock_discipline_slews_without_steps);
+  RUN_TEST(test_clock_discipline_simulation);
+  RUN_TEST(test_clock_discipline_simulation_slow_oscillator);
+  RUN_TEST(test_clock_discipline_restore);
+  RUN_TEST(test_clock_discipline_feed_forward);
+  RUN_TEST(test_clock_discipline_own_timebase);
+}
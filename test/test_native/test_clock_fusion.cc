@@ -0,0 +1,218 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+#include <i2clib/master.h>
+#include <rtclib/clock_fusion.h>
+#include <rtclib/datetime.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/system_clock.h>
+#include "sim_ds3231.h"
+#include "sim_oscillator.h"
+#include "sim_simulator.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+constexpr int64_t kMicrosPerHour = 3600 * kMicrosPerSecond;
+constexpr int64_t kMicrosPerDay = 24 * kMicrosPerHour;
+
+const int64_t kEpoch =
+    static_cast<int64_t>(DateTime(2021, 3, 1).unixtime()) * kMicrosPerSecond;
+
+void test_clock_fusion_uninitialized() {
+  ClockFusion fusion;
+  int64_t micros;
+  TEST_ASSERT_FALSE(fusion.initialized());
+  TEST_ASSERT_FALSE(fusion.estimate(0, &micros, nullptr));
+  TEST_ASSERT_FALSE(fusion.now(&micros, nullptr));
+  // A PPS can't tell which second it marks.
+  TEST_ASSERT_FALSE(fusion.addPps(0));
+}
+
+void test_clock_fusion_learns_frequency() {
+  // The SystemClock runs 50 ppm fast, and there is a reference with 1 ms
+  // of noise every minute.
+  sim::Random random(1);
+  ClockFusion fusion;
+  for (int64_t minute = 0; minute <= 600; minute++) {
+    const int64_t true_micros = minute * 60 * kMicrosPerSecond;
+    const int64_t local = true_micros + true_micros / 20000;
+    TEST_ASSERT_TRUE(fusion.addReference(
+        local,
+        kEpoch + true_micros +
+            static_cast<int64_t>(random.gaussian(1000)),
+        1000));
+  }
+  TEST_ASSERT_INT32_WITHIN(100, 50000, fusion.frequencyPpb());
+
+  // Extrapolated an hour ahead, to within the frequency uncertainty.
+  const int64_t true_micros = 11 * kMicrosPerHour;
+  int64_t micros, stddev;
+  TEST_ASSERT_TRUE(
+      fusion.estimate(true_micros + true_micros / 20000, &micros, &stddev));
+  TEST_ASSERT_INT64_WITHIN(3 * stddev, kEpoch + true_micros, micros);
+  TEST_ASSERT_LESS_THAN(2000, stddev);
+  TEST_ASSERT_EQUAL(601, fusion.stats().updates);
+  TEST_ASSERT_EQUAL(0, fusion.stats().rejections);
+}
+
+void test_clock_fusion_pps() {
+  ClockFusion fusion;
+  // A reference 100 ms out, followed by PPS edges 1 s apart: each is
+  // resolved to the nearest second.
+  TEST_ASSERT_TRUE(fusion.addReference(0, kEpoch + 100000, 50000));
+  for (int64_t second = 1; second <= 10; second++)
+    TEST_ASSERT_TRUE(fusion.addPps(second * kMicrosPerSecond));
+  int64_t micros, stddev;
+  TEST_ASSERT_TRUE(
+      fusion.estimate(10 * kMicrosPerSecond + 250000, &micros, &stddev));
+  TEST_ASSERT_INT64_WITHIN(20, kEpoch + 10 * kMicrosPerSecond + 250000,
+                           micros);
+  TEST_ASSERT_LESS_THAN(20, stddev);
+
+  // Too uncertain to tell the second.
+  ClockFusion rough;
+  TEST_ASSERT_TRUE(rough.addReference(0, kEpoch, 500000));
+  TEST_ASSERT_FALSE(rough.addPps(kMicrosPerSecond));
+}
+
+void test_clock_fusion_rejects_outliers() {
+  ClockFusion fusion;
+  TEST_ASSERT_TRUE(fusion.addReference(0, kEpoch, 1000));
+  TEST_ASSERT_TRUE(fusion.addReference(kMicrosPerSecond,
+                                       kEpoch + kMicrosPerSecond, 1000));
+  // An RTC reading an hour out is ignored.
+  const DateTime wrong(static_cast<uint32_t>(kEpoch / kMicrosPerSecond) +
+                       3600);
+  TEST_ASSERT_FALSE(fusion.addRtc(2 * kMicrosPerSecond, wrong));
+  TEST_ASSERT_EQUAL(1, fusion.stats().rejections);
+  int64_t micros;
+  TEST_ASSERT_TRUE(fusion.estimate(2 * kMicrosPerSecond, &micros, nullptr));
+  TEST_ASSERT_INT64_WITHIN(2000, kEpoch + 2 * kMicrosPerSecond, micros);
+
+  // Measurements going back in time are ignored.
+  TEST_ASSERT_FALSE(fusion.addReference(0, kEpoch, 1000));
+
+  // Until several agree, e.g. after the time was changed.
+  TEST_ASSERT_FALSE(fusion.addRtc(3 * kMicrosPerSecond, wrong));
+  TEST_ASSERT_TRUE(fusion.addRtc(4 * kMicrosPerSecond, wrong));
+  TEST_ASSERT_EQUAL(3, fusion.stats().rejections);
+  TEST_ASSERT_EQUAL(1, fusion.stats().resets);
+  TEST_ASSERT_TRUE(fusion.estimate(4 * kMicrosPerSecond, &micros, nullptr));
+  TEST_ASSERT_INT64_WITHIN(kMicrosPerSecond,
+                           kEpoch + 3600 * kMicrosPerSecond, micros);
+
+  fusion.reset();
+  TEST_ASSERT_FALSE(fusion.initialized());
+}
+
+// A day of a SystemClock 30 ppm fast with 1 ppb/√s wander, a 2 ppm DS3231
+// read every 10 s or so, and a reference with 2 ms of noise every hour.
+void test_clock_fusion_simulation() {
+  sim::Simulator simulator;
+  sim::Oscillator oscillator(30, 1, 2);
+  simulator.setSystemOscillator(&oscillator);
+  sim::DS3231 chip(2);
+  simulator.addChip(&chip);
+  sim::Bus::get(kTestI2CPort).attach(sim::DS3231::kAddress, &chip);
+  DS3231 rtc(Master(kTestI2CPort, nullptr));
+  TEST_ASSERT_TRUE(rtc.adjust(DateTime(2021, 3, 1)));
+  sim::Random random(3);
+  ClockFusion fusion;
+
+  int64_t max_error = 0;
+  int64_t max_stddev = 0;
+  int outside = 0;
+  int checks = 0;
+  double update_nanos = 0;
+  int num_updates = 0;
+  auto check = [&] {
+    int64_t micros, stddev;
+    if (!fusion.estimate(SystemClock::microsSinceStart(), &micros, &stddev))
+      return;
+    const int64_t error = std::llabs(micros - kEpoch - simulator.now());
+    checks++;
+    if (error > 3 * stddev)
+      outside++;
+    // After the first reference has settled things.
+    if (simulator.now() > kMicrosPerHour) {
+      max_error = error > max_error ? error : max_error;
+      max_stddev = stddev > max_stddev ? stddev : max_stddev;
+    }
+  };
+  auto timed = [&](const std::function<void()>& add) {
+    const auto start = std::chrono::steady_clock::now();
+    add();
+    update_nanos += std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+    num_updates++;
+  };
+
+  // Read the RTC at intervals out of step with its seconds.
+  std::function<void()> read_rtc = [&] {
+    check();
+    DateTime now;
+    TEST_ASSERT_TRUE(rtc.now(&now));
+    const int64_t local = SystemClock::microsSinceStart();
+    timed([&] { fusion.addRtc(local, now); });
+    simulator.schedule(
+        simulator.now() + 9500000 +
+            static_cast<int64_t>(random.uniform() * kMicrosPerSecond),
+        read_rtc);
+  };
+  simulator.schedule(0, read_rtc);
+  simulator.scheduleEvery(kMicrosPerHour, [&] {
+    check();
+    const int64_t local = SystemClock::microsSinceStart();
+    const int64_t reference =
+        kEpoch + simulator.now() + static_cast<int64_t>(random.gaussian(2000));
+    timed([&] { fusion.addReference(local, reference, 2000); });
+  });
+
+  simulator.runFor(kMicrosPerDay);
+
+  // The RTC alone bounds the time to a fraction of a second; with the
+  // references it's milliseconds, and the frequency is learned.
+  TEST_ASSERT_LESS_THAN(25000, max_error);
+  TEST_ASSERT_LESS_THAN(25000, max_stddev);
+  TEST_ASSERT_INT32_WITHIN(1000, 30000, fusion.frequencyPpb());
+  // The uncertainty is honest: about 1% fall outside 3 standard deviations.
+  TEST_ASSERT_LESS_THAN(checks / 50, outside);
+  TEST_ASSERT_EQUAL(0, fusion.stats().resets);
+
+  char msg[120];
+  snprintf(msg, sizeof(msg),
+           "Fused %d measurements, %.0f ns each: max error %lld us, "
+           "max stddev %lld us",
+           num_updates, update_nanos / num_updates,
+           static_cast<long long>(max_error),
+           static_cast<long long>(max_stddev));
+  TEST_MESSAGE(msg);
+}
+
+}  // namespace
+
+void run_clock_fusion_tests() {
+  RUN_TEST(test_clock_fusion_uninitialized);
+  RUN_TEST(test_clock_fusion_learns_frequency);
+  RUN_TEST(test_clock_fusion_pps);
+  RUN_TEST(test_clock_fusion_rejects_outliers);
+  RUN_TEST(test_clock_fusion_simulation);
+}
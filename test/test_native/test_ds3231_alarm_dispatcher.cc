@@ -0,0 +1,285 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <i2clib/master.h>
+#include <rtclib/datetime.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/ds3231_alarm_dispatcher.h>
+#include <rtclib/interrupt_source.h>
+#include <rtclib/spsc_queue.h>
+#include "sim_ds3231.h"
+#include "sim_simulator.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+
+const DateTime kStart(2021, 3, 1);
+
+struct Fired {
+  DS3231::Alarm alarm;
+  int64_t micros;
+};
+
+/**
+ * A manual interrupt source which notes an ISR attached over another.
+ */
+class CheckedInterruptSource : public ManualInterruptSource {
+ public:
+  bool attach(Isr isr, void* arg) override {
+    if (attached_)
+      reattached_ = true;
+    attached_ = true;
+    return ManualInterruptSource::attach(isr, arg);
+  }
+
+  void detach() override {
+    attached_ = false;
+    ManualInterruptSource::detach();
+  }
+
+  bool reattached() const { return reattached_; }
+
+ private:
+  bool attached_ = false;
+  bool reattached_ = false;
+};
+
+/**
+ * A DS3231 in a simulation, its INT output wired to a manual interrupt
+ * source.
+ */
+struct Fixture {
+  Fixture()
+      : rtc(Master(kTestI2CPort, nullptr)), dispatcher(&rtc, &source) {
+    sim::Bus::get(kTestI2CPort).attach(sim::DS3231::kAddress, &chip);
+    simulator.addChip(&chip);
+    chip.setTime(kStart);
+    simulator.onInterrupt(&chip, [this] { source.trigger(); });
+    const auto record = [this](DS3231::Alarm alarm, int64_t micros) {
+      fired.push_back({alarm, micros});
+    };
+    dispatcher.addHandler(DS3231::Alarm::A1, record);
+    dispatcher.addHandler(DS3231::Alarm::A2, record);
+  }
+
+  sim::DS3231 chip;
+  sim::Simulator simulator;
+  DS3231 rtc;
+  CheckedInterruptSource source;
+  DS3231AlarmDispatcher dispatcher;
+  std::vector<Fired> fired;
+};
+
+void test_spsc_queue() {
+  SpscQueue<uint32_t, 4> queue;
+  uint32_t item;
+  TEST_ASSERT_TRUE(queue.empty());
+  TEST_ASSERT_FALSE(queue.pop(&item));
+  for (uint32_t i = 0; i < 4; i++)
+    TEST_ASSERT_TRUE(queue.push(i));
+  TEST_ASSERT_FALSE(queue.push(4));
+  TEST_ASSERT_TRUE(queue.pop(&item));
+  TEST_ASSERT_EQUAL(0, item);
+  TEST_ASSERT_TRUE(queue.push(4));
+
+  // A producer thread against this (consumer) thread.
+  constexpr uint32_t kItems = 200000;
+  SpscQueue<uint32_t, 8> shared;
+  std::thread producer([&shared] {
+    for (uint32_t i = 0; i < kItems; i++) {
+      while (!shared.push(i))
+        std::this_thread::yield();
+    }
+  });
+  uint32_t expected = 0;
+  bool in_order = true;
+  while (expected < kItems) {
+    if (!shared.pop(&item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    in_order = in_order && item == expected;
+    expected++;
+  }
+  producer.join();
+  TEST_ASSERT_TRUE(in_order);
+  TEST_ASSERT_TRUE(shared.empty());
+}
+
+void test_alarm_dispatcher_dispatches_alarms() {
+  Fixture f;
+  // Alarm 1 at :30 past each minute, alarm 2 each minute.
+  TEST_ASSERT_TRUE(f.rtc.setAlarm1(DateTime(2000, 1, 1, 0, 0, 30),
+                                   DS3231::Alarm1Mode::Second));
+  TEST_ASSERT_TRUE(
+      f.rtc.setAlarm2(DateTime(2000, 1, 1), DS3231::Alarm2Mode::EveryMinute));
+  TEST_ASSERT_TRUE(f.dispatcher.begin());
+  TEST_ASSERT_TRUE(f.dispatcher.service());
+
+  // The worker runs shortly after each interrupt.
+  f.simulator.onInterrupt(&f.chip, [&f] {
+    f.simulator.scheduleIn(2000, [&f] {
+      const uint32_t before = sim::Bus::get(kTestI2CPort).transactions();
+      TEST_ASSERT_TRUE(f.dispatcher.service());
+      // One status read, one write to clear.
+      TEST_ASSERT_EQUAL(
+          2, sim::Bus::get(kTestI2CPort).transactions() - before);
+    });
+  });
+  f.simulator.runFor(10 * 60 * kMicrosPerSecond + kMicrosPerSecond);
+
+  TEST_ASSERT_EQUAL(20, f.fired.size());
+  for (size_t i = 0; i < f.fired.size(); i++) {
+    const bool a1 = i % 2 == 0;
+    const int64_t minute = (i + 1) / 2;
+    TEST_ASSERT_TRUE(f.fired[i].alarm ==
+                     (a1 ? DS3231::Alarm::A1 : DS3231::Alarm::A2));
+    // Timestamped by the ISR, not the worker.
+    TEST_ASSERT_EQUAL(minute * 60 * kMicrosPerSecond +
+                          (a1 ? 30 * kMicrosPerSecond : 0),
+                      f.fired[i].micros);
+  }
+  TEST_ASSERT_FALSE(f.dispatcher.pending());
+  TEST_ASSERT_EQUAL(0, f.dispatcher.overflows());
+}
+
+void test_alarm_dispatcher_coalesces_interrupts() {
+  Fixture f;
+  TEST_ASSERT_TRUE(f.dispatcher.begin());
+  // Nothing fired before begin().
+  TEST_ASSERT_TRUE(f.dispatcher.service());
+  TEST_ASSERT_FALSE(f.dispatcher.pending());
+  TEST_ASSERT_TRUE(f.dispatcher.service());
+  TEST_ASSERT_EQUAL(0, f.fired.size());
+
+  TEST_ASSERT_TRUE(f.rtc.setAlarm1(DateTime(2021, 3, 1, 0, 0, 5),
+                                   DS3231::Alarm1Mode::Date));
+  f.simulator.runFor(10 * kMicrosPerSecond);
+  // Spurious interrupts, more than the queue holds.
+  for (int i = 0; i < 20; i++)
+    f.source.trigger();
+  TEST_ASSERT_TRUE(f.dispatcher.pending());
+  TEST_ASSERT_EQUAL(20 + 1 - 8, f.dispatcher.overflows());
+
+  const uint32_t before = sim::Bus::get(kTestI2CPort).transactions();
+  TEST_ASSERT_TRUE(f.dispatcher.service());
+  TEST_ASSERT_EQUAL(2, sim::Bus::get(kTestI2CPort).transactions() - before);
+  TEST_ASSERT_EQUAL(1, f.fired.size());
+  TEST_ASSERT_EQUAL(5 * kMicrosPerSecond, f.fired[0].micros);
+  TEST_ASSERT_FALSE(f.chip.interrupt());
+}
+
+void test_alarm_dispatcher_retries_after_i2c_error() {
+  Fixture f;
+  TEST_ASSERT_TRUE(f.rtc.setAlarm1(DateTime(2021, 3, 1, 0, 0, 5),
+                                   DS3231::Alarm1Mode::Date));
+  // The alarm fires before begin(): INT is already asserted.
+  f.simulator.runFor(10 * kMicrosPerSecond);
+  TEST_ASSERT_TRUE(f.chip.interrupt());
+  TEST_ASSERT_TRUE(f.dispatcher.begin());
+  TEST_ASSERT_TRUE(f.dispatcher.pending());
+
+  sim::Bus::get(kTestI2CPort).detach(sim::DS3231::kAddress);
+  TEST_ASSERT_FALSE(f.dispatcher.service());
+  TEST_ASSERT_TRUE(f.dispatcher.pending());
+
+  sim::Bus::get(kTestI2CPort).attach(sim::DS3231::kAddress, &f.chip);
+  f.simulator.runFor(kMicrosPerSecond);
+  TEST_ASSERT_TRUE(f.dispatcher.service());
+  TEST_ASSERT_FALSE(f.dispatcher.pending());
+  TEST_ASSERT_EQUAL(1, f.fired.size());
+  TEST_ASSERT_TRUE(f.fired[0].alarm == DS3231::Alarm::A1);
+  // Timestamped when begin() queued the check.
+  TEST_ASSERT_EQUAL(10 * kMicrosPerSecond, f.fired[0].micros);
+}
+
+void test_alarm_dispatcher_handler_adds_handlers() {
+  Fixture f;
+  TEST_ASSERT_TRUE(
+      f.rtc.setAlarm2(DateTime(2000, 1, 1), DS3231::Alarm2Mode::EveryMinute));
+  TEST_ASSERT_TRUE(f.dispatcher.begin());
+  TEST_ASSERT_TRUE(f.dispatcher.service());
+
+  // Enough handlers to reallocate the dispatcher's, while the adding one is
+  // still running and uses its captures.
+  int added = 0;
+  int calls = 0;
+  std::vector<int> counts(16, 0);
+  f.dispatcher.addHandler(
+      DS3231::Alarm::A2, [&f, &added, &calls, &counts](DS3231::Alarm,
+                                                       int64_t) {
+        if (!added) {
+          for (int& count : counts) {
+            f.dispatcher.addHandler(DS3231::Alarm::A2,
+                                    [&count](DS3231::Alarm, int64_t) {
+                                      count++;
+                                    });
+          }
+          added = static_cast<int>(counts.size());
+        }
+        calls++;
+      });
+
+  f.simulator.runFor(60 * kMicrosPerSecond);
+  TEST_ASSERT_TRUE(f.dispatcher.service());
+  TEST_ASSERT_EQUAL(1, calls);
+  TEST_ASSERT_EQUAL(16, added);
+  // Added handlers first run on the next alarm.
+  TEST_ASSERT_EQUAL(0, counts[0]);
+
+  f.simulator.runFor(60 * kMicrosPerSecond);
+  TEST_ASSERT_TRUE(f.dispatcher.service());
+  TEST_ASSERT_EQUAL(2, calls);
+  for (int count : counts)
+    TEST_ASSERT_EQUAL(1, count);
+}
+
+void test_alarm_dispatcher_begin_twice() {
+  Fixture f;
+  TEST_ASSERT_TRUE(f.dispatcher.begin());
+  TEST_ASSERT_TRUE(f.dispatcher.service());
+
+  // The ISR is detached while the check is queued.
+  TEST_ASSERT_TRUE(f.dispatcher.begin());
+  TEST_ASSERT_FALSE(f.source.reattached());
+  TEST_ASSERT_TRUE(f.dispatcher.pending());
+  TEST_ASSERT_TRUE(f.dispatcher.service());
+  TEST_ASSERT_FALSE(f.dispatcher.pending());
+
+  TEST_ASSERT_TRUE(f.rtc.setAlarm1(DateTime(2021, 3, 1, 0, 0, 5),
+                                   DS3231::Alarm1Mode::Date));
+  f.simulator.runFor(10 * kMicrosPerSecond);
+  TEST_ASSERT_TRUE(f.dispatcher.service());
+  TEST_ASSERT_EQUAL(1, f.fired.size());
+  TEST_ASSERT_EQUAL(5 * kMicrosPerSecond, f.fired[0].micros);
+
+  f.dispatcher.end();
+  TEST_ASSERT_TRUE(f.dispatcher.begin());
+  TEST_ASSERT_FALSE(f.source.reattached());
+}
+
+}  // namespace
+
+void run_ds3231_alarm_dispatcher_tests() {
+  RUN_TEST(test_spsc_queue);
+  RUN_TEST(test_alarm_dispatcher_dispatches_alarms);
+  RUN_TEST(test_alarm_dispatcher_coalesces_interrupts);
+  RUN_TEST(test_alarm_dispatcher_retries_after_i2c_error);
+  RUN_TEST(test_alarm_dispatcher_handler_adds_handlers);
+  RUN_TEST(test_alarm_dispatcher_begin_twice);
+}
@@ -0,0 +1,232 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+#include <vector>
+
+#include <i2clib/master.h>
+#include <rtclib/datetime.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/ds3231_alarm_scheduler.h>
+#include "sim_ds3231.h"
+#include "sim_oscillator.h"
+#include "sim_simulator.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+constexpr int64_t kMicrosPerDay = 86400 * kMicrosPerSecond;
+
+const DateTime kStart(2021, 3, 1);
+
+/**
+ * A DS3231 in a simulation, with its INT output serviced by a scheduler.
+ */
+struct Fixture {
+  Fixture() : rtc(Master(kTestI2CPort, nullptr)), scheduler(&rtc) {
+    sim::Bus::get(kTestI2CPort).attach(sim::DS3231::kAddress, &chip);
+    simulator.addChip(&chip);
+    chip.setTime(kStart);
+    simulator.onInterrupt(&chip, [this] {
+      interrupts++;
+      TEST_ASSERT_TRUE(scheduler.service());
+    });
+    TEST_ASSERT_TRUE(scheduler.begin());
+  }
+
+  /**
+   * The time programmed into alarm 1, if enabled.
+   */
+  bool armedAlarm(uint8_t* day, uint8_t* hour, uint8_t* minute) {
+    if (!(chip.reg(0x0E) & 0x01))
+      return false;
+    *minute = sim::fromBcd(chip.reg(0x08));
+    *hour = sim::fromBcd(chip.reg(0x09));
+    *day = sim::fromBcd(chip.reg(0x0A));
+    return true;
+  }
+
+  DateTime chipTime() {
+    DateTime now;
+    rtc.now(&now);
+    return now;
+  }
+
+  sim::DS3231 chip;
+  sim::Simulator simulator;
+  DS3231 rtc;
+  DS3231AlarmScheduler scheduler;
+  int interrupts = 0;
+};
+
+void test_alarm_scheduler_fires_in_order() {
+  Fixture f;
+  sim::Random random(42);
+  constexpr int kNumAlarms = 200;
+  std::vector<uint32_t> fired;
+  int wrong_time = 0;
+  for (int i = 0; i < kNumAlarms; i++) {
+    // Within the next week, with some duplicate times.
+    const uint32_t when =
+        kStart.unixtime() + 60 + (random.next() % (7 * 86400)) / 60 * 60;
+    TEST_ASSERT_TRUE(f.scheduler.schedule(
+        DateTime(when),
+        [&f, &fired, &wrong_time, when](DS3231AlarmScheduler::AlarmId) {
+          if (f.chipTime().unixtime() != when)
+            wrong_time++;
+          fired.push_back(when);
+        },
+        nullptr));
+
+    // Alarm 1 always holds the earliest alarm.
+    DateTime earliest;
+    TEST_ASSERT_TRUE(f.scheduler.next(&earliest));
+    uint8_t day, hour, minute;
+    TEST_ASSERT_TRUE(f.armedAlarm(&day, &hour, &minute));
+    TEST_ASSERT_EQUAL_UINT8(earliest.day(), day);
+    TEST_ASSERT_EQUAL_UINT8(earliest.hour(), hour);
+    TEST_ASSERT_EQUAL_UINT8(earliest.minute(), minute);
+  }
+  TEST_ASSERT_EQUAL_UINT32(kNumAlarms, f.scheduler.size());
+
+  f.simulator.runFor(8 * kMicrosPerDay);
+  TEST_ASSERT_EQUAL_INT(kNumAlarms, fired.size());
+  TEST_ASSERT_EQUAL_INT(0, wrong_time);
+  for (size_t i = 1; i < fired.size(); i++)
+    TEST_ASSERT_TRUE(fired[i - 1] <= fired[i]);
+  // One interrupt per distinct time: duplicates are run together.
+  TEST_ASSERT_TRUE(f.interrupts <= kNumAlarms);
+  TEST_ASSERT_EQUAL_UINT32(0, f.scheduler.size());
+  uint8_t day, hour, minute;
+  TEST_ASSERT_FALSE(f.armedAlarm(&day, &hour, &minute));
+}
+
+void test_alarm_scheduler_cancel() {
+  Fixture f;
+  std::vector<int> fired;
+  DS3231AlarmScheduler::AlarmId ids[4];
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_TRUE(f.scheduler.schedule(
+        DateTime(kStart.unixtime() + 3600 * (i + 1)),
+        [&fired, i](DS3231AlarmScheduler::AlarmId) { fired.push_back(i); },
+        &ids[i]));
+  }
+
+  // Cancelling the armed alarm re-arms with the next.
+  TEST_ASSERT_TRUE(f.scheduler.cancel(ids[0]));
+  uint8_t day, hour, minute;
+  TEST_ASSERT_TRUE(f.armedAlarm(&day, &hour, &minute));
+  TEST_ASSERT_EQUAL_UINT8(2, hour);
+  TEST_ASSERT_TRUE(f.scheduler.cancel(ids[2]));
+  // Unknown and stale ids.
+  TEST_ASSERT_FALSE(f.scheduler.cancel(ids[0]));
+  TEST_ASSERT_FALSE(f.scheduler.cancel(0));
+  DS3231AlarmScheduler::AlarmId reused;
+  TEST_ASSERT_TRUE(f.scheduler.schedule(
+      DateTime(kStart.unixtime() + 7200),
+      [&fired](DS3231AlarmScheduler::AlarmId) { fired.push_back(10); },
+      &reused));
+  TEST_ASSERT_FALSE(reused == ids[0] || reused == ids[2]);
+  TEST_ASSERT_FALSE(f.scheduler.cancel(ids[2]));
+
+  f.simulator.runFor(kMicrosPerDay);
+  TEST_ASSERT_EQUAL_INT(3, fired.size());
+  TEST_ASSERT_EQUAL_INT(1, fired[0]);
+  TEST_ASSERT_EQUAL_INT(10, fired[1]);
+  TEST_ASSERT_EQUAL_INT(3, fired[2]);
+}
+
+void test_alarm_scheduler_many_alarms() {
+  Fixture f;
+  // More live alarms than a 16-bit slot index could hold. Each is later
+  // than the first, so the hardware is only armed once.
+  constexpr uint32_t kNumAlarms = 0x10002;
+  std::vector<DS3231AlarmScheduler::AlarmId> ids(kNumAlarms);
+  bool first_fired = false;
+  TEST_ASSERT_TRUE(f.scheduler.schedule(
+      DateTime(kStart.unixtime() + 60),
+      [&first_fired](DS3231AlarmScheduler::AlarmId) { first_fired = true; },
+      &ids[0]));
+  for (uint32_t i = 1; i < kNumAlarms; i++) {
+    TEST_ASSERT_TRUE(f.scheduler.schedule(
+        DateTime(kStart.unixtime() + 3600 + i),
+        [](DS3231AlarmScheduler::AlarmId) {}, &ids[i]));
+  }
+
+  // Cancelling the last alarms removes them, not the first.
+  for (uint32_t i = kNumAlarms - 2; i < kNumAlarms; i++) {
+    TEST_ASSERT_FALSE(ids[i] == ids[0]);
+    TEST_ASSERT_TRUE(f.scheduler.cancel(ids[i]));
+  }
+  TEST_ASSERT_EQUAL_UINT32(kNumAlarms - 2, f.scheduler.size());
+  DateTime next;
+  TEST_ASSERT_TRUE(f.scheduler.next(&next));
+  TEST_ASSERT_EQUAL_UINT32(kStart.unixtime() + 60, next.unixtime());
+  f.simulator.runFor(120 * kMicrosPerSecond);
+  TEST_ASSERT_TRUE(first_fired);
+}
+
+void test_alarm_scheduler_far_alarm() {
+  Fixture f;
+  // More than a month ahead: alarm 1 (date mode) wakes early on 2021-03-20
+  // and 2021-04-20, and the alarm only runs on 2021-05-20.
+  const DateTime when(2021, 5, 20, 8, 0, 0);
+  bool fired = false;
+  TEST_ASSERT_TRUE(f.scheduler.schedule(
+      when,
+      [&](DS3231AlarmScheduler::AlarmId) {
+        fired = true;
+        TEST_ASSERT_EQUAL_UINT32(when.unixtime(), f.chipTime().unixtime());
+      },
+      nullptr));
+  f.simulator.runFor(100 * kMicrosPerDay);
+  TEST_ASSERT_TRUE(fired);
+  TEST_ASSERT_EQUAL_INT(3, f.interrupts);
+}
+
+void test_alarm_scheduler_reentrant() {
+  Fixture f;
+  // A callback rescheduling itself, making a periodic alarm.
+  int count = 0;
+  DS3231AlarmScheduler::Callback tick;
+  tick = [&](DS3231AlarmScheduler::AlarmId) {
+    count++;
+    if (count < 10) {
+      f.scheduler.schedule(DateTime(f.chipTime().unixtime() + 90), tick,
+                           nullptr);
+    }
+  };
+  TEST_ASSERT_TRUE(
+      f.scheduler.schedule(DateTime(kStart.unixtime() + 90), tick, nullptr));
+
+  // Already due: runs immediately.
+  bool past = false;
+  TEST_ASSERT_TRUE(f.scheduler.schedule(
+      DateTime(kStart.unixtime() - 10),
+      [&](DS3231AlarmScheduler::AlarmId) { past = true; }, nullptr));
+  TEST_ASSERT_TRUE(past);
+
+  f.simulator.runFor(kMicrosPerDay);
+  TEST_ASSERT_EQUAL_INT(10, count);
+  TEST_ASSERT_EQUAL_INT(10, f.interrupts);
+}
+
+}  // namespace
+
+void run_ds3231_alarm_scheduler_tests() {
+  RUN_TEST(test_alarm_scheduler_fires_in_order);
+  RUN_TEST(test_alarm_scheduler_cancel);
+  RUN_TEST(test_alarm_scheduler_many_alarms);
+  RUN_TEST(test_alarm_scheduler_far_alarm);
+  RUN_TEST(test_alarm_scheduler_reentrant);
+}
@@ -0,0 +1,199 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <i2clib/master.h>
+#include <rtclib/datetime.h>
+#include <rtclib/ds1307.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/ensemble_clock.h>
+#include <rtclib/pcf8523.h>
+#include <rtclib/system_clock.h>
+#include "sim_ds1307.h"
+#include "sim_ds3231.h"
+#include "sim_pcf8523.h"
+#include "sim_simulator.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+constexpr int64_t kMicrosPerHour = 3600 * kMicrosPerSecond;
+
+/**
+ * A source reading the SystemClock, plus an offset, as a unix time.
+ */
+struct FakeRtc {
+  bool now(DateTime* dt) {
+    if (fail)
+      return false;
+    *dt = DateTime(static_cast<uint32_t>(
+        (epoch + SystemClock::microsSinceStart() + offset) /
+        kMicrosPerSecond));
+    return true;
+  }
+
+  int64_t epoch = static_cast<int64_t>(DateTime(2021, 3, 1).unixtime()) *
+                  kMicrosPerSecond;
+  int64_t offset = 0;
+  bool fail = false;
+};
+
+void test_ensemble_clock_rejects_outlier() {
+  SystemClock::setMicrosSinceStart(250000);
+  FakeRtc a, b, c;
+  c.offset = kMicrosPerHour;
+  EnsembleClock ensemble;
+  TEST_ASSERT_TRUE(ensemble.addRtc(&a));
+  TEST_ASSERT_TRUE(ensemble.addRtc(&b));
+  TEST_ASSERT_TRUE(ensemble.addRtc(&c));
+  TEST_ASSERT_EQUAL(3, ensemble.numSources());
+
+  // To within the half second of RTC resolution.
+  int64_t micros;
+  TEST_ASSERT_TRUE(ensemble.nowMicros(&micros));
+  TEST_ASSERT_INT64_WITHIN(500000,
+                           a.epoch + SystemClock::microsSinceStart(), micros);
+  TEST_ASSERT_TRUE(ensemble.stats(0).accepted);
+  TEST_ASSERT_TRUE(ensemble.stats(1).accepted);
+  TEST_ASSERT_FALSE(ensemble.stats(2).accepted);
+  TEST_ASSERT_EQUAL(1, ensemble.stats(2).rejections);
+  TEST_ASSERT_EQUAL_FLOAT(0.5f, ensemble.stats(0).weight);
+  TEST_ASSERT_EQUAL_FLOAT(0, ensemble.stats(2).weight);
+
+  DateTime now;
+  TEST_ASSERT_TRUE(ensemble.now(&now));
+  TEST_ASSERT_EQUAL(DateTime(2021, 3, 1).unixtime(), now.unixtime());
+
+  // A failed source is skipped.
+  a.fail = true;
+  TEST_ASSERT_TRUE(ensemble.nowMicros(&micros));
+  TEST_ASSERT_EQUAL(1, ensemble.stats(0).failures);
+  TEST_ASSERT_FALSE(ensemble.stats(0).accepted);
+
+  b.fail = true;
+  c.fail = true;
+  TEST_ASSERT_FALSE(ensemble.nowMicros(&micros));
+
+  FakeRtc d, e;
+  TEST_ASSERT_TRUE(ensemble.addRtc(&d));
+  TEST_ASSERT_FALSE(ensemble.addRtc(&e));
+}
+
+void test_ensemble_clock_trusts_most_stable() {
+  SystemClock::setMicrosSinceStart(0);
+  FakeRtc good, bad;
+  EnsembleClock ensemble;
+  ensemble.addRtc(&good);
+  ensemble.addRtc(&bad);
+
+  // While they agree, each has an equal say.
+  int64_t micros;
+  for (int i = 0; i < 10; i++) {
+    SystemClock::advanceMicros(kMicrosPerSecond);
+    TEST_ASSERT_TRUE(ensemble.nowMicros(&micros));
+  }
+  TEST_ASSERT_EQUAL_FLOAT(0.5f, ensemble.stats(1).weight);
+
+  // Two which disagree can't be told apart by voting, so the one with the
+  // better record is trusted. The one which started to drift first has
+  // already lost weight.
+  bad.offset = kMicrosPerSecond;
+  SystemClock::advanceMicros(kMicrosPerSecond);
+  TEST_ASSERT_TRUE(ensemble.nowMicros(&micros));
+  TEST_ASSERT_LESS_THAN(0.5f, ensemble.stats(1).weight);
+  TEST_ASSERT_GREATER_THAN(0.5f, ensemble.stats(0).weight);
+
+  bad.offset = 10 * kMicrosPerSecond;
+  for (int i = 0; i < 3; i++) {
+    SystemClock::advanceMicros(kMicrosPerSecond);
+    TEST_ASSERT_TRUE(ensemble.nowMicros(&micros));
+  }
+  TEST_ASSERT_TRUE(ensemble.stats(0).accepted);
+  TEST_ASSERT_FALSE(ensemble.stats(1).accepted);
+  TEST_ASSERT_INT64_WITHIN(500000,
+                           good.epoch + SystemClock::microsSinceStart(),
+                           micros);
+}
+
+void test_ensemble_clock_drifting_chip() {
+  // Three RTCs, one with a bad crystal: 300 ppm is 26 seconds a day.
+  sim::DS1307 ds1307_chip(5);
+  sim::DS3231 ds3231_chip(-2);
+  sim::PCF8523 pcf8523_chip(300);
+  sim::Bus::get(kTestI2CPort).attach(sim::DS1307::kAddress, &ds1307_chip);
+  sim::Bus::get(kTestI2CPort + 1).attach(sim::DS3231::kAddress, &ds3231_chip);
+  sim::Bus::get(kTestI2CPort + 2)
+      .attach(sim::PCF8523::kAddress, &pcf8523_chip);
+  DS1307 ds1307(Master(kTestI2CPort, nullptr));
+  DS3231 ds3231(Master(kTestI2CPort + 1, nullptr));
+  PCF8523 pcf8523(Master(kTestI2CPort + 2, nullptr));
+  sim::Simulator simulator;
+  simulator.addChip(&ds1307_chip);
+  simulator.addChip(&ds3231_chip);
+  simulator.addChip(&pcf8523_chip);
+
+  const DateTime start(2021, 3, 1);
+  TEST_ASSERT_TRUE(ds1307.adjust(start));
+  TEST_ASSERT_TRUE(ds3231.adjust(start));
+  TEST_ASSERT_TRUE(pcf8523.adjust(start));
+  const int64_t epoch =
+      static_cast<int64_t>(start.unixtime()) * kMicrosPerSecond -
+      SystemClock::microsSinceStart();
+
+  EnsembleClock ensemble;
+  ensemble.addRtc(&ds1307);
+  ensemble.addRtc(&ds3231);
+  ensemble.addRtc(&pcf8523);
+
+  // Every ten minutes for a day.
+  int64_t max_error = 0;
+  bool read_failed = false;
+  simulator.scheduleEvery(600 * kMicrosPerSecond, [&] {
+    int64_t micros;
+    if (!ensemble.nowMicros(&micros)) {
+      read_failed = true;
+      return;
+    }
+    const int64_t error =
+        std::llabs(micros - (epoch + SystemClock::microsSinceStart()));
+    if (error > max_error)
+      max_error = error;
+  });
+  simulator.runFor(24 * kMicrosPerHour);
+
+  TEST_ASSERT_FALSE(read_failed);
+  TEST_ASSERT_LESS_THAN(kMicrosPerSecond, max_error);
+  TEST_ASSERT_FALSE(ensemble.stats(2).accepted);
+  TEST_ASSERT_GREATER_THAN(100, ensemble.stats(2).rejections);
+  TEST_ASSERT_EQUAL(0, ensemble.stats(0).rejections);
+  TEST_ASSERT_EQUAL(0, ensemble.stats(1).rejections);
+
+  // Losing a second chip degrades to the last.
+  sim::Bus::get(kTestI2CPort).detach(sim::DS1307::kAddress);
+  int64_t micros;
+  TEST_ASSERT_TRUE(ensemble.nowMicros(&micros));
+  TEST_ASSERT_TRUE(ensemble.stats(1).accepted);
+  TEST_ASSERT_EQUAL_FLOAT(1, ensemble.stats(1).weight);
+  TEST_ASSERT_INT64_WITHIN(kMicrosPerSecond,
+                           epoch + SystemClock::microsSinceStart(), micros);
+}
+
+}  // namespace
+
+void run_ensemble_clock_tests() {
+  RUN_TEST(test_ensemble_clock_rejects_outlier);
+  RUN_TEST(test_ensemble_clock_trusts_most_stable);
+  RUN_TEST(test_ensemble_clock_drifting_chip);
+}
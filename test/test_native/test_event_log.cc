@@ -0,0 +1,169 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <rtclib/at24c32.h>
+#include <rtclib/datetime.h>
+#include <rtclib/event_log.h>
+#include "sim_at24c32.h"
+#include "tests.h"
+
+using namespace rtc;
+
+namespace {
+
+const DateTime kStart(2021, 3, 1, 12, 0, 0);
+
+struct Decoded {
+  uint32_t time;
+  std::vector<uint8_t> data;
+};
+
+/**
+ * An AT24C32 on the test bus.
+ */
+struct Fixture : sim::AT24C32Fixture {
+  Fixture() : sim::AT24C32Fixture(kTestI2CPort) {}
+
+  std::vector<Decoded> decode(EventLog* log) {
+    std::vector<Decoded> events;
+    log->forEach([&events](const EventLog::Event& event) {
+      events.push_back({event.time.unixtime(),
+                        std::vector<uint8_t>(event.data,
+                                             event.data + event.length)});
+    });
+    return events;
+  }
+};
+
+void test_event_log_round_trip() {
+  Fixture f;
+  EventLog log(&f.eeprom);
+  TEST_ASSERT_TRUE(log.begin());
+  TEST_ASSERT_TRUE(log.empty());
+
+  // Deltas of one, two and three varint bytes, and an empty payload.
+  const uint32_t offsets[] = {0, 1, 5, 300, 100000, 100000};
+  const uint32_t start = kStart.unixtime();
+  for (size_t i = 0; i < 6; i++) {
+    const uint8_t payload[] = {static_cast<uint8_t>(i), 0xAB};
+    TEST_ASSERT_TRUE(log.append(DateTime(start + offsets[i]), payload,
+                                i == 5 ? 0 : sizeof(payload)));
+  }
+  // Eight byte header, and records of 5, 5, 5, 6, 7 and 3 bytes.
+  TEST_ASSERT_EQUAL(0xFF, f.chip.byte(8 + 5 + 5 + 5 + 6 + 7 + 3));
+  TEST_ASSERT_EQUAL(0, f.chip.byte(EventLog::kBlockSize));
+
+  EventLog reloaded(&f.eeprom);
+  TEST_ASSERT_TRUE(reloaded.begin());
+  TEST_ASSERT_FALSE(reloaded.empty());
+  const std::vector<Decoded> events = f.decode(&reloaded);
+  TEST_ASSERT_EQUAL(6, events.size());
+  for (size_t i = 0; i < events.size(); i++) {
+    TEST_ASSERT_EQUAL(start + offsets[i], events[i].time);
+    TEST_ASSERT_EQUAL(i == 5 ? 0 : 2, events[i].data.size());
+    if (i < 5)
+      TEST_ASSERT_EQUAL(i, events[i].data[0]);
+  }
+
+  // Oversized payloads are refused.
+  const uint8_t big[EventLog::kMaxPayloadSize + 1] = {};
+  TEST_ASSERT_FALSE(reloaded.append(DateTime(start + 200000), big,
+                                    sizeof(big)));
+}
+
+void test_event_log_wraps_and_recovers_head() {
+  Fixture f;
+  EventLog log(&f.eeprom);
+  TEST_ASSERT_TRUE(log.begin());
+  // Seven byte records, eight to a block: almost two laps of 64 blocks.
+  constexpr uint32_t kEvents = 1000;
+  const uint32_t start = kStart.unixtime();
+  for (uint32_t i = 0; i < kEvents; i++)
+    TEST_ASSERT_TRUE(log.append(DateTime(start + 10 * i), &i, sizeof(i)));
+
+  // A binary search of the headers, then one read of the newest block.
+  TEST_ASSERT_TRUE(f.eeprom.waitReady());
+  const uint32_t before = f.transactions();
+  EventLog reloaded(&f.eeprom);
+  TEST_ASSERT_TRUE(reloaded.begin());
+  TEST_ASSERT_EQUAL(1 + 6 + 1, f.transactions() - before);
+
+  const uint32_t next = kEvents;
+  TEST_ASSERT_TRUE(
+      reloaded.append(DateTime(start + 10 * next), &next, sizeof(next)));
+  const std::vector<Decoded> events = f.decode(&reloaded);
+  // 63 whole blocks and the newest, holding events 1000 % 8 and one more.
+  TEST_ASSERT_EQUAL(63 * 8 + 1000 % 8 + 1, events.size());
+  const uint32_t first = kEvents + 1 - events.size();
+  for (uint32_t i = 0; i < events.size(); i++) {
+    uint32_t value;
+    TEST_ASSERT_EQUAL(sizeof(value), events[i].data.size());
+    std::memcpy(&value, events[i].data.data(), sizeof(value));
+    TEST_ASSERT_EQUAL(first + i, value);
+    TEST_ASSERT_EQUAL(start + 10 * value, events[i].time);
+  }
+}
+
+void test_event_log_recovers_torn_writes() {
+  Fixture f;
+  // A small log of four blocks after the first 64 bytes.
+  EventLog log(&f.eeprom, 64, 4 * EventLog::kBlockSize);
+  TEST_ASSERT_TRUE(log.begin());
+  const uint32_t start = kStart.unixtime();
+  for (uint32_t i = 0; i < 32; i++)
+    TEST_ASSERT_TRUE(log.append(DateTime(start + i), &i, sizeof(i)));
+
+  // The last record (bytes 57..63 of block 3) was torn.
+  f.chip.byte(64 + 3 * EventLog::kBlockSize + 63) ^= 1;
+  EventLog reloaded(&f.eeprom, 64, 4 * EventLog::kBlockSize);
+  TEST_ASSERT_TRUE(reloaded.begin());
+  TEST_ASSERT_EQUAL(31, f.decode(&reloaded).size());
+  uint32_t value = 99;
+  TEST_ASSERT_TRUE(reloaded.append(DateTime(start + 99), &value, 4));
+  std::vector<Decoded> events = f.decode(&reloaded);
+  TEST_ASSERT_EQUAL(32, events.size());
+  TEST_ASSERT_EQUAL(start + 99, events.back().time);
+
+  // A torn header while starting block 0 on the next lap.
+  value = 100;
+  TEST_ASSERT_TRUE(reloaded.append(DateTime(start + 100), &value, 4));
+  f.chip.byte(64 + 3) ^= 1;
+  EventLog recovered(&f.eeprom, 64, 4 * EventLog::kBlockSize);
+  TEST_ASSERT_TRUE(recovered.begin());
+  events = f.decode(&recovered);
+  TEST_ASSERT_EQUAL(24, events.size());
+  TEST_ASSERT_EQUAL(start + 99, events.back().time);
+
+  // Time going backwards starts a block with an absolute time.
+  TEST_ASSERT_TRUE(recovered.append(DateTime(start - 3600), &value, 4));
+  events = f.decode(&recovered);
+  TEST_ASSERT_EQUAL(start - 3600, events.back().time);
+
+  TEST_ASSERT_TRUE(recovered.clear());
+  TEST_ASSERT_TRUE(recovered.empty());
+  EventLog cleared(&f.eeprom, 64, 4 * EventLog::kBlockSize);
+  TEST_ASSERT_TRUE(cleared.begin());
+  TEST_ASSERT_TRUE(cleared.empty());
+  TEST_ASSERT_EQUAL(0, f.decode(&cleared).size());
+  // The bytes before the log are untouched.
+  for (uint16_t i = 0; i < 64; i++)
+    TEST_ASSERT_EQUAL(0, f.chip.byte(i));
+}
+
+}  // namespace
+
+void run_event_log_tests() {
+  RUN_TEST(test_event_log_round_trip);
+  RUN_TEST(test_event_log_wraps_and_recovers_head);
+  RUN_TEST(test_event_log_recovers_torn_writes);
+}
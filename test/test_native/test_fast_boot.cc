@@ -0,0 +1,133 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+
+#include <i2clib/master.h>
+#include <rtclib/at24c32.h>
+#include <rtclib/datetime.h>
+#include <rtclib/ds1307.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/fast_boot.h>
+#include <rtclib/micros.h>
+#include <rtclib/software_clock.h>
+#include <rtclib/sync_state.h>
+#include "sim_at24c32.h"
+#include "sim_ds1307.h"
+#include "sim_ds3231.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+const DateTime kTime(2021, 3, 1, 12, 34, 56);
+
+uint32_t transactions() {
+  return sim::Bus::get(kTestI2CPort).transactions();
+}
+
+void test_fast_boot_ds1307() {
+  sim::Attached<sim::DS1307> chip(kTestI2CPort);
+  DS1307 rtc(Master(kTestI2CPort, nullptr));
+  DS1307Nvram nvram(&rtc);
+  SoftwareClock* clock = Micros::softwareClock();
+  Micros::adjustDriftPpb(0);
+
+  // A halted clock, with nothing saved.
+  SyncState state;
+  FastBoot::Status status;
+  TEST_ASSERT_TRUE(FastBoot::restore(&rtc, 0, clock, &state, &status));
+  TEST_ASSERT_TRUE(status == FastBoot::Status::LostPower);
+
+  TEST_ASSERT_TRUE(rtc.adjust(kTime));
+  TEST_ASSERT_TRUE(FastBoot::restore(&rtc, 0, clock, &state, &status));
+  TEST_ASSERT_TRUE(status == FastBoot::Status::NoSyncState);
+  TEST_ASSERT_EQUAL(kTime.unixtime(), Micros::now().unixtime());
+  TEST_ASSERT_EQUAL(0, Micros::driftPpb());
+
+  SyncState saved;
+  saved.last_sync = kTime.unixtime() - 3600;
+  saved.drift_ppb = -12345;
+  TEST_ASSERT_TRUE(SyncStateStore(&nvram, 4).save(saved));
+
+  // Everything in a single transaction.
+  Micros::adjust(DateTime(2000, 1, 1));
+  const uint32_t before = transactions();
+  TEST_ASSERT_TRUE(FastBoot::restore(&rtc, 4, clock, &state, &status));
+  TEST_ASSERT_EQUAL(1, transactions() - before);
+  TEST_ASSERT_TRUE(status == FastBoot::Status::Restored);
+  TEST_ASSERT_EQUAL(saved.last_sync, state.last_sync);
+  TEST_ASSERT_EQUAL(saved.drift_ppb, state.drift_ppb);
+  TEST_ASSERT_EQUAL(kTime.unixtime(), Micros::now().unixtime());
+  TEST_ASSERT_EQUAL(-12345, Micros::driftPpb());
+
+  // A corrupt state is ignored.
+  chip.reg(0x08 + 4 + 2) ^= 1;
+  TEST_ASSERT_TRUE(FastBoot::restore(&rtc, 4, clock, &state, &status));
+  TEST_ASSERT_TRUE(status == FastBoot::Status::NoSyncState);
+  Micros::adjustDriftPpb(0);
+}
+
+void test_fast_boot_ds3231() {
+  sim::Attached<sim::DS3231> chip(kTestI2CPort);
+  sim::Attached<sim::AT24C32> eeprom_chip(kTestI2CPort);
+  DS3231 rtc(Master(kTestI2CPort, nullptr));
+  AT24C32 eeprom(Master(kTestI2CPort, nullptr));
+  SoftwareClock* clock = Micros::softwareClock();
+  Micros::adjustDriftPpb(0);
+
+  TEST_ASSERT_TRUE(rtc.adjust(kTime));
+  TEST_ASSERT_TRUE(rtc.setAgingOffset(-20));
+  SyncState saved;
+  saved.last_sync = kTime.unixtime();
+  saved.drift_ppb = 2500;
+  saved.calibration = -20;
+  TEST_ASSERT_TRUE(SyncStateStore(&eeprom, 0x100).save(saved));
+  TEST_ASSERT_TRUE(eeprom.waitReady());
+
+  // The RTC, then the state.
+  SyncState state;
+  FastBoot::Status status;
+  uint32_t before = transactions();
+  TEST_ASSERT_TRUE(
+      FastBoot::restore(&rtc, &eeprom, 0x100, clock, &state, &status));
+  TEST_ASSERT_EQUAL(2, transactions() - before);
+  TEST_ASSERT_TRUE(status == FastBoot::Status::Restored);
+  TEST_ASSERT_EQUAL(kTime.unixtime(), Micros::now().unixtime());
+  TEST_ASSERT_EQUAL(2500, Micros::driftPpb());
+
+  // A power loss resets the aging offset, which is restored.
+  chip.reg(0x0F) |= 0x80;
+  chip.reg(0x10) = 0;
+  Micros::adjust(DateTime(2000, 1, 1));
+  before = transactions();
+  TEST_ASSERT_TRUE(
+      FastBoot::restore(&rtc, &eeprom, 0x100, clock, &state, &status));
+  TEST_ASSERT_EQUAL(3, transactions() - before);
+  TEST_ASSERT_TRUE(status == FastBoot::Status::LostPower);
+  TEST_ASSERT_EQUAL(DateTime(2000, 1, 1).unixtime(),
+                    Micros::now().unixtime());
+  int8_t aging_offset = 0;
+  TEST_ASSERT_TRUE(rtc.getAgingOffset(&aging_offset));
+  TEST_ASSERT_EQUAL(-20, aging_offset);
+
+  sim::Bus::get(kTestI2CPort).detach(sim::AT24C32::kAddress);
+  TEST_ASSERT_FALSE(
+      FastBoot::restore(&rtc, &eeprom, 0x100, clock, &state, &status));
+  Micros::adjustDriftPpb(0);
+}
+
+}  // namespace
+
+void run_fast_boot_tests() {
+  RUN_TEST(test_fast_boot_ds1307);
+  RUN_TEST(test_fast_boot_ds3231);
+}
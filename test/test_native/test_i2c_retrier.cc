@@ -0,0 +1,181 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+
+#include <i2clib/master.h>
+#include <rtclib/datetime.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/i2c_retrier.h>
+#include <rtclib/system_clock.h>
+#include "sim_ds3231.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+sim::Bus& bus() {
+  return sim::Bus::get(kTestI2CPort);
+}
+
+/**
+ * A DS3231 on the test bus, with a retrier.
+ */
+struct Fixture {
+  explicit Fixture(const I2CRetrier::Config& config)
+      : rtc(Master(kTestI2CPort, nullptr)),
+        retrier(Master(kTestI2CPort, nullptr),
+                sim::DS3231::kAddress,
+                config) {
+    bus().attach(sim::DS3231::kAddress, &chip);
+  }
+
+  bool now() {
+    return retrier.run([this] { return rtc.now(&time); });
+  }
+
+  sim::DS3231 chip;
+  DS3231 rtc;
+  I2CRetrier retrier;
+  DateTime time;
+};
+
+void test_i2c_retrier_transient_faults() {
+  Fixture f{I2CRetrier::Config()};
+
+  // Two NACKs, then success after backing off 500 and 1000 µs.
+  bus().injectFaults(sim::DS3231::kAddress, 2);
+  const int64_t start = SystemClock::microsSinceStart();
+  TEST_ASSERT_TRUE(f.now());
+  TEST_ASSERT_EQUAL(1500, SystemClock::microsSinceStart() - start);
+  TEST_ASSERT_TRUE(f.retrier.lastFault() == I2CRetrier::Fault::None);
+  const I2CRetrier::Metrics& metrics = f.retrier.metrics();
+  TEST_ASSERT_EQUAL(1, metrics.operations);
+  TEST_ASSERT_EQUAL(0, metrics.failures);
+  TEST_ASSERT_EQUAL(3, metrics.attempts);
+  TEST_ASSERT_EQUAL(2, metrics.retries);
+  TEST_ASSERT_EQUAL(2, metrics.transient);
+  TEST_ASSERT_EQUAL(0, metrics.absent);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 2.0f / 3, metrics.errorRate());
+
+  // Too many: gives up after max_attempts.
+  bus().injectFaults(sim::DS3231::kAddress, 5);
+  TEST_ASSERT_FALSE(f.now());
+  TEST_ASSERT_TRUE(f.retrier.lastFault() == I2CRetrier::Fault::Transient);
+  TEST_ASSERT_EQUAL(2, metrics.operations);
+  TEST_ASSERT_EQUAL(1, metrics.failures);
+  TEST_ASSERT_EQUAL(6, metrics.attempts);
+
+  f.retrier.resetMetrics();
+  TEST_ASSERT_EQUAL(0, f.retrier.metrics().attempts);
+  TEST_ASSERT_EQUAL(0, f.retrier.metrics().errorRate());
+}
+
+void test_i2c_retrier_backoff_limit() {
+  I2CRetrier::Config config;
+  config.max_attempts = 5;
+  config.initial_backoff = 300;
+  config.max_backoff = 1000;
+  Fixture f(config);
+
+  bus().injectFaults(sim::DS3231::kAddress, 10);
+  const int64_t start = SystemClock::microsSinceStart();
+  TEST_ASSERT_FALSE(f.now());
+  TEST_ASSERT_EQUAL(300 + 600 + 1000 + 1000,
+                    SystemClock::microsSinceStart() - start);
+  TEST_ASSERT_EQUAL(5, f.retrier.metrics().attempts);
+}
+
+void test_i2c_retrier_absent_device() {
+  Fixture f{I2CRetrier::Config()};
+
+  // Not retried.
+  bus().detach(sim::DS3231::kAddress);
+  const int64_t start = SystemClock::microsSinceStart();
+  TEST_ASSERT_FALSE(f.now());
+  TEST_ASSERT_EQUAL(0, SystemClock::microsSinceStart() - start);
+  TEST_ASSERT_TRUE(f.retrier.lastFault() == I2CRetrier::Fault::Absent);
+  TEST_ASSERT_EQUAL(1, f.retrier.metrics().attempts);
+  TEST_ASSERT_EQUAL(1, f.retrier.metrics().absent);
+  TEST_ASSERT_EQUAL(1, f.retrier.metrics().failures);
+
+  bus().attach(sim::DS3231::kAddress, &f.chip);
+  TEST_ASSERT_TRUE(f.now());
+}
+
+void test_i2c_retrier_bus_clear() {
+  int clears = 0;
+  I2CRetrier::Config config;
+  config.bus_clear = [&clears] {
+    clears++;
+    bus().setStuck(false);
+    return true;
+  };
+  Fixture f(config);
+
+  bus().setStuck(true);
+  TEST_ASSERT_TRUE(f.now());
+  TEST_ASSERT_EQUAL(1, clears);
+  TEST_ASSERT_EQUAL(1, f.retrier.metrics().recoveries);
+  TEST_ASSERT_EQUAL(1, f.retrier.metrics().transient);
+  TEST_ASSERT_EQUAL(2, f.retrier.metrics().attempts);
+
+  // A bus clear which doesn't bring the device back.
+  bus().detach(sim::DS3231::kAddress);
+  TEST_ASSERT_FALSE(f.now());
+  TEST_ASSERT_EQUAL(2, clears);
+  TEST_ASSERT_TRUE(f.retrier.lastFault() == I2CRetrier::Fault::Absent);
+  TEST_ASSERT_EQUAL(1, f.retrier.metrics().recoveries);
+}
+
+void test_ds3231_lost_power_read_failure() {
+  sim::DS3231 chip;
+  bus().attach(sim::DS3231::kAddress, &chip);
+  DS3231 rtc(Master(kTestI2CPort, nullptr));
+  TEST_ASSERT_TRUE(rtc.adjust(DateTime(2021, 3, 1)));
+
+  bool lost_power = true;
+  TEST_ASSERT_TRUE(rtc.lostPower(&lost_power));
+  TEST_ASSERT_FALSE(lost_power);
+
+  // The legacy call can't report the failure.
+  bus().injectFaults(sim::DS3231::kAddress, 2);
+  TEST_ASSERT_FALSE(rtc.lostPower(&lost_power));
+  TEST_ASSERT_TRUE(rtc.lostPower());
+  TEST_ASSERT_FALSE(rtc.lostPower());
+}
+
+void test_ds3231_set_alarm_read_failure() {
+  sim::DS3231 chip;
+  bus().attach(sim::DS3231::kAddress, &chip);
+  DS3231 rtc(Master(kTestI2CPort, nullptr));
+  const DateTime alarm(2021, 3, 1, 12, 30, 15);
+
+  // A failed control read must not be taken as INTCN set.
+  bus().injectFaults(sim::DS3231::kAddress, 1);
+  TEST_ASSERT_FALSE(rtc.setAlarm1(alarm, DS3231::Alarm1Mode::Second));
+  bus().injectFaults(sim::DS3231::kAddress, 1);
+  TEST_ASSERT_FALSE(rtc.setAlarm2(alarm, DS3231::Alarm2Mode::Minute));
+
+  TEST_ASSERT_TRUE(rtc.setAlarm1(alarm, DS3231::Alarm1Mode::Second));
+  TEST_ASSERT_TRUE(rtc.setAlarm2(alarm, DS3231::Alarm2Mode::Minute));
+}
+
+}  // namespace
+
+void run_i2c_retrier_tests() {
+  RUN_TEST(test_i2c_retrier_transient_faults);
+  RUN_TEST(test_i2c_retrier_backoff_limit);
+  RUN_TEST(test_i2c_retrier_absent_device);
+  RUN_TEST(test_i2c_retrier_bus_clear);
+  RUN_TEST(test_ds3231_lost_power_read_failure);
+  RUN_TEST(test_ds3231_set_alarm_read_failure);
+}
@@ -0,0 +1,148 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include <i2clib/master.h>
+#include <rtclib/at24c32.h>
+#include <rtclib/datetime.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/instrumentation.h>
+#include "sim_at24c32.h"
+#include "sim_ds3231.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+#if defined(RTC_INSTRUMENTATION)
+
+const OpStats* find(const OpStats* stats,
+                    size_t count,
+                    uint8_t address,
+                    const char* name) {
+  for (size_t i = 0; i < count; i++) {
+    if (stats[i].address == address && !strcmp(stats[i].name, name))
+      return &stats[i];
+  }
+  return nullptr;
+}
+
+void test_instrumentation_record() {
+  TEST_ASSERT_EQUAL(0, OpStats::bucket(0));
+  TEST_ASSERT_EQUAL(0, OpStats::bucket(1));
+  TEST_ASSERT_EQUAL(1, OpStats::bucket(2));
+  TEST_ASSERT_EQUAL(1, OpStats::bucket(3));
+  TEST_ASSERT_EQUAL(6, OpStats::bucket(100));
+  TEST_ASSERT_EQUAL(OpStats::kNumBuckets - 1, OpStats::bucket(INT64_MAX));
+
+  Instrumentation::reset();
+  Instrumentation::record(0x10, "op", true, 4, 100);
+  Instrumentation::record(0x10, "op", false, 0, 1000);
+  Instrumentation::record(0x11, "op", true, 2, 1);
+
+  OpStats stats[4];
+  TEST_ASSERT_EQUAL(2, Instrumentation::snapshot(stats, 4));
+  TEST_ASSERT_EQUAL(0x10, stats[0].address);
+  TEST_ASSERT_EQUAL_STRING("op", stats[0].name);
+  TEST_ASSERT_EQUAL(2, stats[0].calls);
+  TEST_ASSERT_EQUAL(1, stats[0].failures);
+  TEST_ASSERT_EQUAL(4, stats[0].bytes);
+  TEST_ASSERT_EQUAL(1100, stats[0].total_micros);
+  TEST_ASSERT_EQUAL(1000, stats[0].max_micros);
+  TEST_ASSERT_EQUAL(1, stats[0].histogram[6]);
+  TEST_ASSERT_EQUAL(1, stats[0].histogram[9]);
+  TEST_ASSERT_EQUAL(0x11, stats[1].address);
+  TEST_ASSERT_EQUAL(1, stats[1].histogram[0]);
+
+  // Only as many as asked for.
+  TEST_ASSERT_EQUAL(1, Instrumentation::snapshot(stats, 1));
+
+  Instrumentation::reset();
+  TEST_ASSERT_EQUAL(0, Instrumentation::snapshot(stats, 4));
+}
+
+void test_instrumentation_drivers() {
+  sim::Attached<sim::DS3231> chip(kTestI2CPort);
+  sim::Attached<sim::AT24C32> eeprom_chip(kTestI2CPort);
+  DS3231 rtc(Master(kTestI2CPort, nullptr));
+  AT24C32 eeprom(Master(kTestI2CPort, nullptr));
+  TEST_ASSERT_TRUE(rtc.adjust(DateTime(2021, 3, 1, 12, 34, 56)));
+  Instrumentation::reset();
+
+  DateTime now;
+  TEST_ASSERT_TRUE(rtc.now(&now));
+  TEST_ASSERT_TRUE(rtc.now(&now));
+  TEST_ASSERT_FALSE(rtc.lostPower());
+  sim::Bus::get(kTestI2CPort).detach(sim::DS3231::kAddress);
+  TEST_ASSERT_FALSE(rtc.now(&now));
+
+  // The write cycle is waited out by polling, 100 µs per attempt.
+  const uint8_t data[3] = {1, 2, 3};
+  TEST_ASSERT_TRUE(eeprom.write(0x123, data, sizeof(data)));
+  TEST_ASSERT_TRUE(eeprom.waitReady());
+
+  OpStats stats[Instrumentation::kMaxOps];
+  const size_t count =
+      Instrumentation::snapshot(stats, Instrumentation::kMaxOps);
+
+  const OpStats* op = find(stats, count, sim::DS3231::kAddress, "now");
+  TEST_ASSERT_NOT_NULL(op);
+  TEST_ASSERT_EQUAL(3, op->calls);
+  TEST_ASSERT_EQUAL(1, op->failures);
+  TEST_ASSERT_EQUAL(21, op->bytes);
+
+  // Single register accesses are named after the driver method.
+  op = find(stats, count, sim::DS3231::kAddress, "lostPower");
+  TEST_ASSERT_NOT_NULL(op);
+  TEST_ASSERT_EQUAL(1, op->calls);
+  TEST_ASSERT_EQUAL(0, op->failures);
+  TEST_ASSERT_EQUAL(1, op->bytes);
+
+  // The address's low byte and the data.
+  op = find(stats, count, sim::AT24C32::kAddress, "write");
+  TEST_ASSERT_NOT_NULL(op);
+  TEST_ASSERT_EQUAL(1, op->calls);
+  TEST_ASSERT_EQUAL(4, op->bytes);
+
+  op = find(stats, count, sim::AT24C32::kAddress, "waitReady");
+  TEST_ASSERT_NOT_NULL(op);
+  TEST_ASSERT_GREATER_THAN(0, op->failures);
+  TEST_ASSERT_EQUAL(op->failures + 1, op->calls);
+  TEST_ASSERT_EQUAL(op->failures, op->histogram[6]);
+  TEST_ASSERT_EQUAL(1, op->histogram[0]);
+  TEST_ASSERT_EQUAL(op->failures * sim::AT24C32::kAddressMicros,
+                    op->total_micros);
+  Instrumentation::reset();
+}
+
+#else  // defined(RTC_INSTRUMENTATION)
+
+void test_instrumentation_disabled() {
+  TEST_ASSERT_FALSE(Instrumentation::enabled());
+  Instrumentation::record(0x10, "op", true, 4, 100);
+  OpStats stats[1];
+  TEST_ASSERT_EQUAL(0, Instrumentation::snapshot(stats, 1));
+}
+
+#endif  // defined(RTC_INSTRUMENTATION)
+
+}  // namespace
+
+void run_instrumentation_tests() {
+#if defined(RTC_INSTRUMENTATION)
+  RUN_TEST(test_instrumentation_record);
+  RUN_TEST(test_instrumentation_drivers);
+#else
+  RUN_TEST(test_instrumentation_disabled);
+#endif
+}
@@ -0,0 +1,49 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include "sim_bus.h"
+#include "tests.h"
+
+// Called before each test.
+void setUp(void) {
+  for (int port = kTestI2CPort; port < kTestI2CPort + kNumTestI2CPorts;
+       port++) {
+    rtc::sim::Bus::get(port).detachAll();
+  }
+}
+
+void tearDown(void) {}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  run_pcf8523_calibrator_tests();
+  run_temperature_compensator_tests();
+  run_clock_discipline_tests();
+  run_wall_clock_tests();
+  run_software_clock_tests();
+  run_simulator_tests();
+  run_ds3231_alarm_scheduler_tests();
+  run_recurrence_tests();
+  run_pcf8523_timer_scheduler_tests();
+  run_pcf8563_tests();
+  run_ds3231_alarm_dispatcher_tests();
+  run_nvram_store_tests();
+  run_at24c32_tests();
+  run_event_log_tests();
+  run_fast_boot_tests();
+  run_instrumentation_tests();
+  run_trace_tests();
+  run_i2c_retrier_tests();
+  run_ensemble_clock_tests();
+  run_clock_fusion_tests();
+  run_register_map_tests();
+  run_precision_setter_tests();
+  run_rtc_timestamper_tests();
+  return UNITY_END();
+}
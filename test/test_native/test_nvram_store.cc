@@ -0,0 +1,190 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+
+#include <i2clib/master.h>
+#include <rtclib/ds1307.h>
+#include <rtclib/nvram_store.h>
+#include "sim_ds1307.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+// The store's header, then its ring, in the DS1307 register file.
+constexpr uint8_t kNvramRegister = 0x08;
+constexpr uint8_t kRingRegister = kNvramRegister + 2;
+
+/**
+ * A DS1307 on the test bus, its NVRAM used as a store.
+ */
+struct Fixture {
+  Fixture()
+      : chip(kTestI2CPort), rtc(Master(kTestI2CPort, nullptr)), nvram(&rtc) {}
+
+  uint32_t getU32(NvramStore* store, uint8_t key) {
+    uint32_t value = 0;
+    size_t length = 0;
+    if (!store->get(key, &value, sizeof(value), &length) ||
+        length != sizeof(value)) {
+      return 0xFFFFFFFF;
+    }
+    return value;
+  }
+
+  sim::Attached<sim::DS1307> chip;
+  DS1307 rtc;
+  DS1307Nvram nvram;
+};
+
+void test_nvram_store_put_get_remove() {
+  Fixture f;
+  NvramStore store(&f.nvram);
+  TEST_ASSERT_TRUE(store.begin());
+  TEST_ASSERT_EQUAL(0, store.size());
+
+  const uint32_t a = 0x12345678;
+  const uint8_t b[] = {1, 2, 3};
+  TEST_ASSERT_TRUE(store.put(1, &a, sizeof(a)));
+  TEST_ASSERT_TRUE(store.put(2, b, sizeof(b)));
+  TEST_ASSERT_EQUAL(2, store.size());
+  TEST_ASSERT_EQUAL_UINT32(a, f.getU32(&store, 1));
+
+  uint8_t value[4] = {};
+  size_t length = 0;
+  TEST_ASSERT_TRUE(store.get(2, value, sizeof(value), &length));
+  TEST_ASSERT_EQUAL(3, length);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(b, value, sizeof(b));
+  TEST_ASSERT_FALSE(store.get(3, value, sizeof(value), &length));
+
+  // Rewriting the same value writes nothing.
+  const uint32_t before = store.bytesWritten();
+  TEST_ASSERT_TRUE(store.put(1, &a, sizeof(a)));
+  TEST_ASSERT_EQUAL(before, store.bytesWritten());
+
+  TEST_ASSERT_TRUE(store.remove(2));
+  TEST_ASSERT_TRUE(store.remove(3));
+  TEST_ASSERT_FALSE(store.get(2, value, sizeof(value), &length));
+  TEST_ASSERT_EQUAL(1, store.size());
+
+  // Everything survives a reload.
+  NvramStore reloaded(&f.nvram);
+  TEST_ASSERT_TRUE(reloaded.begin());
+  TEST_ASSERT_EQUAL(1, reloaded.size());
+  TEST_ASSERT_EQUAL_UINT32(a, f.getU32(&reloaded, 1));
+  TEST_ASSERT_FALSE(reloaded.get(2, value, sizeof(value), &length));
+}
+
+void test_nvram_store_rotates_writes() {
+  Fixture f;
+  NvramStore store(&f.nvram);
+  TEST_ASSERT_TRUE(store.begin());
+  const uint32_t constant = 0xCAFEF00D;
+  TEST_ASSERT_TRUE(store.put(7, &constant, sizeof(constant)));
+
+  // Each update is one record of 8 or 6 bytes, with the occasional header
+  // and copy of the constant record.
+  constexpr uint32_t kUpdates = 500;
+  const uint32_t start = store.bytesWritten();
+  for (uint32_t i = 0; i < kUpdates; i++) {
+    TEST_ASSERT_TRUE(store.put(1, &i, sizeof(i)));
+    TEST_ASSERT_TRUE(store.put(2, &i, 2));
+  }
+  TEST_ASSERT_LESS_THAN(kUpdates * (8 + 6) * 2,
+                        store.bytesWritten() - start);
+
+  NvramStore reloaded(&f.nvram);
+  TEST_ASSERT_TRUE(reloaded.begin());
+  TEST_ASSERT_EQUAL(3, reloaded.size());
+  TEST_ASSERT_EQUAL_UINT32(constant, f.getU32(&reloaded, 7));
+  TEST_ASSERT_EQUAL(kUpdates - 1, f.getU32(&reloaded, 1));
+}
+
+void test_nvram_store_recovers_torn_writes() {
+  Fixture f;
+  NvramStore store(&f.nvram);
+  TEST_ASSERT_TRUE(store.begin());
+  const uint32_t old_value = 1;
+  const uint32_t new_value = 2;
+  TEST_ASSERT_TRUE(store.put(1, &old_value, sizeof(old_value)));
+  TEST_ASSERT_TRUE(store.put(1, &new_value, sizeof(new_value)));
+
+  // The second record (at ring offset 8) was cut short: its CRC is wrong.
+  f.chip.reg(kRingRegister + 8 + 7) ^= 0x5A;
+  NvramStore reloaded(&f.nvram);
+  TEST_ASSERT_TRUE(reloaded.begin());
+  TEST_ASSERT_EQUAL(old_value, f.getU32(&reloaded, 1));
+  TEST_ASSERT_TRUE(reloaded.put(1, &new_value, sizeof(new_value)));
+
+  // A corrupt header: the log is recovered, and the header rewritten.
+  f.chip.reg(kNvramRegister) = 0xFF;
+  f.chip.reg(kNvramRegister + 1) = 0xFF;
+  NvramStore recovered(&f.nvram);
+  TEST_ASSERT_TRUE(recovered.begin());
+  TEST_ASSERT_EQUAL(new_value, f.getU32(&recovered, 1));
+  TEST_ASSERT_EQUAL(0xFF, f.chip.reg(kNvramRegister) ^
+                              f.chip.reg(kNvramRegister + 1));
+
+  // Garbage everywhere: formatted.
+  for (uint8_t reg = kNvramRegister; reg < 0x40; reg++)
+    f.chip.reg(reg) = 0xA5;
+  NvramStore formatted(&f.nvram);
+  TEST_ASSERT_TRUE(formatted.begin());
+  TEST_ASSERT_EQUAL(0, formatted.size());
+}
+
+void test_nvram_store_limits_and_errors() {
+  Fixture f;
+  // A store in the upper half of the NVRAM.
+  NvramStore store(&f.nvram, 28, 28);
+  TEST_ASSERT_TRUE(store.begin());
+  const uint8_t big[NvramStore::kMaxValueSize + 1] = {};
+  TEST_ASSERT_FALSE(store.put(1, big, sizeof(big)));
+
+  // The store reloads after an I2C error.
+  sim::Bus::get(kTestI2CPort).detach(sim::DS1307::kAddress);
+  TEST_ASSERT_FALSE(store.put(1, big, 6));
+  sim::Bus::get(kTestI2CPort).attach(sim::DS1307::kAddress, &f.chip);
+  TEST_ASSERT_TRUE(store.put(1, big, 6));
+
+  // A record of 10 bytes, with the same in reserve, fills a third of it.
+  TEST_ASSERT_FALSE(store.put(2, big, 6));
+  const uint8_t value = 42;
+  TEST_ASSERT_TRUE(store.put(2, &value, 1));
+  // An update needs room for the old and new records until the old one is
+  // reclaimed.
+  const uint8_t new_value = 43;
+  TEST_ASSERT_FALSE(store.put(2, &new_value, 1));
+  TEST_ASSERT_EQUAL(2, store.size());
+
+  // The lower half is untouched.
+  for (uint8_t reg = kNvramRegister; reg < kNvramRegister + 28; reg++)
+    TEST_ASSERT_EQUAL(0, f.chip.reg(reg));
+
+  NvramStore too_big(&f.nvram, 0, NvramStore::kMaxSize);
+  TEST_ASSERT_FALSE(too_big.begin());
+
+  NvramStore reloaded(&f.nvram, 28, 28);
+  TEST_ASSERT_TRUE(reloaded.begin());
+  uint8_t read = 0;
+  TEST_ASSERT_TRUE(reloaded.get(2, &read, 1, nullptr));
+  TEST_ASSERT_EQUAL(value, read);
+}
+
+}  // namespace
+
+void run_nvram_store_tests() {
+  RUN_TEST(test_nvram_store_put_get_remove);
+  RUN_TEST(test_nvram_store_rotates_writes);
+  RUN_TEST(test_nvram_store_recovers_torn_writes);
+  RUN_TEST(test_nvram_store_limits_and_errors);
+}
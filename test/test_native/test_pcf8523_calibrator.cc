@@ -0,0 +1,185 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cmath>
+
+#include <i2clib/master.h>
+#include <rtclib/datetime.h>
+#include <rtclib/pcf8523.h>
+#include <rtclib/pcf8523_calibrator.h>
+#include "sim_bus.h"
+#include "sim_pcf8523.h"
+#include "tests.h"
+
+using i2c::Master;
+
+using namespace rtc;
+
+namespace {
+
+constexpr int64_t kMicrosPerDay = 1000000LL * SECONDS_PER_DAY;
+
+class MemoryStore : public PCF8523Calibrator::Store {
+ public:
+  bool load(PCF8523Calibration* calibration) override {
+    if (!saved_)
+      return false;
+    *calibration = calibration_;
+    return true;
+  }
+
+  bool save(const PCF8523Calibration& calibration) override {
+    calibration_ = calibration;
+    saved_ = true;
+    return true;
+  }
+
+ private:
+  bool saved_ = false;
+  PCF8523Calibration calibration_;
+};
+
+/**
+ * Advance the simulated chip and the reference by |days|, calling
+ * PCF8523Calibrator::update() once per day.
+ */
+void runDays(sim::PCF8523* chip,
+             PCF8523Calibrator* calibrator,
+             uint32_t* reference,
+             int days) {
+  for (int i = 0; i < days; i++) {
+    chip->advance(kMicrosPerDay);
+    *reference += SECONDS_PER_DAY;
+    TEST_ASSERT_TRUE(calibrator->update(DateTime(*reference)));
+  }
+}
+
+void test_pcf8523_offset_register() {
+  sim::PCF8523 chip;
+  sim::Bus::get(kTestI2CPort).attach(sim::PCF8523::kAddress, &chip);
+  PCF8523 rtc(Master(kTestI2CPort, nullptr));
+
+  Pcf8523OffsetMode mode;
+  int8_t offset;
+  TEST_ASSERT_TRUE(rtc.calibrate(PCF8523_OneMinute, -5));
+  TEST_ASSERT_TRUE(rtc.getOffset(&mode, &offset));
+  TEST_ASSERT_EQUAL(PCF8523_OneMinute, mode);
+  TEST_ASSERT_EQUAL_INT8(-5, offset);
+
+  TEST_ASSERT_TRUE(rtc.calibrate(PCF8523_TwoHours, 63));
+  TEST_ASSERT_TRUE(rtc.getOffset(&mode, &offset));
+  TEST_ASSERT_EQUAL(PCF8523_TwoHours, mode);
+  TEST_ASSERT_EQUAL_INT8(63, offset);
+
+  TEST_ASSERT_TRUE(rtc.calibrate(PCF8523_TwoHours, -64));
+  TEST_ASSERT_TRUE(rtc.getOffset(&mode, &offset));
+  TEST_ASSERT_EQUAL_INT8(-64, offset);
+}
+
+void test_pcf8523_calibrator_select_offset() {
+  Pcf8523OffsetMode mode;
+  int8_t offset;
+
+  // 12 * 4.069 is closer to 50 than 12 * 4.340.
+  PCF8523Calibrator::selectOffset(50.0f, &mode, &offset);
+  TEST_ASSERT_EQUAL(PCF8523_OneMinute, mode);
+  TEST_ASSERT_EQUAL_INT8(12, offset);
+
+  PCF8523Calibrator::selectOffset(-8.68f, &mode, &offset);
+  TEST_ASSERT_EQUAL(PCF8523_TwoHours, mode);
+  TEST_ASSERT_EQUAL_INT8(-2, offset);
+
+  PCF8523Calibrator::selectOffset(0.0f, &mode, &offset);
+  TEST_ASSERT_EQUAL(PCF8523_TwoHours, mode);
+  TEST_ASSERT_EQUAL_INT8(0, offset);
+
+  PCF8523Calibrator::selectOffset(1000.0f, &mode, &offset);
+  TEST_ASSERT_EQUAL_INT8(63, offset);
+}
+
+void test_pcf8523_calibrator_converges() {
+  sim::PCF8523 chip(/*crystal_ppm=*/50.0);
+  sim::Bus::get(kTestI2CPort).attach(sim::PCF8523::kAddress, &chip);
+  PCF8523 rtc(Master(kTestI2CPort, nullptr));
+
+  uint32_t reference = DateTime(2021, 3, 1).unixtime();
+  TEST_ASSERT_TRUE(rtc.adjust(DateTime(reference)));
+  PCF8523Calibrator calibrator(&rtc, nullptr);
+  TEST_ASSERT_TRUE(calibrator.begin(DateTime(reference)));
+
+  runDays(&chip, &calibrator, &reference, 30);
+
+  TEST_ASSERT_GREATER_OR_EQUAL(1, calibrator.calibrations());
+  TEST_ASSERT_FLOAT_WITHIN(3.0, 0.0, chip.effectivePpm());
+  TEST_ASSERT_FLOAT_WITHIN(3.0, 0.0, calibrator.measuredPpm());
+}
+
+void test_pcf8523_calibrator_recalibrates() {
+  sim::PCF8523 chip(/*crystal_ppm=*/-20.0);
+  sim::Bus::get(kTestI2CPort).attach(sim::PCF8523::kAddress, &chip);
+  PCF8523 rtc(Master(kTestI2CPort, nullptr));
+
+  uint32_t reference = DateTime(2021, 3, 1).unixtime();
+  TEST_ASSERT_TRUE(rtc.adjust(DateTime(reference)));
+  PCF8523Calibrator calibrator(&rtc, nullptr);
+  TEST_ASSERT_TRUE(calibrator.begin(DateTime(reference)));
+  runDays(&chip, &calibrator, &reference, 30);
+  TEST_ASSERT_FLOAT_WITHIN(3.0, 0.0, chip.effectivePpm());
+  const uint32_t calibrations = calibrator.calibrations();
+
+  // The crystal changes (e.g. due to aging) so the residual exceeds the
+  // threshold and the chip must be recalibrated.
+  chip.setCrystalError(30.0);
+  runDays(&chip, &calibrator, &reference, 30);
+  TEST_ASSERT_GREATER_THAN(calibrations, calibrator.calibrations());
+  TEST_ASSERT_FLOAT_WITHIN(3.0, 0.0, chip.effectivePpm());
+}
+
+void test_pcf8523_calibrator_persists() {
+  sim::PCF8523 chip(/*crystal_ppm=*/50.0);
+  sim::Bus::get(kTestI2CPort).attach(sim::PCF8523::kAddress, &chip);
+  PCF8523 rtc(Master(kTestI2CPort, nullptr));
+  MemoryStore store;
+
+  uint32_t reference = DateTime(2021, 3, 1).unixtime();
+  TEST_ASSERT_TRUE(rtc.adjust(DateTime(reference)));
+  PCF8523Calibration saved;
+  {
+    PCF8523Calibrator calibrator(&rtc, &store);
+    TEST_ASSERT_TRUE(calibrator.begin(DateTime(reference)));
+    runDays(&chip, &calibrator, &reference, 3);
+    saved = calibrator.calibration();
+  }
+
+  // A new calibrator (e.g. after a reboot) resumes the persisted window.
+  PCF8523Calibrator calibrator(&rtc, &store);
+  TEST_ASSERT_TRUE(calibrator.begin(DateTime(reference)));
+  TEST_ASSERT_EQUAL_UINT32(saved.reference_start,
+                           calibrator.calibration().reference_start);
+  TEST_ASSERT_EQUAL_UINT32(saved.rtc_start,
+                           calibrator.calibration().rtc_start);
+  TEST_ASSERT_EQUAL_INT8(saved.offset, calibrator.calibration().offset);
+
+  // ..but not if the offset register no longer matches.
+  TEST_ASSERT_TRUE(rtc.calibrate(PCF8523_TwoHours, 0));
+  PCF8523Calibrator reset(&rtc, &store);
+  TEST_ASSERT_TRUE(reset.begin(DateTime(reference)));
+  TEST_ASSERT_EQUAL_UINT32(reference, reset.calibration().reference_start);
+  TEST_ASSERT_EQUAL_INT8(0, reset.calibration().offset);
+}
+
+}  // namespace
+
+void run_pcf8523_calibrator_tests() {
+  RUN_TEST(test_pcf8523_offset_register);
+  RUN_TEST(test_pcf8523_calibrator_select_offset);
+  RUN_TEST(test_pcf8523_calibrator_converges);
+  RUN_TEST(test_pcf8523_calibrator_recalibrates);
+  RUN_TEST(test_pcf8523_calibrator_persists);
+}
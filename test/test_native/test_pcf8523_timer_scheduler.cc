@@ -0,0 +1,172 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+
+#include <i2clib/master.h>
+#include <rtclib/pcf8523.h>
+#include <rtclib/pcf8523_timer_scheduler.h>
+#include "sim_oscillator.h"
+#include "sim_pcf8523.h"
+#include "sim_simulator.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+
+/**
+ * A PCF8523 in a simulation, with its INT1 output serviced by a scheduler.
+ */
+struct Fixture {
+  explicit Fixture(double crystal_ppm)
+      : chip(crystal_ppm), rtc(Master(kTestI2CPort, nullptr)),
+        scheduler(&rtc) {
+    sim::Bus::get(kTestI2CPort).attach(sim::PCF8523::kAddress, &chip);
+    simulator.addChip(&chip);
+    simulator.onInterrupt(&chip, [this] {
+      wakeups++;
+      TEST_ASSERT_TRUE(scheduler.service());
+    });
+    TEST_ASSERT_TRUE(scheduler.begin());
+  }
+
+  sim::PCF8523 chip;
+  sim::Simulator simulator;
+  PCF8523 rtc;
+  PCF8523TimerScheduler scheduler;
+  int wakeups = 0;
+};
+
+void test_countdown_first_period_is_shortened() {
+  sim::PCF8523 chip;
+  sim::Bus::get(kTestI2CPort).attach(sim::PCF8523::kAddress, &chip);
+  sim::Simulator simulator;
+  simulator.addChip(&chip);
+  PCF8523 rtc(Master(kTestI2CPort, nullptr));
+
+  int64_t fired_a = 0;
+  int64_t fired_b = 0;
+  simulator.onInterrupt(&chip, [&] {
+    bool a, b;
+    TEST_ASSERT_TRUE(rtc.readAndClearCountdownFlags(&a, &b));
+    if (a && !fired_a)
+      fired_a = simulator.now();
+    if (b && !fired_b)
+      fired_b = simulator.now();
+  });
+
+  // Start 3 x 1 s on timer A and 100 x 1/64 s on timer B, mid-second.
+  simulator.runFor(kMicrosPerSecond / 2);
+  TEST_ASSERT_TRUE(
+      rtc.startCountdownTimer(PCF8523_TimerA, PCF8523_FrequencySecond, 3));
+  TEST_ASSERT_TRUE(
+      rtc.startCountdownTimer(PCF8523_TimerB, PCF8523_Frequency64Hz, 100));
+  simulator.runFor(3 * kMicrosPerSecond);
+
+  // Timer A's first second was half over.
+  TEST_ASSERT_INT64_WITHIN(1, 3 * kMicrosPerSecond, fired_a);
+  TEST_ASSERT_INT64_WITHIN(1, kMicrosPerSecond / 2 + 1562500, fired_b);
+
+  // Both repeat until stopped.
+  TEST_ASSERT_TRUE(rtc.stopCountdownTimer(PCF8523_TimerA));
+  TEST_ASSERT_TRUE(rtc.stopCountdownTimer(PCF8523_TimerB));
+  TEST_ASSERT_FALSE(chip.interrupt());
+  TEST_ASSERT_EQUAL_HEX8(0, chip.reg(0x01) & 0x60);
+}
+
+void test_timer_scheduler_meets_deadlines() {
+  // A fast RTC crystal: the stages are measured, so this is corrected.
+  Fixture f(/*crystal_ppm=*/80);
+  sim::Random random(7);
+  const int64_t kDelays[] = {
+      150,
+      900,
+      40 * 1000,
+      700 * 1000,
+      3 * kMicrosPerSecond + 123457,
+      11 * 60 * kMicrosPerSecond + 654321,
+      5 * 3600 * kMicrosPerSecond + 98765,
+      3 * 86400 * kMicrosPerSecond + 11111,
+      12 * 86400 * kMicrosPerSecond + 22222,
+  };
+  int64_t worst = 0;
+  for (int64_t delay : kDelays) {
+    // Start at a random phase of the timers' source clocks.
+    f.simulator.runFor(random.next() % kMicrosPerSecond);
+    const int64_t deadline = f.simulator.now() + delay;
+    int64_t fired = -1;
+    f.wakeups = 0;
+    TEST_ASSERT_TRUE(f.scheduler.scheduleAt(
+        deadline, [&] { fired = f.simulator.now(); }));
+    TEST_ASSERT_TRUE(f.scheduler.pending() || fired >= 0);
+    f.simulator.runUntil(deadline + kMicrosPerSecond);
+
+    TEST_ASSERT_TRUE(fired >= 0);
+    TEST_ASSERT_FALSE(f.scheduler.pending());
+    const int64_t error = std::llabs(fired - deadline);
+    if (error > worst)
+      worst = error;
+    // One wakeup per stage, a handful even for 12 days.
+    TEST_ASSERT_EQUAL(static_cast<int>(f.scheduler.stages()), f.wakeups);
+    TEST_ASSERT_TRUE(f.scheduler.stages() <= 7);
+  }
+  // Within one 4.096 kHz period.
+  TEST_ASSERT_TRUE(worst <= 245);
+  // The timers are left stopped.
+  TEST_ASSERT_EQUAL_HEX8(0, f.chip.reg(0x0F) & 0x07);
+}
+
+void test_timer_scheduler_cancel_and_replace() {
+  Fixture f(/*crystal_ppm=*/-30);
+  int first = 0;
+  int second = 0;
+  TEST_ASSERT_TRUE(
+      f.scheduler.scheduleIn(10 * kMicrosPerSecond, [&] { first++; }));
+  f.simulator.runFor(4 * kMicrosPerSecond);
+  // Replacing the deadline cancels the first.
+  TEST_ASSERT_TRUE(
+      f.scheduler.scheduleIn(2 * kMicrosPerSecond, [&] { second++; }));
+  f.simulator.runFor(10 * kMicrosPerSecond);
+  TEST_ASSERT_EQUAL(0, first);
+  TEST_ASSERT_EQUAL(1, second);
+
+  TEST_ASSERT_TRUE(
+      f.scheduler.scheduleIn(5 * kMicrosPerSecond, [&] { first++; }));
+  f.simulator.runFor(kMicrosPerSecond);
+  TEST_ASSERT_TRUE(f.scheduler.cancel());
+  TEST_ASSERT_FALSE(f.scheduler.pending());
+  const int wakeups = f.wakeups;
+  f.simulator.runFor(20 * kMicrosPerSecond);
+  TEST_ASSERT_EQUAL(0, first);
+  TEST_ASSERT_EQUAL(wakeups, f.wakeups);
+
+  // A callback may schedule the next deadline.
+  int chained = 0;
+  std::function<void()> again = [&] {
+    if (++chained < 5)
+      TEST_ASSERT_TRUE(f.scheduler.scheduleIn(250 * 1000, again));
+  };
+  TEST_ASSERT_TRUE(f.scheduler.scheduleIn(250 * 1000, again));
+  f.simulator.runFor(2 * kMicrosPerSecond);
+  TEST_ASSERT_EQUAL(5, chained);
+}
+
+}  // namespace
+
+void run_pcf8523_timer_scheduler_tests() {
+  RUN_TEST(test_countdown_first_period_is_shortened);
+  RUN_TEST(test_timer_scheduler_meets_deadlines);
+  RUN_TEST(test_timer_scheduler_cancel_and_replace);
+}
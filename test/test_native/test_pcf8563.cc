@@ -0,0 +1,154 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+#include <vector>
+
+#include <i2clib/master.h>
+#include <rtclib/datetime.h>
+#include <rtclib/pcf8563.h>
+#include "sim_pcf8563.h"
+#include "sim_simulator.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+constexpr int64_t kMicrosPerDay = 86400 * kMicrosPerSecond;
+
+/**
+ * A PCF8563 in a simulation, recording the chip time of each interrupt.
+ */
+struct Fixture {
+  Fixture() : rtc(Master(kTestI2CPort, nullptr)) {
+    sim::Bus::get(kTestI2CPort).attach(sim::PCF8563::kAddress, &chip);
+    simulator.addChip(&chip);
+    simulator.onInterrupt(&chip, [this] {
+      times.push_back(simulator.now());
+      dates.push_back(chip.time());
+      if (clear_alarm) {
+        TEST_ASSERT_TRUE(rtc.isAlarmFired());
+        TEST_ASSERT_TRUE(rtc.clearAlarm());
+      }
+    });
+  }
+
+  sim::PCF8563 chip;
+  sim::Simulator simulator;
+  PCF8563 rtc;
+  std::vector<int64_t> times;
+  std::vector<DateTime> dates;
+  bool clear_alarm = false;  // Clear the alarm flag on each interrupt.
+};
+
+void test_pcf8563_alarm_modes() {
+  Fixture f;
+  // A Monday.
+  TEST_ASSERT_TRUE(f.rtc.adjust(DateTime(2021, 3, 1, 6, 0, 0)));
+  f.clear_alarm = true;
+
+  // Daily at 07:30.
+  TEST_ASSERT_TRUE(f.rtc.setAlarm(DateTime(2000, 1, 1, 7, 30, 45),
+                                  PCF8563::AlarmMode::Hour));
+  f.simulator.runFor(3 * kMicrosPerDay);
+  TEST_ASSERT_EQUAL(3, f.dates.size());
+  for (size_t i = 0; i < f.dates.size(); i++) {
+    TEST_ASSERT_EQUAL(1 + i, f.dates[i].day());
+    TEST_ASSERT_EQUAL(7, f.dates[i].hour());
+    TEST_ASSERT_EQUAL(30, f.dates[i].minute());
+    TEST_ASSERT_EQUAL(0, f.dates[i].second());
+  }
+
+  // Wednesdays at 12:00: adjust() set the weekday register.
+  f.dates.clear();
+  TEST_ASSERT_TRUE(f.rtc.setAlarm(DateTime(2021, 3, 10, 12, 0, 0),
+                                  PCF8563::AlarmMode::Day));
+  f.simulator.runFor(14 * kMicrosPerDay);
+  TEST_ASSERT_EQUAL(2, f.dates.size());
+  TEST_ASSERT_EQUAL(3, f.dates[0].dayOfTheWeek());
+  TEST_ASSERT_EQUAL(10, f.dates[0].day());
+  TEST_ASSERT_EQUAL(17, f.dates[1].day());
+
+  // Every hour at :15.
+  f.dates.clear();
+  TEST_ASSERT_TRUE(f.rtc.setAlarm(DateTime(2000, 1, 1, 0, 15, 0),
+                                  PCF8563::AlarmMode::Minute));
+  f.simulator.runFor(kMicrosPerDay);
+  TEST_ASSERT_EQUAL(24, f.dates.size());
+
+  TEST_ASSERT_TRUE(f.rtc.disableAlarm());
+  f.simulator.runFor(kMicrosPerDay);
+  TEST_ASSERT_EQUAL(24, f.dates.size());
+}
+
+void test_pcf8563_alarm_holds_interrupt_until_cleared() {
+  Fixture f;
+  TEST_ASSERT_TRUE(f.rtc.adjust(DateTime(2021, 3, 1, 6, 0, 0)));
+  TEST_ASSERT_TRUE(f.rtc.setAlarm(DateTime(2021, 3, 1, 6, 1, 0),
+                                  PCF8563::AlarmMode::Hour));
+  f.simulator.runFor(2 * 60 * kMicrosPerSecond);
+  TEST_ASSERT_EQUAL(1, f.times.size());
+  TEST_ASSERT_EQUAL(60 * kMicrosPerSecond, f.times[0]);
+  TEST_ASSERT_TRUE(f.chip.interrupt());
+
+  // Re-arming clears the flag.
+  TEST_ASSERT_TRUE(f.rtc.setAlarm(DateTime(2021, 3, 1, 6, 5, 0),
+                                  PCF8563::AlarmMode::Hour));
+  TEST_ASSERT_FALSE(f.chip.interrupt());
+  TEST_ASSERT_FALSE(f.rtc.isAlarmFired());
+}
+
+void test_pcf8563_countdown_timer() {
+  Fixture f;
+  f.simulator.runFor(kMicrosPerSecond / 4);
+
+  // Pulsed: periodic wakeups without clearing the flag.
+  TEST_ASSERT_TRUE(f.rtc.enableCountdownTimer(PCF8563_FrequencySecond, 5));
+  f.simulator.runFor(20 * kMicrosPerSecond);
+  TEST_ASSERT_EQUAL(4, f.times.size());
+  // The first period was a quarter over.
+  TEST_ASSERT_INT64_WITHIN(1, 5 * kMicrosPerSecond, f.times[0]);
+  for (size_t i = 1; i < f.times.size(); i++)
+    TEST_ASSERT_INT64_WITHIN(1, 5 * kMicrosPerSecond,
+                             f.times[i] - f.times[i - 1]);
+  TEST_ASSERT_TRUE(f.rtc.isCountdownTimerFired());
+
+  // Fast pulses are distinct interrupts too.
+  f.times.clear();
+  TEST_ASSERT_TRUE(f.rtc.enableCountdownTimer(PCF8563_Frequency64Hz, 2));
+  TEST_ASSERT_FALSE(f.rtc.isCountdownTimerFired());
+  f.simulator.runFor(kMicrosPerSecond - 10000);
+  TEST_ASSERT_EQUAL(31, f.times.size());
+
+  // Level: held until cleared.
+  f.times.clear();
+  TEST_ASSERT_TRUE(
+      f.rtc.enableCountdownTimer(PCF8563_Frequency4kHz, 100, false));
+  f.simulator.runFor(kMicrosPerSecond);
+  TEST_ASSERT_EQUAL(1, f.times.size());
+  TEST_ASSERT_TRUE(f.chip.interrupt());
+  TEST_ASSERT_TRUE(f.rtc.clearCountdownTimer());
+  TEST_ASSERT_FALSE(f.rtc.isCountdownTimerFired());
+
+  TEST_ASSERT_TRUE(f.rtc.disableCountdownTimer());
+  f.simulator.runFor(kMicrosPerSecond);
+  TEST_ASSERT_EQUAL(1, f.times.size());
+  TEST_ASSERT_FALSE(f.rtc.isCountdownTimerFired());
+}
+
+}  // namespace
+
+void run_pcf8563_tests() {
+  RUN_TEST(test_pcf8563_alarm_modes);
+  RUN_TEST(test_pcf8563_alarm_holds_interrupt_until_cleared);
+  RUN_TEST(test_pcf8563_countdown_timer);
+}
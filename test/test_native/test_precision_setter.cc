@@ -0,0 +1,147 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include <i2clib/master.h>
+#include <rtclib/datetime.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/pcf8563.h>
+#include <rtclib/precision_setter.h>
+#include <rtclib/system_clock.h>
+#include "sim_ds3231.h"
+#include "sim_pcf8563.h"
+#include "sim_simulator.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+
+const int64_t kEpoch =
+    static_cast<int64_t>(DateTime(2021, 3, 1).unixtime()) * kMicrosPerSecond;
+
+// A 100 kHz bus: about 90 µs a byte, and some overhead.
+constexpr int64_t kTransactionMicros = 400;
+constexpr int64_t kByteMicros = 90;
+
+/**
+ * How far (µs) |chip| is ahead of the reference time kEpoch + now.
+ */
+template <typename Chip>
+int64_t chipError(const Chip& chip, const sim::Simulator& simulator) {
+  const double chip_micros =
+      (chip.time().unixtime() + chip.phase()) * kMicrosPerSecond;
+  return std::llround(chip_micros) - kEpoch - simulator.now();
+}
+
+void test_precision_setter_aligns_second() {
+  sim::Simulator simulator;
+  sim::DS3231 chip;
+  simulator.addChip(&chip);
+  sim::Bus::get(kTestI2CPort).attach(sim::DS3231::kAddress, &chip);
+  sim::Bus::get(kTestI2CPort).setTiming(kTransactionMicros, kByteMicros);
+  DS3231 rtc(Master(kTestI2CPort, nullptr));
+
+  // adjust() is behind by the time into the second, and the latency.
+  simulator.runFor(400000);
+  const int64_t reference = kEpoch + simulator.now();
+  TEST_ASSERT_TRUE(
+      rtc.adjust(DateTime(static_cast<uint32_t>(reference / 1000000))));
+  const int64_t adjust_error = chipError(chip, simulator);
+  TEST_ASSERT_INT64_WITHIN(5000, -400000, adjust_error);
+
+  // The status is read before the wait, and only the write timed.
+  PrecisionSetter::Config config;
+  config.latch_lag = 9 * kByteMicros;
+  config.prepare = [&rtc] { return rtc.prepareAdjust(); };
+  PrecisionSetter setter(PrecisionSetter::adjuster(&rtc), config);
+  simulator.runFor(1234567);
+  TEST_ASSERT_TRUE(setter.set(SystemClock::microsSinceStart(),
+                              kEpoch + simulator.now()));
+  // The first set assumes the default latency.
+  const int64_t first_error = chipError(chip, simulator);
+  TEST_ASSERT_EQUAL_INT64(-setter.lastErrorMicros(), first_error);
+  TEST_ASSERT_INT64_WITHIN(2000, 0, first_error);
+
+  // Once measured, to within the microsecond.
+  simulator.runFor(3456789);
+  TEST_ASSERT_TRUE(setter.set(SystemClock::microsSinceStart(),
+                              kEpoch + simulator.now()));
+  const int64_t error = chipError(chip, simulator);
+  TEST_ASSERT_INT64_WITHIN(2, 0, error);
+  TEST_ASSERT_INT64_WITHIN(2, 0, setter.lastErrorMicros());
+  TEST_ASSERT_EQUAL(2, setter.stats().sets);
+  // A write of 7 time bytes and the status.
+  TEST_ASSERT_EQUAL_INT64(kTransactionMicros + 12 * kByteMicros,
+                          setter.latencyMicros());
+
+  bool lost_power;
+  TEST_ASSERT_TRUE(rtc.lostPower(&lost_power));
+  TEST_ASSERT_FALSE(lost_power);
+
+  char msg[100];
+  snprintf(msg, sizeof(msg), "adjust() error %lld us, set() error %lld us",
+           static_cast<long long>(adjust_error),
+           static_cast<long long>(error));
+  TEST_MESSAGE(msg);
+}
+
+void test_precision_setter_reference_in_past() {
+  // A reference taken some time ago, on a chip with a single transaction
+  // adjust().
+  sim::Simulator simulator;
+  sim::PCF8563 chip;
+  simulator.addChip(&chip);
+  sim::Bus::get(kTestI2CPort).attach(sim::PCF8563::kAddress, &chip);
+  sim::Bus::get(kTestI2CPort).setTiming(kTransactionMicros, kByteMicros);
+  PCF8563 rtc(Master(kTestI2CPort, nullptr));
+  PrecisionSetter::Config config;
+  config.initial_latency = kTransactionMicros + 9 * kByteMicros;
+  PrecisionSetter setter(PrecisionSetter::adjuster(&rtc), config);
+
+  simulator.runFor(777777);
+  const int64_t local = SystemClock::microsSinceStart();
+  const int64_t reference = kEpoch + simulator.now();
+  simulator.runFor(2500000);
+  TEST_ASSERT_TRUE(setter.set(local, reference));
+  TEST_ASSERT_INT64_WITHIN(2, 0, chipError(chip, simulator));
+  TEST_ASSERT_EQUAL_INT64(config.initial_latency, setter.latencyMicros());
+}
+
+void test_precision_setter_write_failure() {
+  sim::Simulator simulator;
+  DS3231 rtc(Master(kTestI2CPort, nullptr));
+  PrecisionSetter setter(PrecisionSetter::adjuster(&rtc));
+  TEST_ASSERT_FALSE(setter.set(0, kEpoch));
+  TEST_ASSERT_EQUAL(1, setter.stats().failures);
+  TEST_ASSERT_EQUAL(0, setter.stats().sets);
+
+  // A failed preparation is not followed by the wait and write.
+  PrecisionSetter::Config config;
+  config.prepare = [&rtc] { return rtc.prepareAdjust(); };
+  PrecisionSetter prepared(PrecisionSetter::adjuster(&rtc), config);
+  const int64_t before = SystemClock::microsSinceStart();
+  TEST_ASSERT_FALSE(prepared.set(0, kEpoch));
+  TEST_ASSERT_EQUAL(1, prepared.stats().failures);
+  TEST_ASSERT_EQUAL_INT64(before, SystemClock::microsSinceStart());
+}
+
+}  // namespace
+
+void run_precision_setter_tests() {
+  RUN_TEST(test_precision_setter_aligns_second);
+  RUN_TEST(test_precision_setter_reference_in_past);
+  RUN_TEST(test_precision_setter_write_failure);
+}
@@ -0,0 +1,232 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <cstdio>
+
+#include <rtclib/datetime.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/recurrence.h>
+#include "sim_oscillator.h"
+#include "tests.h"
+
+using namespace rtc;
+
+namespace {
+
+constexpr uint8_t kSunday = 1 << 0;
+constexpr uint8_t kMonday = 1 << 1;
+constexpr uint8_t kFriday = 1 << 5;
+
+void assertNext(const Recurrence& rule,
+                const DateTime& after,
+                const DateTime& expected) {
+  DateTime next;
+  TEST_ASSERT_TRUE(rule.next(after, &next));
+  TEST_ASSERT_EQUAL_UINT32(expected.unixtime(), next.unixtime());
+  TEST_ASSERT_TRUE(rule.matches(next));
+}
+
+/**
+ * Reference implementation: step through time, skipping whole days, hours
+ * and minutes which don't match.
+ */
+bool bruteForceNext(const Recurrence& rule,
+                    const DateTime& after,
+                    DateTime* next) {
+  uint32_t t = after.unixtime() + 1;
+  const uint32_t end = DateTime(2100, 1, 1).unixtime();
+  while (t < end) {
+    const DateTime dt(t);
+    if (rule.matches(dt)) {
+      *next = dt;
+      return true;
+    }
+    // Does any time in the rest of this day/hour/minute match?
+    Recurrence minute_rule = rule;
+    minute_rule.seconds(~0ULL);
+    Recurrence hour_rule = minute_rule;
+    hour_rule.minutes(~0ULL);
+    Recurrence day_rule = hour_rule;
+    day_rule.hours(~0U);
+    if (!day_rule.matches(dt))
+      t += 86400 - (t % 86400);
+    else if (!hour_rule.matches(dt))
+      t += 3600 - (t % 3600);
+    else if (!minute_rule.matches(dt))
+      t += 60 - (t % 60);
+    else
+      t++;
+  }
+  return false;
+}
+
+void test_recurrence_alarm_modes() {
+  const DateTime set(2021, 3, 1, 8, 30, 15);  // A Monday.
+  const DateTime after(2021, 3, 3, 9, 0, 0);  // A Wednesday.
+  assertNext(Recurrence::alarm1(set, DS3231::Alarm1Mode::EverySecond), after,
+             DateTime(2021, 3, 3, 9, 0, 1));
+  assertNext(Recurrence::alarm1(set, DS3231::Alarm1Mode::Second), after,
+             DateTime(2021, 3, 3, 9, 0, 15));
+  assertNext(Recurrence::alarm1(set, DS3231::Alarm1Mode::Minute), after,
+             DateTime(2021, 3, 3, 9, 30, 15));
+  assertNext(Recurrence::alarm1(set, DS3231::Alarm1Mode::Hour), after,
+             DateTime(2021, 3, 4, 8, 30, 15));
+  assertNext(Recurrence::alarm1(set, DS3231::Alarm1Mode::Date), after,
+             DateTime(2021, 4, 1, 8, 30, 15));
+  assertNext(Recurrence::alarm1(set, DS3231::Alarm1Mode::Day), after,
+             DateTime(2021, 3, 8, 8, 30, 15));
+
+  assertNext(Recurrence::alarm2(set, DS3231::Alarm2Mode::EveryMinute), after,
+             DateTime(2021, 3, 3, 9, 1, 0));
+  assertNext(Recurrence::alarm2(set, DS3231::Alarm2Mode::Minute), after,
+             DateTime(2021, 3, 3, 9, 30, 0));
+  assertNext(Recurrence::alarm2(set, DS3231::Alarm2Mode::Hour), after,
+             DateTime(2021, 3, 4, 8, 30, 0));
+  assertNext(Recurrence::alarm2(set, DS3231::Alarm2Mode::Date), after,
+             DateTime(2021, 4, 1, 8, 30, 0));
+  assertNext(Recurrence::alarm2(set, DS3231::Alarm2Mode::Day), after,
+             DateTime(2021, 3, 8, 8, 30, 0));
+
+  // Strictly after: an alarm time is not its own next occurrence.
+  assertNext(Recurrence::alarm1(set, DS3231::Alarm1Mode::Hour), set,
+             DateTime(2021, 3, 2, 8, 30, 15));
+}
+
+void test_recurrence_calendar() {
+  // Next Monday 08:00.
+  const Recurrence monday_8am =
+      Recurrence().weekdays(kMonday).hours(1 << 8).minutes(1).seconds(1);
+  assertNext(monday_8am, DateTime(2021, 3, 3, 12, 0, 0),
+             DateTime(2021, 3, 8, 8, 0, 0));
+  assertNext(monday_8am, DateTime(2021, 12, 28), DateTime(2022, 1, 3, 8));
+
+  // The 31st skips shorter months.
+  const Recurrence the_31st = Recurrence().days(1UL << 31).hours(1).minutes(
+      1).seconds(1);
+  assertNext(the_31st, DateTime(2021, 3, 31, 1), DateTime(2021, 5, 31));
+
+  // February 29th.
+  const Recurrence leap_day = Recurrence()
+                                  .months(1 << 2)
+                                  .days(1UL << 29)
+                                  .hours(1)
+                                  .minutes(1)
+                                  .seconds(1);
+  assertNext(leap_day, DateTime(2021, 3, 1), DateTime(2024, 2, 29));
+
+  // Friday the 13th at noon.
+  const Recurrence friday_13th = Recurrence()
+                                     .weekdays(kFriday)
+                                     .days(1UL << 13)
+                                     .hours(1 << 12)
+                                     .minutes(1)
+                                     .seconds(1);
+  assertNext(friday_13th, DateTime(2021, 1, 1), DateTime(2021, 8, 13, 12));
+
+  // Sundays in June, every 15 minutes.
+  const Recurrence june_sundays =
+      Recurrence()
+          .months(1 << 6)
+          .weekdays(kSunday)
+          .minutes(1ULL | 1ULL << 15 | 1ULL << 30 | 1ULL << 45)
+          .seconds(1);
+  assertNext(june_sundays, DateTime(2021, 6, 6, 23, 45),
+             DateTime(2021, 6, 13, 0, 0));
+  assertNext(june_sundays, DateTime(2021, 6, 27, 23, 45),
+             DateTime(2022, 6, 5, 0, 0));
+
+  // No occurrence.
+  DateTime next;
+  TEST_ASSERT_FALSE(
+      Recurrence().months(1 << 2).days(1UL << 30).next(DateTime(2021, 1, 1),
+                                                      &next));
+  TEST_ASSERT_FALSE(Recurrence().hours(0).next(DateTime(2021, 1, 1), &next));
+  TEST_ASSERT_FALSE(
+      Recurrence().seconds(1).next(DateTime(2099, 12, 31, 23, 59, 0), &next));
+}
+
+void test_recurrence_matches_brute_force() {
+  sim::Random random(7);
+  for (int i = 0; i < 300; i++) {
+    // Random sparse rules.
+    Recurrence rule;
+    rule.seconds(1ULL << (random.next() % 60))
+        .minutes((static_cast<uint64_t>(random.next()) << 32 |
+                  random.next()) &
+                 (static_cast<uint64_t>(random.next()) << 32 |
+                  random.next()))
+        .hours(random.next() & random.next())
+        .days(random.next() | random.next())
+        .months(static_cast<uint16_t>(random.next() | random.next()))
+        .weekdays(static_cast<uint8_t>(random.next()));
+    const DateTime after(
+        DateTime(2001, 1, 1).unixtime() + random.next() % (20 * 365 * 86400));
+
+    DateTime expected;
+    DateTime actual;
+    const bool expected_found = bruteForceNext(rule, after, &expected);
+    TEST_ASSERT_EQUAL(expected_found, rule.next(after, &actual));
+    if (expected_found)
+      TEST_ASSERT_EQUAL_UINT32(expected.unixtime(), actual.unixtime());
+  }
+}
+
+void test_recurrence_benchmark() {
+  const struct {
+    const char* name;
+    Recurrence rule;
+  } rules[] = {
+      {"daily alarm", Recurrence::alarm1(DateTime(2021, 3, 1, 8, 30, 15),
+                                         DS3231::Alarm1Mode::Hour)},
+      {"Monday 08:00",
+       Recurrence().weekdays(kMonday).hours(1 << 8).minutes(1).seconds(1)},
+      {"Friday 13th",
+       Recurrence().weekdays(kFriday).days(1UL << 13).hours(1).minutes(
+           1).seconds(1)},
+      {"Feb 29th",
+       Recurrence().months(1 << 2).days(1UL << 29).hours(1).minutes(
+           1).seconds(1)},
+  };
+  constexpr int kIterations = 250000;
+  uint32_t checksum = 0;
+  for (const auto& entry : rules) {
+    const Recurrence& rule = entry.rule;
+    uint32_t t = DateTime(2021, 1, 1).unixtime();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; i++) {
+      DateTime next;
+      if (!rule.next(DateTime(t), &next))
+        break;
+      checksum += next.unixtime();
+      // Restart within the century so that every call finds a match.
+      t = next.unixtime() < DateTime(2090, 1, 1).unixtime()
+              ? next.unixtime()
+              : DateTime(2021, 1, 1).unixtime() + i;
+    }
+    const double ns = std::chrono::duration<double, std::nano>(
+                          std::chrono::steady_clock::now() - start)
+                          .count() /
+                      kIterations;
+    char msg[80];
+    snprintf(msg, sizeof(msg), "next(%s): %.0f ns/call, %.2f M calls/s",
+             entry.name, ns, 1e3 / ns);
+    TEST_MESSAGE(msg);
+  }
+  TEST_ASSERT_TRUE(checksum != 0);
+}
+
+}  // namespace
+
+void run_recurrence_tests() {
+  RUN_TEST(test_recurrence_alarm_modes);
+  RUN_TEST(test_recurrence_calendar);
+  RUN_TEST(test_recurrence_matches_brute_force);
+  RUN_TEST(test_recurrence_benchmark);
+}
@@ -0,0 +1,260 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+
+#include <i2clib/master.h>
+#include <rtclib/datetime.h>
+#include <rtclib/ds1307.h>
+#include <rtclib/ds1307_registers.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/ds3231_registers.h>
+#include <rtclib/pcf8523.h>
+#include <rtclib/pcf8523_registers.h>
+#include <rtclib/pcf8563.h>
+#include <rtclib/pcf8563_registers.h>
+#include <rtclib/register_map.h>
+#include "sim_ds1307.h"
+#include "sim_ds3231.h"
+#include "sim_pcf8523.h"
+#include "sim_pcf8563.h"
+#include "sim_simulator.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+
+using Field = RegisterField<0x0E, 3, 2>;
+
+// Fields fold to constants.
+static_assert(Field::kMask == 0b00011000, "Wrong mask");
+static_assert(Field::get(0b11110111) == 0b10, "Wrong get");
+static_assert(Field::set(0xFF, 0b01) == 0b11101111, "Wrong set");
+static_assert(DS3231Registers::A1F::kMask == 0x01, "Wrong mask");
+static_assert(encodeField(DS3231Registers::kSqwPinModes,
+                          DS3231::SqwPinMode::Rate4kHz) == 0b100,
+              "Wrong encoding");
+static_assert(decodeField(DS3231Registers::kSqwPinModes, 0b110,
+                          DS3231::SqwPinMode::Off) ==
+                  DS3231::SqwPinMode::Rate8kHz,
+              "Wrong decoding");
+// A value outside of the table gets the first encoding.
+static_assert(encodeField(DS3231Registers::kSqwPinModes,
+                          static_cast<DS3231::SqwPinMode>(99)) ==
+                  DS3231Registers::kSqwPinModes[0].bits,
+              "Wrong out of range encoding");
+static_assert(encodeField(PCF8523Registers::kSqwPinModes,
+                          static_cast<PCF8523::SqwPinMode>(-1)) ==
+                  PCF8523Registers::kSqwPinModes[0].bits,
+              "Wrong out of range encoding");
+
+void test_register_map_field() {
+  // Setting a field leaves the other bits alone, and truncates the value.
+  TEST_ASSERT_EQUAL_HEX8(0b10101010, Field::set(0b10110010, 0b01));
+  TEST_ASSERT_EQUAL_HEX8(0b00011000, Field::set(0, 0xFF));
+  TEST_ASSERT_EQUAL_HEX8(0b11, Field::get(0xFF));
+  TEST_ASSERT_EQUAL_HEX8(0x80, DS1307Registers::CH::kMask);
+  TEST_ASSERT_EQUAL_HEX8(0x7F, PCF8523Registers::OFFSET::kMask);
+  TEST_ASSERT_EQUAL_HEX8(0x3F, PCF8563Registers::Hours::get(0xFF));
+}
+
+void test_register_map_decode_fallback() {
+  // The DS3231 is off whenever INTCN is set, whatever the rate.
+  TEST_ASSERT_TRUE(decodeField(DS3231Registers::kSqwPinModes, 0b111,
+                               DS3231::SqwPinMode::Off) ==
+                   DS3231::SqwPinMode::Off);
+  TEST_ASSERT_TRUE(decodeField(PCF8563Registers::kSqwPinModes, 0x55,
+                               PCF8563::SqwPinMode::Off) ==
+                   PCF8563::SqwPinMode::Off);
+  TEST_ASSERT_TRUE(PCF8563Registers::sqwPinMode(0x55) ==
+                   PCF8563::SqwPinMode::Off);
+  // OUT is ignored while the DS1307 square wave is enabled.
+  TEST_ASSERT_TRUE(
+      DS1307Registers::sqwPinMode(DS1307Registers::OUT::kMask |
+                                  DS1307Registers::SQWE::kMask | 0b10) ==
+      DS1307::SqwPinMode::Rate8kHz);
+}
+
+/**
+ * Write each square wave mode of |rtc|, and read it back.
+ */
+template <typename RTC>
+void checkSqwPinModes(RTC* rtc, int num_modes) {
+  using Mode = typename RTC::SqwPinMode;
+  for (int i = num_modes - 1; i >= 0; i--) {
+    const Mode mode = static_cast<Mode>(i);
+    TEST_ASSERT_TRUE(rtc->writeSqwPinMode(mode));
+    TEST_ASSERT_EQUAL(i, static_cast<int>(rtc->readSqwPinMode()));
+  }
+}
+
+void test_register_map_sqw_pin_modes() {
+  sim::DS1307 ds1307_chip;
+  sim::DS3231 ds3231_chip;
+  sim::PCF8523 pcf8523_chip;
+  sim::PCF8563 pcf8563_chip;
+  sim::Bus::get(kTestI2CPort).attach(sim::DS1307::kAddress, &ds1307_chip);
+  sim::Bus::get(kTestI2CPort + 1).attach(sim::DS3231::kAddress, &ds3231_chip);
+  sim::Bus::get(kTestI2CPort + 2)
+      .attach(sim::PCF8523::kAddress, &pcf8523_chip);
+  sim::Bus::get(kTestI2CPort).attach(sim::PCF8563::kAddress, &pcf8563_chip);
+
+  DS1307 ds1307(Master(kTestI2CPort, nullptr));
+  DS3231 ds3231(Master(kTestI2CPort + 1, nullptr));
+  PCF8523 pcf8523(Master(kTestI2CPort + 2, nullptr));
+  PCF8563 pcf8563(Master(kTestI2CPort, nullptr));
+  checkSqwPinModes(&ds1307, 6);
+  checkSqwPinModes(&ds3231, 5);
+  checkSqwPinModes(&pcf8523, 8);
+  checkSqwPinModes(&pcf8563, 5);
+
+  // Other control bits are kept.
+  ds3231_chip.reg(DS3231Registers::kControl) |= DS3231Registers::A1IE::kMask;
+  TEST_ASSERT_TRUE(ds3231.writeSqwPinMode(DS3231::SqwPinMode::Rate1kHz));
+  TEST_ASSERT_EQUAL_HEX8(
+      DS3231Registers::A1IE::kMask | DS3231Registers::RS::set(0, 0b01),
+      ds3231_chip.reg(DS3231Registers::kControl));
+}
+
+void test_register_map_dump_restore() {
+  // A golden DS3231 configuration, copied to a chip which lost power.
+  sim::DS3231 golden_chip;
+  sim::DS3231 chip;
+  sim::Bus::get(kTestI2CPort).attach(sim::DS3231::kAddress, &golden_chip);
+  sim::Bus::get(kTestI2CPort + 1).attach(sim::DS3231::kAddress, &chip);
+  DS3231 golden(Master(kTestI2CPort, nullptr));
+  DS3231 rtc(Master(kTestI2CPort + 1, nullptr));
+  TEST_ASSERT_TRUE(golden.adjust(DateTime(2021, 3, 1)));
+  TEST_ASSERT_TRUE(golden.setAlarm1(DateTime(2021, 3, 1, 6, 30, 0),
+                                    DS3231::Alarm1Mode::Hour));
+  TEST_ASSERT_TRUE(golden.setAgingOffset(-7));
+  golden.disable32K();
+  golden_chip.reg(DS3231Registers::kStatus) |= DS3231Registers::A1F::kMask;
+  uint8_t values[DS3231::kNumRegisters];
+  TEST_ASSERT_TRUE(golden.dumpRegisters(values));
+  TEST_ASSERT_EQUAL_HEX8(0xF9, values[DS3231Registers::kAgingOffset]);
+
+  TEST_ASSERT_TRUE(rtc.adjust(DateTime(2022, 5, 7, 12, 0, 0)));
+  chip.reg(DS3231Registers::kStatus) |= DS3231Registers::OSF::kMask;
+  TEST_ASSERT_TRUE(rtc.restoreRegisters(values));
+  for (uint8_t reg = 0; reg < DS3231::kNumRegisters; reg++) {
+    const uint8_t config = DS3231Registers::kRestore[reg].config;
+    TEST_ASSERT_EQUAL_HEX8(values[reg] & config, chip.reg(reg) & config);
+  }
+  // The time and flags are unchanged.
+  DateTime now;
+  TEST_ASSERT_TRUE(rtc.now(&now));
+  TEST_ASSERT_TRUE(now == DateTime(2022, 5, 7, 12, 0, 0));
+  TEST_ASSERT_TRUE(rtc.lostPower());
+  TEST_ASSERT_FALSE(rtc.isAlarmFired(DS3231::Alarm::A1));
+  TEST_ASSERT_FALSE(rtc.isEnabled32K());
+
+  // Writing OSF as one would set it.
+  chip.reg(DS3231Registers::kStatus) &= ~DS3231Registers::OSF::kMask;
+  TEST_ASSERT_TRUE(rtc.restoreRegisters(values));
+  TEST_ASSERT_FALSE(rtc.lostPower());
+}
+
+void test_register_map_restore_skips_registers() {
+  // The PCF8523's configuration is either side of its time registers.
+  sim::PCF8523 golden_chip;
+  sim::PCF8523 chip;
+  sim::Bus::get(kTestI2CPort).attach(sim::PCF8523::kAddress, &golden_chip);
+  sim::Bus::get(kTestI2CPort + 1).attach(sim::PCF8523::kAddress, &chip);
+  PCF8523 golden(Master(kTestI2CPort, nullptr));
+  PCF8523 rtc(Master(kTestI2CPort + 1, nullptr));
+  TEST_ASSERT_TRUE(golden.start());
+  TEST_ASSERT_TRUE(golden.calibrate(PCF8523_OneMinute, -5));
+  TEST_ASSERT_TRUE(golden.writeSqwPinMode(PCF8523::SqwPinMode::Rate1kHz));
+  uint8_t values[PCF8523::kNumRegisters];
+  TEST_ASSERT_TRUE(golden.dumpRegisters(values));
+
+  TEST_ASSERT_TRUE(rtc.adjust(DateTime(2022, 5, 7, 12, 0, 0)));
+  const uint8_t seconds = chip.reg(PCF8523Registers::kSeconds);
+  TEST_ASSERT_TRUE(rtc.restoreRegisters(values));
+  TEST_ASSERT_EQUAL_HEX8(seconds, chip.reg(PCF8523Registers::kSeconds));
+  Pcf8523OffsetMode mode;
+  int8_t offset;
+  TEST_ASSERT_TRUE(rtc.getOffset(&mode, &offset));
+  TEST_ASSERT_EQUAL(PCF8523_OneMinute, mode);
+  TEST_ASSERT_EQUAL(-5, offset);
+  TEST_ASSERT_TRUE(rtc.readSqwPinMode() == PCF8523::SqwPinMode::Rate1kHz);
+
+  // A missing chip.
+  sim::Bus::get(kTestI2CPort + 1).detach(sim::PCF8523::kAddress);
+  TEST_ASSERT_FALSE(rtc.restoreRegisters(values));
+}
+
+void test_register_map_restore_starts_timers() {
+  // Running timers restart from the count remaining, rather than from
+  // whatever their value registers held when they were enabled.
+  sim::PCF8523 golden_pcf8523_chip;
+  sim::PCF8523 pcf8523_chip;
+  sim::PCF8563 golden_pcf8563_chip;
+  sim::PCF8563 pcf8563_chip;
+  sim::Bus::get(kTestI2CPort)
+      .attach(sim::PCF8523::kAddress, &golden_pcf8523_chip);
+  sim::Bus::get(kTestI2CPort + 1)
+      .attach(sim::PCF8523::kAddress, &pcf8523_chip);
+  sim::Bus::get(kTestI2CPort)
+      .attach(sim::PCF8563::kAddress, &golden_pcf8563_chip);
+  sim::Bus::get(kTestI2CPort + 1)
+      .attach(sim::PCF8563::kAddress, &pcf8563_chip);
+  PCF8523 golden_pcf8523(Master(kTestI2CPort, nullptr));
+  PCF8523 pcf8523(Master(kTestI2CPort + 1, nullptr));
+  PCF8563 golden_pcf8563(Master(kTestI2CPort, nullptr));
+  PCF8563 pcf8563(Master(kTestI2CPort + 1, nullptr));
+  sim::Simulator simulator;
+  simulator.addChip(&pcf8523_chip);
+  simulator.addChip(&pcf8563_chip);
+
+  TEST_ASSERT_TRUE(
+      golden_pcf8523.enableCountdownTimer(PCF8523_FrequencySecond, 100));
+  uint8_t pcf8523_values[PCF8523::kNumRegisters];
+  TEST_ASSERT_TRUE(golden_pcf8523.dumpRegisters(pcf8523_values));
+  TEST_ASSERT_TRUE(pcf8523.restoreRegisters(pcf8523_values));
+  uint8_t pcf8523_restored[PCF8523::kNumRegisters];
+  TEST_ASSERT_TRUE(pcf8523.dumpRegisters(pcf8523_restored));
+  TEST_ASSERT_EQUAL_HEX8(pcf8523_values[PCF8523Registers::kTmrClkout],
+                         pcf8523_restored[PCF8523Registers::kTmrClkout]);
+  TEST_ASSERT_EQUAL(100, pcf8523_restored[PCF8523Registers::kTmrB]);
+
+  TEST_ASSERT_TRUE(
+      golden_pcf8563.enableCountdownTimer(PCF8563_FrequencySecond, 100));
+  uint8_t pcf8563_values[PCF8563::kNumRegisters];
+  TEST_ASSERT_TRUE(golden_pcf8563.dumpRegisters(pcf8563_values));
+  TEST_ASSERT_TRUE(pcf8563.restoreRegisters(pcf8563_values));
+  uint8_t pcf8563_restored[PCF8563::kNumRegisters];
+  TEST_ASSERT_TRUE(pcf8563.dumpRegisters(pcf8563_restored));
+  TEST_ASSERT_EQUAL_HEX8(pcf8563_values[PCF8563Registers::kTimerControl],
+                         pcf8563_restored[PCF8563Registers::kTimerControl]);
+  TEST_ASSERT_EQUAL(100, pcf8563_restored[PCF8563Registers::kTimer]);
+
+  // Both count down from there.
+  simulator.runFor(10 * kMicrosPerSecond);
+  TEST_ASSERT_TRUE(pcf8523.dumpRegisters(pcf8523_restored));
+  TEST_ASSERT_INT_WITHIN(1, 90, pcf8523_restored[PCF8523Registers::kTmrB]);
+  TEST_ASSERT_TRUE(pcf8563.dumpRegisters(pcf8563_restored));
+  TEST_ASSERT_INT_WITHIN(1, 90, pcf8563_restored[PCF8563Registers::kTimer]);
+}
+
+}  // namespace
+
+void run_register_map_tests() {
+  RUN_TEST(test_register_map_field);
+  RUN_TEST(test_register_map_decode_fallback);
+  RUN_TEST(test_register_map_sqw_pin_modes);
+  RUN_TEST(test_register_map_dump_restore);
+  RUN_TEST(test_register_map_restore_skips_registers);
+  RUN_TEST(test_register_map_restore_starts_timers);
+}
@@ -0,0 +1,138 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+#include <cstdio>
+
+#include <i2clib/master.h>
+#include <rtclib/datetime.h>
+#include <rtclib/ds1307.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/precision_setter.h>
+#include <rtclib/rtc_timestamper.h>
+#include <rtclib/system_clock.h>
+#include "sim_ds1307.h"
+#include "sim_ds3231.h"
+#include "sim_simulator.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+
+// A 100 kHz bus: about 90 µs a byte, and some overhead.
+constexpr int64_t kTransactionMicros = 400;
+constexpr int64_t kByteMicros = 90;
+
+/**
+ * A DS3231 on a bus with realistic timing, set to |time| at the start of
+ * the simulation.
+ */
+struct Rig {
+  explicit Rig(const DateTime& time) : rtc(Master(kTestI2CPort, nullptr)) {
+    simulator.addChip(&chip);
+    sim::Bus::get(kTestI2CPort).attach(sim::DS3231::kAddress, &chip);
+    sim::Bus::get(kTestI2CPort).setTiming(kTransactionMicros, kByteMicros);
+    chip.setTime(time);
+  }
+
+  sim::Simulator simulator;
+  sim::DS3231 chip;
+  DS3231 rtc;
+};
+
+void test_rtc_timestamper_read() {
+  Rig rig(DateTime(2021, 3, 1, 12, 0, 0));
+  RtcTimestamper timestamper = RtcTimestamper::forRtc(&rig.rtc);
+  rig.simulator.runFor(2500000);
+  RtcTimestamper::Reading reading;
+  TEST_ASSERT_TRUE(timestamper.read(&reading));
+  TEST_ASSERT_TRUE(reading.time == DateTime(2021, 3, 1, 12, 0, 2));
+  // The register and 7 time bytes.
+  const int64_t duration = kTransactionMicros + 9 * kByteMicros;
+  TEST_ASSERT_EQUAL_INT64(2500000 + duration / 2, reading.local_micros);
+  TEST_ASSERT_EQUAL_INT64(duration / 2, reading.uncertainty_micros);
+}
+
+void test_rtc_timestamper_rollover() {
+  Rig rig(DateTime(2021, 3, 1, 12, 0, 0));
+  RtcTimestamper timestamper = RtcTimestamper::forRtc(&rig.rtc);
+  rig.simulator.runFor(300000);
+  RtcTimestamper::Reading reading;
+  TEST_ASSERT_TRUE(timestamper.waitForRollover(&reading));
+  TEST_ASSERT_TRUE(reading.time == DateTime(2021, 3, 1, 12, 0, 1));
+  TEST_ASSERT_INT64_WITHIN(reading.uncertainty_micros, kMicrosPerSecond,
+                           reading.local_micros);
+  // Two one byte reads.
+  TEST_ASSERT_LESS_OR_EQUAL(kTransactionMicros + 3 * kByteMicros,
+                            reading.uncertainty_micros);
+
+  char msg[80];
+  snprintf(msg, sizeof(msg), "Rollover timestamped to +/- %lld us",
+           static_cast<long long>(reading.uncertainty_micros));
+  TEST_MESSAGE(msg);
+
+  // Polling less often is less precise.
+  RtcTimestamper::Config config;
+  config.poll_interval = 10000;
+  RtcTimestamper slow = RtcTimestamper::forRtc(&rig.rtc, config);
+  TEST_ASSERT_TRUE(slow.waitForRollover(&reading));
+  TEST_ASSERT_TRUE(reading.time == DateTime(2021, 3, 1, 12, 0, 2));
+  TEST_ASSERT_INT64_WITHIN(reading.uncertainty_micros, 2 * kMicrosPerSecond,
+                           reading.local_micros);
+  TEST_ASSERT_GREATER_THAN(5000, reading.uncertainty_micros);
+}
+
+void test_rtc_timestamper_checks_precision_setter() {
+  Rig rig(DateTime(2021, 3, 1));
+  const int64_t epoch =
+      static_cast<int64_t>(DateTime(2022, 5, 7).unixtime()) * kMicrosPerSecond;
+  PrecisionSetter setter(PrecisionSetter::adjuster(&rig.rtc));
+  RtcTimestamper timestamper = RtcTimestamper::forRtc(&rig.rtc);
+  rig.simulator.runFor(654321);
+  TEST_ASSERT_TRUE(setter.set(SystemClock::microsSinceStart(),
+                              epoch + rig.simulator.now()));
+
+  // The RTC's seconds start on the reference's.
+  RtcTimestamper::Reading reading;
+  TEST_ASSERT_TRUE(timestamper.waitForRollover(&reading));
+  const int64_t second =
+      static_cast<int64_t>(reading.time.unixtime()) * kMicrosPerSecond;
+  TEST_ASSERT_INT64_WITHIN(reading.uncertainty_micros + 2000, second,
+                           epoch + reading.local_micros);
+}
+
+void test_rtc_timestamper_stopped() {
+  // A DS1307 is halted at power-on.
+  sim::Simulator simulator;
+  sim::DS1307 chip;
+  simulator.addChip(&chip);
+  sim::Bus::get(kTestI2CPort).attach(sim::DS1307::kAddress, &chip);
+  sim::Bus::get(kTestI2CPort).setTiming(kTransactionMicros, kByteMicros);
+  DS1307 rtc(Master(kTestI2CPort, nullptr));
+  RtcTimestamper timestamper = RtcTimestamper::forRtc(&rtc);
+  RtcTimestamper::Reading reading;
+  TEST_ASSERT_FALSE(timestamper.waitForRollover(&reading));
+  TEST_ASSERT_GREATER_OR_EQUAL(1100000, SystemClock::microsSinceStart());
+
+  sim::Bus::get(kTestI2CPort).detach(sim::DS1307::kAddress);
+  TEST_ASSERT_FALSE(timestamper.read(&reading));
+}
+
+}  // namespace
+
+void run_rtc_timestamper_tests() {
+  RUN_TEST(test_rtc_timestamper_read);
+  RUN_TEST(test_rtc_timestamper_rollover);
+  RUN_TEST(test_rtc_timestamper_checks_precision_setter);
+  RUN_TEST(test_rtc_timestamper_stopped);
+}
@@ -0,0 +1,312 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include <i2clib/master.h>
+#include <rtclib/datetime.h>
+#include <rtclib/ds1307.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/micros.h>
+#include <rtclib/pcf8523.h>
+#include <rtclib/pcf8563.h>
+#include <rtclib/system_clock.h>
+#include "sim_ds1307.h"
+#include "sim_ds3231.h"
+#include "sim_pcf8523.h"
+#include "sim_pcf8563.h"
+#include "sim_simulator.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+constexpr int64_t kMicrosPerMinute = 60 * kMicrosPerSecond;
+constexpr int64_t kMicrosPerHour = 60 * kMicrosPerMinute;
+constexpr int64_t kMicrosPerDay = 24 * kMicrosPerHour;
+
+/**
+ * All four RTCs, with their drivers. The DS1307, DS3231 and PCF8523 share
+ * an I2C address, so each is on its own port.
+ */
+struct Rig {
+  Rig()
+      : ds1307_chip(20),
+        ds3231_chip(2),
+        pcf8523_chip(-15),
+        pcf8563_chip(35),
+        ds1307(Master(kTestI2CPort, nullptr)),
+        ds3231(Master(kTestI2CPort + 1, nullptr)),
+        pcf8523(Master(kTestI2CPort + 2, nullptr)),
+        pcf8563(Master(kTestI2CPort + 1, nullptr)) {
+    sim::Bus::get(kTestI2CPort).attach(sim::DS1307::kAddress, &ds1307_chip);
+    sim::Bus::get(kTestI2CPort + 1)
+        .attach(sim::DS3231::kAddress, &ds3231_chip);
+    sim::Bus::get(kTestI2CPort + 2)
+        .attach(sim::PCF8523::kAddress, &pcf8523_chip);
+    sim::Bus::get(kTestI2CPort + 1)
+        .attach(sim::PCF8563::kAddress, &pcf8563_chip);
+    simulator.addChip(&ds1307_chip);
+    simulator.addChip(&ds3231_chip);
+    simulator.addChip(&pcf8523_chip);
+    simulator.addChip(&pcf8563_chip);
+  }
+
+  void adjustAll(const DateTime& dt) {
+    TEST_ASSERT_TRUE(ds1307.adjust(dt));
+    TEST_ASSERT_TRUE(ds3231.adjust(dt));
+    TEST_ASSERT_TRUE(pcf8523.adjust(dt));
+    TEST_ASSERT_TRUE(pcf8563.adjust(dt));
+  }
+
+  sim::DS1307 ds1307_chip;
+  sim::DS3231 ds3231_chip;
+  sim::PCF8523 pcf8523_chip;
+  sim::PCF8563 pcf8563_chip;
+  DS1307 ds1307;
+  DS3231 ds3231;
+  PCF8523 pcf8523;
+  PCF8563 pcf8563;
+  sim::Simulator simulator;
+};
+
+/**
+ * Seconds by which |actual| differs from |expected|.
+ */
+int32_t secondsOff(const DateTime& expected, const DateTime& actual) {
+  return static_cast<int32_t>(actual.unixtime() - expected.unixtime());
+}
+
+void test_simulator_event_order() {
+  sim::Simulator simulator;
+  std::vector<int> order;
+  std::vector<int64_t> system_times;
+  simulator.schedule(2000, [&] { order.push_back(2); });
+  simulator.schedule(1000, [&] { order.push_back(1); });
+  simulator.schedule(2000, [&] { order.push_back(3); });
+  const sim::Simulator::EventId cancelled =
+      simulator.schedule(1500, [&] { order.push_back(-1); });
+  simulator.schedule(3000, [&] {
+    order.push_back(4);
+    system_times.push_back(SystemClock::microsSinceStart());
+    // Scheduled from an event, at the current time.
+    simulator.scheduleIn(0, [&] { order.push_back(5); });
+  });
+  int ticks = 0;
+  const sim::Simulator::EventId every =
+      simulator.scheduleEvery(700, [&] { ticks++; });
+  simulator.cancel(cancelled);
+
+  simulator.runUntil(3000);
+  TEST_ASSERT_EQUAL_INT64(3000, simulator.now());
+  TEST_ASSERT_EQUAL_INT(5, order.size());
+  for (size_t i = 0; i < order.size(); i++)
+    TEST_ASSERT_EQUAL_INT(static_cast<int>(i) + 1, order[i]);
+  TEST_ASSERT_EQUAL_INT64(3000, system_times[0]);
+  TEST_ASSERT_EQUAL_INT(4, ticks);  // 700, 1400, 2100, 2800.
+
+  simulator.cancel(every);
+  simulator.runFor(10000);
+  TEST_ASSERT_EQUAL_INT(4, ticks);
+  TEST_ASSERT_EQUAL_INT64(13000, SystemClock::microsSinceStart());
+}
+
+void test_simulator_system_clock_drift() {
+  sim::Simulator simulator;
+  sim::Oscillator oscillator(50, 0, 1);
+  simulator.setSystemOscillator(&oscillator);
+  Micros::adjustDriftPpb(0);
+  Micros::adjust(DateTime(2021, 3, 1));
+
+  simulator.runFor(kMicrosPerDay);
+  // 50 ppm fast: 4.32 seconds per day.
+  TEST_ASSERT_INT64_WITHIN(
+      1, static_cast<int64_t>(DateTime(2021, 3, 2).unixtime()) *
+                 kMicrosPerSecond +
+             4320000,
+      Micros::nowMicros());
+}
+
+void test_simulator_week() {
+  const auto wall_start = std::chrono::steady_clock::now();
+  Rig rig;
+  const DateTime start(2021, 3, 1);
+  rig.adjustAll(start);
+
+  // DS3231 alarm 1 every hour at mm:ss = 30:00, and alarm 2 daily at 06:15.
+  TEST_ASSERT_TRUE(rig.ds3231.setAlarm1(DateTime(2021, 3, 1, 0, 30, 0),
+                                        DS3231::Alarm1Mode::Minute));
+  TEST_ASSERT_TRUE(rig.ds3231.setAlarm2(DateTime(2021, 3, 1, 6, 15, 0),
+                                        DS3231::Alarm2Mode::Hour));
+  // PCF8563 alarm daily at 12:00 (minute, hour enabled; day, weekday not).
+  rig.pcf8563_chip.reg(0x09) = 0x00;
+  rig.pcf8563_chip.reg(0x0A) = 0x12;
+  rig.pcf8563_chip.reg(0x0B) = 0x80;
+  rig.pcf8563_chip.reg(0x0C) = 0x80;
+  rig.pcf8563_chip.reg(0x01) = 0x02;  // AIE.
+
+  int hourly = 0;
+  int daily = 0;
+  int noon = 0;
+  int wrong_time = 0;
+  rig.simulator.onInterrupt(&rig.ds3231_chip, [&] {
+    DateTime now;
+    TEST_ASSERT_TRUE(rig.ds3231.now(&now));
+    if (rig.ds3231.isAlarmFired(DS3231::Alarm::A1)) {
+      hourly++;
+      if (now.minute() != 30 || now.second() != 0)
+        wrong_time++;
+      rig.ds3231.clearAlarm(DS3231::Alarm::A1);
+    }
+    if (rig.ds3231.isAlarmFired(DS3231::Alarm::A2)) {
+      daily++;
+      if (now.hour() != 6 || now.minute() != 15 || now.second() != 0)
+        wrong_time++;
+      rig.ds3231.clearAlarm(DS3231::Alarm::A2);
+    }
+  });
+  rig.simulator.onInterrupt(&rig.pcf8563_chip, [&] {
+    noon++;
+    DateTime now;
+    TEST_ASSERT_TRUE(rig.pcf8563.now(&now));
+    if (now.hour() != 12 || now.minute() != 0 || now.second() != 0)
+      wrong_time++;
+    rig.pcf8563_chip.reg(0x01) &= ~0x08;  // Clear AF.
+  });
+
+  // A 20 minute outage on day 3, between alarms. The batteries keep the
+  // clocks running.
+  bool reachable_during_outage = true;
+  rig.simulator.schedule(2 * kMicrosPerDay + 10 * kMicrosPerHour +
+                             35 * kMicrosPerMinute,
+                         [&] { rig.simulator.powerOff(); });
+  rig.simulator.schedule(
+      2 * kMicrosPerDay + 10 * kMicrosPerHour + 45 * kMicrosPerMinute, [&] {
+        DateTime now;
+        reachable_during_outage = rig.ds3231.now(&now) || rig.ds1307.begin();
+      });
+  rig.simulator.schedule(2 * kMicrosPerDay + 10 * kMicrosPerHour +
+                             55 * kMicrosPerMinute,
+                         [&] { rig.simulator.powerOn(); });
+
+  rig.simulator.runFor(7 * kMicrosPerDay);
+
+  TEST_ASSERT_EQUAL_INT(7 * 24, hourly);
+  TEST_ASSERT_EQUAL_INT(7, daily);
+  TEST_ASSERT_EQUAL_INT(7, noon);
+  TEST_ASSERT_EQUAL_INT(0, wrong_time);
+  TEST_ASSERT_FALSE(reachable_during_outage);
+
+  // Each chip drifted by its crystal error: 1 ppm is 0.6 s per week.
+  const DateTime end(start.unixtime() + 7 * SECONDS_PER_DAY);
+  DateTime now;
+  TEST_ASSERT_TRUE(rig.ds1307.now(&now));
+  TEST_ASSERT_INT32_WITHIN(1, 12, secondsOff(end, now));
+  TEST_ASSERT_TRUE(rig.ds3231.now(&now));
+  TEST_ASSERT_INT32_WITHIN(1, 1, secondsOff(end, now));
+  TEST_ASSERT_TRUE(rig.pcf8523.now(&now));
+  TEST_ASSERT_INT32_WITHIN(1, -9, secondsOff(end, now));
+  TEST_ASSERT_TRUE(rig.pcf8563.now(&now));
+  TEST_ASSERT_INT32_WITHIN(1, 21, secondsOff(end, now));
+
+  TEST_ASSERT_TRUE(rig.ds1307.isRunning());
+  TEST_ASSERT_FALSE(rig.ds3231.lostPower());
+  TEST_ASSERT_FALSE(rig.pcf8523.lostPower());
+  TEST_ASSERT_FALSE(rig.pcf8563.lostPower());
+  // The system rebooted during the outage.
+  TEST_ASSERT_EQUAL_INT64(
+      7 * kMicrosPerDay -
+          (2 * kMicrosPerDay + 10 * kMicrosPerHour + 55 * kMicrosPerMinute),
+      SystemClock::microsSinceStart());
+
+  const double elapsed_ms =
+      std::chrono::duration<double, std::milli>(
+          std::chrono::steady_clock::now() - wall_start)
+          .count();
+  char msg[80];
+  snprintf(msg, sizeof(msg), "Simulated 7 days in %.1f ms", elapsed_ms);
+  TEST_MESSAGE(msg);
+}
+
+void test_simulator_power_loss_without_battery() {
+  Rig rig;
+  rig.adjustAll(DateTime(2021, 3, 1));
+  const uint8_t data[4] = {1, 2, 3, 4};
+  TEST_ASSERT_TRUE(rig.ds1307.writeNVRAM(0, data, sizeof(data)));
+  rig.ds1307_chip.setBattery(false);
+  rig.ds3231_chip.setBattery(false);
+  rig.pcf8523_chip.setBattery(false);
+  rig.pcf8563_chip.setBattery(false);
+
+  rig.simulator.runFor(kMicrosPerHour);
+  rig.simulator.powerOff();
+  rig.simulator.runFor(kMicrosPerMinute);
+  rig.simulator.powerOn();
+  rig.simulator.runFor(kMicrosPerMinute);
+
+  TEST_ASSERT_FALSE(rig.ds1307.isRunning());
+  TEST_ASSERT_TRUE(rig.ds3231.lostPower());
+  TEST_ASSERT_TRUE(rig.pcf8523.lostPower());
+  TEST_ASSERT_FALSE(rig.pcf8523.initialized());
+  TEST_ASSERT_TRUE(rig.pcf8563.lostPower());
+  uint8_t read[4];
+  TEST_ASSERT_TRUE(rig.ds1307.readnvram(0, read, sizeof(read)));
+  TEST_ASSERT_EQUAL_UINT8(0, read[0]);
+
+  // The clocks restarted from their reset value (except the halted
+  // DS1307).
+  DateTime now;
+  TEST_ASSERT_TRUE(rig.ds3231.now(&now));
+  TEST_ASSERT_EQUAL_UINT32(DateTime(2000, 1, 1, 0, 1, 0).unixtime(),
+                           now.unixtime());
+  TEST_ASSERT_TRUE(rig.ds1307.now(&now));
+  TEST_ASSERT_EQUAL_UINT32(DateTime(2000, 1, 1).unixtime(), now.unixtime());
+}
+
+void test_simulator_pcf8523_battery_switch_over() {
+  // After a power-on reset the PCF8523's battery switch-over is disabled
+  // until configured (adjust() enables it), so the battery doesn't help.
+  sim::Simulator simulator;
+  sim::PCF8523 chip;
+  simulator.addChip(&chip);
+  sim::Bus::get(kTestI2CPort).attach(sim::PCF8523::kAddress, &chip);
+  PCF8523 rtc(Master(kTestI2CPort, nullptr));
+  chip.setTime(DateTime(2021, 3, 1));
+  chip.reg(0x03) &= 0x7F;  // Clear OS.
+
+  simulator.powerOff();
+  simulator.runFor(kMicrosPerMinute);
+  simulator.powerOn();
+  TEST_ASSERT_TRUE(rtc.lostPower());
+
+  TEST_ASSERT_TRUE(rtc.adjust(DateTime(2021, 3, 1)));
+  simulator.powerOff();
+  simulator.runFor(kMicrosPerMinute);
+  simulator.powerOn();
+  TEST_ASSERT_FALSE(rtc.lostPower());
+  DateTime now;
+  TEST_ASSERT_TRUE(rtc.now(&now));
+  TEST_ASSERT_EQUAL_UINT32(DateTime(2021, 3, 1, 0, 1, 0).unixtime(),
+                           now.unixtime());
+}
+
+}  // namespace
+
+void run_simulator_tests() {
+  RUN_TEST(test_simulator_event_order);
+  RUN_TEST(test_simulator_system_clock_drift);
+  RUN_TEST(test_simulator_week);
+  RUN_TEST(test_simulator_power_loss_without_battery);
+  RUN_TEST(test_simulator_pcf8523_battery_switch_over);
+}
@@ -0,0 +1,132 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+#include <limits>
+
+#include <rtclib/datetime.h>
+#include <rtclib/micros.h>
+#include <rtclib/millis.h>
+#include <rtclib/software_clock.h>
+#include <rtclib/system_clock.h>
+#include <rtclib/tick_source.h>
+#include "tests.h"
+
+using namespace rtc;
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+constexpr int64_t kMicrosPerDay = 86400 * kMicrosPerSecond;
+
+void test_software_clock_independent_instances() {
+  ManualTickSource ticks_a;
+  ManualTickSource ticks_b(123456789);
+  SoftwareClock a(&ticks_a);
+  SoftwareClock b(&ticks_b);
+  a.adjust(DateTime(2021, 1, 1));
+  b.adjust(DateTime(2030, 6, 1));
+  b.adjustDriftPpb(1000);
+
+  ticks_a.advance(10 * kMicrosPerSecond);
+  TEST_ASSERT_EQUAL_UINT32(DateTime(2021, 1, 1, 0, 0, 10).unixtime(),
+                           a.now().unixtime());
+  TEST_ASSERT_EQUAL_UINT32(DateTime(2030, 6, 1).unixtime(),
+                           b.now().unixtime());
+  TEST_ASSERT_EQUAL_INT32(0, a.driftPpb());
+  TEST_ASSERT_EQUAL_INT32(1000, b.driftPpb());
+
+  ticks_b.advance(kMicrosPerSecond);
+  TEST_ASSERT_EQUAL_INT64(
+      static_cast<int64_t>(DateTime(2030, 6, 1).unixtime()) *
+              kMicrosPerSecond +
+          kMicrosPerSecond + 1,
+      b.nowMicros());
+}
+
+void test_software_clock_no_rollover() {
+  ManualTickSource ticks;
+  SoftwareClock clock(&ticks);
+  const int64_t start =
+      static_cast<int64_t>(DateTime(2021, 1, 1).unixtime()) *
+      kMicrosPerSecond;
+  clock.adjustMicros(start);
+
+  // Far beyond 2^32 microseconds (71.6 minutes) and 2^32 milliseconds
+  // (49.7 days), read only once.
+  ticks.advance(400 * kMicrosPerDay + 7);
+  TEST_ASSERT_EQUAL_INT64(start + 400 * kMicrosPerDay + 7, clock.nowMicros());
+
+  // And with a drift adjustment. The 32.32 rate is within 0.12 ppb of
+  // -2500 ppb, i.e. within 4 ms over 400 days.
+  clock.adjustDriftPpb(-2500);
+  ticks.advance(400 * kMicrosPerDay);
+  TEST_ASSERT_INT64_WITHIN(4000, start + 800 * kMicrosPerDay + 7 - 86400000,
+                           clock.nowMicros());
+}
+
+void test_software_clock_tick_source_epoch() {
+  // The tick source epoch is arbitrary, and may be negative.
+  ManualTickSource ticks(-5 * kMicrosPerDay);
+  SoftwareClock clock(&ticks);
+  clock.adjust(DateTime(2021, 1, 1));
+  ticks.advance(10 * kMicrosPerDay);
+  TEST_ASSERT_EQUAL_UINT32(DateTime(2021, 1, 11).unixtime(),
+                           clock.now().unixtime());
+}
+
+void test_software_clock_system_default() {
+  SystemClock::setMicrosSinceStart(5 * kMicrosPerSecond);
+  SoftwareClock clock;
+  clock.adjust(DateTime(2021, 1, 1));
+  Millis::adjust(DateTime(2022, 1, 1));
+  SystemClock::advanceMicros(60 * kMicrosPerDay + 999999);
+  TEST_ASSERT_EQUAL_UINT32(DateTime(2021, 3, 2).unixtime(),
+                           clock.now().unixtime());
+  TEST_ASSERT_EQUAL_UINT32(DateTime(2022, 3, 2).unixtime(),
+                           Millis::now().unixtime());
+}
+
+void test_system_clock_millis() {
+  // The reciprocal division against the real one, around every power of
+  // two and multiple of 1000 boundary, and at the limits.
+  const int64_t kMin = std::numeric_limits<int64_t>::min();
+  const int64_t kMax = std::numeric_limits<int64_t>::max();
+  const int64_t values[] = {kMin,     kMin + 1, kMin + 999, kMin + 1000,
+                            -1000001, -1000,    -999,       -1,
+                            0,        1,        999,        1000,
+                            1001,     999999,   1000000,    kMax - 1000,
+                            kMax - 1, kMax};
+  for (int64_t value : values) {
+    SystemClock::setMicrosSinceStart(value);
+    TEST_ASSERT_EQUAL_INT64(value / 1000, SystemClock::millisSinceStart());
+  }
+  for (int bit = 0; bit < 63; bit++) {
+    const int64_t power = static_cast<int64_t>(1) << bit;
+    for (int64_t delta = -1; delta <= 1; delta++) {
+      for (int64_t value : {power + delta, -power + delta,
+                            power / 1000 * 1000 + delta}) {
+        SystemClock::setMicrosSinceStart(value);
+        TEST_ASSERT_EQUAL_INT64(value / 1000,
+                                SystemClock::millisSinceStart());
+      }
+    }
+  }
+  SystemClock::setMicrosSinceStart(0);
+}
+
+}  // namespace
+
+void run_software_clock_tests() {
+  RUN_TEST(test_software_clock_independent_instances);
+  RUN_TEST(test_software_clock_no_rollover);
+  RUN_TEST(test_software_clock_tick_source_epoch);
+  RUN_TEST(test_software_clock_system_default);
+  RUN_TEST(test_system_clock_millis);
+}
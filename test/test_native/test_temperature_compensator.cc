@@ -0,0 +1,197 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cmath>
+
+#include <i2clib/master.h>
+#include <rtclib/clock_discipline.h>
+#include <rtclib/datetime.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/micros.h>
+#include <rtclib/software_clock.h>
+#include <rtclib/system_clock.h>
+#include <rtclib/temperature_compensator.h>
+#include <rtclib/tick_source.h>
+#include "sim_bus.h"
+#include "sim_ds3231.h"
+#include "tests.h"
+
+using i2c::Master;
+
+using namespace rtc;
+
+namespace {
+
+constexpr int64_t kMicrosPerMinute = 60 * 1000000LL;
+
+/**
+ * A typical 32.768 kHz tuning fork crystal, 20 ppm fast at the turnover.
+ */
+double crystalPpm(double celsius) {
+  return 20.0 - 0.034 * (celsius - 25.0) * (celsius - 25.0);
+}
+
+/**
+ * Advance true time by |micros|, and the system clock by the same amount
+ * plus the crystal error at |celsius|.
+ */
+void advance(int64_t micros, double celsius, int64_t* reference) {
+  *reference += micros;
+  SystemClock::advanceMicros(
+      micros + std::llround(micros * crystalPpm(celsius) * 1e-6));
+}
+
+void test_temperature_model_fits_parabola() {
+  TemperatureDriftModel model;
+  for (float t = -10; t <= 60; t += 5)
+    model.addSample(t, static_cast<float>(crystalPpm(t)));
+  TEST_ASSERT_EQUAL_UINT32(15, model.numSamples());
+  TEST_ASSERT_FLOAT_WITHIN(0.05, crystalPpm(25), model.ppmAt(25));
+  TEST_ASSERT_FLOAT_WITHIN(0.05, crystalPpm(-5), model.ppmAt(-5));
+  TEST_ASSERT_FLOAT_WITHIN(0.05, crystalPpm(52.5), model.ppmAt(52.5));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, -0.034, model.coefficients()[2]);
+}
+
+void test_temperature_model_fallbacks() {
+  TemperatureDriftModel model;
+  TEST_ASSERT_EQUAL_FLOAT(0, model.ppmAt(25));
+
+  // A single temperature: constant.
+  model.addSample(20, 12);
+  model.addSample(20, 14);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 13, model.ppmAt(40));
+
+  // Two temperatures: a line.
+  model.reset();
+  model.addSample(20, 10);
+  model.addSample(30, 20);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 15, model.ppmAt(25));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 25, model.ppmAt(35));
+}
+
+void test_ds3231_negative_temperature() {
+  sim::DS3231 chip;
+  sim::Bus::get(kTestI2CPort).attach(sim::DS3231::kAddress, &chip);
+  DS3231 rtc(Master(kTestI2CPort, nullptr));
+
+  chip.setTemperature(-10.25f);
+  TEST_ASSERT_EQUAL_FLOAT(-10.25f, rtc.getTemperature());
+  chip.setTemperature(31.75f);
+  TEST_ASSERT_EQUAL_FLOAT(31.75f, rtc.getTemperature());
+}
+
+void test_temperature_compensator_learns_and_retunes() {
+  sim::DS3231 chip;
+  sim::Bus::get(kTestI2CPort).attach(sim::DS3231::kAddress, &chip);
+  DS3231 rtc(Master(kTestI2CPort, nullptr));
+  SystemClock::setMicrosSinceStart(0);
+  Micros::adjustDrift(0);
+
+  int64_t reference = 0;
+  double celsius = 0;
+  chip.setTemperature(celsius);
+  TemperatureCompensator compensator(&rtc, Micros::softwareClock());
+  TEST_ASSERT_TRUE(compensator.begin(reference));
+
+  // Sweep the temperature between 0°C and 50°C. After each change sync
+  // once the temperature has settled, and again 20 minutes later.
+  for (int step = 0; step < 2 * 10; step++) {
+    celsius = step < 10 ? celsius + 5 : celsius - 5;
+    chip.setTemperature(celsius);
+    for (int minute = 0; minute < 22; minute++) {
+      advance(kMicrosPerMinute, celsius, &reference);
+      TEST_ASSERT_TRUE(compensator.update());
+      if (minute == 1 || minute == 21)
+        TEST_ASSERT_TRUE(compensator.sync(reference));
+    }
+  }
+  TEST_ASSERT_GREATER_OR_EQUAL(15, compensator.model().numSamples());
+
+  // Holdover at a cold temperature, without syncs: the Micros clock must be
+  // retuned to the modeled drift.
+  celsius = 5;
+  chip.setTemperature(celsius);
+  advance(2 * kMicrosPerMinute, celsius, &reference);
+  TEST_ASSERT_TRUE(compensator.update());
+  TEST_ASSERT_INT_WITHIN(100, -std::lround(crystalPpm(celsius) * 1000),
+                         compensator.appliedPpb());
+
+  const DateTime start(2021, 6, 1);
+  Micros::adjust(start);
+  const int64_t holdover = 7 * 24 * 60 * kMicrosPerMinute;
+  for (int64_t t = 0; t < holdover; t += kMicrosPerMinute) {
+    advance(kMicrosPerMinute, celsius, &reference);
+    TEST_ASSERT_TRUE(compensator.update());
+  }
+  const DateTime now = Micros::now();
+  // 6.5 ppm is 3.9 s of uncompensated drift over a week; the compensated
+  // clock must stay within a second.
+  TEST_ASSERT_INT_WITHIN(1, start.unixtime() + 7 * 24 * 3600,
+                         now.unixtime());
+  Micros::adjustDrift(0);
+}
+
+void test_temperature_compensator_feeds_discipline() {
+  sim::DS3231 chip;
+  sim::Bus::get(kTestI2CPort).attach(sim::DS3231::kAddress, &chip);
+  DS3231 rtc(Master(kTestI2CPort, nullptr));
+  SystemClock::setMicrosSinceStart(0);
+  SoftwareClock clock;
+  ClockDiscipline discipline(&clock);
+  discipline.restore(1500);
+  TemperatureCompensator compensator(&rtc, &discipline);
+
+  int64_t reference = 0;
+  chip.setTemperature(25);
+  TEST_ASSERT_TRUE(compensator.begin(reference));
+  advance(11 * kMicrosPerMinute, 25, &reference);
+  TEST_ASSERT_TRUE(compensator.sync(reference));
+
+  // The correction is added to the discipline's, rather than replacing it.
+  TEST_ASSERT_INT_WITHIN(10, -20000, compensator.appliedPpb());
+  TEST_ASSERT_EQUAL(compensator.appliedPpb(), discipline.feedForwardPpb());
+  TEST_ASSERT_EQUAL(1500, discipline.frequencyPpb());
+  TEST_ASSERT_EQUAL(compensator.appliedPpb() + 1500, clock.driftPpb());
+}
+
+void test_temperature_compensator_own_timebase() {
+  sim::DS3231 chip;
+  sim::Bus::get(kTestI2CPort).attach(sim::DS3231::kAddress, &chip);
+  DS3231 rtc(Master(kTestI2CPort, nullptr));
+  SystemClock::setMicrosSinceStart(0);
+  ManualTickSource source;
+  SoftwareClock clock(&source);
+  ClockDiscipline discipline(&clock);
+  TemperatureCompensator compensator(&rtc, &discipline);
+
+  // The clock's source runs 20 ppm fast at 25°C. The system clock runs at
+  // a different rate, and must not be used to time the interval.
+  int64_t reference = 0;
+  chip.setTemperature(25);
+  TEST_ASSERT_TRUE(compensator.begin(reference));
+  const int64_t interval = 11 * kMicrosPerMinute;
+  reference += interval;
+  source.advance(interval + std::llround(interval * crystalPpm(25) * 1e-6));
+  SystemClock::advanceMicros(interval / 2);
+  TEST_ASSERT_TRUE(compensator.sync(reference));
+
+  TEST_ASSERT_INT_WITHIN(10, -20000, compensator.appliedPpb());
+  TEST_ASSERT_EQUAL(compensator.appliedPpb(), clock.driftPpb());
+}
+
+}  // namespace
+
+void run_temperature_compensator_tests() {
+  RUN_TEST(test_temperature_model_fits_parabola);
+  RUN_TEST(test_temperature_model_fallbacks);
+  RUN_TEST(test_ds3231_negative_temperature);
+  RUN_TEST(test_temperature_compensator_learns_and_retunes);
+  RUN_TEST(test_temperature_compensator_feeds_discipline);
+  RUN_TEST(test_temperature_compensator_own_timebase);
+}
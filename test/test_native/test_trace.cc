@@ -0,0 +1,164 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <i2clib/master.h>
+#include <rtclib/clock_discipline.h>
+#include <rtclib/datetime.h>
+#include <rtclib/ds3231.h>
+#include <rtclib/micros.h>
+#include <rtclib/system_clock.h>
+#include <rtclib/trace.h>
+#include "sim_ds3231.h"
+#include "tests.h"
+
+using namespace rtc;
+using i2c::Master;
+
+namespace {
+
+bool contains(const std::string& str, const char* substr) {
+  return str.find(substr) != std::string::npos;
+}
+
+void test_trace_chrome_json() {
+  const TraceEvent events[] = {
+      {"i2c", "now", 1000, 1, 0x68, TraceEvent::Phase::Begin},
+      {"i2c", "now", 1250, 1, Trace::kNoArg, TraceEvent::Phase::End},
+      {"app", "say \"hi\"", 2000, 2, Trace::kNoArg, TraceEvent::Phase::Begin},
+  };
+  const std::string json = Trace::toChromeJson(events, 3);
+  TEST_ASSERT_TRUE(contains(json, "{\"traceEvents\":["));
+  TEST_ASSERT_TRUE(
+      contains(json, "{\"name\":\"now\",\"cat\":\"i2c\",\"ph\":\"B\","
+                     "\"ts\":1000,\"pid\":1,\"tid\":1,"
+                     "\"args\":{\"arg\":104}}"));
+  TEST_ASSERT_TRUE(
+      contains(json, "{\"name\":\"now\",\"cat\":\"i2c\",\"ph\":\"E\","
+                     "\"ts\":1250,\"pid\":1,\"tid\":1}"));
+  TEST_ASSERT_TRUE(contains(json, "\"name\":\"say \\\"hi\\\"\""));
+  TEST_ASSERT_TRUE(contains(json, "\"tid\":2}\n]"));
+
+  TEST_ASSERT_TRUE(contains(Trace::toChromeJson(events, 0),
+                            "{\"traceEvents\":[\n]"));
+}
+
+#if defined(RTC_TRACING)
+
+void test_trace_drivers_and_clocks() {
+  sim::DS3231 chip;
+  sim::Bus::get(kTestI2CPort).attach(sim::DS3231::kAddress, &chip);
+  DS3231 rtc(Master(kTestI2CPort, nullptr));
+  ClockDiscipline discipline(Micros::softwareClock());
+  Trace::clear();
+
+  DateTime now;
+  TEST_ASSERT_TRUE(rtc.now(&now));
+  discipline.update(0);
+  Micros::adjustDriftPpb(0);
+
+  TraceEvent events[8];
+  TEST_ASSERT_EQUAL(4, Trace::snapshot(events, 8));
+  TEST_ASSERT_EQUAL_STRING("i2c", events[0].category);
+  TEST_ASSERT_EQUAL_STRING("now", events[0].name);
+  TEST_ASSERT_EQUAL(sim::DS3231::kAddress, events[0].arg);
+  TEST_ASSERT_TRUE(events[0].phase == TraceEvent::Phase::Begin);
+  TEST_ASSERT_EQUAL_STRING("now", events[1].name);
+  TEST_ASSERT_TRUE(events[1].phase == TraceEvent::Phase::End);
+  TEST_ASSERT_EQUAL_STRING("clock", events[2].category);
+  TEST_ASSERT_TRUE(events[2].phase == TraceEvent::Phase::Begin);
+  TEST_ASSERT_TRUE(events[3].phase == TraceEvent::Phase::End);
+  TEST_ASSERT_EQUAL(events[0].thread, events[3].thread);
+  Trace::clear();
+}
+
+void test_trace_ring_overwrites_oldest() {
+  Trace::clear();
+  const int64_t start = SystemClock::microsSinceStart();
+  const size_t num_events = Trace::kCapacity + 10;
+  for (size_t i = 0; i < num_events; i++) {
+    SystemClock::advanceMicros(1);
+    Trace::begin("test", "event", static_cast<int32_t>(i));
+  }
+
+  std::vector<TraceEvent> events(Trace::kCapacity + 1);
+  TEST_ASSERT_EQUAL(Trace::kCapacity,
+                    Trace::snapshot(events.data(), events.size()));
+  TEST_ASSERT_EQUAL(10, events[0].arg);
+  TEST_ASSERT_EQUAL(start + 11, events[0].micros);
+  TEST_ASSERT_EQUAL(num_events - 1, events[Trace::kCapacity - 1].arg);
+
+  // Only as many as asked for, oldest first.
+  TEST_ASSERT_EQUAL(2, Trace::snapshot(events.data(), 2));
+  TEST_ASSERT_EQUAL(10, events[0].arg);
+  Trace::clear();
+  TEST_ASSERT_EQUAL(0, Trace::snapshot(events.data(), events.size()));
+}
+
+void test_trace_threads() {
+  Trace::clear();
+  constexpr int kScopes = 20;
+  auto work = [] {
+    for (int i = 0; i < kScopes; i++)
+      TraceScope trace("test", "work");
+  };
+  std::thread a(work);
+  std::thread b(work);
+  a.join();
+  b.join();
+
+  // Every thread's events are complete and balanced.
+  std::vector<TraceEvent> events(Trace::kCapacity);
+  const size_t count = Trace::snapshot(events.data(), events.size());
+  TEST_ASSERT_EQUAL(4 * kScopes, count);
+  const uint32_t thread_a = events[0].thread;
+  uint32_t thread_b = thread_a;
+  int depth_a = 0, depth_b = 0;
+  for (size_t i = 0; i < count; i++) {
+    const TraceEvent& event = events[i];
+    if (event.thread != thread_a)
+      thread_b = event.thread;
+    int& depth = event.thread == thread_a ? depth_a : depth_b;
+    depth += event.phase == TraceEvent::Phase::Begin ? 1 : -1;
+    TEST_ASSERT_TRUE(depth == 0 || depth == 1);
+  }
+  TEST_ASSERT_TRUE(thread_a != thread_b);
+  TEST_ASSERT_EQUAL(0, depth_a);
+  TEST_ASSERT_EQUAL(0, depth_b);
+  Trace::clear();
+}
+
+#else  // defined(RTC_TRACING)
+
+void test_trace_disabled() {
+  TEST_ASSERT_FALSE(Trace::enabled());
+  { TraceScope trace("test", "scope"); }
+  TraceEvent events[1];
+  TEST_ASSERT_EQUAL(0, Trace::snapshot(events, 1));
+}
+
+#endif  // defined(RTC_TRACING)
+
+}  // namespace
+
+void run_trace_tests() {
+  RUN_TEST(test_trace_chrome_json);
+#if defined(RTC_TRACING)
+  RUN_TEST(test_trace_drivers_and_clocks);
+  RUN_TEST(test_trace_ring_overwrites_oldest);
+  RUN_TEST(test_trace_threads);
+#else
+  RUN_TEST(test_trace_disabled);
+#endif
+}
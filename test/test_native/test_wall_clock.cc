@@ -0,0 +1,157 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#include <unity.h>
+
+#include <rtclib/datetime.h>
+#include <rtclib/system_clock.h>
+#include <rtclib/wall_clock.h>
+#include "tests.h"
+
+using namespace rtc;
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+
+int64_t unixMicros(const DateTime& dt) {
+  return static_cast<int64_t>(dt.unixtime()) * kMicrosPerSecond;
+}
+
+void test_wall_clock_first_adjust_steps() {
+  SystemClock::setMicrosSinceStart(5 * kMicrosPerSecond);
+  WallClock clock;
+  const DateTime dt(2021, 4, 1, 12, 0, 0);
+  clock.adjust(dt);
+  // The middle of the second.
+  TEST_ASSERT_EQUAL_INT64(unixMicros(dt) + 500000, clock.nowMicros());
+  TEST_ASSERT_EQUAL_UINT32(1, clock.steps());
+  SystemClock::advanceMicros(2000000);
+  TEST_ASSERT_EQUAL_UINT32(dt.unixtime() + 2, clock.now().unixtime());
+}
+
+void test_wall_clock_slews_small_corrections() {
+  SystemClock::setMicrosSinceStart(0);
+  WallClock clock;  // 500 ppm max slew, 128 ms step threshold.
+  const int64_t start = unixMicros(DateTime(2021, 4, 1));
+  clock.step(start);
+
+  // The clock is 100 ms slow: correct it.
+  SystemClock::advanceMicros(10 * kMicrosPerSecond);
+  clock.adjustMicros(start + 10 * kMicrosPerSecond + 100000);
+  TEST_ASSERT_EQUAL_UINT32(1, clock.steps());
+  TEST_ASSERT_EQUAL_INT64(100000, clock.remainingSlew());
+  TEST_ASSERT_EQUAL_INT64(start + 10 * kMicrosPerSecond, clock.nowMicros());
+
+  // After 100 s at 500 ppm, half has been slewed.
+  SystemClock::advanceMicros(100 * kMicrosPerSecond);
+  TEST_ASSERT_EQUAL_INT64(50000, clock.remainingSlew());
+  TEST_ASSERT_EQUAL_INT64(start + 110 * kMicrosPerSecond + 50000,
+                          clock.nowMicros());
+
+  // And after 200 s it is all slewed.
+  SystemClock::advanceMicros(200 * kMicrosPerSecond);
+  TEST_ASSERT_EQUAL_INT64(0, clock.remainingSlew());
+  TEST_ASSERT_EQUAL_INT64(start + 310 * kMicrosPerSecond + 100000,
+                          clock.nowMicros());
+}
+
+void test_wall_clock_never_goes_backwards() {
+  SystemClock::setMicrosSinceStart(0);
+  WallClock clock;
+  const int64_t start = unixMicros(DateTime(2021, 4, 1));
+  clock.step(start);
+
+  // The clock is 120 ms fast. Slewing back must not reverse time: each
+  // millisecond of monotonic time still advances the wall clock.
+  SystemClock::advanceMicros(kMicrosPerSecond);
+  clock.adjustMicros(start + kMicrosPerSecond - 120000);
+  int64_t last = clock.nowMicros();
+  int64_t last_monotonic = WallClock::monotonicMicros();
+  for (int i = 0; i < 300000; i++) {
+    SystemClock::advanceMicros(1000);
+    const int64_t now = clock.nowMicros();
+    TEST_ASSERT_GREATER_OR_EQUAL(last, now);
+    last = now;
+    // The monotonic timebase is unaffected.
+    TEST_ASSERT_EQUAL_INT64(last_monotonic + 1000,
+                            WallClock::monotonicMicros());
+    last_monotonic = WallClock::monotonicMicros();
+  }
+  TEST_ASSERT_EQUAL_INT64(0, clock.remainingSlew());
+  TEST_ASSERT_EQUAL_INT64(start + 301 * kMicrosPerSecond - 120000,
+                          clock.nowMicros());
+}
+
+void test_wall_clock_steps_large_corrections() {
+  SystemClock::setMicrosSinceStart(0);
+  WallClock::Config config;
+  config.step_threshold = 2 * kMicrosPerSecond;
+  WallClock clock(config);
+  const int64_t start = unixMicros(DateTime(2021, 4, 1));
+  clock.step(start);
+
+  SystemClock::advanceMicros(kMicrosPerSecond);
+  clock.adjustMicros(start + kMicrosPerSecond + 1500000);
+  TEST_ASSERT_EQUAL_UINT32(1, clock.steps());  // Within the threshold.
+
+  clock.adjustMicros(start + kMicrosPerSecond + 2500000);
+  TEST_ASSERT_EQUAL_UINT32(2, clock.steps());
+  TEST_ASSERT_EQUAL_INT64(start + kMicrosPerSecond + 2500000,
+                          clock.nowMicros());
+  TEST_ASSERT_EQUAL_INT64(0, clock.remainingSlew());
+}
+
+void test_wall_clock_resync_replaces_slew() {
+  SystemClock::setMicrosSinceStart(0);
+  WallClock clock;
+  const int64_t start = unixMicros(DateTime(2021, 4, 1));
+  clock.step(start);
+
+  clock.adjustMicros(start + 100000);
+  SystemClock::advanceMicros(20 * kMicrosPerSecond);  // 10 ms slewed.
+  TEST_ASSERT_EQUAL_INT64(90000, clock.remainingSlew());
+
+  // A new sync supersedes the remainder of the previous slew.
+  clock.adjustMicros(start + 20 * kMicrosPerSecond + 30000);
+  TEST_ASSERT_EQUAL_INT64(20000, clock.remainingSlew());
+}
+
+void test_wall_clock_rtc_resync() {
+  SystemClock::setMicrosSinceStart(0);
+  WallClock clock;
+  const int64_t start = unixMicros(DateTime(2021, 4, 1));
+  clock.step(start + 250000);
+
+  // Whole second readings of the right time, however far into the second,
+  // leave the clock alone.
+  for (int i = 1; i <= 10; i++) {
+    SystemClock::advanceMicros(kMicrosPerSecond / 10);
+    clock.adjust(DateTime(static_cast<uint32_t>(clock.nowMicros() /
+                                                kMicrosPerSecond)));
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, clock.steps());
+  TEST_ASSERT_EQUAL_INT64(0, clock.remainingSlew());
+  TEST_ASSERT_EQUAL_INT64(start + 1250000, clock.nowMicros());
+
+  // 300 ms slow, and so in the previous second: slewed to the middle.
+  clock.step(start + 900000);
+  clock.adjust(DateTime(static_cast<uint32_t>(start / kMicrosPerSecond + 1)));
+  TEST_ASSERT_EQUAL_UINT32(2, clock.steps());
+  TEST_ASSERT_EQUAL_INT64(600000, clock.remainingSlew());
+}
+
+}  // namespace
+
+void run_wall_clock_tests() {
+  RUN_TEST(test_wall_clock_first_adjust_steps);
+  RUN_TEST(test_wall_clock_slews_small_corrections);
+  RUN_TEST(test_wall_clock_never_goes_backwards);
+  RUN_TEST(test_wall_clock_steps_large_corrections);
+  RUN_TEST(test_wall_clock_resync_replaces_slew);
+  RUN_TEST(test_wall_clock_rtc_resync);
+}
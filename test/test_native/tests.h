@@ -0,0 +1,47 @@
+/**
+ * @section license License
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'license.txt', which is part of this source code package.
+ */
+
+#ifndef RTC_TEST_NATIVE_TESTS_H_
+#define RTC_TEST_NATIVE_TESTS_H_
+
+/**
+ * The (simulated) I2C port used by all native tests.
+ */
+constexpr int kTestI2CPort = 0;
+
+/**
+ * Number of simulated I2C ports, from kTestI2CPort, reset before each test.
+ * The DS1307, DS3231 and PCF8523 share an address, so tests using several
+ * of them put each on its own port.
+ */
+constexpr int kNumTestI2CPorts = 3;
+
+void run_pcf8523_calibrator_tests();
+void run_temperature_compensator_tests();
+void run_clock_discipline_tests();
+void run_wall_clock_tests();
+void run_software_clock_tests();
+void run_simulator_tests();
+void run_ds3231_alarm_scheduler_tests();
+void run_recurrence_tests();
+void run_pcf8523_timer_scheduler_tests();
+void run_pcf8563_tests();
+void run_ds3231_alarm_dispatcher_tests();
+void run_nvram_store_tests();
+void run_at24c32_tests();
+void run_event_log_tests();
+void run_fast_boot_tests();
+void run_instrumentation_tests();
+void run_trace_tests();
+void run_i2c_retrier_tests();
+void run_ensemble_clock_tests();
+void run_clock_fusion_tests();
+void run_register_map_tests();
+void run_precision_setter_tests();
+void run_rtc_timestamper_tests();
+
+#endif  // RTC_TEST_NATIVE_TESTS_H_
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+#
+# This file is subject to the terms and conditions defined in
+# file 'license.txt', which is part of this source code package.
+#
+"""Decode a memory dump of an rtc::EventLog (see include/rtclib/event_log.h).
+
+Example, for a log using the whole of an AT24C32:
+
+    decode_event_log.py eeprom.bin
+
+Prints one event per line, oldest first: the ISO 8601 UTC time and the
+payload in hex.
+"""
+
+import argparse
+import datetime
+import struct
+import sys
+
+BLOCK_SIZE = 64
+HEADER_SIZE = 8
+MAX_PAYLOAD_SIZE = 16
+MAGIC = 0xE7
+END_MARKER = 0xFF
+
+
+def crc8(crc, data):
+    """CRC-8, polynomial 0x07, as rtc_util.cc's crc8()."""
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc << 1) ^ 0x07 if crc & 0x80 else crc << 1
+            crc &= 0xFF
+    return crc
+
+
+def parse_header(block):
+    """Return (sequence, time) of a valid block header, else None."""
+    header = block[:HEADER_SIZE]
+    if header[0] != MAGIC or header[-1] != crc8(0xFF, header[:-1]):
+        return None
+    seq, time = struct.unpack_from('<HI', header, 1)
+    return seq, time
+
+
+def parse_records(block):
+    """Yield (delta, payload) for each valid record of a block."""
+    offset = HEADER_SIZE
+    header_crc = block[HEADER_SIZE - 1]
+    while offset + 3 <= BLOCK_SIZE:
+        length = block[offset]
+        if length > MAX_PAYLOAD_SIZE:
+            return
+        delta = 0
+        size = 1
+        for shift in range(0, 35, 7):
+            if offset + size >= BLOCK_SIZE:
+                return
+            byte = block[offset + size]
+            size += 1
+            delta |= (byte & 0x7F) << shift
+            if not byte & 0x80:
+                break
+        else:
+            return
+        size += length
+        if offset + size >= BLOCK_SIZE:
+            return
+        record = block[offset:offset + size]
+        seed = crc8(header_crc, [offset])
+        if block[offset + size] != crc8(seed, record):
+            return
+        yield delta, record[size - length:]
+        offset += size + 1
+
+
+def decode(image):
+    """Yield (time, payload) for each event in |image|, oldest first."""
+    blocks = []
+    for start in range(0, len(image) - BLOCK_SIZE + 1, BLOCK_SIZE):
+        block = image[start:start + BLOCK_SIZE]
+        header = parse_header(block)
+        if header:
+            blocks.append((header[0], header[1], block))
+    if not blocks:
+        return
+    # Order by sequence number, allowing it to wrap: the oldest block is the
+    # one following the largest gap.
+    blocks.sort(key=lambda b: b[0])
+    gaps = [(blocks[(i + 1) % len(blocks)][0] - blocks[i][0]) & 0xFFFF
+            for i in range(len(blocks))]
+    oldest = (gaps.index(max(gaps)) + 1) % len(blocks)
+    for i in range(len(blocks)):
+        _, time, block = blocks[(oldest + i) % len(blocks)]
+        for delta, payload in parse_records(block):
+            time += delta
+            yield time, payload
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('dump', help='binary memory dump')
+    parser.add_argument('--address', type=lambda s: int(s, 0), default=0,
+                        help='start of the log in the dump')
+    parser.add_argument('--size', type=lambda s: int(s, 0),
+                        help='size of the log (default: to the end)')
+    args = parser.parse_args()
+
+    with open(args.dump, 'rb') as f:
+        image = f.read()
+    end = len(image) if args.size is None else args.address + args.size
+    for time, payload in decode(image[args.address:end]):
+        stamp = datetime.datetime.fromtimestamp(time, datetime.timezone.utc)
+        print(stamp.strftime('%Y-%m-%dT%H:%M:%S'), payload.hex())
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())